@@ -0,0 +1,653 @@
+"""
+Replay backtester: historical candles from the local candle store go through pt_thinker's
+signal logic and pt_trader's manage_trades(), against a simulated exchange and clock.
+
+	python pt_backtest.py --days 60
+	python pt_backtest.py --start 2025-01-01 --end 2025-03-01 --cash 5000 --set trade_start_level=4
+	python pt_backtest.py --days 90 --sweep "trailing_gap_pct=[0.25,0.5,1.0]" \\
+		--sweep "dca_levels=[[-2.5,-5,-10,-20],[-5,-10,-20,-30]]" --workers 4
+
+Every run gets its own folder, laid out like a live install so the hub's readers work on it:
+
+	<run>/gui_settings.json     what the run traded with (your gui_settings.json + --set / --sweep)
+	<run>/hub_data/             trade_history.jsonl, pnl_ledger.json, account_value_history.jsonl, ...
+	<run>/neural/               private copy of the trained memories + thresholds (BTC on top, others in <SYM>/),
+	                            or, with --train, memories trained up to the replay start
+	<run>/summary.json          return, realized profit, max drawdown, trade counts, speed
+
+How it works:
+- Clock: `time` in pt_thinker, pt_trader and pt_candles is replaced by SimClock, so trade
+  timestamps, the 24h DCA limit and the candle store's "now" are historical and sleeps are free.
+- Candles: pt_candles answers windows ending at the simulated now from the store (no
+  downloads; the run is clamped to the history that is on disk). Each 1hour candle is replayed
+  as four ticks: open, low, high, close (open, high, low, close when the candle closed down).
+  The thinker only reads closed candles, so the final values of the open ones never leak in.
+- Thinker: one full pt_thinker.step_coin() sweep per coin per tick; signals go to ReplaySignals
+  (in memory) instead of the localhost socket / text files.
+- Trader: BacktestTrader is CryptoAPITrading with its Robinhood calls answered by SimExchange
+  (market orders fill at once at candle price +/- half of --spread-pct), so manage_trades(),
+  place_buy_order() / place_sell_order() and _record_trade() are the live code paths.
+
+KuCoin USDT candles stand in for Robinhood's USD quotes. Sweeps run on a process pool with one
+fresh process per run (the thinker and trader keep module-level state).
+
+Look-ahead bias: by default a run replays the LIVE memories and thresholds, and those were
+trained on candles up to whenever the trainer last ran, usually including the replayed window
+itself. Such a result is optimistic. Such runs print a warning and are marked
+"lookahead_bias": true in summary.json / results.json. --train avoids it: each coin is trained from
+scratch into <out>/neural on candles that had closed by the replay start only (pt_trainer's
+end_at, on a clock that starts at the replay start; log in <coin folder>/train.log). That takes as long as
+a normal training run.
+"""
+import os
+import sys
+import json
+import time
+import glob
+import shutil
+import argparse
+import datetime
+import itertools
+import traceback
+import contextlib
+import importlib
+import multiprocessing
+from urllib.parse import parse_qsl
+
+import pt_candles
+
+BASE_DIR = os.path.dirname(os.path.abspath(__file__))
+GUI_SETTINGS_PATH = os.environ.get("POWERTRADER_GUI_SETTINGS") or os.path.join(BASE_DIR, "gui_settings.json")
+
+REPLAY_TF = "1hour"
+TICK_OFFSETS = (0, 900, 1800, 2700)  # seconds into the candle for its open / first extreme / second extreme / close
+THINKER_TFS = ('1hour', '2hour', '4hour', '8hour', '12hour', '1day', '1week')  # pt_thinker.tf_choices
+DEFAULT_DAYS = 30
+DEFAULT_CASH = 10000.0
+DEFAULT_SPREAD_PCT = 0.5  # Robinhood prices include the spread: ask = mid * 1.0025, bid = mid * 0.9975
+
+# per-coin training files a run needs; the thinker only reads them, so a run can hard-link them
+TRAINING_FILE_PATTERNS = ("memories_*", "memory_weights_*", "neural_perfect_threshold_*.txt", "trainer_last_training_time.txt")
+
+ACCOUNTS_PATH = "/api/v1/crypto/trading/accounts/"
+HOLDINGS_PATH = "/api/v1/crypto/trading/holdings/"
+PAIRS_PATH = "/api/v1/crypto/trading/trading_pairs/"
+ORDERS_PATH = "/api/v1/crypto/trading/orders/"
+BEST_BID_ASK_PATH = "/api/v1/crypto/marketdata/best_bid_ask/"
+
+
+class SimClock:
+	"""Stands in for the `time` module: time() is the replay's now and sleep() only moves it forward."""
+
+	def __init__(self, now):
+		self.now = float(now)
+
+	def time(self):
+		return self.now
+
+	def sleep(self, seconds):
+		try:
+			self.now += max(0.0, float(seconds))
+		except Exception:
+			pass
+
+	def advance_to(self, ts):
+		if ts > self.now:
+			self.now = float(ts)
+
+	def __getattr__(self, name):
+		return getattr(time, name)  # perf_counter, monotonic, ... stay real
+
+
+class ReplaySignals:
+	"""In-memory thinker -> trader handoff: pt_thinker publishes into it and pt_trader reads from it."""
+
+	def __init__(self):
+		self._snapshots = {}
+
+	def publish(self, coin, fields, folder=None, files=None):
+		self._snapshots.setdefault(str(coin).upper().strip(), {}).update(fields)
+
+	def get(self, coin, max_age=None):
+		snap = self._snapshots.get(str(coin).upper().strip())
+		return dict(snap) if snap is not None else None
+
+
+class SimExchange:
+	"""Just enough of Robinhood's crypto API for CryptoAPITrading. Market orders fill immediately."""
+
+	def __init__(self, clock, cash, spread_pct=DEFAULT_SPREAD_PCT):
+		self.clock = clock
+		self.buying_power = float(cash)
+		self.half_spread = float(spread_pct) / 200.0
+		self.prices = {}    # "BTC-USD" -> mid price
+		self.holdings = {}  # "BTC" -> quantity
+		self.orders = []
+		self._last_order_ts = 0.0
+
+	def quote(self, symbol):
+		"""(ask, bid) for "BTC-USD", or None without a price."""
+		mid = self.prices.get(symbol)
+		if not mid:
+			return None
+		return mid * (1.0 + self.half_spread), mid * (1.0 - self.half_spread)
+
+	def account_value(self):
+		value = self.buying_power
+		for asset, qty in self.holdings.items():
+			q = self.quote(f"{asset}-USD")
+			if q is not None:
+				value += qty * q[1]
+		return value
+
+	def request(self, method, path, body=""):
+		route, _, query = path.partition("?")
+		if method == "POST":
+			return self._place(json.loads(body or "{}")) if route == ORDERS_PATH else None
+		if route == ACCOUNTS_PATH:
+			return {"buying_power": str(self.buying_power), "buying_power_currency": "USD"}
+		if route == HOLDINGS_PATH:
+			return {"results": [{"asset_code": a, "total_quantity": str(q)} for a, q in self.holdings.items() if q > 0.0]}
+		if route == PAIRS_PATH:
+			return {"results": [{"symbol": s, "status": "tradable"} for s in sorted(self.prices)]}
+		if route == ORDERS_PATH:
+			symbol = dict(parse_qsl(query)).get("symbol", "")
+			return {"results": [dict(o) for o in self.orders if o["symbol"] == symbol]}
+		if route == BEST_BID_ASK_PATH:
+			results = []
+			for key, symbol in parse_qsl(query):
+				q = self.quote(symbol) if key == "symbol" else None
+				if q is not None:
+					results.append({"symbol": symbol, "ask_inclusive_of_buy_spread": str(q[0]), "bid_inclusive_of_sell_spread": str(q[1])})
+			return {"results": results}
+		return None
+
+	def _place(self, body):
+		symbol = str(body.get("symbol", "")).upper()
+		side = str(body.get("side", "")).lower()
+		asset = symbol.split("-")[0]
+		try:
+			qty = float((body.get("market_order_config") or {}).get("asset_quantity"))
+		except Exception:
+			return {"errors": [{"detail": "asset_quantity is required"}]}
+		q = self.quote(symbol)
+		if q is None or qty <= 0.0:
+			return {"errors": [{"detail": f"no quote for {symbol}"}]}
+
+		if side == "buy":
+			price = q[0]
+			if qty * price > self.buying_power + 1e-9:
+				return {"errors": [{"detail": "Insufficient buying power"}]}
+			self.buying_power -= qty * price
+			self.holdings[asset] = self.holdings.get(asset, 0.0) + qty
+		elif side == "sell":
+			price = q[1]
+			held = self.holdings.get(asset, 0.0)
+			if qty > held * (1.0 + 1e-9) + 1e-12:
+				return {"errors": [{"detail": "Insufficient holdings"}]}
+			qty = min(qty, held)
+			self.buying_power += qty * price
+			if held - qty <= 1e-12:
+				self.holdings.pop(asset, None)
+			else:
+				self.holdings[asset] = held - qty
+		else:
+			return {"errors": [{"detail": f"unsupported side {side!r}"}]}
+
+		# strictly increasing created_at: the trader orders and counts DCA buys by it
+		ts = max(self.clock.time(), self._last_order_ts + 0.001)
+		self._last_order_ts = ts
+		created = datetime.datetime.fromtimestamp(ts, tz=datetime.timezone.utc).isoformat(timespec="microseconds")
+		order = {
+			"id": f"bt-{len(self.orders) + 1:06d}",
+			"client_order_id": body.get("client_order_id"),
+			"side": side,
+			"type": "market",
+			"symbol": symbol,
+			"state": "filled",
+			"created_at": created,
+			"filled_asset_quantity": str(qty),
+			"average_price": str(price),
+			"executions": [{"quantity": str(qty), "effective_price": str(price), "timestamp": created}],
+		}
+		self.orders.append(order)
+		return dict(order)
+
+
+def _make_trader(pt_trader, exchange):
+	"""CryptoAPITrading wired to `exchange` (pt_trader is imported late, once the run's env is set)."""
+
+	class BacktestTrader(pt_trader.CryptoAPITrading):
+
+		def _init_api(self):
+			self.api_key = ""
+			self.private_key = None
+			self.base_url = ""
+			self.session = None
+			self.api_latency = None
+
+		def make_api_request(self, method, path, body=""):
+			return exchange.request(method, path, body)
+
+		def _market_data_get(self, path):
+			return exchange.request("GET", path)
+
+		def _clear_screen(self):
+			pass
+
+		def _start_position_verify(self):
+			# inline, so a replay stays deterministic
+			self._position_verify_due = pt_trader.time.time() + pt_trader.POSITION_VERIFY_SECONDS
+			self._verify_positions({base: self.positions.rev(base) for base in self.positions.positions})
+
+	return BacktestTrader()
+
+
+def _bar_path(o, c, h, l):
+	return (o, l, h, c) if c >= o else (o, h, l, c)
+
+
+def replay_ticks(coins, start, end):
+	"""(ts, {coin: price}) along every stored 1hour candle of `coins` with start <= ts <= end."""
+	bars = {}
+	for coin in coins:
+		st = pt_candles.get_store(coin + "-USDT", REPLAY_TF)
+		for row in st.window(start, end, limit=None):
+			bars.setdefault(row[0], {})[coin] = _bar_path(row[1], row[2], row[3], row[4])
+	last = {}
+	for bar_ts in sorted(bars):
+		for i, offset in enumerate(TICK_OFFSETS):
+			for coin, path in bars[bar_ts].items():
+				last[coin] = path[i]
+			if bar_ts + offset <= end:
+				yield bar_ts + offset, dict(last)
+
+
+def data_range(coins):
+	"""
+	(usable coins, first ts, last ts) the thinker can replay without downloading: every
+	timeframe needs a closed candle at the start and must not have run out before the end.
+	"""
+	usable, first, last = [], None, None
+	for coin in coins:
+		lo, hi = None, None
+		for tf in THINKER_TFS:
+			st = pt_candles.get_store(coin + "-USDT", tf)
+			if len(st.ts) < 2:
+				lo = None
+				break
+			lo = st.ts[1] if lo is None else max(lo, st.ts[1])
+			hi = st.last_ts() + st.tf_seconds - 1 if hi is None else min(hi, st.last_ts() + st.tf_seconds - 1)
+		if lo is None or hi is None or lo >= hi:
+			print(f"[pt_backtest] skipping {coin}: not enough candles in {pt_candles.candle_dir()} (run the trainer for it first)")
+			continue
+		usable.append(coin)
+		first = lo if first is None else max(first, lo)
+		last = hi if last is None else min(last, hi)
+	return usable, first, last
+
+
+def coin_dir(root, coin):
+	return root if coin == "BTC" else os.path.join(root, coin)
+
+
+def trained_through(folder):
+	"""
+	Latest candle time the memories in `folder` may have seen: the newest trainer checkpoint's
+	candle close, else the last training stamp (the trainer reads up to its own now). None if unknown.
+	"""
+	newest = None
+	for tf in THINKER_TFS:
+		try:
+			with open(os.path.join(folder, f"trainer_checkpoint_{tf}.json"), "r", encoding="utf-8") as f:
+				ts = int(json.load(f)["last_candle_ts"]) + pt_candles.TF_SECONDS[tf]
+			newest = ts if newest is None else max(newest, ts)
+		except Exception:
+			continue
+	if newest is None:
+		try:
+			with open(os.path.join(folder, "trainer_last_training_time.txt"), "r", encoding="utf-8") as f:
+				newest = int(float(f.read().strip()))
+		except Exception:
+			pass
+	return newest
+
+
+class _TrainClock(SimClock):
+	"""
+	Starts at the replay start and runs at real speed: sleeps are real, and the candle rate
+	bucket (which refills by elapsed time) doesn't starve the downloads.
+	"""
+
+	def __init__(self, now):
+		super().__init__(now)
+		self._t0 = time.time()
+
+	def time(self):
+		return self.now + (time.time() - self._t0)
+
+	def sleep(self, seconds):
+		time.sleep(seconds)
+
+
+def _train_coin(job):
+	"""One coin's pt_trainer.train() (its own process: the trainer keeps module-level state)."""
+	neural_dir, coin, until = job
+	folder = coin_dir(neural_dir, coin)
+	os.makedirs(folder, exist_ok=True)
+	os.chdir(folder)
+	try:
+		with open(os.path.join(folder, "train.log"), "w", encoding="utf-8") as log, contextlib.redirect_stdout(log):
+			pt_trainer = importlib.import_module("pt_trainer")
+			clock = _TrainClock(until)
+			for mod in (pt_trainer, pt_candles):
+				mod.time = clock
+			try:
+				pt_trainer.train(pt_trainer.TrainContext(coin, end_at=until))
+			except SystemExit:
+				pass
+		return coin, None
+	except Exception:
+		return coin, traceback.format_exc()
+
+
+def train_until(neural_dir, coins, until, workers=1):
+	"""Train every coin from scratch into neural_dir on candles that closed by `until`. Returns the failures."""
+	ctx = multiprocessing.get_context("spawn")
+	with ctx.Pool(processes=max(1, min(workers, len(coins))), maxtasksperchild=1) as pool:
+		return {coin: err for coin, err in pool.imap_unordered(_train_coin, [(neural_dir, c, until) for c in coins]) if err}
+
+
+def copy_training_files(src_root, dst_root, coins, link=False):
+	for coin in coins:
+		src, dst = coin_dir(src_root, coin), coin_dir(dst_root, coin)
+		os.makedirs(dst, exist_ok=True)
+		for pattern in TRAINING_FILE_PATTERNS:
+			for path in glob.glob(os.path.join(src, pattern)):
+				target = os.path.join(dst, os.path.basename(path))
+				if os.path.exists(target):
+					os.remove(target)
+				try:
+					if not link:
+						raise OSError
+					os.link(path, target)
+				except OSError:
+					shutil.copy2(path, target)
+
+
+def run_backtest(cfg):
+	"""One replay (in this process). Returns the run's summary dict, also saved as <run>/summary.json."""
+	run_dir = os.path.abspath(cfg["run_dir"])
+	hub_dir = os.path.join(run_dir, "hub_data")
+	neural_dir = os.path.join(run_dir, "neural")
+	os.makedirs(hub_dir, exist_ok=True)
+	coins = list(cfg["coins"])
+	if os.path.abspath(cfg["neural_src"]) != neural_dir:
+		copy_training_files(cfg["neural_src"], neural_dir, coins, link=True)
+
+	settings = dict(cfg["settings"])
+	settings.update(coins=coins, main_neural_dir=neural_dir, market_stream=False, signal_file_mirror=False)
+	settings_path = os.path.join(run_dir, "gui_settings.json")
+	with open(settings_path, "w", encoding="utf-8") as f:
+		json.dump(settings, f, indent=2)
+
+	# the thinker and trader read these on import
+	os.environ["POWERTRADER_GUI_SETTINGS"] = settings_path
+	os.environ["POWERTRADER_HUB_DIR"] = hub_dir
+	os.chdir(run_dir)  # the trader writes <SYM>_current_price.txt into the working folder
+
+	clock = SimClock(cfg["start"])
+	exchange = SimExchange(clock, cfg["cash"], cfg["spread_pct"])
+	signals = ReplaySignals()
+	errors = 0
+	ticks = 0
+	peak = max_drawdown = 0.0
+	wall_start = time.perf_counter()
+
+	console = open(os.path.join(run_dir, "console.log") if cfg.get("verbose") else os.devnull, "w", encoding="utf-8")
+	with console, contextlib.redirect_stdout(console):
+		pt_thinker = importlib.import_module("pt_thinker")
+		pt_trader = importlib.import_module("pt_trader")
+		for mod in (pt_thinker, pt_trader, pt_candles):
+			mod.time = clock
+		pt_thinker._signals = signals
+		pt_thinker.BASE_DIR = neural_dir
+		pt_thinker.STATE_SNAPSHOTS = False
+		pt_thinker.current_ask = lambda sym: exchange.quote(sym + "-USD")[0]
+		pt_trader._signal_feed = signals
+
+		ticks_iter = replay_ticks(coins, cfg["start"], cfg["end"])
+		first = next(ticks_iter, None)
+		if first is None:
+			raise RuntimeError("no candles in the requested range")
+		clock.advance_to(first[0])
+		exchange.prices = {f"{c}-USD": p for c, p in first[1].items()}
+		for sym in coins:
+			pt_thinker.init_coin(sym)
+		trader = _make_trader(pt_trader, exchange)
+
+		for ts, prices in itertools.chain([first], ticks_iter):
+			clock.advance_to(ts)
+			exchange.prices = {f"{c}-USD": p for c, p in prices.items()}
+			for sym in coins:
+				try:
+					for _ in pt_thinker.tf_choices:
+						pt_thinker.step_coin(sym)
+				except Exception:
+					errors += 1
+					print(traceback.format_exc())
+			try:
+				trader.manage_trades()
+			except Exception:
+				errors += 1
+				print(traceback.format_exc())
+
+			value = exchange.account_value()
+			peak = max(peak, value)
+			if peak > 0.0:
+				max_drawdown = max(max_drawdown, (peak - value) / peak * 100.0)
+			ticks += 1
+
+	wall = time.perf_counter() - wall_start
+	trades = []
+	try:
+		with open(pt_trader.TRADE_HISTORY_PATH, "r", encoding="utf-8") as f:
+			trades = [json.loads(line) for line in f if line.strip()]
+	except Exception:
+		pass
+
+	final_value = exchange.account_value()
+	summary = {
+		"name": cfg["name"],
+		"params": cfg.get("params", {}),
+		"run_dir": run_dir,
+		"coins": coins,
+		"start": cfg["start"],
+		"end": clock.time(),
+		"days": round((clock.time() - cfg["start"]) / 86400.0, 2),
+		"ticks": ticks,
+		"errors": errors,
+		"start_cash": float(cfg["cash"]),
+		"final_value": round(final_value, 2),
+		"return_pct": round((final_value / float(cfg["cash"]) - 1.0) * 100.0, 4) if cfg["cash"] else 0.0,
+		"realized_profit_usd": round(float(trader._pnl_ledger.get("total_realized_profit_usd", 0.0) or 0.0), 2),
+		"max_drawdown_pct": round(max_drawdown, 4),
+		"buys": sum(1 for t in trades if t.get("side") == "buy" and t.get("tag") != "DCA"),
+		"dca_buys": sum(1 for t in trades if t.get("side") == "buy" and t.get("tag") == "DCA"),
+		"sells": sum(1 for t in trades if t.get("side") == "sell"),
+		"open_positions": sorted(exchange.holdings),
+		"wall_seconds": round(wall, 2),
+		"lookahead_bias": bool(cfg.get("lookahead_bias")),
+		"speedup": round((clock.time() - cfg["start"]) / wall) if wall > 0 else None,
+	}
+	with open(os.path.join(run_dir, "summary.json"), "w", encoding="utf-8") as f:
+		json.dump(summary, f, indent=2)
+	return summary
+
+
+def _run_in_worker(cfg):
+	try:
+		return run_backtest(cfg)
+	except Exception:
+		return {"name": cfg["name"], "params": cfg.get("params", {}), "run_dir": cfg["run_dir"], "error": traceback.format_exc()}
+
+
+def _parse_ts(text):
+	try:
+		return float(text)
+	except ValueError:
+		d = datetime.datetime.strptime(text, "%Y-%m-%d")
+		return d.replace(tzinfo=datetime.timezone.utc).timestamp()
+
+
+def _parse_value(text):
+	try:
+		return json.loads(text)
+	except ValueError:
+		return text
+
+
+def _parse_assignments(items, sweep=False):
+	out = {}
+	for item in items or []:
+		key, sep, raw = item.partition("=")
+		if not sep or not key.strip():
+			raise SystemExit(f"expected key=value, got {item!r}")
+		val = _parse_value(raw.strip())
+		if sweep and not isinstance(val, list):
+			raise SystemExit(f"--sweep {key} needs a JSON list of values")
+		out[key.strip()] = val
+	return out
+
+
+def _load_settings():
+	try:
+		with open(GUI_SETTINGS_PATH, "r", encoding="utf-8") as f:
+			data = json.load(f) or {}
+		return data if isinstance(data, dict) else {}
+	except Exception:
+		return {}
+
+
+def _fmt_params(params):
+	return " ".join(f"{k}={json.dumps(v)}" for k, v in params.items())
+
+
+def main(argv=None):
+	ap = argparse.ArgumentParser(description="Replay stored candles through the thinker + trader against a simulated exchange.")
+	ap.add_argument("--start", help="UTC date (YYYY-MM-DD) or unix time; default --days before --end")
+	ap.add_argument("--end", help="UTC date (YYYY-MM-DD) or unix time; default the end of the stored candles")
+	ap.add_argument("--days", type=float, default=DEFAULT_DAYS)
+	ap.add_argument("--coins", help="comma-separated (default: gui_settings.json coins)")
+	ap.add_argument("--cash", type=float, default=DEFAULT_CASH, help="starting buying power (USD)")
+	ap.add_argument("--spread-pct", type=float, default=DEFAULT_SPREAD_PCT, help="simulated ask-bid spread, %% of price")
+	ap.add_argument("--set", action="append", metavar="KEY=JSON", help="override one gui_settings.json value for every run")
+	ap.add_argument("--sweep", action="append", metavar="KEY=[JSON,...]", help="one run per value (several --sweep = every combination)")
+	ap.add_argument("--workers", type=int, default=os.cpu_count() or 1, help="parallel runs in a sweep")
+	ap.add_argument("--neural-dir", help="trained memories folder (default: gui_settings.json main_neural_dir)")
+	ap.add_argument("--out", help="output folder (default: backtests/<timestamp> next to this script)")
+	ap.add_argument("--verbose", action="store_true", help="keep each run's thinker/trader console output in console.log")
+	ap.add_argument("--train", action="store_true", help="train fresh memories on candles up to --start only (no look-ahead; slow)")
+	args = ap.parse_args(argv)
+
+	settings = _load_settings()
+	settings.update(_parse_assignments(args.set))
+	sweep = _parse_assignments(args.sweep, sweep=True)
+
+	coins = [c.strip().upper() for c in (args.coins.split(",") if args.coins else settings.get("coins") or ["BTC"]) if c.strip()]
+	coins, data_first, data_last = data_range(coins)
+	if not coins:
+		print("[pt_backtest] nothing to replay")
+		return 1
+	end = min(_parse_ts(args.end), data_last) if args.end else data_last
+	start = _parse_ts(args.start) if args.start else end - args.days * 86400.0
+	start = max(start, data_first)
+	if start >= end:
+		print(f"[pt_backtest] no stored candles between the requested start and end (stored: {data_first:.0f} .. {data_last:.0f})")
+		return 1
+
+	neural_src = os.path.abspath(args.neural_dir or settings.get("main_neural_dir") or BASE_DIR)
+	out = os.path.abspath(args.out or os.path.join(BASE_DIR, "backtests", datetime.datetime.now().strftime("%Y%m%d-%H%M%S")))
+	os.makedirs(out, exist_ok=True)
+	lookahead = []
+	if args.train:
+		print(f"[pt_backtest] training {', '.join(coins)} on candles up to the replay start (logs in {os.path.join(out, 'neural')}) ...")
+		failed = train_until(os.path.join(out, "neural"), coins, int(start), workers=args.workers)
+		for coin, err in failed.items():
+			print(f"[pt_backtest] training {coin} failed:\n{err}")
+		if failed:
+			return 1
+	else:
+		copy_training_files(neural_src, os.path.join(out, "neural"), coins)  # snapshot: training may go on meanwhile
+		for coin in coins:
+			seen = trained_through(coin_dir(neural_src, coin))
+			if seen is None or seen > start:
+				lookahead.append(coin)
+		if lookahead:
+			print("[pt_backtest] " + "!" * 72)
+			print(f"[pt_backtest] LOOK-AHEAD BIAS: the memories of {', '.join(lookahead)} were trained on candles")
+			print("[pt_backtest] after the replay start (or when is unknown), so they already know the replayed")
+			print("[pt_backtest] prices and the result is optimistic. Use --train for an honest run.")
+			print("[pt_backtest] " + "!" * 72)
+
+	keys = list(sweep)
+	combos = list(itertools.product(*(sweep[k] for k in keys))) if keys else [()]
+	cfgs = []
+	for i, combo in enumerate(combos, 1):
+		params = dict(zip(keys, combo))
+		run_settings = dict(settings)
+		run_settings.update(params)
+		name = f"run-{i:03d}" if keys else "run"
+		cfgs.append({
+			"name": name,
+			"params": params,
+			"run_dir": os.path.join(out, name) if keys else out,
+			"neural_src": os.path.join(out, "neural"),
+			"settings": run_settings,
+			"coins": coins,
+			"start": start,
+			"end": end,
+			"cash": args.cash,
+			"spread_pct": args.spread_pct,
+			"verbose": args.verbose,
+			"lookahead_bias": bool(lookahead),
+		})
+
+	print(f"[pt_backtest] {len(cfgs)} run(s), {', '.join(coins)}, "
+		f"{datetime.datetime.fromtimestamp(start, tz=datetime.timezone.utc):%Y-%m-%d %H:%M} -> "
+		f"{datetime.datetime.fromtimestamp(end, tz=datetime.timezone.utc):%Y-%m-%d %H:%M} UTC, output in {out}")
+
+	results = []
+	if len(cfgs) == 1:
+		results.append(_run_in_worker(cfgs[0]))
+	else:
+		# spawn + one task per child: every run imports the thinker/trader fresh with its own settings
+		ctx = multiprocessing.get_context("spawn")
+		with ctx.Pool(processes=max(1, min(args.workers, len(cfgs))), maxtasksperchild=1) as pool:
+			for res in pool.imap_unordered(_run_in_worker, cfgs):
+				results.append(res)
+				if "error" in res:
+					print(f"  {res['name']}: FAILED ({res['run_dir']})")
+				else:
+					print(f"  {res['name']}: {res['return_pct']:+.2f}%  {_fmt_params(res['params'])}")
+
+	results.sort(key=lambda r: r.get("return_pct", float("-inf")), reverse=True)
+	with open(os.path.join(out, "results.json"), "w", encoding="utf-8") as f:
+		json.dump(results, f, indent=2)
+
+	print()
+	for r in results:
+		if "error" in r:
+			print(f"{r['name']:>8}  FAILED\n{r['error']}")
+			continue
+		print(
+			f"{r['name']:>8}  return {r['return_pct']:+8.2f}%  realized ${r['realized_profit_usd']:>10.2f}"
+			f"  max DD {r['max_drawdown_pct']:6.2f}%  trades {r['buys']}/{r['dca_buys']}/{r['sells']} (buy/DCA/sell)"
+			f"  {r['days']:.0f}d in {r['wall_seconds']:.0f}s  {_fmt_params(r['params'])}"
+			+ ("  [LOOK-AHEAD BIAS]" if r.get("lookahead_bias") else "")
+		)
+	return 0 if all("error" not in r for r in results) else 1
+
+
+if __name__ == "__main__":
+	sys.exit(main())
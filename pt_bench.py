@@ -0,0 +1,489 @@
+"""
+Benchmarks for the trainer / thinker / trader hot paths, on reproducible fixtures.
+
+	python pt_bench.py                                   # everything -> bench_results.json
+	python pt_bench.py --only knn,memory --sizes 10000,100000
+	python pt_bench.py --out after.json --compare before.json
+
+Fixtures are built once per --seed (deterministic) into --fixtures (default
+<temp>/powertrader_bench_<seed>) and reused afterwards:
+
+	memories/<N>/memories_1hour.ptm   N synthetic single-value memories (10k / 100k / 1M)
+	wide/<N>/memories_1hour.ptm       N synthetic 8-value memories scored at widths 1-8
+	candles/                          a seeded random-walk BTC-USDT kline history in candle-store
+	                                  format, every thinker timeframe aggregated from one 1hour series
+	coin/                             a trained-looking coin folder (memories + threshold per timeframe)
+
+Benchmarks (each in its own fresh process, so peak RSS and module state are per benchmark):
+
+	memory.load            pt_memory.load_store() of N memories
+	memory.flush           1000 weight updates through the journal (set_weights + write)
+	memory.compact         full rewrite of the store (forced flush / end of a timeframe)
+	knn.scan               pt_match.match_store() for one candle, index and exact mode
+	knn.lengths            pt_match.match_lengths() over wide memories: width 7 alone, then 3 and 5 widths
+	                       up to 7 (each a single pass, so the cost should stay near the width-7 scan)
+	thinker.sweep          one full step_coin() sweep over every timeframe, with the candles unchanged
+	                       (cached predictions) and with a new 1hour candle every sweep
+	trainer.epoch          pt_trainer.train() of one timeframe over the fixed candle window
+	trader.manage_trades   one manage_trades() pass against pt_backtest.SimExchange (no network)
+
+Every result has the iteration count, throughput (items per second), latency percentiles in ms
+and peak RSS in MB; the file also records the git revision, Python and platform. --compare
+prints p50 and throughput ratios against an earlier results file.
+"""
+import os
+import sys
+import json
+import time
+import random
+import shutil
+import argparse
+import datetime
+import platform
+import tempfile
+import traceback
+import contextlib
+import importlib
+import subprocess
+import multiprocessing
+
+import pt_memory
+import pt_match
+import pt_candles
+import pt_backtest
+
+BASE_DIR = os.path.dirname(os.path.abspath(__file__))
+
+FIXTURE_VERSION = 1
+FIXTURE_END = 1767225600  # 2026-01-01 00:00 UTC, on a 1week boundary: every fixture candle is closed
+FIXTURE_HOURS = 3000
+FIXTURE_PAIR = "BTC-USDT"
+COIN_MEMORIES = 10000  # per timeframe in the thinker's coin folder
+DEFAULT_SIZES = (10000, 100000, 1000000)
+KNN_THRESHOLD = 5.0
+FLUSH_UPDATES = 1000
+TRADER_COINS = ("BTC", "ETH", "XRP", "BNB", "DOGE")
+TRAINER_TF = "1day"
+
+BENCH_BUDGET_SECONDS = 3.0  # per benchmark, after MIN_ITERATIONS
+MIN_ITERATIONS = 5
+MAX_ITERATIONS = 1000
+
+
+# -----------------------------
+# Fixtures
+# -----------------------------
+
+def _rng(seed, salt):
+	return random.Random(f"{seed}:{salt}")
+
+
+def build_memory_store(n, rng, width=1):
+	st = pt_memory.MemoryStore(width)
+	st.flags = pt_memory.widths_flags(range(1, width + 1))
+	for _ in range(n):
+		st.append([rng.gauss(0.0, 1.5) for _ in range(width)], rng.gauss(0.0, 1.0), abs(rng.gauss(0.0, 0.8)), -abs(rng.gauss(0.0, 0.8)),
+			rng.uniform(-1.0, 2.0), rng.uniform(-0.5, 2.0), rng.uniform(-0.5, 2.0))
+	st.generation = 1
+	return st
+
+
+def build_candles(folder, rng, hours=FIXTURE_HOURS, end=FIXTURE_END):
+	os.makedirs(folder, exist_ok=True)
+	hourly = []
+	price = 100.0
+	for i in range(hours):
+		o = price
+		c = o * (1.0 + rng.gauss(0.0, 0.006))
+		h = max(o, c) * (1.0 + abs(rng.gauss(0.0, 0.003)))
+		l = min(o, c) * (1.0 - abs(rng.gauss(0.0, 0.003)))
+		v = rng.uniform(50.0, 150.0)
+		hourly.append((end - (hours - i) * 3600, o, c, h, l, v, v * (o + c) / 2.0))
+		price = c
+	for tf in pt_backtest.THINKER_TFS:
+		sec = pt_candles.TF_SECONDS[tf]
+		buckets = {}
+		for r in hourly:
+			b = r[0] - r[0] % sec
+			old = buckets.get(b)
+			buckets[b] = (b,) + r[1:] if old is None else (b, old[1], r[2], max(old[3], r[3]), min(old[4], r[4]), old[5] + r[5], old[6] + r[6])
+		rows = [buckets[b] for b in sorted(buckets)]
+		pt_candles.CandleStore(FIXTURE_PAIR, tf, folder).merge(rows, known_from=0, history_start=True)  # never backfill
+
+
+def ensure_fixtures(root, seed, sizes):
+	"""Build whatever is missing under `root` (a seed/version change rebuilds everything)."""
+	spec = {"version": FIXTURE_VERSION, "seed": seed, "hours": FIXTURE_HOURS, "coin_memories": COIN_MEMORIES}
+	spec_path = os.path.join(root, "spec.json")
+	try:
+		with open(spec_path, "r", encoding="utf-8") as f:
+			if json.load(f) != spec:
+				raise ValueError
+	except Exception:
+		shutil.rmtree(root, ignore_errors=True)
+		os.makedirs(root)
+		with open(spec_path, "w", encoding="utf-8") as f:
+			json.dump(spec, f)
+
+	for n in sizes:
+		folder = os.path.join(root, "memories", str(n))
+		if not os.path.isfile(pt_memory.store_path("1hour", folder)):
+			print(f"[pt_bench] building {n} memories ...")
+			os.makedirs(folder, exist_ok=True)
+			build_memory_store(n, _rng(seed, f"memories:{n}")).save(pt_memory.store_path("1hour", folder))
+		folder = os.path.join(root, "wide", str(n))
+		if not os.path.isfile(pt_memory.store_path("1hour", folder)):
+			print(f"[pt_bench] building {n} wide memories ...")
+			os.makedirs(folder, exist_ok=True)
+			build_memory_store(n, _rng(seed, f"wide:{n}"), width=pt_memory.MAX_PATTERN_WIDTH).save(pt_memory.store_path("1hour", folder))
+
+	candles = os.path.join(root, "candles")
+	if not os.path.isfile(pt_candles.store_path(FIXTURE_PAIR, "1week", candles)):
+		print("[pt_bench] building kline fixtures ...")
+		build_candles(candles, _rng(seed, "candles"))
+
+	coin = os.path.join(root, "coin")
+	if not os.path.isfile(os.path.join(coin, "trainer_last_training_time.txt")):
+		print("[pt_bench] building the thinker coin folder ...")
+		os.makedirs(coin, exist_ok=True)
+		for tf in pt_backtest.THINKER_TFS:
+			build_memory_store(COIN_MEMORIES, _rng(seed, f"coin:{tf}")).save(pt_memory.store_path(tf, coin))
+			with open(os.path.join(coin, f"neural_perfect_threshold_{tf}.txt"), "w", encoding="utf-8") as f:
+				f.write(str(KNN_THRESHOLD))
+		with open(os.path.join(coin, "trainer_last_training_time.txt"), "w", encoding="utf-8") as f:
+			f.write(str(FIXTURE_END))
+
+
+# -----------------------------
+# Measurement
+# -----------------------------
+
+def _measure(fn, budget=BENCH_BUDGET_SECONDS, min_iter=MIN_ITERATIONS, max_iter=MAX_ITERATIONS):
+	"""Call fn(i) until min_iter calls and `budget` seconds are done (or max_iter). Returns seconds per call."""
+	lat = []
+	deadline = time.perf_counter() + budget
+	while len(lat) < max_iter and (len(lat) < min_iter or time.perf_counter() < deadline):
+		t0 = time.perf_counter()
+		fn(len(lat))
+		lat.append(time.perf_counter() - t0)
+	return lat
+
+
+def _percentile(sorted_vals, q):
+	if not sorted_vals:
+		return None
+	k = min(len(sorted_vals) - 1, max(0, int(round(q * (len(sorted_vals) - 1)))))
+	return sorted_vals[k]
+
+
+def _peak_rss_mb():
+	try:
+		# VmHWM belongs to this address space; ru_maxrss on Linux survives exec and would report the parent's peak
+		with open("/proc/self/status", "r") as f:
+			for line in f:
+				if line.startswith("VmHWM:"):
+					return round(int(line.split()[1]) / 1024.0, 1)
+	except Exception:
+		pass
+	try:
+		import resource
+		peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+		return round(peak / (1024.0 * 1024.0) if sys.platform == "darwin" else peak / 1024.0, 1)  # bytes on macOS, KB elsewhere
+	except Exception:
+		pass
+	try:
+		import psutil
+		mi = psutil.Process().memory_info()
+		return round(getattr(mi, "peak_wset", mi.rss) / (1024.0 * 1024.0), 1)
+	except Exception:
+		return None
+
+
+def _quiet():
+	return contextlib.redirect_stdout(open(os.devnull, "w"))
+
+
+# -----------------------------
+# Benchmarks: fn(fixtures, scratch, params) -> (seconds per iteration, items per iteration, item unit)
+# -----------------------------
+
+def bench_memory_load(fx, scratch, params):
+	folder = os.path.join(fx, "memories", str(params["memories"]))
+	lat = _measure(lambda i: pt_memory.load_store("1hour", folder))
+	return lat, params["memories"], "memory"
+
+
+def _scratch_store(fx, scratch, n):
+	shutil.copy2(pt_memory.store_path("1hour", os.path.join(fx, "memories", str(n))), pt_memory.store_path("1hour", scratch))
+	store = pt_memory.load_store("1hour", scratch)
+	store.journal = pt_memory.MemoryJournal(pt_memory.journal_path("1hour", scratch), store.pattern_len, store.generation)
+	return store
+
+
+def bench_memory_flush(fx, scratch, params):
+	store = _scratch_store(fx, scratch, params["memories"])
+	rng = _rng(0, "flush")
+	n = len(store)
+
+	def flush(i):
+		store.set_weights([(rng.randrange(n), rng.uniform(-2.0, 2.0), rng.uniform(0.0, 2.0), rng.uniform(0.0, 2.0)) for _ in range(FLUSH_UPDATES)])
+		store.journal.write()
+
+	return _measure(flush), FLUSH_UPDATES, "update"
+
+
+def bench_memory_compact(fx, scratch, params):
+	store = _scratch_store(fx, scratch, params["memories"])
+	lat = _measure(lambda i: pt_memory.compact(store, "1hour", scratch))
+	return lat, params["memories"], "memory"
+
+
+def bench_knn_scan(fx, scratch, params):
+	store = pt_memory.load_store("1hour", os.path.join(fx, "memories", str(params["memories"])))
+	rng = _rng(0, "knn")
+	queries = [rng.gauss(0.0, 1.5) for _ in range(1000)]
+	pt_match.match_store([queries[0]], store, KNN_THRESHOLD, mode=params["mode"])  # builds the index outside the timing
+	lat = _measure(lambda i: pt_match.match_store([queries[i % len(queries)]], store, KNN_THRESHOLD, mode=params["mode"]))
+	return lat, 1, "scan"
+
+
+def bench_knn_lengths(fx, scratch, params):
+	store = pt_memory.load_store("1hour", os.path.join(fx, "wide", str(params["memories"])))
+	widths = [int(w) for w in params["widths"].split(",")]
+	rng = _rng(0, "knn.lengths")
+	queries = [[rng.gauss(0.0, 1.5) for _ in range(store.pattern_len)] for _ in range(1000)]
+	pt_match.match_lengths(queries[0], store, KNN_THRESHOLD, widths)  # index + kernel built outside the timing
+	lat = _measure(lambda i: pt_match.match_lengths(queries[i % len(queries)], store, KNN_THRESHOLD, widths))
+	return lat, 1, "scan"
+
+
+def _bench_env(scratch, fx, coins):
+	"""gui_settings.json + hub_data for a thinker/trader imported inside this benchmark process."""
+	settings_path = os.path.join(scratch, "gui_settings.json")
+	with open(settings_path, "w", encoding="utf-8") as f:
+		json.dump({"coins": list(coins), "main_neural_dir": os.path.join(scratch, "coin"), "market_stream": False, "signal_file_mirror": False}, f)
+	os.environ["POWERTRADER_GUI_SETTINGS"] = settings_path
+	os.environ["POWERTRADER_HUB_DIR"] = os.path.join(scratch, "hub_data")
+	os.environ["POWERTRADER_CANDLE_DIR"] = os.path.join(fx, "candles")
+
+
+def bench_thinker_sweep(fx, scratch, params):
+	shutil.copytree(os.path.join(fx, "coin"), os.path.join(scratch, "coin"))
+	_bench_env(scratch, fx, ["BTC"])
+	iters = MAX_ITERATIONS if not params["new_candle"] else min(MAX_ITERATIONS, FIXTURE_HOURS // 2)
+	clock = pt_backtest.SimClock(FIXTURE_END - 1 - (iters * 3600 if params["new_candle"] else 0))
+	with _quiet():
+		pt_thinker = importlib.import_module("pt_thinker")
+		for mod in (pt_thinker, pt_candles):
+			mod.time = clock
+		pt_thinker._signals = pt_backtest.ReplaySignals()
+		pt_thinker.BASE_DIR = os.path.join(scratch, "coin")
+		pt_thinker.current_ask = lambda sym: 100.0
+		pt_thinker.init_coin("BTC")
+		for _ in pt_thinker.tf_choices:
+			pt_thinker.step_coin("BTC")  # first sweep loads the memories
+
+		def sweep(i):
+			if params["new_candle"]:
+				clock.sleep(3600)
+			for _ in pt_thinker.tf_choices:
+				pt_thinker.step_coin("BTC")
+
+		lat = _measure(sweep, max_iter=iters)
+	return lat, 1, "sweep"
+
+
+def bench_trainer_epoch(fx, scratch, params):
+	folder = os.path.join(scratch, "train")
+	os.makedirs(folder)
+	os.environ["POWERTRADER_CANDLE_DIR"] = os.path.join(fx, "candles")
+	os.chdir(folder)
+	clock = pt_backtest.SimClock(FIXTURE_END - 1)
+	with _quiet():
+		pt_trainer = importlib.import_module("pt_trainer")
+		for mod in (pt_trainer, pt_candles):
+			mod.time = clock
+		ctx = pt_trainer.TrainContext("BTC", [params["tf"]], worker=True)
+
+		def epoch(i):
+			try:
+				pt_trainer.train(ctx)
+			except SystemExit:
+				pass
+
+		lat = _measure(epoch, min_iter=1, max_iter=1)
+	candles = len(pt_candles.get_store(FIXTURE_PAIR, params["tf"]).ts)
+	return lat, candles, "candle"
+
+
+def bench_trader_manage_trades(fx, scratch, params):
+	_bench_env(scratch, fx, TRADER_COINS)
+	os.chdir(scratch)
+	clock = pt_backtest.SimClock(FIXTURE_END)
+	exchange = pt_backtest.SimExchange(clock, 10000.0)
+	rng = _rng(0, "trader")
+	mids = {f"{c}-USD": 10.0 ** rng.uniform(-1.0, 4.0) for c in TRADER_COINS}
+	exchange.prices = dict(mids)
+	exchange.request("POST", pt_backtest.ORDERS_PATH, json.dumps({"symbol": "BTC-USD", "side": "buy", "market_order_config": {"asset_quantity": "0.01"}}))
+	signals = pt_backtest.ReplaySignals()
+	for c in TRADER_COINS:
+		mid = mids[f"{c}-USD"]
+		signals.publish(c, {"long": 1, "short": 0, "low_bounds": [mid * (1.0 - k / 100.0) for k in range(1, 8)]})
+	with _quiet():
+		pt_trader = importlib.import_module("pt_trader")
+		pt_trader.time = clock
+		pt_trader._signal_feed = signals
+		trader = pt_backtest._make_trader(pt_trader, exchange)
+
+		def tick(i):
+			clock.sleep(1.0)
+			exchange.prices = {s: p * (1.0 + rng.uniform(-0.001, 0.001)) for s, p in mids.items()}
+			trader.manage_trades()
+
+		lat = _measure(tick)
+	return lat, 1, "pass"
+
+
+BENCHMARKS = {
+	"memory.load": bench_memory_load,
+	"memory.flush": bench_memory_flush,
+	"memory.compact": bench_memory_compact,
+	"knn.scan": bench_knn_scan,
+	"knn.lengths": bench_knn_lengths,
+	"thinker.sweep": bench_thinker_sweep,
+	"trainer.epoch": bench_trainer_epoch,
+	"trader.manage_trades": bench_trader_manage_trades,
+}
+
+
+def _jobs(sizes, trainer_tf):
+	jobs = []
+	for n in sizes:
+		jobs.append(("memory.load", {"memories": n}))
+		jobs.append(("memory.flush", {"memories": n}))
+		jobs.append(("memory.compact", {"memories": n}))
+		for mode in ("index", "exact"):
+			jobs.append(("knn.scan", {"memories": n, "mode": mode}))
+		for widths in ("7", "1,3,7", "1,2,3,5,7"):
+			jobs.append(("knn.lengths", {"memories": n, "widths": widths}))
+	jobs.append(("thinker.sweep", {"memories": COIN_MEMORIES, "new_candle": False}))
+	jobs.append(("thinker.sweep", {"memories": COIN_MEMORIES, "new_candle": True}))
+	jobs.append(("trainer.epoch", {"tf": trainer_tf, "candles_1hour": FIXTURE_HOURS}))
+	jobs.append(("trader.manage_trades", {"coins": len(TRADER_COINS)}))
+	return jobs
+
+
+def run_job(job):
+	"""One benchmark in this (fresh) process. Returns its result dict."""
+	name, params, fx = job
+	scratch = tempfile.mkdtemp(prefix="pt_bench_")
+	cwd = os.getcwd()
+	result = {"name": name, "params": params}
+	try:
+		t0 = time.perf_counter()
+		lat, items, unit = BENCHMARKS[name](fx, scratch, params)
+		wall = time.perf_counter() - t0
+		s = sorted(lat)
+		total = sum(lat)
+		result.update({
+			"iterations": len(lat),
+			"unit": unit,
+			"throughput_per_s": round(items * len(lat) / total, 3) if total > 0 else None,
+			"latency_ms": {
+				"mean": round(total / len(lat) * 1000.0, 4),
+				"p50": round(_percentile(s, 0.50) * 1000.0, 4),
+				"p90": round(_percentile(s, 0.90) * 1000.0, 4),
+				"p99": round(_percentile(s, 0.99) * 1000.0, 4),
+				"max": round(s[-1] * 1000.0, 4),
+			},
+			"peak_rss_mb": _peak_rss_mb(),
+			"wall_s": round(wall, 3),
+		})
+	except Exception:
+		result["error"] = traceback.format_exc()
+	finally:
+		os.chdir(cwd)
+		shutil.rmtree(scratch, ignore_errors=True)
+	return result
+
+
+def _key(r):
+	return r["name"] + " " + json.dumps(r.get("params", {}), sort_keys=True)
+
+
+def _git_rev():
+	try:
+		out = subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=BASE_DIR, capture_output=True, text=True, timeout=10)
+		dirty = subprocess.run(["git", "status", "--porcelain", "--untracked-files=no"], cwd=BASE_DIR, capture_output=True, text=True, timeout=10)
+		return out.stdout.strip() + ("+dirty" if dirty.stdout.strip() else "") if out.returncode == 0 else None
+	except Exception:
+		return None
+
+
+def _print_result(r, old=None):
+	label = f"{r['name']} {' '.join(f'{k}={v}' for k, v in r['params'].items())}"
+	if "error" in r:
+		print(f"{label:<58} FAILED\n{r['error']}")
+		return
+	lat = r["latency_ms"]
+	line = (f"{label:<58} {r['throughput_per_s']:>14,.1f} {r['unit']}/s  p50 {lat['p50']:>10.3f} ms  p99 {lat['p99']:>10.3f} ms"
+		f"  rss {r['peak_rss_mb']} MB")
+	if old and "error" not in old:
+		line += f"  | p50 x{lat['p50'] / old['latency_ms']['p50']:.2f}" if old["latency_ms"]["p50"] else ""
+		line += f", throughput x{r['throughput_per_s'] / old['throughput_per_s']:.2f}" if old.get("throughput_per_s") else ""
+	print(line)
+
+
+def main(argv=None):
+	ap = argparse.ArgumentParser(description="Benchmark the trainer / thinker / trader hot paths on synthetic fixtures.")
+	ap.add_argument("--only", help="comma-separated benchmark name prefixes (memory, knn, thinker, trainer, trader, knn.scan, ...)")
+	ap.add_argument("--sizes", default=",".join(str(n) for n in DEFAULT_SIZES), help="memory counts for the memory.* / knn.* fixtures")
+	ap.add_argument("--trainer-tf", default=TRAINER_TF, help="timeframe trainer.epoch trains")
+	ap.add_argument("--seed", type=int, default=1)
+	ap.add_argument("--fixtures", help="fixture folder (default: <temp>/powertrader_bench_<seed>)")
+	ap.add_argument("--out", default="bench_results.json")
+	ap.add_argument("--compare", help="earlier results file to compare against")
+	args = ap.parse_args(argv)
+
+	sizes = [int(s) for s in args.sizes.split(",") if s.strip()]
+	fx = os.path.abspath(args.fixtures or os.path.join(tempfile.gettempdir(), f"powertrader_bench_{args.seed}"))
+	ensure_fixtures(fx, args.seed, sizes)
+
+	prefixes = [p.strip() for p in (args.only or "").split(",") if p.strip()]
+	jobs = [(name, params, fx) for name, params in _jobs(sizes, args.trainer_tf)
+		if not prefixes or any(name == p or name.startswith(p + ".") for p in prefixes)]
+
+	old = {}
+	if args.compare:
+		with open(args.compare, "r", encoding="utf-8") as f:
+			old = {_key(r): r for r in json.load(f).get("results", [])}
+
+	results = []
+	# one fresh process per benchmark, one at a time (no noisy neighbours, per-benchmark peak RSS)
+	ctx = multiprocessing.get_context("spawn")
+	with ctx.Pool(processes=1, maxtasksperchild=1) as pool:
+		for r in pool.imap(run_job, jobs):
+			results.append(r)
+			_print_result(r, old.get(_key(r)))
+
+	report = {
+		"schema": 1,
+		"created_at": datetime.datetime.now(tz=datetime.timezone.utc).isoformat(timespec="seconds"),
+		"git_rev": _git_rev(),
+		"python": platform.python_version(),
+		"platform": platform.platform(),
+		"cpu_count": os.cpu_count(),
+		"numpy": pt_match.HAVE_NUMPY,
+		"match_mode": pt_match.MATCH_MODE,
+		"seed": args.seed,
+		"fixtures": fx,
+		"results": results,
+	}
+	with open(args.out, "w", encoding="utf-8") as f:
+		json.dump(report, f, indent=2)
+	print(f"\n[pt_bench] wrote {os.path.abspath(args.out)}")
+	return 0 if all("error" not in r for r in results) else 1
+
+
+if __name__ == "__main__":
+	sys.exit(main())
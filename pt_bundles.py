@@ -0,0 +1,365 @@
+"""
+Trained-memory bundles, so the trainer can run on other machines than the live thinker.
+
+A bundle is one coin/timeframe's trained artifacts, versioned and checksummed:
+
+	<repo>/<COIN>/LATEST.json                           {tf: newest version}, replaced atomically
+	<repo>/<COIN>/<tf>/<version>/manifest.json
+	<repo>/<COIN>/<tf>/<version>/memories_<tf>.ptm       the store with its journal folded in
+	<repo>/<COIN>/<tf>/<version>/neural_perfect_threshold_<tf>.txt
+
+	manifest: {"format": 1, "coin", "tf", "version", "created_ts", "trained_at", "host",
+	           "generation", "memories", "files": {name: {"sha256", "size"}}}
+
+Training node: publish_coin() (or `pt_trainer.py <COIN> --publish <repo>`) builds a version
+in a hidden temp folder and renames it into place before LATEST.json points at it, so a reader
+never sees a partial bundle. Artifacts that didn't change since the last version publish
+nothing; the newest KEEP_VERSIONS of each timeframe are kept. One publisher per coin.
+
+Live node: the repo is either a folder (shared drive or rsync target: the training node pushes)
+or the http(s) URL of one (`pt_bundles.py serve <repo>` on the training node: the live node
+pulls). sync_coin() reads LATEST.json, downloads a newer version, and checks every file's size
+and sha256. Only then does it swap the files into the coin folder (tmp + os.replace, the store
+last) and drop the old journal. The thinker's memory cache sees the new store signature and
+reloads on that coin's next step. Installs are recorded in <coin folder>/bundles_installed.json;
+an older bundle never replaces a newer install.
+
+CLI:
+	python pt_bundles.py publish <repo> <main_neural_dir> COIN [COIN ...]
+	python pt_bundles.py pull <repo or url> <main_neural_dir> COIN [COIN ...]
+	python pt_bundles.py list <repo or url> COIN [COIN ...]
+	python pt_bundles.py serve <repo> [--host H] [--port P]
+"""
+import os
+import sys
+import json
+import time
+import shutil
+import socket
+import hashlib
+import threading
+import urllib.request
+
+import pt_memory
+
+FORMAT = 1
+KEEP_VERSIONS = 3
+LATEST_FILE = "LATEST.json"
+MANIFEST_FILE = "manifest.json"
+INSTALLED_FILE = "bundles_installed.json"
+TRAINING_TIME_FILE = "trainer_last_training_time.txt"
+FETCH_TIMEOUT_SECONDS = 30.0
+POLL_SECONDS = 60.0
+SERVE_PORT = 8766
+
+
+def coin_folder(main_dir: str, coin: str) -> str:
+	"""Same convention as the thinker: BTC lives in the main neural folder, other coins in a sub-folder."""
+	coin = coin.upper()
+	return main_dir if coin == "BTC" else os.path.join(main_dir, coin)
+
+
+def threshold_name(tf: str) -> str:
+	return f"neural_perfect_threshold_{tf}.txt"
+
+
+def _sha256(data: bytes) -> str:
+	return hashlib.sha256(data).hexdigest()
+
+
+def _atomic_write(path: str, data: bytes) -> None:
+	tmp = path + ".tmp"
+	with open(tmp, "wb") as f:
+		f.write(data)
+		f.flush()
+		os.fsync(f.fileno())
+	os.replace(tmp, path)
+	pt_memory.fsync_dir(path)
+
+
+def _read_json(path: str, default=None):
+	try:
+		with open(path, "r", encoding="utf-8") as f:
+			return json.load(f)
+	except Exception:
+		return default
+
+
+def _read_training_time(folder: str) -> int:
+	try:
+		with open(os.path.join(folder, TRAINING_TIME_FILE), "r") as f:
+			return int(float(f.read().strip()))
+	except Exception:
+		return 0
+
+
+# -----------------------------
+# Publishing (training node)
+# -----------------------------
+
+def _artifacts(folder: str, tf: str):
+	"""({file name: bytes}, store) of one timeframe's trained state, or (None, None) if untrained."""
+	store = pt_memory.load_store(tf, folder)
+	if len(store) == 0:
+		return None, None
+	files = {os.path.basename(pt_memory.store_path(tf)): store.to_bytes()}
+	try:
+		with open(os.path.join(folder, threshold_name(tf)), "rb") as f:
+			files[threshold_name(tf)] = f.read()
+	except OSError:
+		pass
+	return files, store
+
+
+def publish(repo: str, folder: str, coin: str, tf: str, trained_at: int = None):
+	"""
+	Publish `folder`'s current artifacts for coin/tf into `repo`. Returns the new version, or
+	None when nothing changed since the latest one (or there is nothing trained).
+	"""
+	coin = coin.upper()
+	files, store = _artifacts(folder, tf)
+	if files is None:
+		return None
+	coin_dir = os.path.join(repo, coin)
+	tf_dir = os.path.join(coin_dir, tf)
+	latest = _read_json(os.path.join(coin_dir, LATEST_FILE), {}) or {}
+	sums = {name: {"sha256": _sha256(data), "size": len(data)} for name, data in files.items()}
+	prev = _read_json(os.path.join(tf_dir, str(latest.get(tf, "")), MANIFEST_FILE), {}) or {}
+	if prev.get("files") == sums:
+		return None
+
+	now = time.time()
+	digest = _sha256("".join(sums[n]["sha256"] for n in sorted(sums)).encode())
+	version = f"{int(now * 1000):013d}-{digest[:8]}"
+	manifest = {
+		"format": FORMAT,
+		"coin": coin,
+		"tf": tf,
+		"version": version,
+		"created_ts": now,
+		"trained_at": int(trained_at if trained_at is not None else _read_training_time(folder)),
+		"host": socket.gethostname(),
+		"generation": int(store.generation),
+		"memories": len(store),
+		"files": sums,
+	}
+	os.makedirs(tf_dir, exist_ok=True)
+	tmp_dir = os.path.join(tf_dir, "." + version + ".tmp")
+	os.makedirs(tmp_dir, exist_ok=True)
+	for name, data in files.items():
+		with open(os.path.join(tmp_dir, name), "wb") as f:
+			f.write(data)
+	with open(os.path.join(tmp_dir, MANIFEST_FILE), "w", encoding="utf-8") as f:
+		json.dump(manifest, f, indent=2)
+	os.replace(tmp_dir, os.path.join(tf_dir, version))
+
+	latest = _read_json(os.path.join(coin_dir, LATEST_FILE), {}) or {}
+	latest[tf] = version
+	_atomic_write(os.path.join(coin_dir, LATEST_FILE), json.dumps(latest, indent=2).encode())
+
+	keep = set(sorted(v for v in os.listdir(tf_dir) if not v.startswith("."))[-KEEP_VERSIONS:]) | {version}
+	for old in os.listdir(tf_dir):
+		if old not in keep and not old.startswith("."):
+			shutil.rmtree(os.path.join(tf_dir, old), ignore_errors=True)
+	return version
+
+
+def publish_coin(repo: str, folder: str, coin: str, tfs=None, trained_at: int = None) -> dict:
+	"""publish() for every timeframe; {tf: version} of the ones that produced a new version."""
+	out = {}
+	for tf in (tfs or pt_memory.TF_CHOICES):
+		try:
+			version = publish(repo, folder, coin, tf, trained_at)
+			if version:
+				out[tf] = version
+		except Exception as e:
+			print(f"[pt_bundles] publish {coin} {tf} failed: {e}")
+	return out
+
+
+# -----------------------------
+# Subscribing (live node)
+# -----------------------------
+
+def _is_url(source: str) -> bool:
+	return str(source).startswith(("http://", "https://"))
+
+
+def _fetch(source: str, *parts) -> bytes:
+	if _is_url(source):
+		url = source.rstrip("/") + "/" + "/".join(urllib.request.quote(p) for p in parts)
+		with urllib.request.urlopen(url, timeout=FETCH_TIMEOUT_SECONDS) as resp:
+			return resp.read()
+	with open(os.path.join(source, *parts), "rb") as f:
+		return f.read()
+
+
+def latest_versions(source: str, coin: str) -> dict:
+	"""{tf: version} the repo currently offers for `coin` ({} if none / unreachable)."""
+	try:
+		return json.loads(_fetch(source, coin.upper(), LATEST_FILE).decode("utf-8")) or {}
+	except Exception:
+		return {}
+
+
+def installed(folder: str) -> dict:
+	return _read_json(os.path.join(folder, INSTALLED_FILE), {}) or {}
+
+
+def install(source: str, folder: str, coin: str, tf: str, version: str) -> bool:
+	"""
+	Download, verify and swap in one bundle. Nothing in `folder` changes unless every file
+	matches its manifest. Returns True if it was installed.
+	"""
+	coin = coin.upper()
+	manifest = json.loads(_fetch(source, coin, tf, version, MANIFEST_FILE).decode("utf-8"))
+	if manifest.get("format") != FORMAT or manifest.get("tf") != tf or manifest.get("coin") != coin:
+		raise ValueError(f"bundle {coin}/{tf}/{version}: unexpected manifest")
+	have = installed(folder).get(tf) or {}
+	if float(manifest.get("created_ts", 0.0)) <= float(have.get("created_ts", 0.0)):
+		return False  # never roll back to an older bundle
+
+	store_name = os.path.basename(pt_memory.store_path(tf))
+	files = {}
+	for name, meta in (manifest.get("files") or {}).items():
+		if os.path.basename(name) != name:
+			raise ValueError(f"bundle {coin}/{tf}/{version}: bad file name {name!r}")
+		data = _fetch(source, coin, tf, version, name)
+		if len(data) != int(meta.get("size", -1)) or _sha256(data) != meta.get("sha256"):
+			raise ValueError(f"bundle {coin}/{tf}/{version}: checksum mismatch on {name}")
+		files[name] = data
+	if store_name not in files:
+		raise ValueError(f"bundle {coin}/{tf}/{version}: no {store_name}")
+
+	os.makedirs(folder, exist_ok=True)
+	# the store goes last: the thinker reloads on its signature, by then the threshold is in place
+	for name in sorted(files, key=lambda n: n == store_name):
+		_atomic_write(os.path.join(folder, name), files[name])
+	# the local journal / prune remap belonged to the replaced store
+	for stale in (pt_memory.journal_path(tf, folder), pt_memory.remap_path(tf, folder)):
+		try:
+			os.remove(stale)
+		except OSError:
+			pass
+
+	trained_at = int(manifest.get("trained_at", 0) or 0)
+	if trained_at > _read_training_time(folder):
+		_atomic_write(os.path.join(folder, TRAINING_TIME_FILE), str(trained_at).encode())
+
+	record = installed(folder)
+	record[tf] = {
+		"version": version,
+		"created_ts": manifest.get("created_ts"),
+		"host": manifest.get("host"),
+		"memories": manifest.get("memories"),
+		"installed_ts": time.time(),
+	}
+	_atomic_write(os.path.join(folder, INSTALLED_FILE), json.dumps(record, indent=2).encode())
+	return True
+
+
+def sync_coin(source: str, folder: str, coin: str) -> list:
+	"""Install every timeframe whose offered version differs from the installed one; returns those tfs."""
+	done = []
+	have = installed(folder)
+	for tf, version in sorted(latest_versions(source, coin).items()):
+		if tf not in pt_memory.TF_CHOICES or (have.get(tf) or {}).get("version") == version:
+			continue
+		try:
+			if install(source, folder, coin, tf, str(version)):
+				done.append(tf)
+		except Exception as e:
+			print(f"[pt_bundles] {coin} {tf} {version}: {e}")
+	return done
+
+
+class Subscriber:
+	"""
+	Daemon thread that keeps the live node's coin folders on the newest bundles.
+	source() / coins() / folder(coin) / interval() are re-read every round, so settings
+	changes apply without a restart; a falsy source() pauses it.
+	"""
+
+	def __init__(self, source, coins, folder, interval=lambda: POLL_SECONDS):
+		self._source = source
+		self._coins = coins
+		self._folder = folder
+		self._interval = interval
+		self._stop = threading.Event()
+		self._thread = None
+
+	def start(self) -> None:
+		if self._thread is None:
+			self._thread = threading.Thread(target=self._run, name="bundle-subscriber", daemon=True)
+			self._thread.start()
+
+	def stop(self) -> None:
+		self._stop.set()
+
+	def _run(self) -> None:
+		while not self._stop.is_set():
+			try:
+				source = self._source()
+				if source:
+					for coin in list(self._coins()):
+						for tf in sync_coin(source, self._folder(coin), coin):
+							print(f"[pt_bundles] installed {coin} {tf} from {source}")
+			except Exception as e:
+				print(f"[pt_bundles] sync failed: {e}")
+			try:
+				wait = max(1.0, float(self._interval()))
+			except Exception:
+				wait = POLL_SECONDS
+			self._stop.wait(wait)
+
+
+# -----------------------------
+# CLI
+# -----------------------------
+
+def serve(repo: str, host: str = "127.0.0.1", port: int = SERVE_PORT) -> None:
+	"""Read-only HTTP view of `repo` for live nodes that pull (use --host 0.0.0.0 to expose it)."""
+	import functools
+	import http.server
+	handler = functools.partial(http.server.SimpleHTTPRequestHandler, directory=os.path.abspath(repo))
+	httpd = http.server.ThreadingHTTPServer((host, int(port)), handler)
+	print(f"[pt_bundles] serving {os.path.abspath(repo)} on http://{host}:{port}/")
+	httpd.serve_forever()
+
+
+def _main(argv: list) -> int:
+	if len(argv) < 2 or argv[0] not in ("publish", "pull", "list", "serve"):
+		print(__doc__)
+		return 2
+	cmd, repo = argv[0], argv[1]
+	if cmd == "serve":
+		host, port = "127.0.0.1", SERVE_PORT
+		args = list(argv[2:])
+		while args:
+			a = args.pop(0)
+			if a == "--host" and args:
+				host = args.pop(0)
+			elif a == "--port" and args:
+				port = int(args.pop(0))
+		serve(repo, host, port)
+		return 0
+	if cmd == "list":
+		for coin in [c.upper() for c in argv[2:]]:
+			print(f"{coin}: {json.dumps(latest_versions(repo, coin), sort_keys=True)}")
+		return 0
+	if len(argv) < 4:
+		print(__doc__)
+		return 2
+	main_dir = argv[2]
+	for coin in [c.upper() for c in argv[3:]]:
+		if cmd == "publish":
+			done = publish_coin(repo, coin_folder(main_dir, coin), coin)
+			print(f"{coin}: published {', '.join(f'{tf} {v}' for tf, v in done.items()) if done else 'nothing new'}")
+		else:
+			done = sync_coin(repo, coin_folder(main_dir, coin), coin)
+			print(f"{coin}: installed {', '.join(done) if done else 'nothing new'}")
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(_main(sys.argv[1:]))
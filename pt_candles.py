@@ -0,0 +1,591 @@
+"""
+Shared on-disk KuCoin candle store for pt_trainer.py, pt_thinker.py and pt_hub.py.
+
+One file per (pair, timeframe) in the candle store folder (POWERTRADER_CANDLE_DIR, default
+<project folder>/candle_store):
+
+	candles_<PAIR>_<tf>.ptc
+
+Layout (little-endian):
+
+	header (64 bytes)
+		magic        8s   b"PTCANDLE"
+		version      u32
+		tf_seconds   u32
+		known_from   i64  the store has every candle from here up to its last row
+		                  (lower than the first row when KuCoin had nothing there)
+		pair         24s
+		flags        u32  FLAG_HISTORY_START: KuCoin has nothing older than known_from
+		reserved     12 bytes
+
+	rows (56 bytes each, sorted by ts, one per candle)
+		ts i64, open, close, high, low, volume, turnover (f64)
+
+New candles are appended; the newest row (the candle that was still open when it was
+fetched) is overwritten in place when it gets re-fetched. Only backfilling older history
+rewrites the file (tmp + os.replace). Writers serialize on <file>.lock; readers never lock
+and simply ignore a partially written trailing row.
+
+get_kline() is a drop-in for kucoin Market.get_kline(): it answers from the store and only
+downloads the candles the store doesn't have yet. With a live source (set_live_source, see
+pt_stream.py) the open candle is served from the stream instead of being re-downloaded.
+download_history() backfills a pair's whole history, HISTORY_WORKERS pages at a time.
+
+Every KuCoin request takes a token from one bucket shared by all processes using the same
+candle store folder (trainer workers, thinker, hub): RATE_PER_SECOND sustained, RATE_BURST
+at once, state in <candle store>/kucoin_rate.json under its own lock file. A rate-limit
+answer (429) drains the bucket and pauses everyone for RATE_LIMITED_PAUSE_SECONDS.
+"""
+import os
+import json
+import time
+import struct
+import bisect
+import threading
+from concurrent.futures import ThreadPoolExecutor
+
+import pt_metrics
+
+TF_SECONDS = {
+	"1min": 60, "5min": 300, "15min": 900, "30min": 1800,
+	"1hour": 3600, "2hour": 7200, "4hour": 14400, "8hour": 28800, "12hour": 43200,
+	"1day": 86400, "1week": 604800,
+}
+
+MAGIC = b"PTCANDLE"
+VERSION = 1
+HEADER_STRUCT = struct.Struct("<8sIIq24sI12x")
+FLAG_HISTORY_START = 1
+HEADER_SIZE = HEADER_STRUCT.size  # 64
+ROW_STRUCT = struct.Struct("<q6d")
+ROW_SIZE = ROW_STRUCT.size  # 56
+
+PAGE_ROWS = 1500  # KuCoin returns at most 1500 candles per request
+RATE_FILE = "kucoin_rate.json"
+RATE_PER_SECOND = 8.0  # KuCoin requests per second, for all processes together
+RATE_BURST = 8.0
+RATE_LIMITED_PAUSE_SECONDS = 10.0
+HISTORY_WORKERS = 4  # pages download_history() fetches concurrently
+LOCK_TIMEOUT_SECONDS = 30.0
+LOCK_STALE_SECONDS = 120.0
+
+
+def candle_dir() -> str:
+	d = os.environ.get("POWERTRADER_CANDLE_DIR") or os.path.join(os.path.dirname(os.path.abspath(__file__)), "candle_store")
+	os.makedirs(d, exist_ok=True)
+	return d
+
+
+def store_path(pair: str, tf: str, folder: str = None) -> str:
+	return os.path.join(folder or candle_dir(), f"candles_{pair.upper()}_{tf}.ptc")
+
+
+class _FileLock:
+	"""Cross-process lock via O_EXCL lockfile (works the same on Windows and Linux)."""
+
+	def __init__(self, path: str, timeout: float = LOCK_TIMEOUT_SECONDS):
+		self.path = path
+		self.timeout = timeout
+		self._fd = None
+
+	def __enter__(self):
+		deadline = time.time() + self.timeout
+		while True:
+			try:
+				self._fd = os.open(self.path, os.O_CREAT | os.O_EXCL | os.O_WRONLY)
+				os.write(self._fd, str(os.getpid()).encode())
+				return self
+			except FileExistsError:
+				try:
+					if time.time() - os.path.getmtime(self.path) > LOCK_STALE_SECONDS:
+						os.remove(self.path)  # left behind by a killed process
+						continue
+				except OSError:
+					pass
+				if time.time() >= deadline:
+					raise TimeoutError(f"candle store busy: {self.path}")
+				time.sleep(0.05)
+
+	def __exit__(self, *exc):
+		try:
+			os.close(self._fd)
+		except Exception:
+			pass
+		try:
+			os.remove(self.path)
+		except OSError:
+			pass
+		return False
+
+
+def _parse_row(row):
+	"""KuCoin kline row [time, open, close, high, low, volume, turnover] -> tuple of numbers."""
+	vals = [float(x) for x in list(row)[:7]]
+	while len(vals) < 7:
+		vals.append(0.0)
+	return (int(vals[0]),) + tuple(vals[1:])
+
+
+def _format_row(r):
+	return [str(r[0])] + [repr(float(x)) for x in r[1:]]
+
+
+class CandleStore:
+	"""
+	Cached view of one .ptc file. Rows live in RAM (self.ts + self.rows) and are refreshed
+	by re-reading only the tail when the file grows, or everything when it was rewritten.
+	One view is shared by the threads of a process (get_store), so refresh(), merge() and
+	window() hold self._lock: a refresh trims and re-reads the tail in place.
+	"""
+
+	def __init__(self, pair: str, tf: str, folder: str = None):
+		self.pair = pair.upper()
+		self.tf = tf
+		self.tf_seconds = TF_SECONDS.get(tf, 3600)
+		self.path = store_path(self.pair, tf, folder)
+		self.ts = []
+		self.rows = []
+		self.known_from = None
+		self.flags = 0
+		self._sig = None
+		self._lock = threading.RLock()
+
+	# ---- reading ----
+
+	def _stat(self):
+		try:
+			st = os.stat(self.path)
+			return (st.st_ino, st.st_mtime_ns, st.st_size)
+		except OSError:
+			return None
+
+	def refresh(self) -> None:
+		with self._lock:
+			self._refresh()
+
+	def _refresh(self) -> None:
+		sig = self._stat()
+		if sig == self._sig:
+			return
+		if sig is None:
+			self.ts, self.rows, self.known_from, self.flags, self._sig = [], [], None, 0, None
+			return
+		with open(self.path, "rb") as f:
+			hdr = f.read(HEADER_SIZE)
+			if len(hdr) < HEADER_SIZE:
+				self.ts, self.rows, self.known_from, self.flags, self._sig = [], [], None, 0, sig
+				return
+			magic, version, tf_seconds, known_from, _pair, flags = HEADER_STRUCT.unpack(hdr)
+			if magic != MAGIC:
+				raise ValueError(f"not a PowerTrader candle store: {self.path}")
+			same_file = self._sig is not None and self._sig[0] == sig[0] and sig[2] >= self._sig[2] and self.rows
+			if same_file:
+				# append-only (+ last row overwrite): re-read from the old last row onward
+				start = len(self.rows) - 1
+				del self.ts[start:]
+				del self.rows[start:]
+			else:
+				start = 0
+				self.ts, self.rows = [], []
+			f.seek(HEADER_SIZE + start * ROW_SIZE)
+			raw = f.read()
+		usable = len(raw) - (len(raw) % ROW_SIZE)
+		for r in ROW_STRUCT.iter_unpack(raw[:usable]):
+			self.ts.append(r[0])
+			self.rows.append(r)
+		self.known_from = known_from
+		self.flags = flags
+		self._sig = sig
+
+	def history_start_known(self) -> bool:
+		return bool(self.flags & FLAG_HISTORY_START)
+
+	def first_ts(self):
+		return self.ts[0] if self.ts else None
+
+	def last_ts(self):
+		return self.ts[-1] if self.ts else None
+
+	def window(self, start_at=None, end_at=None, limit=PAGE_ROWS) -> list:
+		"""Rows with start_at <= ts <= end_at, newest first (KuCoin order), at most `limit`."""
+		with self._lock:
+			lo = 0 if start_at is None else bisect.bisect_left(self.ts, int(start_at))
+			hi = len(self.ts) if end_at is None else bisect.bisect_right(self.ts, int(end_at))
+			out = self.rows[lo:hi][::-1]
+		return out[:limit] if limit else out
+
+	# ---- writing (caller holds the lock) ----
+
+	def _write_header(self, f, known_from, flags) -> None:
+		f.seek(0)
+		f.write(HEADER_STRUCT.pack(MAGIC, VERSION, self.tf_seconds, int(known_from), self.pair.encode()[:24], int(flags)))
+
+	def _rewrite(self, rows, known_from, flags) -> None:
+		tmp = self.path + ".tmp"
+		with open(tmp, "wb") as f:
+			self._write_header(f, known_from, flags)
+			f.write(b"".join(ROW_STRUCT.pack(*r) for r in rows))
+		os.replace(tmp, self.path)
+
+	def merge(self, new_rows, known_from=None, history_start=False) -> None:
+		"""
+		Merge downloaded rows into the file (append / last-row overwrite / backfill rewrite).
+		history_start: KuCoin has nothing older than known_from (sets FLAG_HISTORY_START).
+		"""
+		with self._lock:
+			self._merge(new_rows, known_from, history_start)
+
+	def _merge(self, new_rows, known_from, history_start) -> None:
+		self._refresh()
+		rows = {}
+		for r in new_rows:
+			rows[r[0]] = r
+		if not rows and not self.rows:
+			return
+		first, last = self.first_ts(), self.last_ts()
+		if known_from is None:
+			known_from = self.known_from
+		flags = self.flags | (FLAG_HISTORY_START if history_start else 0)
+		if not self.rows or any(t < first for t in rows):
+			merged = dict((r[0], r) for r in self.rows)
+			merged.update(rows)
+			ordered = [merged[t] for t in sorted(merged)]
+			kf = ordered[0][0] if ordered else 0
+			if known_from is not None:
+				kf = min(kf, known_from)
+			self._rewrite(ordered, kf, flags)
+			self._sig = None
+			self.refresh()
+			return
+
+		newer = [rows[t] for t in sorted(rows) if t > last]
+		with open(self.path, "r+b") as f:
+			if last in rows:
+				f.seek(HEADER_SIZE + (len(self.rows) - 1) * ROW_SIZE)
+				f.write(ROW_STRUCT.pack(*rows[last]))
+			if newer:
+				f.seek(HEADER_SIZE + len(self.rows) * ROW_SIZE)
+				f.write(b"".join(ROW_STRUCT.pack(*r) for r in newer))
+			if (known_from is not None and known_from < self.known_from) or flags != self.flags:
+				self._write_header(f, min(known_from, self.known_from) if known_from is not None else self.known_from, flags)
+		# mtime granularity can hide our own in-place writes: force a tail re-read
+		self._sig = (self._sig[0], None, self._sig[2])
+		self.refresh()
+
+
+_stores = {}  # (pair, tf) -> CandleStore, one cached view per process
+_stores_lock = threading.Lock()
+
+
+def get_store(pair: str, tf: str) -> CandleStore:
+	key = (pair.upper(), tf)
+	with _stores_lock:
+		st = _stores.get(key)
+		if st is None:
+			st = CandleStore(pair, tf)
+			_stores[key] = st
+	st.refresh()
+	return st
+
+
+class TokenBucket:
+	"""
+	Request limiter shared across processes: {"tokens", "ts", "paused_until"} in a JSON file,
+	read-modify-written under a _FileLock. Threads of one process queue on a local lock
+	first, so only one of them polls the file at a time. If the file can't be locked or read
+	the process falls back to pacing itself at `rate`.
+	"""
+
+	def __init__(self, path: str, rate: float = RATE_PER_SECOND, burst: float = RATE_BURST):
+		self.path = path
+		self.rate = max(0.01, float(rate))
+		self.burst = max(1.0, float(burst))
+		self._lock = threading.Lock()
+		self._local_next = 0.0
+
+	def _read(self, now):
+		try:
+			with open(self.path, "r", encoding="utf-8") as f:
+				s = json.load(f) or {}
+			return float(s.get("tokens", self.burst)), float(s.get("ts", now)), float(s.get("paused_until", 0.0))
+		except Exception:
+			return self.burst, now, 0.0
+
+	def _write(self, tokens, ts, paused_until) -> None:
+		with open(self.path, "w", encoding="utf-8") as f:
+			json.dump({"tokens": tokens, "ts": ts, "paused_until": paused_until}, f)
+
+	def _take(self) -> float:
+		"""Takes a token and returns 0, or returns how long to wait before asking again."""
+		try:
+			with _FileLock(self.path + ".lock", timeout=5.0):
+				now = time.time()
+				tokens, ts, paused_until = self._read(now)
+				if now < paused_until:
+					return paused_until - now
+				tokens = min(self.burst, tokens + max(0.0, now - ts) * self.rate)
+				if tokens >= 1.0:
+					self._write(tokens - 1.0, now, paused_until)
+					return 0.0
+				self._write(tokens, now, paused_until)
+				return (1.0 - tokens) / self.rate
+		except Exception:
+			now = time.time()
+			wait = self._local_next - now
+			if wait <= 0:
+				self._local_next = now + 1.0 / self.rate
+			return max(0.0, wait)
+
+	def acquire(self) -> None:
+		with self._lock:
+			waited = False
+			while True:
+				wait = self._take()
+				if wait <= 0:
+					break
+				waited = True
+				time.sleep(min(wait, 1.0))
+			if waited:
+				pt_metrics.incr("kline_rate_waits")
+
+	def pause(self, seconds: float) -> None:
+		"""Empties the bucket and holds every process off for `seconds` (after a 429)."""
+		try:
+			with _FileLock(self.path + ".lock", timeout=5.0):
+				now = time.time()
+				_tokens, _ts, paused_until = self._read(now)
+				self._write(0.0, now, max(paused_until, now + float(seconds)))
+		except Exception:
+			self._local_next = time.time() + float(seconds)
+
+
+_limiter = None
+_limiter_lock = threading.Lock()
+
+
+def limiter() -> TokenBucket:
+	global _limiter
+	with _limiter_lock:
+		if _limiter is None:
+			_limiter = TokenBucket(os.path.join(candle_dir(), RATE_FILE), RATE_PER_SECOND, RATE_BURST)
+		return _limiter
+
+
+def _rate_limited(exc) -> bool:
+	text = str(exc)
+	return "429" in text or "Too Many Requests" in text
+
+
+def _fetch(market, pair, tf, start_at, end_at) -> list:
+	limiter().acquire()
+	try:
+		with pt_metrics.timer("kline_fetch"):
+			raw = market.get_kline(pair, tf, startAt=int(start_at), endAt=int(end_at))
+	except Exception as e:
+		pt_metrics.incr("kline_fetch_errors")
+		if _rate_limited(e):
+			limiter().pause(RATE_LIMITED_PAUSE_SECONDS)
+		raise
+	return [_parse_row(r) for r in (raw or [])]
+
+
+_live = None  # optional pt_stream.KucoinStream: pushes the still-open candle
+
+
+def set_live_source(source) -> None:
+	"""Serve the open candle from `source.live_candle(pair, tf)` (None = REST only)."""
+	global _live
+	_live = source
+
+
+def _live_row(pair, tf):
+	if _live is None:
+		return None
+	try:
+		return _live.live_candle(pair, tf)
+	except Exception:
+		return None
+
+
+def _overlay_live(rows: list, pair: str, tf: str, end_at=None) -> list:
+	"""Newest-first rows with the stored open candle replaced by its live version."""
+	live = _live_row(pair, tf)
+	if live is None or not rows or rows[0][0] != live[0]:
+		return rows
+	if end_at is not None and live[0] > int(end_at):
+		return rows
+	return [live] + rows[1:]
+
+
+def _needs_recent(st: CandleStore, now: float, max_age) -> bool:
+	last = st.last_ts()
+	if last is None:
+		return True
+	# a newer candle has opened since the newest stored one -> the stored "open" candle is final now
+	if now >= last + st.tf_seconds:
+		return True
+	# the stream keeps the open candle current, no need to re-download it
+	live = _live_row(st.pair, st.tf)
+	if live is not None and live[0] == last:
+		return False
+	if max_age is not None:
+		try:
+			return (now - os.path.getmtime(st.path)) > max_age
+		except OSError:
+			return True
+	return False
+
+
+def top_up(market, pair: str, tf: str, start_at=None, max_age=None) -> CandleStore:
+	"""
+	Make sure the store for (pair, tf) holds every candle from start_at (default: the last
+	page) up to now, downloading only what's missing.
+
+	max_age: also re-fetch the still-open newest candle when the store is older than this many
+	seconds (charts want a live last candle; the trainer/thinker only use closed ones).
+	"""
+	st = get_store(pair, tf)
+	now = time.time()
+	sec = st.tf_seconds
+	need_recent = _needs_recent(st, now, max_age)
+	need_old = start_at is not None and st.first_ts() is not None and int(start_at) < min(st.first_ts(), st.known_from if st.known_from is not None else st.first_ts())
+	if not need_recent and not need_old:
+		pt_metrics.incr("kline_cache_hits")
+		return st
+	pt_metrics.incr("kline_cache_misses")
+
+	with _FileLock(st.path + ".lock"):
+		st.refresh()  # someone else may have downloaded it while we waited for the lock
+
+		if _needs_recent(st, now, max_age):
+			last = st.last_ts()
+			start = last if last is not None else int(now) - PAGE_ROWS * sec
+			if last is None and start_at is not None:
+				start = max(int(start_at), start)
+			while True:
+				end = min(int(now), start + (PAGE_ROWS - 1) * sec)
+				rows = _fetch(market, pair, tf, start, end)
+				st.merge(rows)
+				if end >= int(now) or not rows:
+					break
+				start = max(end, st.last_ts() or end)
+
+		while start_at is not None and st.first_ts() is not None:
+			floor = min(st.first_ts(), st.known_from if st.known_from is not None else st.first_ts())
+			if int(start_at) >= floor:
+				break
+			end = floor
+			start = max(int(start_at), end - (PAGE_ROWS - 1) * sec)
+			rows = [r for r in _fetch(market, pair, tf, start, end) if r[0] < st.first_ts()]
+			# nothing older than what we have in this range: remember it so we never ask again
+			st.merge(rows, known_from=start)
+	return st
+
+
+def get_kline(market, pair: str, tf: str, startAt=None, endAt=None, max_age=None, limit=PAGE_ROWS) -> list:
+	"""
+	Drop-in for kucoin Market.get_kline(pair, tf, startAt=, endAt=): newest-first rows of
+	[time, open, close, high, low, volume, turnover] strings, at most `limit` (1500, like
+	KuCoin), served from the shared store (topped up first).
+	"""
+	now = int(time.time())
+	end_at = now if endAt is None else min(int(endAt), now)
+	st = top_up(market, pair, tf, start_at=startAt, max_age=max_age)
+	rows = _overlay_live(st.window(startAt, end_at, max(1, min(int(limit), PAGE_ROWS))), pair, tf, end_at)
+	return [_format_row(r) for r in rows]
+
+
+def download_history(market, pair: str, tf: str, stop_at=None, workers: int = HISTORY_WORKERS, progress=None) -> CandleStore:
+	"""
+	Top up (pair, tf), then backfill it back to the start of KuCoin's data (or to stop_at).
+	Each wave fetches `workers` disjoint PAGE_ROWS windows concurrently (every request still
+	goes through the shared TokenBucket) and merges them in one backfill. A wave whose oldest
+	window comes back empty is where KuCoin's history starts: FLAG_HISTORY_START is set, so
+	later calls return without asking. Missing candles inside the history only lower
+	known_from and the walk goes on. progress(n_candles) is called after every wave.
+
+	A failed window re-raises once the newer windows of its wave are merged, so a retry
+	resumes where this one stopped.
+	"""
+	st = top_up(market, pair, tf)
+	sec = st.tf_seconds
+	workers = max(1, int(workers))
+	with ThreadPoolExecutor(max_workers=workers) as pool:
+		while True:
+			with _FileLock(st.path + ".lock"):
+				st.refresh()
+				first = st.first_ts()
+				if first is None:
+					break  # KuCoin has nothing for this pair
+				if st.history_start_known():
+					break  # already know where KuCoin's history starts
+				floor = min(first, st.known_from if st.known_from is not None else first)
+				if stop_at is not None and floor <= int(stop_at):
+					break
+
+				windows = []
+				end = floor - sec
+				while len(windows) < workers and (stop_at is None or end >= int(stop_at)):
+					start = end - (PAGE_ROWS - 1) * sec
+					if stop_at is not None:
+						start = max(start, int(stop_at))
+					windows.append((start, end))
+					end = start - sec
+				if not windows:
+					break
+
+				futures = [pool.submit(_fetch, market, pair, tf, s, e) for s, e in windows]
+				rows, known_from, error, exhausted = [], None, None, False
+				for (s, e), fut in zip(windows, futures):  # newest window first
+					try:
+						got = fut.result()
+					except Exception as exc:
+						error = exc
+						break
+					rows.extend(r for r in got if s <= r[0] <= e)
+					known_from = s
+					exhausted = not got  # only the oldest window fetched decides: a gap in between is not the start
+				for fut in futures:
+					fut.cancel()
+				exhausted = exhausted and error is None
+				if known_from is not None:
+					st.merge(rows, known_from=known_from, history_start=exhausted)
+			if progress is not None:
+				try:
+					progress(len(st.ts))
+				except Exception:
+					pass
+			if error is not None:
+				raise error
+			if exhausted:
+				break
+	return st
+
+
+def recent(market, pair: str, tf: str, limit: int = 120, max_age=None) -> list:
+	"""Newest `limit` candles oldest->newest as tuples (ts, open, close, high, low, volume, turnover)."""
+	st = top_up(market, pair, tf, max_age=max_age)
+	rows = _overlay_live(st.window(None, None, limit), pair, tf)
+	rows.reverse()
+	return rows
+
+
+class RestMarket:
+	"""Minimal KuCoin REST stand-in for kucoin.client.Market (used when kucoin-python isn't installed)."""
+
+	def __init__(self, url: str = "https://api.kucoin.com", session=None):
+		import requests
+		self.url = url.rstrip("/")
+		self._session = session or requests.Session()
+
+	def get_kline(self, symbol, kline_type, startAt=None, endAt=None):
+		params = {"symbol": symbol, "type": kline_type}
+		if startAt is not None:
+			params["startAt"] = int(startAt)
+		if endAt is not None:
+			params["endAt"] = int(endAt)
+		resp = self._session.get(self.url + "/api/v1/market/candles", params=params, timeout=10)
+		j = resp.json()
+		if str(j.get("code", "200000")) != "200000":
+			raise Exception(str(j.get("msg") or j))
+		return j.get("data", [])
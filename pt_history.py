@@ -0,0 +1,440 @@
+"""
+Account value history: the trader's raw log, its tiered rollups, and incremental readers.
+
+Files in hub_data/ (all JSONL, one object per line):
+
+	account_value_history.jsonl     raw, one row per trader loop: {"ts": <unix>, "total_account_value": <usd>}
+	account_value_history.1.jsonl   the previous raw file; the raw log rotates after RAW_MAX_AGE_SECONDS
+	                                or RAW_MAX_BYTES, so the last day is always there at full resolution
+	account_value_1min.jsonl        {"ts": <bucket start>, "min": .., "max": .., "last": ..}, kept 7 days
+	account_value_1hour.jsonl       same per hour, kept 400 days
+	account_value_1day.jsonl        same per UTC day, kept forever (one row a day)
+
+AccountValueRecorder (pt_trader.py) appends a rollup row when its bucket closes; the open
+bucket of every tier lives in RAM and is rebuilt from the raw log on restart. A tier file
+that doesn't exist yet is backfilled from whatever raw history is on disk, so the first
+start after an upgrade rolls up the old, never-rotated log before rotating it. A tier is
+rewritten (tmp + os.replace) only once it holds TRIM_SLACK more than its retention, so the
+files stay bounded without a rewrite per bucket.
+
+AccountValueHistory (pt_hub.py) tails every file (JsonlTail: only appended lines are parsed)
+and stitches one series from the coarsest tier for old history down to the raw rows of the
+current minute, so any range comes out of RAM.
+"""
+import os
+import json
+import math
+import bisect
+from typing import Any, Iterator, List, Optional, Tuple
+
+RAW_FILE = "account_value_history.jsonl"
+RAW_ROTATED_FILE = "account_value_history.1.jsonl"
+RAW_MAX_AGE_SECONDS = 24 * 60 * 60
+RAW_MAX_BYTES = 32 * 1024 * 1024
+TIERS = (  # name, bucket seconds, retention seconds (None = forever)
+	("1min", 60, 7 * 24 * 60 * 60),
+	("1hour", 3600, 400 * 24 * 60 * 60),
+	("1day", 86400, None),
+)
+TRIM_SLACK = 0.1
+JSONL_READ_CHUNK_BYTES = 1 << 20
+READER_RAW_CAP = 10000  # raw points the reader keeps while there is no 1min tier to fall back on
+
+
+def raw_path(folder: str) -> str:
+	return os.path.join(folder, RAW_FILE)
+
+
+def rotated_path(folder: str) -> str:
+	return os.path.join(folder, RAW_ROTATED_FILE)
+
+
+def tier_path(folder: str, tier: str) -> str:
+	return os.path.join(folder, f"account_value_{tier}.jsonl")
+
+
+class JsonlTail:
+	"""
+	Incremental reader for an append-only .jsonl file (trade_history.jsonl,
+	account_value_history.jsonl). Remembers the byte offset and only parses lines appended
+	since the last call. A partial last line (trader mid-write) waits for the next call; a
+	replaced or truncated file is read again from the start.
+	"""
+
+	def __init__(self, path: str):
+		self.path = path
+		self.offset = 0
+		self._ident: Optional[Tuple[int, int]] = None
+
+	def read_new(self) -> Tuple[bool, Iterator[Any]]:
+		"""
+		(reset, objects): reset=True means drop what you had (the objects then start from the
+		top of the file). `objects` yields the JSON values of the newly completed lines; it
+		reads in JSONL_READ_CHUNK_BYTES pieces, so a huge first read never sits in RAM at once.
+		Consume it before the next call.
+		"""
+		try:
+			st = os.stat(self.path)
+		except OSError:
+			reset = self._ident is not None
+			self._ident, self.offset = None, 0
+			return reset, iter(())
+
+		reset = False
+		ident = (st.st_dev, st.st_ino)
+		if ident != self._ident or st.st_size < self.offset:
+			reset = self._ident is not None or self.offset > 0
+			self._ident, self.offset = ident, 0
+		if st.st_size == self.offset:
+			return reset, iter(())
+		return reset, self._objects(st.st_size)
+
+	def _objects(self, size: int) -> Iterator[Any]:
+		try:
+			f = open(self.path, "rb")
+		except OSError:
+			return
+		with f:
+			f.seek(self.offset)
+			pos = self.offset
+			buf = b""
+			while pos < size:
+				chunk = f.read(min(JSONL_READ_CHUNK_BYTES, size - pos))
+				if not chunk:
+					break
+				pos += len(chunk)
+				buf += chunk
+				end = buf.rfind(b"\n")
+				if end < 0:
+					continue
+				lines, buf = buf[:end], buf[end + 1:]
+				self.offset = pos - len(buf)
+				for ln in lines.split(b"\n"):
+					ln = ln.strip()
+					if not ln:
+						continue
+					try:
+						yield json.loads(ln)
+					except Exception:
+						continue
+
+
+def lttb(points: List[Tuple[float, float]], n_out: int) -> List[Tuple[float, float]]:
+	"""
+	Largest-Triangle-Three-Buckets downsampling of time-sorted (ts, value) points to n_out.
+	Buckets span equal TIME (not equal point counts), so a series that is dense in one
+	stretch and sparse in another still comes out evenly spaced. First and last points are
+	always kept.
+	"""
+	n = len(points)
+	if n <= n_out or n <= 2:
+		return list(points)
+	if n_out < 3:
+		return [points[0], points[-1]]
+
+	n_buckets = n_out - 2
+	t0 = points[0][0]
+	span = (points[-1][0] - t0) / float(n_buckets)
+	if span <= 0.0:
+		return [points[0], points[-1]]
+
+	# [start, end) index ranges of the non-empty buckets over points[1:-1]
+	ranges: List[Tuple[int, int]] = []
+	start = 1
+	cur = min(n_buckets - 1, int((points[1][0] - t0) / span))
+	for i in range(2, n - 1):
+		b = min(n_buckets - 1, int((points[i][0] - t0) / span))
+		if b != cur:
+			ranges.append((start, i))
+			start, cur = i, b
+	ranges.append((start, n - 1))
+
+	avgs = []
+	for s, e in ranges:
+		cnt = float(e - s)
+		avgs.append((sum(p[0] for p in points[s:e]) / cnt, sum(p[1] for p in points[s:e]) / cnt))
+	avgs.append(points[-1])
+
+	out = [points[0]]
+	ax, ay = points[0]
+	for k, (s, e) in enumerate(ranges):
+		cx, cy = avgs[k + 1]
+		best, best_area = s, -1.0
+		for i in range(s, e):
+			px, py = points[i]
+			area = abs((ax - cx) * (py - ay) - (ax - px) * (cy - ay))
+			if area > best_area:
+				best, best_area = i, area
+		out.append(points[best])
+		ax, ay = points[best]
+	out.append(points[-1])
+	return out
+
+
+def _raw_point(obj):
+	"""(ts, value) of a raw row, or None for anything unusable (missing, non-finite, <= 0)."""
+	try:
+		tsf = float(obj.get("ts"))
+		vf = float(obj.get("total_account_value"))
+	except Exception:
+		return None
+	if (not math.isfinite(tsf)) or (not math.isfinite(vf)) or (vf <= 0.0):
+		return None
+	return tsf, vf
+
+
+def _insert_point(pts: list, pt) -> None:
+	"""Keep `pts` chronological with one point per timestamp (the latest occurrence wins)."""
+	if not pts or pt[0] > pts[-1][0]:
+		pts.append(pt)
+		return
+	i = bisect.bisect_left(pts, (pt[0], float("-inf")))
+	if i < len(pts) and pts[i][0] == pt[0]:
+		pts[i] = pt
+	else:
+		pts.insert(i, pt)
+
+
+def _iter_jsonl(path: str):
+	try:
+		with open(path, "r", encoding="utf-8") as f:
+			for ln in f:
+				ln = ln.strip()
+				if not ln:
+					continue
+				try:
+					yield json.loads(ln)
+				except Exception:
+					continue
+	except OSError:
+		return
+
+
+def _first_last_ts(path: str):
+	"""Bucket starts of the first and last rows of a tier file ((None, None) if empty/missing)."""
+	first = last = None
+	try:
+		with open(path, "rb") as f:
+			for ln in f:
+				try:
+					first = int(json.loads(ln)["ts"])
+					break
+				except Exception:
+					continue
+			f.seek(0, os.SEEK_END)
+			size = f.tell()
+			f.seek(max(0, size - 4096))
+			for ln in reversed(f.read().splitlines()):
+				try:
+					last = int(json.loads(ln)["ts"])
+					break
+				except Exception:
+					continue
+	except OSError:
+		pass
+	return first, last
+
+
+class AccountValueRecorder:
+	"""Writes the raw log and the rollup tiers (the trader's only account history writer)."""
+
+	def __init__(self, folder: str):
+		self.folder = folder
+		self.raw_path = raw_path(folder)
+		self._open = {}         # tier -> [bucket start, min, max, last]
+		self._first = {}        # tier -> oldest bucket start on disk
+		self._last_closed = {}  # tier -> newest bucket start on disk
+		self._raw_first_ts = None
+		try:
+			self._bootstrap()
+		except Exception:
+			pass
+
+	def _bootstrap(self) -> None:
+		for name, _sec, _keep in TIERS:
+			self._first[name], self._last_closed[name] = _first_last_ts(tier_path(self.folder, name))
+		pending = {name: [] for name, _sec, _keep in TIERS}
+		last_ts = None
+		for path in (rotated_path(self.folder), self.raw_path):
+			for obj in _iter_jsonl(path):
+				pt = _raw_point(obj) if isinstance(obj, dict) else None
+				if pt is None:
+					continue
+				if path == self.raw_path and self._raw_first_ts is None:
+					self._raw_first_ts = pt[0]
+				self._feed(pt[0], pt[1], pending)
+				last_ts = pt[0] if last_ts is None else max(last_ts, pt[0])
+		self._write_closed(pending)
+		if last_ts is not None:
+			self._maintain(last_ts)
+
+	def _feed(self, ts: float, value: float, pending: dict) -> None:
+		for name, sec, _keep in TIERS:
+			start = int(ts // sec) * sec
+			closed = self._last_closed.get(name)
+			if closed is not None and start <= closed:
+				continue  # that bucket is on disk already (restart / backfill overlap)
+			b = self._open.get(name)
+			if b is not None and start != b[0]:
+				if start < b[0]:
+					continue  # a late row for a bucket that's already behind us
+				pending[name].append(b)
+				self._last_closed[name] = b[0]
+				if self._first.get(name) is None:
+					self._first[name] = b[0]
+				b = None
+			if b is None:
+				self._open[name] = [start, value, value, value]
+			else:
+				if value < b[1]:
+					b[1] = value
+				if value > b[2]:
+					b[2] = value
+				b[3] = value
+
+	def _write_closed(self, pending: dict) -> bool:
+		wrote = False
+		for name, rows in pending.items():
+			if not rows:
+				continue
+			try:
+				with open(tier_path(self.folder, name), "a", encoding="utf-8") as f:
+					for start, lo, hi, last in rows:
+						f.write(json.dumps({"ts": start, "min": lo, "max": hi, "last": last}) + "\n")
+				wrote = True
+			except Exception:
+				pass
+		return wrote
+
+	def record(self, ts: float, value: float) -> None:
+		"""Roll one value into every tier (bucket rows are written as buckets close), then append the raw row."""
+		pt = _raw_point({"ts": ts, "total_account_value": value})
+		if pt is not None:
+			pending = {name: [] for name, _sec, _keep in TIERS}
+			self._feed(pt[0], pt[1], pending)
+			if self._write_closed(pending):
+				self._maintain(pt[0])  # at most once a minute; rotating first keeps this row in the new file
+			if self._raw_first_ts is None:
+				self._raw_first_ts = pt[0]
+		try:
+			with open(self.raw_path, "a", encoding="utf-8") as f:
+				f.write(json.dumps({"ts": ts, "total_account_value": value}) + "\n")
+		except Exception:
+			pass
+
+	def _maintain(self, now: float) -> None:
+		# raw log rotation (age or size)
+		try:
+			too_old = self._raw_first_ts is not None and (now - self._raw_first_ts) >= RAW_MAX_AGE_SECONDS
+			if too_old or os.path.getsize(self.raw_path) >= RAW_MAX_BYTES:
+				os.replace(self.raw_path, rotated_path(self.folder))
+				self._raw_first_ts = None
+		except Exception:
+			pass  # missing file, or Windows refusing while a reader has it open: next minute
+
+		# tier retention
+		for name, _sec, keep in TIERS:
+			first = self._first.get(name)
+			if keep is None or first is None or first >= now - keep * (1.0 + TRIM_SLACK):
+				continue
+			path = tier_path(self.folder, name)
+			cutoff = now - keep
+			try:
+				rows = [r for r in _iter_jsonl(path) if isinstance(r, dict) and float(r.get("ts", 0)) >= cutoff]
+				tmp = f"{path}.tmp"
+				with open(tmp, "w", encoding="utf-8") as f:
+					for r in rows:
+						f.write(json.dumps(r) + "\n")
+				os.replace(tmp, path)
+				self._first[name] = int(rows[0]["ts"]) if rows else None
+			except Exception:
+				pass
+
+
+class AccountValueHistory:
+	"""
+	Incremental reader for the hub: every tier file plus the raw rows that no closed 1min
+	bucket covers yet, all tailed (JsonlTail). series() stitches them into one (ts, value)
+	list: day rows for the oldest history, then hour, then minute rows, then raw points.
+	Rollup rows are placed at their bucket's end with their `last` value.
+	"""
+
+	def __init__(self, folder: str):
+		self.folder = folder
+		self._tails = {name: JsonlTail(tier_path(folder, name)) for name, _sec, _keep in TIERS}
+		self._rows = {name: [] for name, _sec, _keep in TIERS}  # tier -> [(bucket start, min, max, last)]
+		self._raw_tail = JsonlTail(raw_path(folder))
+		self._raw = []
+		self._series = None
+
+	def poll(self) -> bool:
+		"""Read what was appended anywhere; True if the series changed."""
+		changed = False
+		for name, _sec, _keep in TIERS:
+			reset, objs = self._tails[name].read_new()
+			rows = self._rows[name]
+			if reset:
+				rows.clear()
+				changed = True
+			for obj in objs:
+				try:
+					row = (int(obj["ts"]), float(obj["min"]), float(obj["max"]), float(obj["last"]))
+				except Exception:
+					continue
+				if rows and row[0] <= rows[-1][0]:
+					i = bisect.bisect_left(rows, (row[0],))
+					if i < len(rows) and rows[i][0] == row[0]:
+						rows[i] = row
+					else:
+						rows.insert(i, row)
+				else:
+					rows.append(row)
+				changed = True
+
+		reset, objs = self._raw_tail.read_new()
+		if reset:
+			self._raw = []
+			changed = True
+		for obj in objs:
+			pt = _raw_point(obj) if isinstance(obj, dict) else None
+			if pt is not None:
+				_insert_point(self._raw, pt)
+				changed = True
+
+		# raw points a closed 1min bucket already covers aren't needed any more
+		minutes = self._rows[TIERS[0][0]]
+		if minutes:
+			covered = minutes[-1][0] + TIERS[0][1]
+			drop = bisect.bisect_left(self._raw, (covered, float("-inf")))
+			if drop:
+				del self._raw[:drop]
+		elif len(self._raw) > READER_RAW_CAP:
+			self._raw = lttb(self._raw, READER_RAW_CAP // 2)  # no rollups yet (older trader): stay bounded
+
+		if changed:
+			self._series = None
+		return changed
+
+	def series(self, start=None, end=None) -> list:
+		"""The stitched (ts, value) series, optionally limited to start <= ts <= end."""
+		if self._series is None:
+			parts = []
+			finer_first = self._raw[0][0] if self._raw else float("inf")
+			for name, sec, _keep in TIERS:
+				rows = self._rows[name]
+				# only buckets that end before the finer data starts (no overlap between tiers)
+				cut = bisect.bisect_right(rows, (finer_first - sec, float("inf")))
+				parts.append([(r[0] + sec, r[3]) for r in rows[:cut]])
+				if cut:
+					finer_first = rows[0][0]
+			series = []
+			for part in reversed(parts):
+				series.extend(part)
+			series.extend(self._raw)
+			self._series = series
+		s = self._series
+		if start is None and end is None:
+			return s
+		i = 0 if start is None else bisect.bisect_left(s, (float(start), float("-inf")))
+		j = len(s) if end is None else bisect.bisect_right(s, (float(end), float("inf")))
+		return s[i:j]
@@ -7,9 +7,11 @@ import math
 import queue
 import threading
 import subprocess
+import concurrent.futures
 import shutil
 import glob
 import bisect
+from collections import deque
 from dataclasses import dataclass
 from typing import Any, Dict, List, Optional, Tuple
 import tkinter as tk
@@ -17,10 +19,14 @@ import tkinter.font as tkfont
 from tkinter import ttk, filedialog, messagebox
 from matplotlib.figure import Figure
 from matplotlib.backends.backend_tkagg import FigureCanvasTkAgg
+from matplotlib.collections import LineCollection, PolyCollection
 from matplotlib.patches import Rectangle
 from matplotlib.ticker import FuncFormatter
 from matplotlib.transforms import blended_transform_factory
 
+import pt_metrics
+import pt_history
+
 DARK_BG = "#070B10"
 DARK_BG2 = "#0B1220"
 DARK_PANEL = "#0E1626"
@@ -331,6 +337,25 @@ DEFAULT_SETTINGS = {
     "script_neural_trainer": "pt_trainer.py",
     "script_trader": "pt_trader.py",
     "auto_start_scripts": False,
+    "trainer_parallel_timeframes": False,  # train each timeframe of a coin in its own worker process
+    "trainer_incremental": False,  # retrain from the trainer's checkpoints (only new candles) instead of from scratch
+    "trainer_max_concurrent": 2,  # max trainer jobs (coins) running at once; 0 = no limit
+    "trainer_core_budget": 0,  # CPU cores shared by running trainer jobs (parallel timeframes); 0 = all cores
+    "thinker_max_workers": 4,  # coins the thinker steps at once (read by pt_thinker.py at startup)
+    "trader_api_pool_size": 10,  # keep-alive connections in the trader's Robinhood session (read at startup)
+    "memory_prune_floor_updates": 0,  # trainer drops memories stuck at the weight floor this many updates (0 = keep)
+    "memory_merge_distance": 0.0,  # trainer merges memories whose patterns differ by <= this % (0 = off)
+    "memory_max_per_timeframe": 0,  # cap on memories per timeframe after training (0 = no cap)
+    "memory_match_mode": "index",  # trainer/thinker memory matching: index | exact | verify (see pt_match.py)
+    "memory_match_recall": 1.0,  # multi-candle patterns only: 1.0 = exact, lower = faster but may miss matches
+    "trainer_pattern_lengths": "2",  # candles per pattern (comma list, 2-9); several = matched together and ensembled (new memories only)
+    "market_stream": False,  # thinker/trader follow KuCoin's WebSocket feed (needs websocket-client); Robinhood quotes stay authoritative
+    "signal_file_mirror": True,  # thinker also writes the per-coin signal/bound text files (the hub's charts and tiles read them)
+    "metrics_enabled": True,  # thinker/trader/trainers record hot-path timers + counters to hub_data/metrics_*.json (read at startup)
+    "metrics_port": 0,  # serve those metrics Prometheus-style on http://127.0.0.1:<port>/metrics (0 = off)
+    "bundle_publish_dir": "",  # training node: finished trainer runs publish memory bundles here (pt_bundles.py); blank = off
+    "bundle_source": "",  # live node: folder or http(s) URL the thinker installs new memory bundles from; blank = off
+    "bundle_poll_seconds": 60.0,  # how often the thinker checks bundle_source
 }
 
 
@@ -344,6 +369,14 @@ DEFAULT_SETTINGS = {
 
 
 SETTINGS_FILE = "gui_settings.json"
+METRICS_PANEL_REFRESH_SECONDS = 2.0
+TRADE_LIST_ROWS = 250  # newest trades shown in the Trade History list
+HUB_LOADER_WORKERS = 4  # background threads for the hub's file reads / candle downloads
+LOADER_PUMP_MS = 50     # how often the Tk thread applies finished background loads
+
+
+# timeframes pt_trainer.py trains (and checkpoints) for every coin
+TRAINER_TIMEFRAMES = ("1hour", "2hour", "4hour", "8hour", "12hour", "1day", "1week")
 
 
 def _safe_read_json(path: str) -> Optional[dict]:
@@ -361,30 +394,59 @@ def _safe_write_json(path: str, data: dict) -> None:
     os.replace(tmp, path)
 
 
+class AccountValueSeries:
+    """
+    The account value chart's data: pt_history.AccountValueHistory (rollup tiers + the raw
+    rows of the current minute, tailed incrementally), downsampled to the chart's n points
+    with LTTB and cached until new data arrives. Memory and redraw cost stay fixed however
+    long the trader has been running.
+    """
+
+    def __init__(self, history_path: str):
+        self.history = pt_history.AccountValueHistory(os.path.dirname(os.path.abspath(history_path)))
+        self._view: Optional[Tuple[int, List[Tuple[float, float]]]] = None
+
+    def poll(self) -> bool:
+        """Read what was appended; True if the series changed."""
+        changed = self.history.poll()
+        if changed:
+            self._view = None
+        return changed
+
+    def points(self, n: int) -> List[Tuple[float, float]]:
+        if self._view is None or self._view[0] != n:
+            self._view = (n, pt_history.lttb(self.history.series(), n))
+        return self._view[1]
+
+
+# trade_history.jsonl readers, shared by every chart and the history list (path -> reader + rows)
+_trade_history_cache: Dict[str, Tuple[pt_history.JsonlTail, List[dict]]] = {}
+_trade_history_lock = threading.Lock()  # callers run on the background loader threads
+
+
 def _read_trade_history_jsonl(path: str) -> List[dict]:
     """
     Reads hub_data/trade_history.jsonl written by pt_trader.py.
-    Returns a list of dicts (only buy/sell rows).
+    Returns a list of dicts (only buy/sell rows). Parsed incrementally; the rows are shared
+    between callers, so treat them as read-only.
     """
-    out: List[dict] = []
-    try:
-        if os.path.isfile(path):
-            with open(path, "r", encoding="utf-8") as f:
-                for ln in f:
-                    ln = ln.strip()
-                    if not ln:
-                        continue
-                    try:
-                        obj = json.loads(ln)
-                        side = str(obj.get("side", "")).lower().strip()
-                        if side not in ("buy", "sell"):
-                            continue
-                        out.append(obj)
-                    except Exception:
-                        continue
-    except Exception:
-        pass
-    return out
+    with _trade_history_lock:
+        entry = _trade_history_cache.get(path)
+        if entry is None:
+            entry = (pt_history.JsonlTail(path), [])
+            _trade_history_cache[path] = entry
+        tail, rows = entry
+        reset, objs = tail.read_new()
+        if reset:
+            rows.clear()
+        for obj in objs:
+            try:
+                side = str(obj.get("side", "")).lower().strip()
+                if side in ("buy", "sell"):
+                    rows.append(obj)
+            except Exception:
+                continue
+        return list(rows)
 
 
 def _ensure_dir(path: str) -> None:
@@ -457,6 +519,19 @@ def _now_str() -> str:
     return time.strftime("%Y-%m-%d %H:%M:%S")
 
 
+def _pattern_lengths(raw: Any) -> str:
+    """trainer_pattern_lengths normalized to what pt_trainer.py --pattern-lengths takes ("2,3,5")."""
+    out = set()
+    for tok in str(raw or "").replace(" ", ",").split(","):
+        try:
+            n = int(float(tok))
+        except Exception:
+            continue
+        if 2 <= n <= 9:
+            out.add(n)
+    return ",".join(str(n) for n in sorted(out)) or "2"
+
+
 # -----------------------------
 # Neural folder detection
 # -----------------------------
@@ -573,7 +648,9 @@ def read_short_signal(folder: str) -> int:
 
 class CandleFetcher:
     """
-    Uses kucoin-python if available; otherwise falls back to KuCoin REST via requests.
+    Reads through the shared candle store (pt_candles.py) that the trainer/thinker also fill,
+    so charts only download the newest candles. Uses kucoin-python if available; otherwise
+    falls back to KuCoin REST via requests.
     """
     def __init__(self):
         self._mode = "kucoin_client"
@@ -589,11 +666,39 @@ class CandleFetcher:
             import requests  # local import
             self._requests = requests
 
+        # market object the candle store downloads through (None = store unavailable)
+        self._store_market = None
+        try:
+            import pt_candles  # type: ignore
+            self._candles = pt_candles
+            self._store_market = self._market if self._market is not None else pt_candles.RestMarket()
+        except Exception:
+            self._candles = None
+
         # Small in-memory cache to keep timeframe switching snappy.
         # key: (pair, timeframe, limit) -> (saved_time_epoch, candles)
         self._cache: Dict[Tuple[str, str, int], Tuple[float, List[dict]]] = {}
         self._cache_ttl_seconds: float = 10.0
 
+        # Widest fresh window per coin/timeframe, shared across limits so a candles_limit
+        # change or a second consumer slices it instead of downloading again.
+        # key: (pair, timeframe) -> (saved_time_epoch, candles)
+        self._latest: Dict[Tuple[str, str], Tuple[float, List[dict]]] = {}
+
+    def _remember(self, pair: str, timeframe: str, limit: int, now: float, candles: List[dict]) -> List[dict]:
+        """
+        Cache a fresh result. Hands back the previously cached list object when the content
+        is unchanged, so charts can tell "nothing new" with an identity check.
+        """
+        prev = self._cache.get((pair, timeframe, limit))
+        if prev and prev[1] == candles:
+            candles = prev[1]
+        self._cache[(pair, timeframe, limit)] = (now, candles)
+
+        latest = self._latest.get((pair, timeframe))
+        if (not latest) or (now - float(latest[0])) > float(self._cache_ttl_seconds) or len(candles) >= len(latest[1]):
+            self._latest[(pair, timeframe)] = (now, candles)
+        return candles
 
     def get_klines(self, symbol: str, timeframe: str, limit: int = 120) -> List[dict]:
         """
@@ -612,6 +717,10 @@ class CandleFetcher:
         if cached and (now - float(cached[0])) <= float(self._cache_ttl_seconds):
             return cached[1]
 
+        latest = self._latest.get((pair, timeframe))
+        if limit and latest and (now - float(latest[0])) <= float(self._cache_ttl_seconds) and len(latest[1]) >= limit:
+            return self._remember(pair, timeframe, limit, float(latest[0]), latest[1][-limit:])
+
         # rough window (timeframe-dependent) so we get enough candles
         tf_seconds = {
             "1min": 60, "5min": 300, "15min": 900, "30min": 1800,
@@ -622,6 +731,21 @@ class CandleFetcher:
         end_at = int(now)
         start_at = end_at - (tf_seconds * max(200, (limit + 50) if limit else 250))
 
+        if self._candles is not None and self._store_market is not None:
+            try:
+                rows = self._candles.recent(
+                    self._store_market, pair, timeframe,
+                    limit=(limit or 250), max_age=self._cache_ttl_seconds,
+                )
+                candles = [
+                    {"ts": int(r[0]), "open": float(r[1]), "high": float(r[3]), "low": float(r[4]), "close": float(r[2])}
+                    for r in rows
+                ]
+                if candles:
+                    return self._remember(pair, timeframe, limit, now, candles)
+            except Exception:
+                pass  # fall back to a direct download below
+
         if self._mode == "kucoin_client" and self._market is not None:
             try:
                 # IMPORTANT: limit the server response by passing startAt/endAt.
@@ -643,8 +767,7 @@ class CandleFetcher:
                 if limit and len(candles) > limit:
                     candles = candles[-limit:]
 
-                self._cache[cache_key] = (now, candles)
-                return candles
+                return self._remember(pair, timeframe, limit, now, candles)
             except Exception:
                 return []
 
@@ -664,8 +787,7 @@ class CandleFetcher:
             if limit and len(candles) > limit:
                 candles = candles[-limit:]
 
-            self._cache[cache_key] = (now, candles)
-            return candles
+            return self._remember(pair, timeframe, limit, now, candles)
         except Exception:
             return []
 
@@ -779,6 +901,7 @@ class CandleChart(ttk.Frame):
 
                 dpi = float(self.fig.get_dpi() or 100.0)
                 self.fig.set_size_inches(w / dpi, h / dpi, forward=True)
+                self._bg = None  # blit background no longer matches the canvas size
 
                 # Debounce redraws during live resize
                 if self._resize_after_id:
@@ -800,6 +923,19 @@ class CandleChart(ttk.Frame):
 
         self._last_refresh = 0.0
 
+        # Persistent artists: refresh() updates these in place instead of clearing and re-plotting.
+        # Everything that moves every tick (forming candle, bid/ask/avg/DCA/trail lines and their
+        # labels) is "animated" so it can be blitted over a cached background of the rest.
+        self._build_artists()
+        self._bg = None              # canvas background (everything except the animated artists)
+        self._static_sig = None      # what the background was drawn from
+        self._overlay_sig = None     # what the animated artists were last set to
+        self._candles_ref = None     # candle list the candle artists were built from (fetcher keeps identity)
+        self._candles_key = None
+        self._deferred_refresh = None
+        self.canvas.mpl_connect("draw_event", self._on_draw)
+        self.bind("<Map>", self._on_map, add="+")
+
 
     def _apply_dark_chart_style(self) -> None:
         """Apply dark styling (called on init and after every ax.clear())."""
@@ -813,307 +949,267 @@ class CandleChart(ttk.Frame):
         except Exception:
             pass
 
-    def refresh(
-        self,
-        coin_folders: Dict[str, str],
-        current_buy_price: Optional[float] = None,
-        current_sell_price: Optional[float] = None,
-        trail_line: Optional[float] = None,
-        dca_line_price: Optional[float] = None,
-        avg_cost_basis: Optional[float] = None,
-    ) -> None:
-
-
-
-        cfg = self.settings_getter()
-
-        tf = self.timeframe_var.get().strip()
-        limit = int(cfg.get("candles_limit", 120))
-
-        candles = self.fetcher.get_klines(self.coin, tf, limit=limit)
-
-        folder = coin_folders.get(self.coin, "")
-        low_path = os.path.join(folder, "low_bound_prices.html")
-        high_path = os.path.join(folder, "high_bound_prices.html")
-
-        # --- Cached neural reads (per path, by mtime) ---
-        if not hasattr(self, "_neural_cache"):
-            self._neural_cache = {}  # path -> (mtime, value)
-
-        def _cached(path: str, loader, default):
-            try:
-                mtime = os.path.getmtime(path)
-            except Exception:
-                return default
-            hit = self._neural_cache.get(path)
-            if hit and hit[0] == mtime:
-                return hit[1]
-            v = loader(path)
-            self._neural_cache[path] = (mtime, v)
-            return v
-
-        long_levels = _cached(low_path, read_price_levels_from_html, []) if folder else []
-        short_levels = _cached(high_path, read_price_levels_from_html, []) if folder else []
+    def _build_artists(self) -> None:
+        ax = self.ax
+        trans = blended_transform_factory(ax.transAxes, ax.transData)
+
+        # Closed candles: one collection for all wicks, one for all bodies
+        self._wicks = LineCollection([], linewidths=1)
+        self._bodies = PolyCollection([], linewidths=1, alpha=0.9)
+        ax.add_collection(self._wicks, autolim=False)
+        ax.add_collection(self._bodies, autolim=False)
+
+        # Forming (last) candle
+        self._live_wick = ax.plot([], [], linewidth=1, color="green", animated=True)[0]
+        self._live_body = Rectangle((0.0, 0.0), 0.7, 0.0, linewidth=1, alpha=0.9, animated=True, visible=False)
+        ax.add_patch(self._live_body)
+
+        # Neural levels (blue long, orange short) as full-width segments in axes-x / data-y
+        self._long_levels = LineCollection([], linewidths=1, colors="blue", alpha=0.8, transform=trans)
+        self._short_levels = LineCollection([], linewidths=1, colors="orange", alpha=0.8, transform=trans)
+        ax.add_collection(self._long_levels, autolim=False)
+        ax.add_collection(self._short_levels, autolim=False)
+
+        # Trade dots, one marker line per colour, plus a reusable pool of annotations
+        self._trade_dots = {
+            color: ax.plot([], [], linestyle="none", marker="o", markersize=6, color=color, zorder=6)[0]
+            for color in ("red", "purple", "green")
+        }
+        self._trade_notes: List[Any] = []
+
+        # Price lines + right-side labels, in label order (Ask=buy line, Bid=sell line)
+        self._price_lines: Dict[str, Tuple[Any, Any]] = {}
+        for tag, color in (("ASK", "purple"), ("BID", "teal"), ("AVG", "yellow"), ("DCA", "red"), ("SELL", "green")):
+            line = ax.axhline(y=0.0, linewidth=1.5, color=color, alpha=0.95, animated=True, visible=False)
+            label = ax.text(
+                1.01,
+                0.0,
+                "",
+                transform=trans,
+                ha="left",
+                va="center",
+                fontsize=8,
+                color=color,
+                bbox=dict(
+                    facecolor=DARK_BG2,
+                    edgecolor=color,
+                    boxstyle="round,pad=0.18",
+                    alpha=0.85,
+                ),
+                zorder=20,
+                clip_on=False,
+                animated=True,
+                visible=False,
+            )
+            self._price_lines[tag] = (line, label)
 
-        long_sig_path = os.path.join(folder, "long_dca_signal.txt")
-        long_sig = _cached(long_sig_path, read_int_from_file, 0) if folder else 0
-        short_sig = read_short_signal(folder) if folder else 0
+        self._animated = [self._live_wick, self._live_body]
+        for line, label in self._price_lines.values():
+            self._animated.extend((line, label))
 
-        # --- Avoid full ax.clear() (expensive). Just clear artists. ---
+    def _on_draw(self, _event) -> None:
+        """Full draws skip animated artists: grab the background, then paint them on top."""
         try:
-            self.ax.lines.clear()
-            self.ax.patches.clear()
-            self.ax.collections.clear()  # scatter dots live here
-            self.ax.texts.clear()        # labels/annotations live here
+            self._bg = self.canvas.copy_from_bbox(self.fig.bbox)
+            for a in self._animated:
+                self.ax.draw_artist(a)
         except Exception:
-            # fallback if matplotlib version lacks .clear() on these lists
-            self.ax.cla()
-            self._apply_dark_chart_style()
+            self._bg = None
 
+    def _blit_overlay(self) -> bool:
+        """Repaint only the animated artists over the cached background. False = needs a full draw."""
+        if self._bg is None:
+            return False
+        try:
+            self.canvas.restore_region(self._bg)
+            for a in self._animated:
+                self.ax.draw_artist(a)
+            self.canvas.blit(self.fig.bbox)
+            return True
+        except Exception:
+            self._bg = None
+            return False
 
-        if not candles:
-            self.ax.set_title(f"{self.coin} ({tf}) - no candles", color=DARK_FG)
-            self.canvas.draw_idle()
+    def _on_map(self, _event=None) -> None:
+        pending = self._deferred_refresh
+        if not pending:
             return
-
-
-        # Candlestick drawing (green up / red down) - batch rectangles
-        xs = getattr(self, "_xs", None)
-        if not xs or len(xs) != len(candles):
-            xs = list(range(len(candles)))
-            self._xs = xs
-
-        rects = []
-        for i, c in enumerate(candles):
+        self._deferred_refresh = None
+        self._bg = None
+        self.after_idle(pending)
+
+    def _set_candles(self, candles: List[dict]) -> None:
+        """Rebuild the closed-candle collections and place the forming candle."""
+        segs = []
+        verts = []
+        colors = []
+        for i, c in enumerate(candles[:-1]):
             o = float(c["open"])
             cl = float(c["close"])
             h = float(c["high"])
             l = float(c["low"])
-
-            up = cl >= o
-            candle_color = "green" if up else "red"
-
-            # wick
-            self.ax.plot([i, i], [l, h], linewidth=1, color=candle_color)
-
-            # body
             bottom = min(o, cl)
-            height = abs(cl - o)
-            if height < 1e-12:
-                height = 1e-12
-
-            rects.append(
-                Rectangle(
-                    (i - 0.35, bottom),
-                    0.7,
-                    height,
-                    facecolor=candle_color,
-                    edgecolor=candle_color,
-                    linewidth=1,
-                    alpha=0.9,
-                )
-            )
-
-        for r in rects:
-            self.ax.add_patch(r)
+            top = max(o, cl)
+            if top - bottom < 1e-12:
+                top = bottom + 1e-12
+            segs.append([(i, l), (i, h)])
+            verts.append([(i - 0.35, bottom), (i + 0.35, bottom), (i + 0.35, top), (i - 0.35, top)])
+            colors.append("green" if cl >= o else "red")
+
+        self._wicks.set_segments(segs)
+        self._wicks.set_color(colors)
+        self._bodies.set_verts(verts)
+        self._bodies.set_facecolor(colors)
+        self._bodies.set_edgecolor(colors)
+
+    def _set_live_candle(self, candles: List[dict]) -> None:
+        if not candles:
+            self._live_wick.set_data([], [])
+            self._live_body.set_visible(False)
+            return
+        i = len(candles) - 1
+        c = candles[-1]
+        o = float(c["open"])
+        cl = float(c["close"])
+        bottom = min(o, cl)
+        height = abs(cl - o)
+        if height < 1e-12:
+            height = 1e-12
+        candle_color = "green" if cl >= o else "red"
+        self._live_wick.set_data([i, i], [float(c["low"]), float(c["high"])])
+        self._live_wick.set_color(candle_color)
+        self._live_body.set_xy((i - 0.35, bottom))
+        self._live_body.set_height(height)
+        self._live_body.set_facecolor(candle_color)
+        self._live_body.set_edgecolor(candle_color)
+        self._live_body.set_visible(True)
+
+    def _set_price_lines(self, prices: Dict[str, Optional[float]]) -> None:
+        """Move the price lines and nudge their right-side labels apart if levels are very close."""
+        used_y: List[float] = []
+        y0, y1 = self.ax.get_ylim()
+        y_pad = max((y1 - y0) * 0.012, 1e-9)
+
+        for tag, (line, label) in self._price_lines.items():
+            yy = None
+            try:
+                v = prices.get(tag)
+                if v is not None and math.isfinite(float(v)) and float(v) > 0:
+                    yy = float(v)
+            except Exception:
+                yy = None
+            if yy is None:
+                line.set_visible(False)
+                label.set_visible(False)
+                continue
 
-        # Lock y-limits to candle range so overlay lines can go offscreen without expanding the chart.
-        try:
-            y_low = min(float(c["low"]) for c in candles)
-            y_high = max(float(c["high"]) for c in candles)
-            pad = (y_high - y_low) * 0.03
-            if not math.isfinite(pad) or pad <= 0:
-                pad = max(abs(y_low) * 0.001, 1e-6)
-            self.ax.set_ylim(y_low - pad, y_high + pad)
-        except Exception:
-            pass
+            line.set_ydata([yy, yy])
+            line.set_visible(True)
+
+            for prev in used_y:
+                if abs(yy - prev) < y_pad:
+                    yy = prev + y_pad
+            used_y.append(yy)
+
+            label.set_position((1.01, yy))
+            label.set_text(f"{tag} {_fmt_price(yy)}")
+            label.set_visible(True)
+
+    def _trade_marks(self, candles: List[dict]) -> List[Tuple[int, float, str, str]]:
+        """(x, y, label, color) for this coin's BUY / DCA / SELL trades inside the candle window."""
+        marks: List[Tuple[int, float, str, str]] = []
+        trades = _read_trade_history_jsonl(self.trade_history_path) if self.trade_history_path else []
+        if not trades:
+            return marks
+        candle_ts = [int(c["ts"]) for c in candles]  # oldest->newest
+        t_min = float(candle_ts[0])
+        t_max = float(candle_ts[-1])
+
+        for tr in trades:
+            sym = str(tr.get("symbol", "")).upper()
+            base = sym.split("-")[0].strip() if sym else ""
+            if base != self.coin.upper().strip():
+                continue
 
+            side = str(tr.get("side", "")).lower().strip()
+            tag = str(tr.get("tag") or "").upper().strip()
 
+            if side == "buy":
+                label = "DCA" if tag == "DCA" else "BUY"
+                color = "purple" if tag == "DCA" else "red"
+            elif side == "sell":
+                label = "SELL"
+                color = "green"
+            else:
+                continue
 
-        # Overlay Neural levels (blue long, orange short)
-        for lv in long_levels:
+            tts = tr.get("ts", None)
+            if tts is None:
+                continue
             try:
-                self.ax.axhline(y=float(lv), linewidth=1, color="blue", alpha=0.8)
+                tts = float(tts)
             except Exception:
-                pass
+                continue
+            if tts < t_min or tts > t_max:
+                continue
 
-        for lv in short_levels:
+            i = bisect.bisect_left(candle_ts, tts)
+            if i <= 0:
+                idx = 0
+            elif i >= len(candle_ts):
+                idx = len(candle_ts) - 1
+            else:
+                idx = i if abs(candle_ts[i] - tts) < abs(tts - candle_ts[i - 1]) else (i - 1)
+
+            # y = trade price if present, else candle close
+            y = None
             try:
-                self.ax.axhline(y=float(lv), linewidth=1, color="orange", alpha=0.8)
+                p = tr.get("price", None)
+                if p is not None and float(p) > 0:
+                    y = float(p)
             except Exception:
-                pass
-
-
-        # Overlay Trailing PM line (sell) and next DCA line
-        try:
-            if trail_line is not None and float(trail_line) > 0:
-                self.ax.axhline(y=float(trail_line), linewidth=1.5, color="green", alpha=0.95)
-        except Exception:
-            pass
-
-        try:
-            if dca_line_price is not None and float(dca_line_price) > 0:
-                self.ax.axhline(y=float(dca_line_price), linewidth=1.5, color="red", alpha=0.95)
-        except Exception:
-            pass
-
-        # Overlay avg cost basis (yellow)
-        try:
-            if avg_cost_basis is not None and float(avg_cost_basis) > 0:
-                self.ax.axhline(y=float(avg_cost_basis), linewidth=1.5, color="yellow", alpha=0.95)
-        except Exception:
-            pass
-
-        # Overlay current ask/bid prices
-        try:
-            if current_buy_price is not None and float(current_buy_price) > 0:
-                self.ax.axhline(y=float(current_buy_price), linewidth=1.5, color="purple", alpha=0.95)
-        except Exception:
-            pass
-
-        try:
-            if current_sell_price is not None and float(current_sell_price) > 0:
-                self.ax.axhline(y=float(current_sell_price), linewidth=1.5, color="teal", alpha=0.95)
-        except Exception:
-            pass
-
-        # Right-side price labels (so you can read Bid/Ask/AVG/DCA/Sell at a glance)
-        try:
-            trans = blended_transform_factory(self.ax.transAxes, self.ax.transData)
-            used_y: List[float] = []
-            y0, y1 = self.ax.get_ylim()
-            y_pad = max((y1 - y0) * 0.012, 1e-9)
-
-            def _label_right(y: Optional[float], tag: str, color: str) -> None:
-                if y is None:
-                    return
+                y = None
+            if y is None:
                 try:
-                    yy = float(y)
-                    if (not math.isfinite(yy)) or yy <= 0:
-                        return
+                    y = float(candles[idx].get("close", 0.0))
                 except Exception:
-                    return
+                    y = None
+            if y is None:
+                continue
 
-                # Nudge labels apart if levels are very close
-                for prev in used_y:
-                    if abs(yy - prev) < y_pad:
-                        yy = prev + y_pad
-                used_y.append(yy)
-
-                self.ax.text(
-                    1.01,
-                    yy,
-                    f"{tag} {_fmt_price(yy)}",
-                    transform=trans,
-                    ha="left",
-                    va="center",
+            marks.append((idx, y, label, color))
+        return marks
+
+    def _set_trade_marks(self, marks: List[Tuple[int, float, str, str]]) -> None:
+        for color, dots in self._trade_dots.items():
+            pts = [(x, y) for x, y, _label, c in marks if c == color]
+            dots.set_data([p[0] for p in pts], [p[1] for p in pts])
+
+        while len(self._trade_notes) < len(marks):
+            self._trade_notes.append(
+                self.ax.annotate(
+                    "",
+                    (0, 0),
+                    textcoords="offset points",
+                    xytext=(0, 10),
+                    ha="center",
                     fontsize=8,
-                    color=color,
-                    bbox=dict(
-                        facecolor=DARK_BG2,
-                        edgecolor=color,
-                        boxstyle="round,pad=0.18",
-                        alpha=0.85,
-                    ),
-                    zorder=20,
-                    clip_on=False,
+                    color=DARK_FG,
+                    zorder=7,
                 )
+            )
+        for j, note in enumerate(self._trade_notes):
+            if j < len(marks):
+                x, y, label, _color = marks[j]
+                note.xy = (x, y)
+                note.set_text(label)
+                note.set_visible(True)
+            else:
+                note.set_visible(False)
 
-            # Map to your terminology: Ask=buy line, Bid=sell line
-            _label_right(current_buy_price, "ASK", "purple")
-            _label_right(current_sell_price, "BID", "teal")
-            _label_right(avg_cost_basis, "AVG", "yellow")
-            _label_right(dca_line_price, "DCA", "red")
-            _label_right(trail_line, "SELL", "green")
-
-        except Exception:
-            pass
-
-
-
-
-        # --- Trade dots (BUY / DCA / SELL) for THIS coin only ---
-        try:
-            trades = _read_trade_history_jsonl(self.trade_history_path) if self.trade_history_path else []
-            if trades:
-                candle_ts = [int(c["ts"]) for c in candles]  # oldest->newest
-                t_min = float(candle_ts[0])
-                t_max = float(candle_ts[-1])
-
-                for tr in trades:
-                    sym = str(tr.get("symbol", "")).upper()
-                    base = sym.split("-")[0].strip() if sym else ""
-                    if base != self.coin.upper().strip():
-                        continue
-
-                    side = str(tr.get("side", "")).lower().strip()
-                    tag = str(tr.get("tag") or "").upper().strip()
-
-                    if side == "buy":
-                        label = "DCA" if tag == "DCA" else "BUY"
-                        color = "purple" if tag == "DCA" else "red"
-                    elif side == "sell":
-                        label = "SELL"
-                        color = "green"
-                    else:
-                        continue
-
-                    tts = tr.get("ts", None)
-                    if tts is None:
-                        continue
-                    try:
-                        tts = float(tts)
-                    except Exception:
-                        continue
-                    if tts < t_min or tts > t_max:
-                        continue
-
-                    i = bisect.bisect_left(candle_ts, tts)
-                    if i <= 0:
-                        idx = 0
-                    elif i >= len(candle_ts):
-                        idx = len(candle_ts) - 1
-                    else:
-                        idx = i if abs(candle_ts[i] - tts) < abs(tts - candle_ts[i - 1]) else (i - 1)
-
-                    # y = trade price if present, else candle close
-                    y = None
-                    try:
-                        p = tr.get("price", None)
-                        if p is not None and float(p) > 0:
-                            y = float(p)
-                    except Exception:
-                        y = None
-                    if y is None:
-                        try:
-                            y = float(candles[idx].get("close", 0.0))
-                        except Exception:
-                            y = None
-                    if y is None:
-                        continue
-
-                    x = idx
-                    self.ax.scatter([x], [y], s=35, color=color, zorder=6)
-                    self.ax.annotate(
-                        label,
-                        (x, y),
-                        textcoords="offset points",
-                        xytext=(0, 10),
-                        ha="center",
-                        fontsize=8,
-                        color=DARK_FG,
-                        zorder=7,
-                    )
-        except Exception:
-            pass
-
-
+    def _set_x_axis(self, candles: List[dict]) -> None:
         self.ax.set_xlim(-0.5, (len(candles) - 0.5) + 0.6)
 
-        self.ax.set_title(f"{self.coin} ({tf})", color=DARK_FG)
-
-
-
         # x tick labels (date + time) - evenly spaced, never overlapping duplicates
         n = len(candles)
         want = 5  # keep it readable even when the window is narrow
@@ -1132,7 +1228,6 @@ class CandleChart(ttk.Frame):
                 idxs.append(i)
                 last = i
 
-        tick_x = [xs[i] for i in idxs]
         tick_lbl = [
             time.strftime("%Y-%m-%d\n%H:%M", time.localtime(int(candles[i].get("ts", 0))))
             for i in idxs
@@ -1140,17 +1235,72 @@ class CandleChart(ttk.Frame):
 
         try:
             self.ax.minorticks_off()
-            self.ax.set_xticks(tick_x)
+            self.ax.set_xticks(idxs)
             self.ax.set_xticklabels(tick_lbl)
             self.ax.tick_params(axis="x", labelsize=8)
         except Exception:
             pass
 
+    def refresh(
+        self,
+        coin_folders: Dict[str, str],
+        current_buy_price: Optional[float] = None,
+        current_sell_price: Optional[float] = None,
+        trail_line: Optional[float] = None,
+        dca_line_price: Optional[float] = None,
+        avg_cost_basis: Optional[float] = None,
+    ) -> None:
+
+        """Synchronous load + apply (the hub normally runs load() on its BackgroundLoader)."""
+        prices = dict(
+            current_buy_price=current_buy_price,
+            current_sell_price=current_sell_price,
+            trail_line=trail_line,
+            dca_line_price=dca_line_price,
+            avg_cost_basis=avg_cost_basis,
+        )
+        # Hidden tab (or minimized window): nothing to draw into. Run it once the chart is mapped again.
+        if not self.winfo_ismapped():
+            self._deferred_refresh = lambda: self.refresh(coin_folders, **prices)
+            return
+        self.apply(self.load(coin_folders, self.timeframe_var.get().strip()), **prices)
 
-        self.canvas.draw_idle()
+    def load(self, coin_folders: Dict[str, str], tf: str) -> dict:
+        """
+        Fetch candles and read the neural files / trade history. No Tk calls, so it can run on a
+        worker thread; apply() does the drawing on the Tk thread.
+        """
+        cfg = self.settings_getter()
+        limit = int(cfg.get("candles_limit", 120))
+
+        candles = self.fetcher.get_klines(self.coin, tf, limit=limit)
+
+        folder = coin_folders.get(self.coin, "")
+        low_path = os.path.join(folder, "low_bound_prices.html")
+        high_path = os.path.join(folder, "high_bound_prices.html")
+
+        # --- Cached neural reads (per path, by mtime) ---
+        if not hasattr(self, "_neural_cache"):
+            self._neural_cache = {}  # path -> (mtime, value)
+
+        def _cached(path: str, loader, default):
+            try:
+                mtime = os.path.getmtime(path)
+            except Exception:
+                return default
+            hit = self._neural_cache.get(path)
+            if hit and hit[0] == mtime:
+                return hit[1]
+            v = loader(path)
+            self._neural_cache[path] = (mtime, v)
+            return v
 
+        long_levels = _cached(low_path, read_price_levels_from_html, []) if folder else []
+        short_levels = _cached(high_path, read_price_levels_from_html, []) if folder else []
 
-        self.neural_status_label.config(text=f"Neural: long={long_sig} short={short_sig} | levels L={len(long_levels)} S={len(short_levels)}")
+        long_sig_path = os.path.join(folder, "long_dca_signal.txt")
+        long_sig = _cached(long_sig_path, read_int_from_file, 0) if folder else 0
+        short_sig = read_short_signal(folder) if folder else 0
 
         # show file update time if possible
         last_ts = None
@@ -1162,11 +1312,152 @@ class CandleChart(ttk.Frame):
         except Exception:
             last_ts = None
 
+        try:
+            marks = self._trade_marks(candles) if candles else []
+        except Exception:
+            marks = []
+
+        return {
+            "tf": tf,
+            "candles": candles,
+            "long_levels": long_levels,
+            "short_levels": short_levels,
+            "long_sig": long_sig,
+            "short_sig": short_sig,
+            "last_ts": last_ts,
+            "marks": marks,
+        }
+
+    def apply(
+        self,
+        data: dict,
+        current_buy_price: Optional[float] = None,
+        current_sell_price: Optional[float] = None,
+        trail_line: Optional[float] = None,
+        dca_line_price: Optional[float] = None,
+        avg_cost_basis: Optional[float] = None,
+    ) -> None:
+        """Draw a load() result. Results for another timeframe than the one selected are dropped."""
+        tf = data.get("tf")
+        if tf != self.timeframe_var.get().strip():
+            return
+        if not self.winfo_ismapped():
+            prices = dict(
+                current_buy_price=current_buy_price,
+                current_sell_price=current_sell_price,
+                trail_line=trail_line,
+                dca_line_price=dca_line_price,
+                avg_cost_basis=avg_cost_basis,
+            )
+            self._deferred_refresh = lambda: self.apply(data, **prices)
+            return
+        self._deferred_refresh = None
+
+        candles = data.get("candles") or []
+        long_levels = data.get("long_levels") or []
+        short_levels = data.get("short_levels") or []
+        marks = data.get("marks") or []
+        last_ts = data.get("last_ts")
+
+        self.neural_status_label.config(text=f"Neural: long={data.get('long_sig', 0)} short={data.get('short_sig', 0)} | levels L={len(long_levels)} S={len(short_levels)}")
+
         if last_ts:
             self.last_update_label.config(text=f"Last: {time.strftime('%H:%M:%S', time.localtime(last_ts))}")
         else:
             self.last_update_label.config(text="Last: N/A")
 
+        if not candles:
+            if self._static_sig != ("empty", tf):
+                self._static_sig = ("empty", tf)
+                self._overlay_sig = None
+                self._candles_ref = None
+                self._candles_key = None
+                self._set_candles([])
+                self._set_live_candle([])
+                self._set_price_lines({})
+                self._set_trade_marks([])
+                self._long_levels.set_segments([])
+                self._short_levels.set_segments([])
+                self.ax.set_title(f"{self.coin} ({tf}) - no candles", color=DARK_FG)
+                self.canvas.draw_idle()
+            return
+
+        # Closed candles only change when the fetcher hands back a different list
+        # (it returns the same object while the content is unchanged).
+        if candles is not self._candles_ref:
+            self._candles_ref = candles
+            self._candles_key = (
+                len(candles),
+                int(candles[-1]["ts"]),
+                tuple((c["ts"], c["open"], c["high"], c["low"], c["close"]) for c in candles[:-1]),
+            )
+
+        # Lock y-limits to candle range so overlay lines can go offscreen without expanding the chart.
+        ylim = None
+        try:
+            y_low = min(float(c["low"]) for c in candles)
+            y_high = max(float(c["high"]) for c in candles)
+            pad = (y_high - y_low) * 0.03
+            if not math.isfinite(pad) or pad <= 0:
+                pad = max(abs(y_low) * 0.001, 1e-6)
+            ylim = (y_low - pad, y_high + pad)
+        except Exception:
+            pass
+
+        levels = []
+        for lvs in (long_levels, short_levels):
+            ys = []
+            for lv in lvs:
+                try:
+                    ys.append(float(lv))
+                except Exception:
+                    pass
+            levels.append(tuple(ys))
+
+        static_sig = (tf, self._candles_key, ylim, levels[0], levels[1], tuple(marks))
+
+        last = candles[-1]
+        prices = {
+            "ASK": current_buy_price,
+            "BID": current_sell_price,
+            "AVG": avg_cost_basis,
+            "DCA": dca_line_price,
+            "SELL": trail_line,
+        }
+        overlay_sig = (
+            (last["ts"], last["open"], last["high"], last["low"], last["close"]),
+            tuple(prices.values()),
+        )
+
+        if static_sig == self._static_sig:
+            if overlay_sig == self._overlay_sig:
+                return  # nothing moved
+            self._overlay_sig = overlay_sig
+            self._set_live_candle(candles)
+            self._set_price_lines(prices)
+            if not self._blit_overlay():
+                self.canvas.draw_idle()
+            return
+
+        # Background changed (new candle, timeframe, y-range, neural levels or trades): update
+        # the persistent artists and do one full draw, which also re-captures the blit background.
+        self._static_sig = static_sig
+        self._overlay_sig = overlay_sig
+
+        self._set_candles(candles)
+        if ylim is not None:
+            self.ax.set_ylim(*ylim)
+        self._long_levels.set_segments([[(0.0, y), (1.0, y)] for y in levels[0]])
+        self._short_levels.set_segments([[(0.0, y), (1.0, y)] for y in levels[1]])
+        self._set_trade_marks(marks)
+        self._set_x_axis(candles)
+        self.ax.set_title(f"{self.coin} ({tf})", color=DARK_FG)
+
+        self._set_live_candle(candles)
+        self._set_price_lines(prices)
+
+        self.canvas.draw_idle()
+
 
 # -----------------------------
 # Account Value chart widget
@@ -1180,6 +1471,7 @@ class AccountValueChart(ttk.Frame):
         # Hard-cap to 250 points max (account value chart only)
         self.max_points = min(int(max_points or 0) or 250, 250)
         self._last_mtime: Optional[float] = None
+        self._series = AccountValueSeries(history_path)
 
 
         top = ttk.Frame(self)
@@ -1260,6 +1552,13 @@ class AccountValueChart(ttk.Frame):
             pass
 
     def refresh(self) -> None:
+        """Synchronous load + apply (the hub normally runs load() on its BackgroundLoader)."""
+        data = self.load()
+        if data is not None:
+            self.apply(data)
+
+    def load(self) -> Optional[dict]:
+        """Read new history/trade rows (no Tk calls). None when nothing changed since the last load."""
         path = self.history_path
 
         # mtime cache so we don't redraw if nothing changed (account history OR trade history)
@@ -1277,98 +1576,26 @@ class AccountValueChart(ttk.Frame):
         mtime = max(candidates) if candidates else None
 
         if mtime is not None and self._last_mtime == mtime:
-            return
+            return None
         self._last_mtime = mtime
 
 
-        points: List[Tuple[float, float]] = []
+        # Only the lines appended since the last refresh are parsed; the rollups keep the FULL
+        # history so the chart still shows from the very beginning.
+        # Downsample to <= 250 points (LTTB; the very first and very last points are never moved,
+        # so the title and chart end match account info).
+        self._series.poll()
+        max_keep = min(max(2, int(self.max_points or 250)), 250)
+        points = self._series.points(max_keep)
 
         try:
-            if os.path.isfile(path):
-                # Read the FULL history so the chart shows from the very beginning
-                with open(path, "r", encoding="utf-8") as f:
-                    lines = f.read().splitlines()
-
-                for ln in lines:
-                    try:
-                        obj = json.loads(ln)
-                        ts = obj.get("ts", None)
-                        v = obj.get("total_account_value", None)
-                        if ts is None or v is None:
-                            continue
-
-                        tsf = float(ts)
-                        vf = float(v)
-
-                        # Drop obviously invalid points early
-                        if (not math.isfinite(tsf)) or (not math.isfinite(vf)) or (vf <= 0.0):
-                            continue
-
-                        points.append((tsf, vf))
-                    except Exception:
-                        continue
+            trades = _read_trade_history_jsonl(self.trade_history_path) if self.trade_history_path else []
         except Exception:
-            points = []
-
-        # ---- Clean up history so single-tick bogus dips/spikes don't render ----
-        if points:
-            # Ensure chronological order
-            points.sort(key=lambda x: x[0])
-
-            # De-dupe identical timestamps (keep the latest occurrence)
-            dedup: List[Tuple[float, float]] = []
-            for tsf, vf in points:
-                if dedup and tsf == dedup[-1][0]:
-                    dedup[-1] = (tsf, vf)
-                else:
-                    dedup.append((tsf, vf))
-            points = dedup
-
-
-        # Downsample to <= 250 points by AVERAGING buckets instead of skipping points.
-        # IMPORTANT: never average the VERY FIRST or VERY LAST point.
-        # - First point should remain the true first historical value.
-        # - Last point should remain the true current/final account value (so the title and chart end match account info).
-        max_keep = min(max(2, int(self.max_points or 250)), 250)
-        n = len(points)
-
-        if n > max_keep:
-            first_pt = points[0]
-            last_pt = points[-1]
-
-            mid_points = points[1:-1]
-            mid_n = len(mid_points)
-            keep_mid = max_keep - 2
-
-            if keep_mid <= 0 or mid_n <= 0:
-                points = [first_pt, last_pt]
-            elif mid_n <= keep_mid:
-                points = [first_pt] + mid_points + [last_pt]
-            else:
-                bucket_size = mid_n / float(keep_mid)
-                new_mid: List[Tuple[float, float]] = []
-
-                for i in range(keep_mid):
-                    start = int(i * bucket_size)
-                    end = int((i + 1) * bucket_size)
-                    if end <= start:
-                        end = start + 1
-                    if start >= mid_n:
-                        break
-                    if end > mid_n:
-                        end = mid_n
-
-                    bucket = mid_points[start:end]
-                    if not bucket:
-                        continue
-
-                    # Average timestamp and account value within the bucket (MID ONLY)
-                    avg_ts = sum(p[0] for p in bucket) / len(bucket)
-                    avg_val = sum(p[1] for p in bucket) / len(bucket)
-                    new_mid.append((avg_ts, avg_val))
-
-                points = [first_pt] + new_mid + [last_pt]
+            trades = []
+        return {"points": points, "trades": trades}
 
+    def apply(self, data: dict) -> None:
+        points = data.get("points") or []
 
 
         # clear artists (fast) / fallback to cla()
@@ -1396,7 +1623,7 @@ class AccountValueChart(ttk.Frame):
 
         # --- Trade dots (BUY / DCA / SELL) for ALL coins ---
         try:
-            trades = _read_trade_history_jsonl(self.trade_history_path) if self.trade_history_path else []
+            trades = data.get("trades") or []
             if trades:
                 ts_list = [float(p[0]) for p in points]  # matches xs/ys indices
                 t_min = ts_list[0]
@@ -1513,6 +1740,101 @@ class AccountValueChart(ttk.Frame):
 
 
 
+# -----------------------------
+# Background loader
+# -----------------------------
+
+class BackgroundLoader:
+    """
+    Thread pool for the hub's file reads and KuCoin downloads. _tick() submits keyed jobs and
+    the Tk thread applies finished results from drain(), so widgets are only touched on the
+    Tk thread.
+
+    - one job per key in flight: a periodic submit while the last one still runs is skipped
+    - replace=True (timeframe change, tab switch) starts a fresh job; the older result is dropped
+    - suggest_interval() stretches the refresh period while jobs take longer than it
+    """
+
+    def __init__(self, workers: int = HUB_LOADER_WORKERS):
+        self.workers = max(1, int(workers))
+        self._pool = concurrent.futures.ThreadPoolExecutor(max_workers=self.workers, thread_name_prefix="hub-loader")
+        self._lock = threading.Lock()
+        self._gen: Dict[Any, int] = {}              # key -> newest generation submitted
+        self._running: Dict[Any, int] = {}          # key -> generation in flight
+        self._done: List[Tuple[Any, int, Any, Any]] = []  # (key, gen, apply, result)
+        self._job_seconds = 0.0                     # EWMA of job wall time
+
+    def submit(self, key: Any, load, apply, *args, replace: bool = False) -> bool:
+        """Run load(*args) on a worker; apply(result) is called later from drain() on the Tk thread."""
+        with self._lock:
+            if key in self._running and not replace:
+                return False
+            gen = self._gen.get(key, 0) + 1
+            self._gen[key] = gen
+            self._running[key] = gen
+        started = time.time()
+        try:
+            fut = self._pool.submit(load, *args)
+        except Exception:
+            with self._lock:
+                if self._running.get(key) == gen:
+                    del self._running[key]
+            return False
+        fut.add_done_callback(lambda f: self._finished(key, gen, apply, started, f))
+        return True
+
+    def _finished(self, key: Any, gen: int, apply, started: float, fut) -> None:
+        elapsed = time.time() - started
+        try:
+            result = fut.result()
+            ok = True
+        except Exception:
+            result = None
+            ok = False
+            pt_metrics.incr("hub_load_errors")
+        pt_metrics.observe("hub_load", elapsed)
+        with self._lock:
+            if self._running.get(key) == gen:
+                del self._running[key]
+            self._job_seconds = elapsed if self._job_seconds <= 0.0 else (0.8 * self._job_seconds + 0.2 * elapsed)
+            if ok and self._gen.get(key) == gen:
+                self._done.append((key, gen, apply, result))
+
+    def drain(self) -> List[Tuple[Any, Any]]:
+        """Finished (apply, result) pairs, newest generation per key only."""
+        with self._lock:
+            done, self._done = self._done, []
+            out = []
+            for key, gen, apply, result in done:
+                if self._gen.get(key) == gen:
+                    out.append((apply, result))
+                else:
+                    pt_metrics.incr("hub_load_stale")
+            return out
+
+    def invalidate(self, key: Any) -> None:
+        """Drop whatever is in flight for key (its result will not be applied)."""
+        with self._lock:
+            self._gen[key] = self._gen.get(key, 0) + 1
+            self._running.pop(key, None)
+
+    def suggest_interval(self, base: float) -> float:
+        """Refresh period to use: base while loads keep up, longer (up to 8x) while they lag."""
+        with self._lock:
+            job = self._job_seconds
+            backlog = len(self._running)
+        interval = max(float(base), job * 2.0)
+        if backlog > self.workers:
+            interval *= 2.0
+        return min(interval, float(base) * 8.0)
+
+    def shutdown(self) -> None:
+        try:
+            self._pool.shutdown(wait=False)
+        except Exception:
+            pass
+
+
 # -----------------------------
 # Hub App
 # -----------------------------
@@ -1580,6 +1902,12 @@ class PowerTraderHub(tk.Tk):
         # file written by pt_thinker.py (runner readiness gate used for Start All)
         self.runner_ready_path = os.path.join(self.hub_dir, "runner_ready.json")
 
+        # metrics_<process>.json files (pt_metrics.py) -> Metrics tab + optional Prometheus endpoint
+        self._last_metrics_refresh = 0.0
+        if bool(self.settings.get("metrics_enabled", True)):
+            pt_metrics.configure("hub", self.hub_dir)  # loader timings show up next to the scripts'
+        self._start_metrics_server()
+
 
         # internal: when Start All is pressed, we start the runner first and only start the trader once ready
         self._auto_start_trader_pending = False
@@ -1622,11 +1950,18 @@ class PowerTraderHub(tk.Tk):
         # trainers: coin -> LogProc
         self.trainers: Dict[str, LogProc] = {}
 
+        # training job queue (coins waiting for a free trainer slot; see _pump_training_queue)
+        self.train_queue: List[str] = []
+
         self.fetcher = CandleFetcher()
 
 
         self.fetcher = CandleFetcher()
 
+        # background file reads / downloads for _tick (results applied by _pump_loader)
+        self.loader = BackgroundLoader(HUB_LOADER_WORKERS)
+        self._last_status_map: Optional[Dict[str, str]] = None
+
         self._build_menu()
         self._build_layout()
 
@@ -1639,6 +1974,7 @@ class PowerTraderHub(tk.Tk):
             self.start_all_scripts()
 
         self.after(250, self._tick)
+        self.after(LOADER_PUMP_MS, self._pump_loader)
 
         self.protocol("WM_DELETE_WINDOW", self._on_close)
 
@@ -2539,6 +2875,28 @@ class PowerTraderHub(tk.Tk):
         self.trainer_text.pack(side="left", fill="both", expand=True, padx=(6, 0), pady=(0, 6))
         trainer_scroll.pack(side="right", fill="y", padx=(0, 6), pady=(0, 6))
 
+        # Metrics tab (hot-path timers / counters from hub_data/metrics_*.json)
+        self.metrics_tab = ttk.Frame(self.logs_nb)
+        self.logs_nb.add(self.metrics_tab, text="Metrics")
+        self.metrics_text = tk.Text(
+            self.metrics_tab,
+            height=8,
+            wrap="none",
+            font=self._live_log_font,
+            bg=DARK_PANEL,
+            fg=DARK_FG,
+            insertbackground=DARK_FG,
+            selectbackground=DARK_SELECT_BG,
+            selectforeground=DARK_SELECT_FG,
+            highlightbackground=DARK_BORDER,
+            highlightcolor=DARK_ACCENT,
+        )
+
+        metrics_scroll = ttk.Scrollbar(self.metrics_tab, orient="vertical", command=self.metrics_text.yview)
+        self.metrics_text.configure(yscrollcommand=metrics_scroll.set)
+        self.metrics_text.pack(side="left", fill="both", expand=True)
+        metrics_scroll.pack(side="right", fill="y")
+
 
         # Add left panes (no trades/history on the left anymore)
         # Default should match the screenshot: more room for Controls/Health + Neural Levels.
@@ -2632,41 +2990,9 @@ class PowerTraderHub(tk.Tk):
             # (even if trader/neural scripts are not running yet).
             try:
                 tab = str(name or "").strip().upper()
-                if tab and tab != "ACCOUNT":
-                    coin = tab
-                    chart = self.charts.get(coin)
-                    if chart:
-                        def _do_refresh_visible():
-                            try:
-                                # Ensure coin folders exist (best-effort; fast)
-                                try:
-                                    cf_sig = (self.settings.get("main_neural_dir"), tuple(self.coins))
-                                    if getattr(self, "_coin_folders_sig", None) != cf_sig:
-                                        self._coin_folders_sig = cf_sig
-                                        self.coin_folders = build_coin_folders(self.settings["main_neural_dir"], self.coins)
-                                except Exception:
-                                    pass
-
-                                pos = self._last_positions.get(coin, {}) if isinstance(self._last_positions, dict) else {}
-                                buy_px = pos.get("current_buy_price", None)
-                                sell_px = pos.get("current_sell_price", None)
-                                trail_line = pos.get("trail_line", None)
-                                dca_line_price = pos.get("dca_line_price", None)
-                                avg_cost_basis = pos.get("avg_cost_basis", None)
-
-                                chart.refresh(
-                                    self.coin_folders,
-                                    current_buy_price=buy_px,
-                                    current_sell_price=sell_px,
-                                    trail_line=trail_line,
-                                    dca_line_price=dca_line_price,
-                                    avg_cost_basis=avg_cost_basis,
-                                )
-
-                            except Exception:
-                                pass
-
-                        self.after(1, _do_refresh_visible)
+                if tab and tab != "ACCOUNT" and self.charts.get(tab):
+                    self._sync_coin_folders()
+                    self._request_chart_refresh(tab, replace=True)
             except Exception:
                 pass
 
@@ -3072,6 +3398,60 @@ class PowerTraderHub(tk.Tk):
         finally:
             q.put(f"{prefix}[process exited]")
 
+    def _prune_args(self) -> List[str]:
+        """pt_trainer.py --prune-* flags from the memory pruning settings (omitted when off)."""
+        out = []
+        for flag, key, conv in (("--prune-floor", "memory_prune_floor_updates", int),
+                                ("--prune-merge", "memory_merge_distance", float),
+                                ("--prune-cap", "memory_max_per_timeframe", int)):
+            try:
+                v = conv(self.settings.get(key, 0) or 0)
+            except Exception:
+                v = 0
+            if v > 0:
+                out += [flag, str(v)]
+        return out
+
+    def _match_env(self) -> Dict[str, str]:
+        """pt_match.py settings for child processes (read at import time)."""
+        mode = str(self.settings.get("memory_match_mode", "index") or "index").strip().lower()
+        try:
+            recall = min(1.0, max(0.0, float(self.settings.get("memory_match_recall", 1.0))))
+        except Exception:
+            recall = 1.0
+        return {"POWERTRADER_MATCH_MODE": mode, "POWERTRADER_MATCH_RECALL": str(recall)}
+
+    def _metrics_env(self) -> Dict[str, str]:
+        """pt_metrics.py switch for child processes (read at import time)."""
+        return {"POWERTRADER_METRICS": "1" if bool(self.settings.get("metrics_enabled", True)) else "0"}
+
+    def _start_metrics_server(self) -> None:
+        """(Re)start the Prometheus endpoint on settings["metrics_port"] (0 = off)."""
+        try:
+            port = int(float(self.settings.get("metrics_port", 0) or 0))
+        except Exception:
+            port = 0
+        old = getattr(self, "_metrics_server", None)
+        if old is not None and getattr(self, "_metrics_server_port", None) == port:
+            return
+        if old is not None:
+            def _stop(s=old):
+                try:
+                    s.shutdown()
+                    s.server_close()
+                except Exception:
+                    pass
+            threading.Thread(target=_stop, daemon=True).start()
+        self._metrics_server = None
+        self._metrics_server_port = port
+        self._metrics_server_error = ""
+        if port <= 0:
+            return
+        try:
+            self._metrics_server = pt_metrics.serve(port, self.hub_dir)
+        except Exception as e:
+            self._metrics_server_error = f"metrics endpoint on port {port} failed: {e}"
+
     def _start_process(self, p: ProcInfo, log_q: Optional["queue.Queue[str]"] = None, prefix: str = "") -> None:
         if p.proc and p.proc.poll() is None:
             return
@@ -3081,6 +3461,8 @@ class PowerTraderHub(tk.Tk):
 
         env = os.environ.copy()
         env["POWERTRADER_HUB_DIR"] = self.hub_dir  # so rhcb writes where GUI reads
+        env.update(self._match_env())
+        env.update(self._metrics_env())
 
         try:
             p.proc = subprocess.Popen(
@@ -3229,7 +3611,7 @@ class PowerTraderHub(tk.Tk):
         running: List[str] = []
 
         # Trainers launched by this GUI instance
-        for c, lp in self.trainers.items():
+        for c, lp in list(self.trainers.items()):
             try:
                 if lp.info.proc and lp.info.proc.poll() is None:
                     running.append(c)
@@ -3273,21 +3655,56 @@ class PowerTraderHub(tk.Tk):
 
 
 
-    def _training_status_map(self) -> Dict[str, str]:
+    def _training_status_map(self, queue: Optional[List[str]] = None) -> Dict[str, str]:
         """
-        Returns {coin: "TRAINED" | "TRAINING" | "NOT TRAINED"}.
+        Returns {coin: "TRAINED" | "TRAINING ..." | "QUEUED #n" | "NOT TRAINED"}.
+
+        Running jobs carry their progress from trainer_status.json, e.g. "TRAINING 4hour 3/7 (41%)",
+        so compare with startswith("TRAINING") rather than ==. `queue` is a snapshot of
+        train_queue when this runs off the Tk thread.
         """
+        queue = list(self.train_queue) if queue is None else queue
         running = set(self._running_trainers())
         out: Dict[str, str] = {}
-        for c in self.coins:
+        for c in list(self.coins):
             if c in running:
-                out[c] = "TRAINING"
+                out[c] = "TRAINING" + self._training_progress_text(c)
+            elif c in queue:
+                out[c] = f"QUEUED #{queue.index(c) + 1}"
             elif self._coin_is_trained(c):
                 out[c] = "TRAINED"
             else:
                 out[c] = "NOT TRAINED"
         return out
 
+    def _training_progress_text(self, coin: str) -> str:
+        folder = self.coin_folders.get(coin, "")
+        st = _safe_read_json(os.path.join(folder, "trainer_status.json")) if folder else None
+        if not isinstance(st, dict) or str(st.get("state", "")).upper() != "TRAINING":
+            return ""
+        parts = []
+        if st.get("timeframe"):
+            parts.append(str(st.get("timeframe")))
+        try:
+            if st.get("total"):
+                parts.append(f"{int(st.get('done', 0))}/{int(st.get('total'))}")
+        except Exception:
+            pass
+        try:
+            if st.get("progress") is not None:
+                parts.append(f"({float(st.get('progress')) * 100.0:.0f}%)")
+        except Exception:
+            pass
+        return (" " + " ".join(parts)) if parts else ""
+
+    def _last_training_time(self, coin: str) -> float:
+        folder = self.coin_folders.get(coin, "")
+        try:
+            with open(os.path.join(folder, "trainer_last_training_time.txt"), "r", encoding="utf-8") as f:
+                return float((f.read() or "").strip() or 0.0)
+        except Exception:
+            return 0.0
+
     def train_selected_coin(self) -> None:
         coin = (getattr(self, 'train_coin_var', self.trainer_coin_var).get() or "").strip().upper()
 
@@ -3297,16 +3714,54 @@ class PowerTraderHub(tk.Tk):
         self.start_trainer_for_selected_coin()
 
     def train_all_coins(self) -> None:
-        # Start trainers for every coin (in parallel)
-        for c in self.coins:
-            self.trainer_coin_var.set(c)
-            self.start_trainer_for_selected_coin()
+        # Queue every coin; the scheduler runs them a few at a time, stalest first
+        self._enqueue_training(list(self.coins))
 
     def start_trainer_for_selected_coin(self) -> None:
         coin = (self.trainer_coin_var.get() or "").strip().upper()
         if not coin:
             return
+        self._enqueue_training([coin])
+
+    def _enqueue_training(self, coins: List[str]) -> None:
+        running = set(self._running_trainers())
+        for c in coins:
+            c = (c or "").strip().upper()
+            if c and c not in self.train_queue and c not in running:
+                self.train_queue.append(c)
+        self._pump_training_queue()
+
+    def _trainer_slots(self) -> int:
+        try:
+            n = int(self.settings.get("trainer_max_concurrent", 2) or 0)
+        except Exception:
+            n = 2
+        return n if n > 0 else 1_000_000
 
+    def _trainer_workers_per_job(self) -> int:
+        """Split the core budget across the job slots (only matters with parallel timeframes)."""
+        try:
+            budget = int(self.settings.get("trainer_core_budget", 0) or 0)
+        except Exception:
+            budget = 0
+        if budget <= 0:
+            budget = os.cpu_count() or 1
+        slots = min(self._trainer_slots(), max(1, len(self.coins)))
+        return max(1, budget // max(1, slots))
+
+    def _pump_training_queue(self) -> None:
+        """Start queued trainer jobs while slots are free. Stalest coin (oldest training stamp) goes first."""
+        if not self.train_queue:
+            return
+        running = set(self._running_trainers())
+        self.train_queue = [c for c in self.train_queue if c not in running]
+        self.train_queue.sort(key=self._last_training_time)  # stable: ties keep queue order
+        while self.train_queue and len(running) < self._trainer_slots():
+            coin = self.train_queue.pop(0)
+            if self._launch_trainer(coin):
+                running.add(coin)
+
+    def _launch_trainer(self, coin: str) -> bool:
         # Stop the Neural Runner before any training starts (training modifies artifacts the runner reads)
         self.stop_neural()
 
@@ -3343,22 +3798,42 @@ class PowerTraderHub(tk.Tk):
                 "Missing trainer",
                 f"Cannot find trainer for {coin} at:\n{trainer_path}"
             )
-            return
+            return False
 
         if coin in self.trainers and self.trainers[coin].info.proc and self.trainers[coin].info.proc.poll() is None:
-            return
+            return False
 
 
+        incremental = bool(self.settings.get("trainer_incremental", DEFAULT_SETTINGS.get("trainer_incremental", False)))
+        if incremental and not all(os.path.isfile(os.path.join(coin_cwd, f"trainer_checkpoint_{tf}.json")) for tf in TRAINER_TIMEFRAMES):
+            # trained before checkpoints existed (or never): there is nothing to resume from, so do
+            # the full retrain; that drops the training stamp and the coin is gated until it's done
+            incremental = False
+
         try:
-            patterns = [
-                "trainer_last_training_time.txt",
-                "trainer_status.json",
-                "trainer_last_start_time.txt",
-                "killer.txt",
-                "memories_*.txt",
-                "memory_weights_*.txt",
-                "neural_perfect_threshold_*.txt",
-            ]
+            if incremental:
+                # keep memories, thresholds and checkpoints (the trainer resumes from them), and the
+                # last training stamp, so the coin stays tradeable while it catches up
+                patterns = [
+                    "trainer_status.json",
+                    "trainer_status_*.json",
+                    "killer.txt",
+                ]
+            else:
+                patterns = [
+                    "trainer_last_training_time.txt",
+                    "trainer_status.json",
+                    "trainer_status_*.json",
+                    "trainer_last_start_time.txt",
+                    "trainer_checkpoint_*.json",
+                    "killer.txt",
+                    "memories_*.txt",
+                    "memories_*.ptm",
+                    "memories_*.ptj",
+                    "memories_*.ptr",
+                    "memory_weights_*.txt",
+                    "neural_perfect_threshold_*.txt",
+                ]
 
 
             deleted = 0
@@ -3383,11 +3858,25 @@ class PowerTraderHub(tk.Tk):
 
         env = os.environ.copy()
         env["POWERTRADER_HUB_DIR"] = self.hub_dir
+        env["POWERTRADER_PROJECT_DIR"] = self.project_dir  # trainer copies import shared modules (pt_memory.py) from here
+        env.update(self._match_env())
+        env.update(self._metrics_env())
 
         try:
             # IMPORTANT: pass `coin` so neural_trainer trains the correct market instead of defaulting to BTC
+            args = [sys.executable, "-u", info.path, coin]
+            if bool(self.settings.get("trainer_parallel_timeframes", False)):
+                args += ["--parallel", "--workers", str(self._trainer_workers_per_job())]
+            if incremental:
+                args.append("--incremental")
+            args += self._prune_args()
+            lengths = _pattern_lengths(self.settings.get("trainer_pattern_lengths", "2"))
+            if lengths != "2":
+                args += ["--pattern-lengths", lengths]
+            if str(self.settings.get("bundle_publish_dir", "") or "").strip():
+                args += ["--publish", str(self.settings.get("bundle_publish_dir")).strip()]
             info.proc = subprocess.Popen(
-                [sys.executable, "-u", info.path, coin],
+                args,
                 cwd=coin_cwd,
                 env=env,
                 stdout=subprocess.PIPE,
@@ -3399,14 +3888,18 @@ class PowerTraderHub(tk.Tk):
             t.start()
 
             self.trainers[coin] = LogProc(info=info, log_q=q, thread=t, is_trainer=True, coin=coin)
+            return True
         except Exception as e:
             messagebox.showerror("Failed to start", f"Trainer for {coin} failed to start:\n{e}")
+            return False
 
 
 
 
     def stop_trainer_for_selected_coin(self) -> None:
         coin = (self.trainer_coin_var.get() or "").strip().upper()
+        if coin in self.train_queue:
+            self.train_queue.remove(coin)
         lp = self.trainers.get(coin)
         if not lp or not lp.info.proc or lp.info.proc.poll() is not None:
             return
@@ -3445,23 +3938,8 @@ class PowerTraderHub(tk.Tk):
             if not coin:
                 return
 
-            self.coin_folders = build_coin_folders(self.settings["main_neural_dir"], self.coins)
-
-            pos = self._last_positions.get(coin, {}) if isinstance(self._last_positions, dict) else {}
-            buy_px = pos.get("current_buy_price", None)
-            sell_px = pos.get("current_sell_price", None)
-            trail_line = pos.get("trail_line", None)
-            dca_line_price = pos.get("dca_line_price", None)
-            avg_cost_basis = pos.get("avg_cost_basis", None)
-
-            chart.refresh(
-                self.coin_folders,
-                current_buy_price=buy_px,
-                current_sell_price=sell_px,
-                trail_line=trail_line,
-                dca_line_price=dca_line_price,
-                avg_cost_basis=avg_cost_basis,
-            )
+            self._sync_coin_folders()
+            self._request_chart_refresh(coin, replace=True)
 
             # Keep the periodic refresh behavior consistent (prevents an immediate full refresh right after this).
             self._last_chart_refresh = time.time()
@@ -3511,8 +3989,28 @@ class PowerTraderHub(tk.Tk):
         except Exception:
             pass
 
+        # start queued trainer jobs as slots free up
+        try:
+            self._pump_training_queue()
+        except Exception:
+            pass
+
+        # File reads / downloads run on the background loader; finished results are applied
+        # by _pump_loader() on this thread. Each submit is skipped while the previous one for
+        # the same key is still running.
+        self._sync_coin_folders()
+        loader = self.loader
+        loader.submit("training_status", self._training_status_map, self._set_training_status, list(self.train_queue))
+        if hasattr(self, "neural_tiles"):
+            loader.submit("neural_overview", self._load_neural_overview, self._apply_neural_overview,
+                          dict(self.coin_folders or {}), list(self.neural_tiles))
+        loader.submit("trader_status", self._load_trader_status, self._apply_if_changed(self._apply_trader_status))
+        loader.submit("pnl", self._load_pnl, self._apply_if_changed(self._apply_pnl))
+        loader.submit("trade_history", self._load_trade_history, self._apply_if_changed(self._apply_trade_history))
+
         # --- flow gating: Train -> Start All ---
-        status_map = self._training_status_map()
+        # (first tick reads it directly so the buttons are right from the start)
+        status_map = self._last_status_map if self._last_status_map is not None else self._training_status_map()
         all_trained = all(v == "TRAINED" for v in status_map.values()) if status_map else False
 
         # Disable Start All until training is done (but always allow it if something is already running/pending,
@@ -3528,11 +4026,15 @@ class PowerTraderHub(tk.Tk):
 
         # Training overview + per-coin list
         try:
-            training_running = [c for c, s in status_map.items() if s == "TRAINING"]
+            training_running = [c for c, s in status_map.items() if s.startswith("TRAINING")]
+            training_queued = [c for c, s in status_map.items() if s.startswith("QUEUED")]
             not_trained = [c for c, s in status_map.items() if s == "NOT TRAINED"]
 
             if training_running:
-                self.lbl_training_overview.config(text=f"Training: RUNNING ({', '.join(training_running)})")
+                queued_txt = f", {len(training_queued)} queued" if training_queued else ""
+                self.lbl_training_overview.config(text=f"Training: RUNNING ({', '.join(training_running)}{queued_txt})")
+            elif training_queued:
+                self.lbl_training_overview.config(text=f"Training: QUEUED ({len(training_queued)} waiting)")
             elif not_trained:
                 self.lbl_training_overview.config(text=f"Training: REQUIRED ({len(not_trained)} not trained)")
             else:
@@ -3558,41 +4060,17 @@ class PowerTraderHub(tk.Tk):
         except Exception:
             pass
 
-        # neural overview bars (mtime-cached inside)
-        self._refresh_neural_overview()
-
-        # trader status -> current trades table (now mtime-cached inside)
-        self._refresh_trader_status()
-
-        # pnl ledger -> realized profit (now mtime-cached inside)
-        self._refresh_pnl()
-
-        # trade history (now mtime-cached inside)
-        self._refresh_trade_history()
-
-
-        # charts (throttle)
+        # charts (throttle; stretched while background loads lag)
         now = time.time()
-        if (now - self._last_chart_refresh) >= float(self.settings.get("chart_refresh_seconds", 10.0)):
+        if (now - self._last_chart_refresh) >= loader.suggest_interval(float(self.settings.get("chart_refresh_seconds", 10.0))):
             # account value chart (internally mtime-cached already)
             try:
                 if self.account_chart:
-                    self.account_chart.refresh()
+                    chart = self.account_chart
+                    loader.submit(("chart", "ACCOUNT"), chart.load, self._apply_if_changed(chart.apply))
             except Exception:
                 pass
 
-            # Only rebuild coin_folders when inputs change (avoids directory scans every refresh)
-            try:
-                cf_sig = (self.settings.get("main_neural_dir"), tuple(self.coins))
-                if getattr(self, "_coin_folders_sig", None) != cf_sig:
-                    self._coin_folders_sig = cf_sig
-                    self.coin_folders = build_coin_folders(self.settings["main_neural_dir"], self.coins)
-            except Exception:
-                try:
-                    self.coin_folders = build_coin_folders(self.settings["main_neural_dir"], self.coins)
-                except Exception:
-                    pass
-
             # Refresh ONLY the currently visible coin tab (prevents O(N_coins) network/plot stalls)
             selected_tab = None
 
@@ -3611,27 +4089,7 @@ class PowerTraderHub(tk.Tk):
                     selected_tab = None
 
             if selected_tab and str(selected_tab).strip().upper() != "ACCOUNT":
-                coin = str(selected_tab).strip().upper()
-                chart = self.charts.get(coin)
-                if chart:
-                    pos = self._last_positions.get(coin, {}) if isinstance(self._last_positions, dict) else {}
-                    buy_px = pos.get("current_buy_price", None)
-                    sell_px = pos.get("current_sell_price", None)
-                    trail_line = pos.get("trail_line", None)
-                    dca_line_price = pos.get("dca_line_price", None)
-                    avg_cost_basis = pos.get("avg_cost_basis", None)
-
-                    try:
-                        chart.refresh(
-                            self.coin_folders,
-                            current_buy_price=buy_px,
-                            current_sell_price=sell_px,
-                            trail_line=trail_line,
-                            dca_line_price=dca_line_price,
-                            avg_cost_basis=avg_cost_basis,
-                        )
-                    except Exception:
-                        pass
+                self._request_chart_refresh(str(selected_tab).strip().upper())
 
 
 
@@ -3641,6 +4099,9 @@ class PowerTraderHub(tk.Tk):
         self._drain_queue_to_text(self.runner_log_q, self.runner_text)
         self._drain_queue_to_text(self.trader_log_q, self.trader_text)
 
+        # metrics tab (only while it's the visible one)
+        self._refresh_metrics_panel()
+
         # trainer logs: show selected trainer output
         try:
             sel = (self.trainer_coin_var.get() or "").strip().upper()
@@ -3654,11 +4115,116 @@ class PowerTraderHub(tk.Tk):
             pass
 
         self.status.config(text=f"{_now_str()} | hub_dir={self.hub_dir}")
-        self.after(int(float(self.settings.get("ui_refresh_seconds", 1.0)) * 1000), self._tick)
+        self.after(int(loader.suggest_interval(float(self.settings.get("ui_refresh_seconds", 1.0))) * 1000), self._tick)
+
+    def _pump_loader(self) -> None:
+        """Apply finished background loads (Tk thread only)."""
+        try:
+            for apply, result in self.loader.drain():
+                try:
+                    apply(result)
+                except Exception:
+                    pass
+        finally:
+            self.after(LOADER_PUMP_MS, self._pump_loader)
+
+    @staticmethod
+    def _apply_if_changed(apply):
+        """Loaders return None for "unchanged since last time"; skip those."""
+        def _apply(result):
+            if result is not None:
+                apply(result)
+        return _apply
+
+    def _set_training_status(self, status_map: Dict[str, str]) -> None:
+        self._last_status_map = status_map
+
+    def _request_chart_refresh(self, coin: str, replace: bool = False) -> None:
+        """
+        Load a coin chart on the background loader and draw it when ready. replace=True (tab
+        switch, timeframe change) drops a still-running load for the old view.
+        """
+        chart = self.charts.get(coin)
+        if not chart:
+            return
+        try:
+            tf = chart.timeframe_var.get().strip()
+        except Exception:
+            return
+
+        def _apply(data, chart=chart):
+            # drop results for a chart that was rebuilt or is no longer the visible page
+            if self.charts.get(coin) is not chart or getattr(self, "_current_chart_page", None) != coin:
+                return
+            pos = self._last_positions.get(coin, {}) if isinstance(self._last_positions, dict) else {}
+            chart.apply(
+                data,
+                current_buy_price=pos.get("current_buy_price", None),
+                current_sell_price=pos.get("current_sell_price", None),
+                trail_line=pos.get("trail_line", None),
+                dca_line_price=pos.get("dca_line_price", None),
+                avg_cost_basis=pos.get("avg_cost_basis", None),
+            )
 
+        self.loader.submit(("chart", coin), chart.load, _apply, dict(self.coin_folders or {}), tf, replace=replace)
 
 
+
+    def _refresh_metrics_panel(self) -> None:
+        try:
+            if self.logs_nb.select() != str(self.metrics_tab):
+                return
+        except Exception:
+            return
+        now = time.time()
+        if (now - self._last_metrics_refresh) < METRICS_PANEL_REFRESH_SECONDS:
+            return
+        self._last_metrics_refresh = now
+
+        snaps = pt_metrics.load_snapshots(self.hub_dir)
+        lines = []
+        if self._metrics_server is not None:
+            lines.append(f"Prometheus endpoint: http://127.0.0.1:{self._metrics_server_port}/metrics")
+        elif self._metrics_server_error:
+            lines.append(self._metrics_server_error)
+        if not bool(self.settings.get("metrics_enabled", True)):
+            lines.append("Metrics are off (Settings); restart the scripts after turning them on.")
+        if not snaps:
+            lines.append("(no running process has written metrics yet)")
+        for snap in snaps:
+            lines.append("")
+            lines.append(f"{snap.get('process')}  pid {snap.get('pid')}  updated {snap.get('age_s', 0.0):.0f}s ago")
+            timers = snap.get("timers") or {}
+            if timers:
+                lines.append(f"  {'stage':<20}{'count':>10}{'avg ms':>10}{'p50':>9}{'p95':>9}{'p99':>9}{'max ms':>10}")
+                for stage, t in timers.items():
+                    q = [t.get(k) for k in ("p50_ms", "p95_ms", "p99_ms")]
+                    q = [f"{v:>9g}" if v is not None else f"{'-':>9}" for v in q]
+                    lines.append(f"  {stage:<20}{t.get('count', 0):>10}{t.get('avg_ms', 0.0):>10.2f}{''.join(q)}{t.get('max_ms', 0.0):>10.1f}")
+            for title, key in (("counters", "counters"), ("gauges", "gauges")):
+                vals = snap.get(key) or {}
+                if vals:
+                    lines.append(f"  {title}: " + ", ".join(f"{k}={v}" for k, v in vals.items()))
+
+        text = "\n".join(lines)
+        if text == getattr(self, "_last_metrics_text", None):
+            return
+        self._last_metrics_text = text
+        try:
+            top = self.metrics_text.yview()[0]
+            self.metrics_text.delete("1.0", "end")
+            self.metrics_text.insert("end", text)
+            self.metrics_text.yview_moveto(top)
+        except Exception:
+            pass
+
     def _refresh_trader_status(self) -> None:
+        result = self._load_trader_status()
+        if result is not None:
+            self._apply_trader_status(result)
+
+    def _load_trader_status(self) -> Optional[Tuple[Optional[dict], Dict[str, int]]]:
+        """Worker side: (trader_status.json, per-coin DCA count in the rolling 24h), None if unchanged."""
         # mtime cache: rebuilding the whole tree every tick is expensive with many rows
         try:
             mtime = os.path.getmtime(self.trader_status_path)
@@ -3666,10 +4232,70 @@ class PowerTraderHub(tk.Tk):
             mtime = None
 
         if getattr(self, "_last_trader_status_mtime", object()) == mtime:
-            return
+            return None
         self._last_trader_status_mtime = mtime
 
         data = _safe_read_json(self.trader_status_path)
+        if not data:
+            return (None, {})
+
+        # --- precompute per-coin DCA count in rolling 24h (and after last SELL for that coin) ---
+        dca_24h_by_coin: Dict[str, int] = {}
+        try:
+            now = time.time()
+            window_floor = now - (24 * 3600)
+
+            trades = _read_trade_history_jsonl(self.trade_history_path) if self.trade_history_path else []
+
+            last_sell_ts: Dict[str, float] = {}
+            for tr in trades:
+                sym = str(tr.get("symbol", "")).upper().strip()
+                base = sym.split("-")[0].strip() if sym else ""
+                if not base:
+                    continue
+
+                side = str(tr.get("side", "")).lower().strip()
+                if side != "sell":
+                    continue
+
+                try:
+                    tsf = float(tr.get("ts", 0))
+                except Exception:
+                    continue
+
+                prev = float(last_sell_ts.get(base, 0.0))
+                if tsf > prev:
+                    last_sell_ts[base] = tsf
+
+            for tr in trades:
+                sym = str(tr.get("symbol", "")).upper().strip()
+                base = sym.split("-")[0].strip() if sym else ""
+                if not base:
+                    continue
+
+                side = str(tr.get("side", "")).lower().strip()
+                if side != "buy":
+                    continue
+
+                tag = str(tr.get("tag") or "").upper().strip()
+                if tag != "DCA":
+                    continue
+
+                try:
+                    tsf = float(tr.get("ts", 0))
+                except Exception:
+                    continue
+
+                start_ts = max(window_floor, float(last_sell_ts.get(base, 0.0)))
+                if tsf >= start_ts:
+                    dca_24h_by_coin[base] = int(dca_24h_by_coin.get(base, 0)) + 1
+        except Exception:
+            dca_24h_by_coin = {}
+
+        return (data, dca_24h_by_coin)
+
+    def _apply_trader_status(self, result: Tuple[Optional[dict], Dict[str, int]]) -> None:
+        data, dca_24h_by_coin = result
         if not data:
             self.lbl_last_status.config(text="Last status: N/A (no trader_status.json yet)")
 
@@ -3785,59 +4411,6 @@ class PowerTraderHub(tk.Tk):
         positions = data.get("positions", {}) or {}
         self._last_positions = positions
 
-        # --- precompute per-coin DCA count in rolling 24h (and after last SELL for that coin) ---
-        dca_24h_by_coin: Dict[str, int] = {}
-        try:
-            now = time.time()
-            window_floor = now - (24 * 3600)
-
-            trades = _read_trade_history_jsonl(self.trade_history_path) if self.trade_history_path else []
-
-            last_sell_ts: Dict[str, float] = {}
-            for tr in trades:
-                sym = str(tr.get("symbol", "")).upper().strip()
-                base = sym.split("-")[0].strip() if sym else ""
-                if not base:
-                    continue
-
-                side = str(tr.get("side", "")).lower().strip()
-                if side != "sell":
-                    continue
-
-                try:
-                    tsf = float(tr.get("ts", 0))
-                except Exception:
-                    continue
-
-                prev = float(last_sell_ts.get(base, 0.0))
-                if tsf > prev:
-                    last_sell_ts[base] = tsf
-
-            for tr in trades:
-                sym = str(tr.get("symbol", "")).upper().strip()
-                base = sym.split("-")[0].strip() if sym else ""
-                if not base:
-                    continue
-
-                side = str(tr.get("side", "")).lower().strip()
-                if side != "buy":
-                    continue
-
-                tag = str(tr.get("tag") or "").upper().strip()
-                if tag != "DCA":
-                    continue
-
-                try:
-                    tsf = float(tr.get("ts", 0))
-                except Exception:
-                    continue
-
-                start_ts = max(window_floor, float(last_sell_ts.get(base, 0.0)))
-                if tsf >= start_ts:
-                    dca_24h_by_coin[base] = int(dca_24h_by_coin.get(base, 0)) + 1
-        except Exception:
-            dca_24h_by_coin = {}
-
         # rebuild tree (only when file changes)
         for iid in self.trades_tree.get_children():
             self.trades_tree.delete(iid)
@@ -3921,6 +4494,11 @@ class PowerTraderHub(tk.Tk):
 
 
     def _refresh_pnl(self) -> None:
+        result = self._load_pnl()
+        if result is not None:
+            self._apply_pnl(result)
+
+    def _load_pnl(self) -> Optional[Tuple[Optional[dict]]]:
         # mtime cache: avoid reading/parsing every tick
         try:
             mtime = os.path.getmtime(self.pnl_ledger_path)
@@ -3928,10 +4506,12 @@ class PowerTraderHub(tk.Tk):
             mtime = None
 
         if getattr(self, "_last_pnl_mtime", object()) == mtime:
-            return
+            return None
         self._last_pnl_mtime = mtime
+        return (_safe_read_json(self.pnl_ledger_path),)
 
-        data = _safe_read_json(self.pnl_ledger_path)
+    def _apply_pnl(self, result: Tuple[Optional[dict]]) -> None:
+        data = result[0]
         if not data:
             self.lbl_pnl.config(text="Total realized: N/A")
             return
@@ -3940,36 +4520,45 @@ class PowerTraderHub(tk.Tk):
 
 
     def _refresh_trade_history(self) -> None:
-        # mtime cache: avoid reading/parsing/rebuilding the list every tick
-        try:
-            mtime = os.path.getmtime(self.trade_history_path)
-        except Exception:
-            mtime = None
-
-        if getattr(self, "_last_trade_history_mtime", object()) == mtime:
-            return
-        self._last_trade_history_mtime = mtime
-
-        if not os.path.isfile(self.trade_history_path):
+        result = self._load_trade_history()
+        if result is not None:
+            self._apply_trade_history(result)
+
+    def _load_trade_history(self) -> Optional[Tuple[bool, List[dict]]]:
+        """Worker side: (file exists, newest rows), None when nothing changed."""
+        # tail the file: only newly appended lines are parsed; the list is rebuilt only when some arrived
+        tail = getattr(self, "_trade_list_tail", None)
+        if tail is None or tail.path != self.trade_history_path:
+            tail = self._trade_list_tail = pt_history.JsonlTail(self.trade_history_path)
+            self._trade_list_rows = deque(maxlen=TRADE_LIST_ROWS)  # cap for UI
+            self._trade_list_shown = None
+
+        reset, objs = tail.read_new()
+        if reset:
+            self._trade_list_rows.clear()
+        added = 0
+        for o in objs:
+            if isinstance(o, dict):
+                self._trade_list_rows.append(o)
+                added += 1
+
+        exists = os.path.isfile(self.trade_history_path)
+        if self._trade_list_shown == exists and not reset and not added:
+            return None
+        self._trade_list_shown = exists
+        return (exists, list(self._trade_list_rows))
+
+    def _apply_trade_history(self, result: Tuple[bool, List[dict]]) -> None:
+        exists, rows = result
+        if not exists:
             self.hist_list.delete(0, "end")
             self.hist_list.insert("end", "(no trade_history.jsonl yet)")
             return
 
-        # show last N lines
-        try:
-            with open(self.trade_history_path, "r", encoding="utf-8") as f:
-                lines = f.readlines()
-        except Exception:
-            return
-
-        lines = lines[-250:]  # cap for UI
+        # show last N trades
         self.hist_list.delete(0, "end")
-        for line in reversed(lines):
-            line = line.strip()
-            if not line:
-                continue
+        for obj in reversed(rows):
             try:
-                obj = json.loads(line)
                 ts = obj.get("ts", None)
                 tss = time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(ts)) if isinstance(ts, (int, float)) else "?"
                 side = str(obj.get("side", "")).upper()
@@ -4013,7 +4602,7 @@ class PowerTraderHub(tk.Tk):
 
                 self.hist_list.insert("end", txt)
             except Exception:
-                self.hist_list.insert("end", line)
+                self.hist_list.insert("end", json.dumps(obj))
 
 
 
@@ -4172,7 +4761,10 @@ class PowerTraderHub(tk.Tk):
         """
         if not hasattr(self, "neural_tiles"):
             return
+        self._sync_coin_folders()
+        self._apply_neural_overview(self._load_neural_overview(dict(self.coin_folders or {}), list(self.neural_tiles)))
 
+    def _sync_coin_folders(self) -> None:
         # Keep coin_folders aligned with current settings/coins
         try:
             sig = (str(self.settings.get("main_neural_dir") or ""), tuple(self.coins or []))
@@ -4182,6 +4774,8 @@ class PowerTraderHub(tk.Tk):
         except Exception:
             pass
 
+    def _load_neural_overview(self, coin_folders: Dict[str, str], coins: List[str]) -> Tuple[Dict[str, Tuple[int, int]], Optional[float]]:
+        """Worker side: {coin: (long, short)} plus the newest signal file mtime."""
         if not hasattr(self, "_neural_overview_cache"):
             self._neural_overview_cache = {}  # path -> (mtime, value)
 
@@ -4207,16 +4801,17 @@ class PowerTraderHub(tk.Tk):
                 return 0
 
         latest_ts = None
+        values: Dict[str, Tuple[int, int]] = {}
 
-        for coin, tile in list(self.neural_tiles.items()):
+        for coin in coins:
             folder = ""
             try:
-                folder = (self.coin_folders or {}).get(coin, "")
+                folder = (coin_folders or {}).get(coin, "")
             except Exception:
                 folder = ""
 
             if not folder or not os.path.isdir(folder):
-                tile.set_values(0, 0)
+                values[coin] = (0, 0)
                 continue
 
             long_sig = 0
@@ -4243,12 +4838,23 @@ class PowerTraderHub(tk.Tk):
                     if mt:
                         mt_candidates.append(float(mt))
 
-            tile.set_values(long_sig, short_sig)
+            values[coin] = (long_sig, short_sig)
 
             if mt_candidates:
                 mx = max(mt_candidates)
                 latest_ts = mx if (latest_ts is None or mx > latest_ts) else latest_ts
 
+        return values, latest_ts
+
+    def _apply_neural_overview(self, result: Tuple[Dict[str, Tuple[int, int]], Optional[float]]) -> None:
+        values, latest_ts = result
+        for coin, tile in list(getattr(self, "neural_tiles", {}).items()):
+            if coin in values:
+                try:
+                    tile.set_values(*values[coin])
+                except Exception:
+                    pass
+
         # Update "Last:" label
         try:
             if hasattr(self, "lbl_neural_overview_last") and self.lbl_neural_overview_last.winfo_exists():
@@ -4509,6 +5115,22 @@ class PowerTraderHub(tk.Tk):
         chart_refresh_var = tk.StringVar(value=str(self.settings["chart_refresh_seconds"]))
         candles_limit_var = tk.StringVar(value=str(self.settings["candles_limit"]))
         auto_start_var = tk.BooleanVar(value=bool(self.settings.get("auto_start_scripts", False)))
+        parallel_tf_var = tk.BooleanVar(value=bool(self.settings.get("trainer_parallel_timeframes", False)))
+        incremental_var = tk.BooleanVar(value=bool(self.settings.get("trainer_incremental", DEFAULT_SETTINGS.get("trainer_incremental", False))))
+        market_stream_var = tk.BooleanVar(value=bool(self.settings.get("market_stream", DEFAULT_SETTINGS.get("market_stream", False))))
+        signal_mirror_var = tk.BooleanVar(value=bool(self.settings.get("signal_file_mirror", DEFAULT_SETTINGS.get("signal_file_mirror", True))))
+        trainer_max_var = tk.StringVar(value=str(self.settings.get("trainer_max_concurrent", DEFAULT_SETTINGS.get("trainer_max_concurrent", 2))))
+        trainer_cores_var = tk.StringVar(value=str(self.settings.get("trainer_core_budget", DEFAULT_SETTINGS.get("trainer_core_budget", 0))))
+        thinker_workers_var = tk.StringVar(value=str(self.settings.get("thinker_max_workers", DEFAULT_SETTINGS.get("thinker_max_workers", 4))))
+        prune_floor_var = tk.StringVar(value=str(self.settings.get("memory_prune_floor_updates", DEFAULT_SETTINGS.get("memory_prune_floor_updates", 0))))
+        merge_dist_var = tk.StringVar(value=str(self.settings.get("memory_merge_distance", DEFAULT_SETTINGS.get("memory_merge_distance", 0.0))))
+        max_mem_var = tk.StringVar(value=str(self.settings.get("memory_max_per_timeframe", DEFAULT_SETTINGS.get("memory_max_per_timeframe", 0))))
+        match_mode_var = tk.StringVar(value=str(self.settings.get("memory_match_mode", DEFAULT_SETTINGS.get("memory_match_mode", "index"))))
+        match_recall_var = tk.StringVar(value=str(self.settings.get("memory_match_recall", DEFAULT_SETTINGS.get("memory_match_recall", 1.0))))
+        pattern_lengths_var = tk.StringVar(value=str(self.settings.get("trainer_pattern_lengths", DEFAULT_SETTINGS.get("trainer_pattern_lengths", "2"))))
+        trader_pool_var = tk.StringVar(value=str(self.settings.get("trader_api_pool_size", DEFAULT_SETTINGS.get("trader_api_pool_size", 10))))
+        metrics_var = tk.BooleanVar(value=bool(self.settings.get("metrics_enabled", DEFAULT_SETTINGS.get("metrics_enabled", True))))
+        metrics_port_var = tk.StringVar(value=str(self.settings.get("metrics_port", DEFAULT_SETTINGS.get("metrics_port", 0))))
 
         r = 0
         add_row(r, "Main neural folder:", main_dir_var, browse="dir"); r += 1
@@ -5181,10 +5803,36 @@ class PowerTraderHub(tk.Tk):
         add_row(r, "UI refresh seconds:", ui_refresh_var); r += 1
         add_row(r, "Chart refresh seconds:", chart_refresh_var); r += 1
         add_row(r, "Candles limit:", candles_limit_var); r += 1
+        add_row(r, "Max trainers at once (0 = no limit):", trainer_max_var); r += 1
+        add_row(r, "Trainer core budget (0 = all):", trainer_cores_var); r += 1
+        add_row(r, "Thinker coins stepped at once:", thinker_workers_var); r += 1
+        add_row(r, "Trader API connections:", trader_pool_var); r += 1
+        add_row(r, "Prune memories at weight floor after N updates (0 = off):", prune_floor_var); r += 1
+        add_row(r, "Merge memories closer than % (0 = off):", merge_dist_var); r += 1
+        add_row(r, "Max memories per timeframe (0 = no cap):", max_mem_var); r += 1
+        add_row(r, "Memory matching (index/exact/verify):", match_mode_var); r += 1
+        add_row(r, "Memory match recall (0-1):", match_recall_var); r += 1
+        add_row(r, "Candles per pattern (comma, 2-9):", pattern_lengths_var); r += 1
+        add_row(r, "Metrics endpoint port (0 = off):", metrics_port_var); r += 1
 
         chk = ttk.Checkbutton(frm, text="Auto start scripts on GUI launch", variable=auto_start_var)
         chk.grid(row=r, column=0, columnspan=3, sticky="w", pady=(10, 0)); r += 1
 
+        chk_tf = ttk.Checkbutton(frm, text="Train timeframes in parallel (one worker process per timeframe)", variable=parallel_tf_var)
+        chk_tf.grid(row=r, column=0, columnspan=3, sticky="w", pady=(6, 0)); r += 1
+
+        chk_inc = ttk.Checkbutton(frm, text="Incremental retraining (keep memories, only train on new candles)", variable=incremental_var)
+        chk_inc.grid(row=r, column=0, columnspan=3, sticky="w", pady=(6, 0)); r += 1
+
+        chk_stream = ttk.Checkbutton(frm, text="Stream KuCoin market data (WebSocket; thinker/trader poll less, Robinhood prices still used)", variable=market_stream_var)
+        chk_stream.grid(row=r, column=0, columnspan=3, sticky="w", pady=(6, 0)); r += 1
+
+        chk_mirror = ttk.Checkbutton(frm, text="Thinker writes signal text files (needed by the hub charts; trader uses the live feed)", variable=signal_mirror_var)
+        chk_mirror.grid(row=r, column=0, columnspan=3, sticky="w", pady=(6, 0)); r += 1
+
+        chk_metrics = ttk.Checkbutton(frm, text="Record hot-path metrics (timers/counters for the Metrics tab; applies when scripts start)", variable=metrics_var)
+        chk_metrics.grid(row=r, column=0, columnspan=3, sticky="w", pady=(6, 0)); r += 1
+
         btns = ttk.Frame(frm)
         btns.grid(row=r, column=0, columnspan=3, sticky="ew", pady=14)
         btns.columnconfigure(0, weight=1)
@@ -5271,7 +5919,47 @@ class PowerTraderHub(tk.Tk):
                 self.settings["chart_refresh_seconds"] = float(chart_refresh_var.get().strip())
                 self.settings["candles_limit"] = int(float(candles_limit_var.get().strip()))
                 self.settings["auto_start_scripts"] = bool(auto_start_var.get())
+                self.settings["trainer_parallel_timeframes"] = bool(parallel_tf_var.get())
+                self.settings["trainer_incremental"] = bool(incremental_var.get())
+                self.settings["market_stream"] = bool(market_stream_var.get())
+                self.settings["signal_file_mirror"] = bool(signal_mirror_var.get())
+                self.settings["metrics_enabled"] = bool(metrics_var.get())
+                try:
+                    self.settings["metrics_port"] = min(65535, max(0, int(float((metrics_port_var.get() or "").strip() or 0))))
+                except Exception:
+                    self.settings["metrics_port"] = 0
+                try:
+                    self.settings["trainer_max_concurrent"] = max(0, int(float((trainer_max_var.get() or "").strip() or 0)))
+                except Exception:
+                    self.settings["trainer_max_concurrent"] = int(DEFAULT_SETTINGS.get("trainer_max_concurrent", 2))
+                try:
+                    self.settings["trainer_core_budget"] = max(0, int(float((trainer_cores_var.get() or "").strip() or 0)))
+                except Exception:
+                    self.settings["trainer_core_budget"] = 0
+                try:
+                    self.settings["thinker_max_workers"] = max(1, int(float((thinker_workers_var.get() or "").strip() or 1)))
+                except Exception:
+                    self.settings["thinker_max_workers"] = int(DEFAULT_SETTINGS.get("thinker_max_workers", 4))
+                for key, var, conv in (("memory_prune_floor_updates", prune_floor_var, int),
+                                       ("memory_merge_distance", merge_dist_var, float),
+                                       ("memory_max_per_timeframe", max_mem_var, int)):
+                    try:
+                        self.settings[key] = max(0, conv(float((var.get() or "").strip() or 0)))
+                    except Exception:
+                        self.settings[key] = DEFAULT_SETTINGS.get(key, 0)
+                mode = (match_mode_var.get() or "").strip().lower()
+                self.settings["memory_match_mode"] = mode if mode in ("index", "exact", "verify") else "index"
+                try:
+                    self.settings["memory_match_recall"] = min(1.0, max(0.0, float((match_recall_var.get() or "").strip() or 1.0)))
+                except Exception:
+                    self.settings["memory_match_recall"] = float(DEFAULT_SETTINGS.get("memory_match_recall", 1.0))
+                self.settings["trainer_pattern_lengths"] = _pattern_lengths(pattern_lengths_var.get())
+                try:
+                    self.settings["trader_api_pool_size"] = max(1, int(float((trader_pool_var.get() or "").strip() or 1)))
+                except Exception:
+                    self.settings["trader_api_pool_size"] = int(DEFAULT_SETTINGS.get("trader_api_pool_size", 10))
                 self._save_settings()
+                self._start_metrics_server()
 
                 # If new coin(s) were added and their training folder doesn't exist yet,
                 # create the folder and copy neural_trainer.py into it RIGHT AFTER saving settings.
@@ -5325,6 +6013,7 @@ class PowerTraderHub(tk.Tk):
             self.stop_all_scripts()
         except Exception:
             pass
+        self.loader.shutdown()
         self.destroy()
 
 
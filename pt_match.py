@@ -0,0 +1,461 @@
+"""
+Batched pattern-similarity kernel for the trainer and thinker.
+
+Both scripts compare the current pattern against EVERY memory with the same per-candle
+percentage difference:
+
+	diff = 0                                   if c + m == 0
+	diff = abs(abs(c - m) / ((c + m) / 2) * 100) otherwise
+
+and average it over the pattern length. match_patterns() does that for the whole memory
+matrix in one call and returns every diff_avg, the indices at/under the threshold and the
+argmin. NumPy is used when it is installed; otherwise a plain-Python loop over the flat
+pattern column gives identical results (just slower).
+
+match_store() can answer from a PatternIndex instead (POWERTRADER_MATCH_MODE):
+
+	index    (default) bisect a sorted copy of each memory's first value down to the memories
+	         that can be within the threshold, and score only those
+	exact    always scan every memory (match_patterns)
+	verify   do both and report any disagreement (then use the exact answer)
+
+For a single-value pattern (what the thinker passes and what the trainer stores with
+number_of_candles=[2]) the threshold translates into an exact interval on that value, so
+index mode returns the same perfect indices and diffs as a full scan. For longer patterns
+the average can be under the threshold while the first value alone is not, so the first
+value is searched within threshold * (1 + (width - 1) * recall): recall=1.0
+(POWERTRADER_MATCH_RECALL, default) is still exact, lower values trade recall for speed.
+
+match_lengths() scores several pattern widths at once (a store trained with more than one
+number_of_candles, see pt_memory.pattern_widths): the width-w pattern is a memory's first w
+values, so one candidate search at the widest radius and one pass that keeps a running sum of
+the per-value diffs give every width's diff_avg. Without NumPy the pass is a scan generated per
+widths tuple with the widest pattern unrolled (kernel()); with NumPy it is one cumulative sum.
+ensemble_moves() turns the per-width matches into one predicted move / high / low.
+"""
+import os
+import bisect
+
+import pt_metrics
+
+try:
+	import numpy as np
+except Exception:  # numpy is optional, the fallback below produces the same numbers
+	np = None
+
+HAVE_NUMPY = np is not None
+
+MATCH_MODES = ("index", "exact", "verify")
+MATCH_MODE = (os.environ.get("POWERTRADER_MATCH_MODE") or "index").strip().lower()
+if MATCH_MODE not in MATCH_MODES:
+	MATCH_MODE = "index"
+try:
+	MATCH_RECALL = min(1.0, max(0.0, float(os.environ.get("POWERTRADER_MATCH_RECALL") or 1.0)))
+except ValueError:
+	MATCH_RECALL = 1.0
+
+
+def _np_dtype(patterns):
+	code = getattr(patterns, "typecode", None) or getattr(patterns, "format", "d")
+	return np.float32 if code == "f" else np.float64
+
+
+def _match_numpy(current, patterns, pattern_len, count, threshold):
+	# zero-copy view of the store column; only lives for this call so the store can still grow
+	mat = np.frombuffer(patterns, dtype=_np_dtype(patterns), count=count * pattern_len)
+	mat = mat.reshape(count, pattern_len)[:, :len(current)].astype(np.float64, copy=False)
+	width = len(current)
+	cur = np.asarray(current, dtype=np.float64)
+	total = cur + mat
+	with np.errstate(divide="ignore", invalid="ignore"):
+		d = np.abs(np.abs(cur - mat) / (total / 2) * 100)
+	d[total == 0.0] = 0.0
+	diffs = d[:, 0].copy() if width == 1 else d.sum(axis=1) / width
+	del mat, total, d
+	perfect = np.flatnonzero(diffs <= threshold).tolist()
+	best = int(np.argmin(diffs))
+	return diffs.tolist(), perfect, best
+
+
+def _match_python(current, patterns, pattern_len, count, threshold):
+	diffs = []
+	perfect = []
+	best = 0
+	best_diff = None
+	cur = [float(c) for c in current]
+	width = len(cur)
+	if width == 1:
+		c = cur[0]
+		for i in range(count):
+			m = patterns[i * pattern_len]
+			if c + m == 0.0:
+				diff_avg = 0.0
+			else:
+				diff_avg = abs((abs(c - m) / ((c + m) / 2)) * 100)
+			diffs.append(diff_avg)
+			if diff_avg <= threshold:
+				perfect.append(i)
+			if best_diff is None or diff_avg < best_diff:
+				best_diff = diff_avg
+				best = i
+		return diffs, perfect, best
+
+	for i in range(count):
+		base = i * pattern_len
+		total = 0.0
+		for j in range(width):
+			c = cur[j]
+			m = patterns[base + j]
+			if c + m != 0.0:
+				total += abs((abs(c - m) / ((c + m) / 2)) * 100)
+		diff_avg = total / width
+		diffs.append(diff_avg)
+		if diff_avg <= threshold:
+			perfect.append(i)
+		if best_diff is None or diff_avg < best_diff:
+			best_diff = diff_avg
+			best = i
+	return diffs, perfect, best
+
+
+def match_patterns(current_pattern, patterns, pattern_len, threshold, count=None):
+	"""
+	Score `current_pattern` against a row-major pattern matrix.
+
+	patterns    flat buffer (array('d'/'f'), memoryview, list...) of count*pattern_len values
+	Returns (diffs, perfect_indices, argmin). argmin is -1 when there are no memories.
+
+	Like the original loops, only the first len(current_pattern) values of each memory
+	are compared (the thinker passes a single candle).
+	"""
+	pattern_len = int(pattern_len)
+	if count is None:
+		count = len(patterns) // pattern_len if pattern_len else 0
+	if count <= 0 or pattern_len <= 0:
+		return [], [], -1
+	current = [float(v) for v in current_pattern]
+	if not current or len(current) > pattern_len:
+		raise ValueError(f"current pattern has {len(current)} values, memories have {pattern_len}")
+	if np is not None and not isinstance(patterns, list):
+		return _match_numpy(current, patterns, pattern_len, count, threshold)
+	return _match_python(current, patterns, pattern_len, count, threshold)
+
+
+def _score_rows(current, patterns, pattern_len, count, ids):
+	"""Same per-memory diff_avg as the full scan, for just the memories in `ids`."""
+	width = len(current)
+	if np is not None and not isinstance(patterns, list):
+		mat = np.frombuffer(patterns, dtype=_np_dtype(patterns), count=count * pattern_len)
+		mat = mat.reshape(count, pattern_len)[np.asarray(ids, dtype=np.int64), :width].astype(np.float64)
+		cur = np.asarray(current, dtype=np.float64)
+		total = cur + mat
+		with np.errstate(divide="ignore", invalid="ignore"):
+			d = np.abs(np.abs(cur - mat) / (total / 2) * 100)
+		d[total == 0.0] = 0.0
+		diffs = d[:, 0] if width == 1 else d.sum(axis=1) / width
+		return diffs.tolist()
+	out = []
+	for i in ids:
+		base = i * pattern_len
+		if width == 1:
+			c = current[0]
+			m = patterns[base]
+			out.append(0.0 if c + m == 0.0 else abs((abs(c - m) / ((c + m) / 2)) * 100))
+			continue
+		total = 0.0
+		for j in range(width):
+			c = current[j]
+			m = patterns[base + j]
+			if c + m != 0.0:
+				total += abs((abs(c - m) / ((c + m) / 2)) * 100)
+		out.append(total / width)
+	return out
+
+
+class PatternIndex:
+	"""
+	Memories sorted by their first pattern value (keys[k] belongs to memory ids[k]).
+
+	Memories are only ever appended, so sync() inserts the new rows; a store that shrank or
+	was replaced gets a fresh index (pt_memory.MemoryStore.index is reset with the store).
+	"""
+
+	def __init__(self):
+		self.keys = []
+		self.ids = []
+		self.count = 0
+
+	def sync(self, patterns, pattern_len, count) -> None:
+		if count < self.count:
+			self.keys, self.ids, self.count = [], [], 0
+		if count == self.count:
+			return
+		if count - self.count > max(64, self.count // 8):
+			# bulk load / big catch-up: one sort beats many inserts
+			rows = [(patterns[i * pattern_len], i) for i in range(count)]
+			rows.sort()
+			self.keys = [r[0] for r in rows]
+			self.ids = [r[1] for r in rows]
+		else:
+			for i in range(self.count, count):
+				k = patterns[i * pattern_len]
+				pos = bisect.bisect_right(self.keys, k)
+				self.keys.insert(pos, k)
+				self.ids.insert(pos, i)
+		self.count = count
+
+	def candidates(self, c, radius):
+		"""
+		Memory ids whose first value m can satisfy |c - m| / |(c + m) / 2| * 100 <= radius,
+		or None when the radius is too wide to bound (then the caller scans everything).
+		"""
+		k = radius / 200.0
+		if k >= 1.0:
+			return None
+		if c >= 0:
+			lo, hi = c * (1 - k) / (1 + k), c * (1 + k) / (1 - k)
+		else:
+			lo, hi = c * (1 + k) / (1 - k), c * (1 - k) / (1 + k)
+		# widen a hair for float rounding; the exact diff decides afterwards
+		lo -= abs(lo) * 1e-9 + 1e-12
+		hi += abs(hi) * 1e-9 + 1e-12
+		out = self.ids[bisect.bisect_left(self.keys, lo):bisect.bisect_right(self.keys, hi)]
+		# m == -c makes the denominator 0, which the kernel scores as a perfect 0.0
+		if not (lo <= -c <= hi):
+			out = out + self.ids[bisect.bisect_left(self.keys, -c):bisect.bisect_right(self.keys, -c)]
+		return out
+
+	def nearest(self, c):
+		pos = bisect.bisect_left(self.keys, c)
+		return [self.ids[p] for p in (pos - 1, pos) if 0 <= p < len(self.ids)]
+
+
+def _match_indexed(current, store, threshold, recall):
+	patterns, pattern_len, count = store.patterns, store.pattern_len, len(store)
+	index = store.index
+	if index is None:
+		index = store.index = PatternIndex()
+	index.sync(patterns, pattern_len, count)
+
+	width = len(current)
+	radius = threshold if width == 1 else threshold * (1 + (width - 1) * recall)
+	ids = index.candidates(current[0], radius)
+	if ids is None:
+		diffs, perfect, best = match_patterns(current, patterns, pattern_len, threshold, count=count)
+		return dict(enumerate(diffs)), perfect, best
+	ids.sort()
+	if not ids:
+		ids = sorted(index.nearest(current[0]))
+	scored = _score_rows(current, patterns, pattern_len, count, ids) if ids else []
+	diffs = dict(zip(ids, scored))
+	perfect = [i for i, d in zip(ids, scored) if d <= threshold]
+	best = -1
+	for i, d in zip(ids, scored):
+		if best < 0 or d < diffs[best]:
+			best = i
+	return diffs, perfect, best
+
+
+@pt_metrics.timed("match_scan")
+def match_store(current_pattern, store, threshold, mode=None, recall=None):
+	"""
+	match_patterns() over a pt_memory.MemoryStore, through its PatternIndex unless the mode
+	is "exact". In index mode `diffs` is a {memory index: diff_avg} dict holding every
+	scored memory (all perfect ones included) and argmin is the best of those.
+	"""
+	mode = MATCH_MODE if mode is None else mode
+	recall = MATCH_RECALL if recall is None else recall
+	count = len(store)
+	if mode == "exact" or count <= 0:
+		return match_patterns(current_pattern, store.patterns, store.pattern_len, threshold, count=count)
+	current = [float(v) for v in current_pattern]
+	if not current or len(current) > store.pattern_len:
+		raise ValueError(f"current pattern has {len(current)} values, memories have {store.pattern_len}")
+	result = _match_indexed(current, store, threshold, recall)
+	if mode == "verify":
+		diffs, perfect, best = match_patterns(current, store.patterns, store.pattern_len, threshold, count=count)
+		if perfect != result[1] or any(diffs[i] != result[0][i] for i in perfect):
+			print(f"[pt_match] index mismatch: {len(result[1])} vs {len(perfect)} perfect matches (threshold {threshold})")
+		return diffs, perfect, best
+	return result
+
+
+# -----------------------------
+# Several pattern widths in one pass
+# -----------------------------
+
+_KERNELS = {}  # widths tuple -> generated scan function
+
+
+def _kernel_source(widths) -> str:
+	"""
+	Source of a scan specialized for `widths`: the per-value terms of the widest pattern are
+	unrolled, and each width's diff_avg is read off the running sum as it goes by, so every
+	width costs one division, one compare and the appends on top of a single widest scan.
+	Arithmetic and tie-breaking are the same as _match_python().
+	"""
+	last = widths[-1]
+	cur = ", ".join(f"c{j}" for j in range(last))
+	lines = [f"def scan(P, n, rows, thr, {cur}):"]
+	for w in widths:
+		lines.append(f"\td{w} = []; p{w} = []; b{w} = -1; bd{w} = INF")
+	lines.append("\tfor i in rows:")
+	lines.append("\t\tb = i * n")
+	for j in range(last):
+		lines.append(f"\t\tm = P[b + {j}]")
+		lines.append(f"\t\tt = c{j} + m")
+		if j == 0:
+			lines.append("\t\ts = 0.0 if t == 0.0 else abs((abs(c0 - m) / (t / 2)) * 100)")
+		else:
+			lines.append("\t\tif t != 0.0:")
+			lines.append(f"\t\t\ts += abs((abs(c{j} - m) / (t / 2)) * 100)")
+		w = j + 1
+		if w in widths:
+			lines.append("\t\tv = s" if w == 1 else f"\t\tv = s / {w}")
+			lines.append(f"\t\td{w}.append(v)")
+			lines.append("\t\tif v <= thr:")
+			lines.append(f"\t\t\tp{w}.append(i)")
+			lines.append(f"\t\tif v < bd{w}:")
+			lines.append(f"\t\t\tbd{w} = v; b{w} = i")
+	lines.append("\treturn (" + ", ".join(f"(d{w}, p{w}, b{w})" for w in widths) + ",)")
+	return "\n".join(lines) + "\n"
+
+
+def kernel(widths):
+	"""The scan for this widths tuple, generated and compiled the first time it's asked for."""
+	widths = tuple(widths)
+	fn = _KERNELS.get(widths)
+	if fn is None:
+		ns = {"INF": float("inf")}
+		exec(compile(_kernel_source(widths), f"<pt_match kernel {widths}>", "exec"), ns)
+		fn = _KERNELS[widths] = ns["scan"]
+	return fn
+
+
+def _lengths_numpy(current, patterns, pattern_len, count, widths, threshold, ids=None):
+	last = widths[-1]
+	mat = np.frombuffer(patterns, dtype=_np_dtype(patterns), count=count * pattern_len).reshape(count, pattern_len)
+	mat = (mat[:, :last] if ids is None else mat[np.asarray(ids, dtype=np.int64), :last]).astype(np.float64)
+	cur = np.asarray(current[:last], dtype=np.float64)
+	total = cur + mat
+	with np.errstate(divide="ignore", invalid="ignore"):
+		d = np.abs(np.abs(cur - mat) / (total / 2) * 100)
+	d[total == 0.0] = 0.0
+	sums = np.cumsum(d, axis=1)
+	out = []
+	for w in widths:
+		diffs = d[:, 0].copy() if w == 1 else sums[:, w - 1] / w
+		perfect = np.flatnonzero(diffs <= threshold)
+		best = int(np.argmin(diffs)) if len(diffs) else -1
+		if ids is None:
+			out.append((diffs.tolist(), perfect.tolist(), best))
+		else:
+			out.append((diffs.tolist(), [ids[k] for k in perfect.tolist()], ids[best] if best >= 0 else -1))
+	return out
+
+
+def _scan_lengths(current, patterns, pattern_len, count, widths, threshold, ids=None):
+	"""[(diffs, perfect, argmin) per width] over all memories, or just `ids` (sorted)."""
+	if np is not None and not isinstance(patterns, list):
+		return _lengths_numpy(current, patterns, pattern_len, count, widths, threshold, ids)
+	rows = range(count) if ids is None else ids
+	out = kernel(widths)(patterns, pattern_len, rows, threshold, *current[:widths[-1]])
+	if rows:
+		# a NaN row never wins the `<` compare; the plain loop falls back to the first row the same way
+		out = tuple((d, p, b if b >= 0 else rows[0]) for d, p, b in out)
+	return list(out)
+
+
+@pt_metrics.timed("match_scan")
+def _match_lengths(current, store, threshold, widths, mode, recall):
+	patterns, pattern_len, count = store.patterns, store.pattern_len, len(store)
+	if mode == "exact":
+		return dict(zip(widths, _scan_lengths(current, patterns, pattern_len, count, widths, threshold)))
+
+	index = store.index
+	if index is None:
+		index = store.index = PatternIndex()
+	index.sync(patterns, pattern_len, count)
+	# the widest radius bounds every narrower width too: one candidate set, one scoring pass
+	last = widths[-1]
+	radius = threshold if last == 1 else threshold * (1 + (last - 1) * recall)
+	ids = index.candidates(current[0], radius)
+	if ids is None:
+		result = dict(zip(widths, _scan_lengths(current, patterns, pattern_len, count, widths, threshold)))
+	else:
+		ids.sort()
+		if not ids:
+			ids = sorted(index.nearest(current[0]))
+		scored = _scan_lengths(current, patterns, pattern_len, count, widths, threshold, ids) if ids else [([], [], -1)] * len(widths)
+		result = {w: (dict(zip(ids, d)), p, b) for w, (d, p, b) in zip(widths, scored)}
+
+	if mode == "verify":
+		exact = dict(zip(widths, _scan_lengths(current, patterns, pattern_len, count, widths, threshold)))
+		for w in widths:
+			if exact[w][1] != result[w][1]:
+				print(f"[pt_match] index mismatch at width {w}: {len(result[w][1])} vs {len(exact[w][1])} perfect matches (threshold {threshold})")
+		return exact
+	return result
+
+
+def match_lengths(current_pattern, store, threshold, widths, mode=None, recall=None):
+	"""
+	match_store() at several pattern widths at once: {width: (diffs, perfect, argmin)}, where
+	the width-w pattern is the first w values of `current_pattern` and of every memory
+	(newest candle first, see pt_memory.pattern_widths). One pass scores them all, so the
+	cost follows the widest pattern, not the number of widths. A single width is exactly
+	match_store().
+	"""
+	widths = tuple(sorted({int(w) for w in widths}))
+	if not widths:
+		return {}
+	if len(widths) == 1:
+		w = widths[0]
+		return {w: match_store(list(current_pattern)[:w], store, threshold, mode=mode, recall=recall)}
+	mode = MATCH_MODE if mode is None else mode
+	recall = MATCH_RECALL if recall is None else recall
+	current = [float(v) for v in current_pattern]
+	if widths[0] < 1 or widths[-1] > len(current) or widths[-1] > store.pattern_len:
+		raise ValueError(f"widths {widths} need {widths[-1]} values, have {len(current)} (memories have {store.pattern_len})")
+	if len(store) <= 0:
+		return {w: ([], [], -1) for w in widths}
+	return _match_lengths(current, store, threshold, widths, mode, recall)
+
+
+def perfect_union(results) -> list:
+	"""Every memory that is a perfect match at any width, in row order."""
+	if len(results) == 1:
+		return list(next(iter(results.values()))[1])
+	rows = set()
+	for _diffs, perfect, _best in results.values():
+		rows.update(perfect)
+	return sorted(rows)
+
+
+def ensemble_moves(store, results, skip_zero_weights=False):
+	"""
+	One (move, high move, low move) prediction from match_lengths() results. Each width with
+	perfect matches predicts the mean of their weighted moves (high/low diffs as fractions),
+	as a single-width prediction always did; the widths that predicted get an equal vote.
+	skip_zero_weights leaves zero-weight memories out of a mean (the thinker's rule). None
+	when no width could predict.
+	"""
+	preds = []
+	for w in sorted(results):
+		moves, high_moves, low_moves = [], [], []
+		for i in results[w][1]:
+			weight, high_weight, low_weight = store.weights[i], store.high_weights[i], store.low_weights[i]
+			if not skip_zero_weights or weight != 0.0:
+				moves.append(store.moves[i] * weight)
+			if not skip_zero_weights or high_weight != 0.0:
+				high_moves.append(store.high_diffs[i] / 100 * high_weight)
+			if not skip_zero_weights or low_weight != 0.0:
+				low_moves.append(store.low_diffs[i] / 100 * low_weight)
+		if moves and high_moves and low_moves:
+			preds.append((sum(moves) / len(moves), sum(high_moves) / len(high_moves), sum(low_moves) / len(low_moves)))
+	if not preds:
+		return None
+	if len(preds) == 1:
+		return preds[0]
+	n = len(preds)
+	return tuple(sum(p[k] for p in preds) / n for k in range(3))
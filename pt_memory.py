@@ -0,0 +1,847 @@
+"""
+Binary pattern-memory store shared by pt_trainer.py and pt_thinker.py.
+
+Replaces the old text files (memories_<tf>.txt + memory_weights[_high|_low]_<tf>.txt)
+with ONE versioned, columnar file per timeframe:
+
+	memories_<tf>.ptm
+
+Layout (little-endian):
+
+	header (64 bytes)
+		magic        8s   b"PTMEMORY"
+		version      u32
+		float_size   u32  4 = float32, 8 = float64
+		pattern_len  u32  values per pattern (the "move" is stored separately)
+		flags        u32  bits 0-15: the pattern widths the memories are scored at (bit w-1 set =
+		                  width w, see pattern_widths()); 0 = the single-value default
+		count        u64  number of memories (rows)
+		generation   u64  bumped on every save so readers can detect changes cheaply
+		                  (seeded from a ms timestamp when a store is first created)
+		reserved     24 bytes
+
+	columns (each one is `count` rows, stored back to back in this order)
+		patterns      count * pattern_len   (row-major pattern matrix)
+		moves         count                 (close move % of the candle AFTER the pattern)
+		high_diffs    count                 (high move %)
+		low_diffs     count                 (low move %)
+		weights       count
+		high_weights  count
+		low_weights   count
+		floor_streaks count   (version 2+) consecutive weight updates that left all three
+		                      weights at their floor (-2.0 / 0.0 / 0.0); prune() uses it
+
+Version 1 files (no floor_streaks column) still load, with every streak at 0.
+
+A store with widths in its flags holds each pattern newest candle first, so the width-w pattern
+is the row's first w values (what pt_match compares) and every width shares the first-value
+index. Flags 0 is what every store had before: one width, the first value.
+
+Because every column is fixed-width and contiguous, a reader can mmap the file and look
+at any column without parsing anything (see MemoryStore.load(..., mapped=True)).
+
+Changes between full saves go to an append-only journal next to the store:
+
+	memories_<tf>.ptj
+
+	header (32 bytes)
+		magic            8s   b"PTJOURNL"
+		version          u32
+		pattern_len      u32
+		base_generation  u64  generation of the .ptm these records apply on top of
+		reserved         8 bytes
+
+	records (repeated)
+		kind u8, payload length u16, crc32(payload) u32, payload
+		kind 1 = append   payload: row u64, pattern..., move, high_diff, low_diff, w, high_w, low_w (f64)
+		kind 2 = weights  payload: row u64, w, high_w, low_w (f64)
+
+A reader replays records in order and stops at the first truncated/corrupt one, so a crash in
+the middle of an append only loses that tail. A journal whose base_generation doesn't match
+the store is ignored: this is the window where a compaction already saved the store but
+hadn't reset the journal yet, so those records are already in the store.
+
+CLI:
+	python pt_memory.py migrate [folder ...]        one-shot text -> binary migration
+	python pt_memory.py export <folder> [tf ...]    write the old text files (debugging)
+	python pt_memory.py info <folder>               print row counts / generations
+	python pt_memory.py compact <folder>            fold journals into their stores
+	python pt_memory.py prune <folder> [--floor N] [--merge D] [--cap M] [tf ...]
+	                                                drop / merge / cap memories (see prune())
+"""
+import os
+import sys
+import mmap
+import struct
+import time
+import zlib
+from array import array
+
+import pt_metrics
+
+TF_CHOICES = ['1hour', '2hour', '4hour', '8hour', '12hour', '1day', '1week']
+
+MAGIC = b"PTMEMORY"
+VERSION = 2
+HEADER_STRUCT = struct.Struct("<8sIIIIQQ24x")
+HEADER_SIZE = HEADER_STRUCT.size  # 64
+
+# per-row float columns (after the pattern matrix), in file order
+COLUMNS = ("moves", "high_diffs", "low_diffs", "weights", "high_weights", "low_weights")
+V2_COLUMNS = ("floor_streaks",)  # appended after COLUMNS from file version 2 on
+
+# header flag bits: bit w-1 set = the memories are scored at pattern width w
+WIDTH_FLAGS_MASK = 0xFFFF
+MAX_PATTERN_WIDTH = 8
+
+# weight clamps used by the trainer; a memory with all three at the floor contributes nothing
+WEIGHT_FLOOR = -2.0
+HIGH_LOW_WEIGHT_FLOOR = 0.0
+
+REMAP_MAGIC = b"PTREMAP\0"
+REMAP_HEADER_STRUCT = struct.Struct("<8sQQQ")  # magic, old_generation, new_generation, old_count
+
+JOURNAL_MAGIC = b"PTJOURNL"
+JOURNAL_VERSION = 1
+JOURNAL_HEADER_STRUCT = struct.Struct("<8sIIQ8x")
+JOURNAL_HEADER_SIZE = JOURNAL_HEADER_STRUCT.size  # 32
+RECORD_STRUCT = struct.Struct("<BHI")
+REC_APPEND = 1
+REC_WEIGHTS = 2
+
+_TYPECODES = {4: "f", 8: "d"}
+_SWAP = sys.byteorder != "little"
+
+
+def store_path(tf_choice: str, folder: str = "") -> str:
+	return os.path.join(folder, f"memories_{tf_choice}.ptm")
+
+
+def journal_path(tf_choice: str, folder: str = "") -> str:
+	return os.path.join(folder, f"memories_{tf_choice}.ptj")
+
+
+def legacy_paths(tf_choice: str, folder: str = "") -> dict:
+	return {
+		"memories": os.path.join(folder, f"memories_{tf_choice}.txt"),
+		"weights": os.path.join(folder, f"memory_weights_{tf_choice}.txt"),
+		"high_weights": os.path.join(folder, f"memory_weights_high_{tf_choice}.txt"),
+		"low_weights": os.path.join(folder, f"memory_weights_low_{tf_choice}.txt"),
+	}
+
+
+def fsync_dir(path: str) -> None:
+	"""Make a rename of `path` durable: fsync its folder (POSIX; Windows can't open a folder, skipped)."""
+	try:
+		fd = os.open(os.path.dirname(os.path.abspath(path)), os.O_RDONLY)
+	except (OSError, AttributeError):
+		return
+	try:
+		os.fsync(fd)
+	except OSError:
+		pass
+	finally:
+		os.close(fd)
+
+
+class MemoryStore:
+	"""
+	In-RAM view of one timeframe's memories.
+
+	Columns are array('d') / array('f') when loaded normally (mutable, appendable),
+	or read-only memoryviews over an mmap when loaded with mapped=True.
+	"""
+
+	def __init__(self, pattern_len: int = 1, float_size: int = 8):
+		if float_size not in _TYPECODES:
+			raise ValueError(f"float_size must be 4 or 8, got {float_size}")
+		self.pattern_len = int(pattern_len)
+		self.float_size = int(float_size)
+		self.typecode = _TYPECODES[self.float_size]
+		# new stores start their generation at a ms timestamp, so a store rebuilt from scratch
+		# (hub deletes + retrains) never reuses a generation a reader already has cached
+		self.generation = int(time.time() * 1000)
+		self.flags = 0
+		self.patterns = array(self.typecode)
+		for name in COLUMNS + V2_COLUMNS:
+			setattr(self, name, array(self.typecode))
+		self._mmap = None
+		self.journal = None  # MemoryJournal; when set, append()/set_weights() record their changes
+		self.index = None  # pt_match.PatternIndex over the first pattern value, synced lazily by match_store()
+
+	def __len__(self) -> int:
+		return len(self.moves)
+
+	# ---- row access ----
+
+	def pattern(self, i: int):
+		n = self.pattern_len
+		return self.patterns[i * n:(i + 1) * n]
+
+	def append(self, pattern, move, high_diff, low_diff, weight=1.0, high_weight=1.0, low_weight=1.0) -> int:
+		"""Append one memory; returns its index."""
+		if len(pattern) != self.pattern_len:
+			raise ValueError(f"pattern length {len(pattern)} != store pattern_len {self.pattern_len}")
+		self.patterns.extend([float(v) for v in pattern])
+		self.moves.append(float(move))
+		self.high_diffs.append(float(high_diff))
+		self.low_diffs.append(float(low_diff))
+		self.weights.append(float(weight))
+		self.high_weights.append(float(high_weight))
+		self.low_weights.append(float(low_weight))
+		self.floor_streaks.append(0.0)
+		i = len(self.moves) - 1
+		if self.journal is not None:
+			self.journal.log_append(self, i)
+		return i
+
+	def set_weights(self, updates) -> None:
+		"""
+		Apply a batch of (row, weight, high_weight, low_weight) updates in place.
+		Plain indexed writes into the typed columns, O(1) per update; later entries win.
+		"""
+		journal = self.journal
+		for i, w, hw, lw in updates:
+			self._set_row_weights(i, w, hw, lw)
+			if journal is not None:
+				journal.log_weights(i, w, hw, lw)
+
+	def _set_row_weights(self, i, w, hw, lw) -> None:
+		self.weights[i] = w
+		self.high_weights[i] = hw
+		self.low_weights[i] = lw
+		if w <= WEIGHT_FLOOR and hw <= HIGH_LOW_WEIGHT_FLOOR and lw <= HIGH_LOW_WEIGHT_FLOOR:
+			self.floor_streaks[i] += 1.0
+		else:
+			self.floor_streaks[i] = 0.0
+
+	# ---- (de)serialization ----
+
+	def to_bytes(self) -> bytes:
+		count = len(self)
+		header = HEADER_STRUCT.pack(MAGIC, VERSION, self.float_size, self.pattern_len, self.flags, count, self.generation)
+		parts = [header]
+		for col in (self.patterns,) + tuple(getattr(self, name) for name in COLUMNS + V2_COLUMNS):
+			a = col if isinstance(col, array) else array(self.typecode, col)
+			if _SWAP:
+				a = array(self.typecode, a)
+				a.byteswap()
+			parts.append(a.tobytes())
+		return b"".join(parts)
+
+	@classmethod
+	def from_buffer(cls, buf, mapped: bool = False) -> "MemoryStore":
+		"""Build a store from raw file bytes. mapped=True keeps zero-copy memoryviews into `buf`."""
+		if len(buf) < HEADER_SIZE:
+			raise ValueError("memory store truncated (no header)")
+		magic, version, float_size, pattern_len, flags, count, generation = HEADER_STRUCT.unpack_from(buf, 0)
+		if magic != MAGIC:
+			raise ValueError("not a PowerTrader memory store")
+		if version > VERSION:
+			raise ValueError(f"memory store version {version} is newer than this code ({VERSION})")
+
+		st = cls(pattern_len=pattern_len, float_size=float_size)
+		st.generation = int(generation)
+		st.flags = int(flags)
+
+		names = COLUMNS + (V2_COLUMNS if version >= 2 else ())
+		sizes = [count * pattern_len] + [count] * len(names)
+		need = HEADER_SIZE + sum(sizes) * float_size
+		if len(buf) < need:
+			raise ValueError(f"memory store truncated ({len(buf)} < {need} bytes)")
+
+		view = memoryview(buf)
+		off = HEADER_SIZE
+		cols = []
+		for n in sizes:
+			raw = view[off:off + n * float_size]
+			off += n * float_size
+			if mapped and not _SWAP:
+				cols.append(raw.cast(st.typecode))
+			else:
+				a = array(st.typecode)
+				a.frombytes(raw)
+				if _SWAP:
+					a.byteswap()
+				cols.append(a)
+
+		st.patterns = cols[0]
+		for name, col in zip(names, cols[1:]):
+			setattr(st, name, col)
+		if version < 2:
+			st.floor_streaks = array(st.typecode, bytes(count * float_size))
+		return st
+
+	@classmethod
+	def load(cls, path: str, mapped: bool = False) -> "MemoryStore":
+		"""
+		Load a .ptm file.
+
+		mapped=True maps the file and exposes read-only column views (no copy at all).
+		Call close() when done; on Windows a mapped file can't be replaced by the trainer
+		while the map is open, so long-lived readers should prefer the default copy mode.
+		"""
+		if not mapped:
+			with open(path, "rb") as f:
+				return cls.from_buffer(f.read())
+		f = open(path, "rb")
+		try:
+			mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+		finally:
+			f.close()
+		st = cls.from_buffer(mm, mapped=True)
+		st._mmap = mm
+		return st
+
+	def close(self) -> None:
+		mm = self._mmap
+		if mm is None:
+			return
+		# drop the views first, mmap refuses to close while exported buffers exist
+		self.patterns = array(self.typecode)
+		for name in COLUMNS + V2_COLUMNS:
+			setattr(self, name, array(self.typecode))
+		self._mmap = None
+		try:
+			mm.close()
+		except Exception:
+			pass
+
+	def save(self, path: str) -> None:
+		"""
+		Atomic write (tmp + os.replace) so readers never see a half-written store. The tmp file
+		and the folder are fsynced, so a power loss leaves the old store or the new one.
+		"""
+		self.generation += 1
+		tmp = path + ".tmp"
+		with open(tmp, "wb") as f:
+			f.write(self.to_bytes())
+			f.flush()
+			os.fsync(f.fileno())
+		os.replace(tmp, path)
+		fsync_dir(path)
+
+
+# -----------------------------
+# Append-only journal
+# -----------------------------
+
+class MemoryJournal:
+	"""
+	Buffers store changes in RAM and appends them to memories_<tf>.ptj on write().
+	write() cost is proportional to the number of changes, not to the store size.
+	"""
+
+	def __init__(self, path: str, pattern_len: int, base_generation: int):
+		self.path = path
+		self.pattern_len = int(pattern_len)
+		self.base_generation = int(base_generation)
+		self._buf = []
+		self.records = 0  # pending + already on disk since the last reset
+
+	@property
+	def pending(self) -> int:
+		return len(self._buf)
+
+	def _add(self, kind: int, payload: bytes) -> None:
+		self._buf.append(RECORD_STRUCT.pack(kind, len(payload), zlib.crc32(payload)) + payload)
+		self.records += 1
+
+	def log_append(self, store: MemoryStore, i: int) -> None:
+		if self.records == 0:
+			self.pattern_len = store.pattern_len  # an empty store may have just picked its pattern length
+		values = list(store.pattern(i)) + [store.moves[i], store.high_diffs[i], store.low_diffs[i], store.weights[i], store.high_weights[i], store.low_weights[i]]
+		self._add(REC_APPEND, struct.pack(f"<Q{len(values)}d", i, *values))
+
+	def log_weights(self, i: int, weight: float, high_weight: float, low_weight: float) -> None:
+		self._add(REC_WEIGHTS, struct.pack("<Q3d", i, weight, high_weight, low_weight))
+
+	def _header(self) -> bytes:
+		return JOURNAL_HEADER_STRUCT.pack(JOURNAL_MAGIC, JOURNAL_VERSION, self.pattern_len, self.base_generation)
+
+	def reset(self, base_generation: int, pattern_len: int = None) -> None:
+		"""Start an empty journal on top of a freshly saved store (atomic tmp + os.replace)."""
+		self.base_generation = int(base_generation)
+		if pattern_len is not None:
+			self.pattern_len = int(pattern_len)
+		self._buf = []
+		self.records = 0
+		tmp = self.path + ".tmp"
+		with open(tmp, "wb") as f:
+			f.write(self._header())
+			f.flush()
+			os.fsync(f.fileno())
+		os.replace(tmp, self.path)
+		fsync_dir(self.path)
+
+	def write(self) -> int:
+		"""Append buffered records (one write + fsync). Returns the number written."""
+		if not self._buf:
+			return 0
+		valid = False
+		try:
+			with open(self.path, "rb") as f:
+				hdr = read_journal_header(f.read(JOURNAL_HEADER_SIZE))
+			valid = hdr is not None and hdr["base_generation"] == self.base_generation and hdr["pattern_len"] == self.pattern_len
+		except OSError:
+			valid = False
+		if not valid:
+			buf = self._buf
+			records = self.records
+			self.reset(self.base_generation)
+			self._buf = buf
+			self.records = records
+		data = b"".join(self._buf)
+		with open(self.path, "ab") as f:
+			f.write(data)
+			f.flush()
+			os.fsync(f.fileno())
+		n = len(self._buf)
+		self._buf = []
+		return n
+
+
+def read_journal_header(raw: bytes):
+	if len(raw) < JOURNAL_HEADER_SIZE:
+		return None
+	magic, version, pattern_len, base_generation = JOURNAL_HEADER_STRUCT.unpack_from(raw, 0)
+	if magic != JOURNAL_MAGIC or version > JOURNAL_VERSION:
+		return None
+	return {"version": version, "pattern_len": pattern_len, "base_generation": base_generation}
+
+
+def replay_journal(store: MemoryStore, path: str) -> int:
+	"""
+	Apply a journal on top of `store` (in place). Returns the number of records applied;
+	0 when the journal is missing, empty, or belongs to another generation of the store.
+	"""
+	try:
+		with open(path, "rb") as f:
+			raw = f.read()
+	except OSError:
+		return 0
+	hdr = read_journal_header(raw)
+	if hdr is None or hdr["base_generation"] != store.generation:
+		return 0
+	if len(store) and hdr["pattern_len"] != store.pattern_len:
+		return 0
+	if not len(store):
+		store.pattern_len = hdr["pattern_len"]
+
+	n = store.pattern_len
+	append_size = 8 + (n + 6) * 8
+	journal, store.journal = store.journal, None  # don't re-log what we replay
+	applied = 0
+	off = JOURNAL_HEADER_SIZE
+	try:
+		while off + RECORD_STRUCT.size <= len(raw):
+			kind, length, crc = RECORD_STRUCT.unpack_from(raw, off)
+			payload = raw[off + RECORD_STRUCT.size:off + RECORD_STRUCT.size + length]
+			if len(payload) != length or zlib.crc32(payload) != crc:
+				break
+			if kind == REC_APPEND and length == append_size:
+				vals = struct.unpack(f"<Q{n + 6}d", payload)
+				if vals[0] != len(store):
+					break
+				store.append(vals[1:n + 1], *vals[n + 1:])
+			elif kind == REC_WEIGHTS and length == 32:
+				i, w, hw, lw = struct.unpack("<Q3d", payload)
+				if i >= len(store):
+					break
+				store._set_row_weights(i, w, hw, lw)
+			else:
+				break
+			off += RECORD_STRUCT.size + length
+			applied += 1
+	finally:
+		store.journal = journal
+	return applied
+
+
+def compact(store: MemoryStore, tf_choice: str, folder: str = "") -> None:
+	"""Fold everything into a fresh .ptm and start an empty journal on top of it."""
+	path = store_path(tf_choice, folder)
+	store.save(path)
+	if store.journal is not None:
+		store.journal.reset(store.generation, store.pattern_len)
+	else:
+		jp = journal_path(tf_choice, folder)
+		if os.path.isfile(jp):
+			MemoryJournal(jp, store.pattern_len, store.generation).reset(store.generation)
+
+
+# -----------------------------
+# Pruning / compaction policy
+# -----------------------------
+
+def _pattern_diff(a, b) -> float:
+	"""Same per-value % difference the matcher uses (pt_match), averaged over the pattern."""
+	total = 0.0
+	for x, y in zip(a, b):
+		if x + y != 0.0:
+			total += abs((abs(x - y) / ((x + y) / 2)) * 100)
+	return total / max(1, len(a))
+
+
+def prune(store: MemoryStore, floor_updates: int = 0, merge_distance: float = 0.0, max_memories: int = 0):
+	"""
+	Build a smaller copy of `store`. Returns (new_store, remap) where remap[old_row] is the
+	row that now stands for it (-1 = dropped). Steps, each off when its knob is 0:
+
+	floor_updates   drop memories whose floor streak reached this many weight updates
+	merge_distance  merge memories whose patterns differ by <= this % (neighbours in
+	                first-value order): the earliest row survives, with the group's mean
+	                move / diffs / weights and its smallest floor streak
+	max_memories    keep at most this many, dropping the lowest weight sum first (older
+	                first on ties)
+
+	Survivors keep their relative order, so the new rows are still in training order.
+	"""
+	n = len(store)
+	pl = store.pattern_len
+	alive = [True] * n
+	target = list(range(n))  # row whose merged values represent this row
+
+	if floor_updates and floor_updates > 0:
+		for i in range(n):
+			if store.floor_streaks[i] >= floor_updates:
+				alive[i] = False
+
+	groups = {}
+	if merge_distance and merge_distance > 0:
+		order = sorted((i for i in range(n) if alive[i]), key=lambda i: (store.patterns[i * pl], i))
+		k = 0
+		while k < len(order):
+			rep = order[k]
+			rep_pat = store.pattern(rep)
+			members = [rep]
+			k += 1
+			while k < len(order) and _pattern_diff(rep_pat, store.pattern(order[k])) <= merge_distance:
+				members.append(order[k])
+				k += 1
+			if len(members) > 1:
+				keep = min(members)
+				groups[keep] = members
+				for m in members:
+					target[m] = keep
+					if m != keep:
+						alive[m] = False
+
+	if max_memories and max_memories > 0:
+		survivors = [i for i in range(n) if alive[i]]
+		if len(survivors) > max_memories:
+			def score(i):
+				members = groups.get(i, [i])
+				return sum(store.weights[m] + store.high_weights[m] + store.low_weights[m] for m in members) / len(members)
+			ranked = sorted(survivors, key=lambda i: (score(i), i))
+			for i in ranked[:len(survivors) - max_memories]:
+				alive[i] = False
+
+	new = MemoryStore(pattern_len=pl, float_size=store.float_size)
+	new.generation = store.generation
+	new.flags = store.flags
+	new_row = {}
+	for i in range(n):
+		if not alive[i]:
+			continue
+		members = groups.get(i, [i])
+		c = float(len(members))
+		new_row[i] = new.append(
+			store.pattern(i),
+			sum(store.moves[m] for m in members) / c,
+			sum(store.high_diffs[m] for m in members) / c,
+			sum(store.low_diffs[m] for m in members) / c,
+			sum(store.weights[m] for m in members) / c,
+			sum(store.high_weights[m] for m in members) / c,
+			sum(store.low_weights[m] for m in members) / c,
+		)
+		new.floor_streaks[new_row[i]] = min(store.floor_streaks[m] for m in members)
+
+	remap = array("q", [new_row.get(target[i], -1) if alive[target[i]] else -1 for i in range(n)])
+	return new, remap
+
+
+def remap_path(tf_choice: str, folder: str = "") -> str:
+	return os.path.join(folder or "", f"memories_{tf_choice}.ptr")
+
+
+def write_remap(path: str, remap, old_generation: int, new_generation: int) -> None:
+	"""old row -> new row (-1 = dropped) for the compaction old_generation -> new_generation."""
+	a = array("q", remap)
+	if _SWAP:
+		a.byteswap()
+	tmp = path + ".tmp"
+	with open(tmp, "wb") as f:
+		f.write(REMAP_HEADER_STRUCT.pack(REMAP_MAGIC, int(old_generation), int(new_generation), len(remap)))
+		f.write(a.tobytes())
+		f.flush()
+		os.fsync(f.fileno())
+	os.replace(tmp, path)
+	fsync_dir(path)
+
+
+def read_remap(path: str):
+	"""(old_generation, new_generation, array of new rows) or None."""
+	try:
+		with open(path, "rb") as f:
+			raw = f.read()
+		magic, old_gen, new_gen, count = REMAP_HEADER_STRUCT.unpack_from(raw, 0)
+		if magic != REMAP_MAGIC:
+			return None
+		a = array("q")
+		a.frombytes(raw[REMAP_HEADER_STRUCT.size:REMAP_HEADER_STRUCT.size + count * 8])
+		if _SWAP:
+			a.byteswap()
+		return old_gen, new_gen, a
+	except Exception:
+		return None
+
+
+def prune_timeframe(store: MemoryStore, tf_choice: str, folder: str = "", **policy):
+	"""
+	prune() + save: the pruned store replaces the .ptm (journal reset on top of it) and the
+	row remap goes to memories_<tf>.ptr. Returns the new store, or `store` itself when
+	nothing was dropped. The caller's journal (if any) moves over to the new store.
+	"""
+	new, remap = prune(store, **policy)
+	if len(new) == len(store):
+		return store
+	old_generation = store.generation
+	new.journal = store.journal
+	compact(new, tf_choice, folder)
+	write_remap(remap_path(tf_choice, folder), remap, old_generation, new.generation)
+	return new
+
+
+# -----------------------------
+# Legacy text format
+# -----------------------------
+
+def _clean_tokens(raw: str, sep: str) -> list:
+	raw = raw.replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '')
+	return raw.split(sep)
+
+
+def _read_optional(path: str) -> str:
+	try:
+		with open(path, "r", encoding="utf-8", errors="ignore") as f:
+			return f.read()
+	except Exception:
+		return ""
+
+
+def read_text_memory(tf_choice: str, folder: str = "", float_size: int = 8) -> MemoryStore:
+	"""
+	Parse the old memories_<tf>.txt / memory_weights_*_<tf>.txt files into a MemoryStore.
+
+	Entries that don't parse (or don't match the dominant pattern width) are skipped
+	together with their weights so the columns stay aligned.
+	"""
+	paths = legacy_paths(tf_choice, folder)
+	entries = [e for e in _clean_tokens(_read_optional(paths["memories"]), '~') if e.strip() != ""]
+	weights = {}
+	for key in ("weights", "high_weights", "low_weights"):
+		weights[key] = [w for w in _clean_tokens(_read_optional(paths[key]), ' ') if w.strip() != ""]
+
+	rows = []
+	for i, entry in enumerate(entries):
+		try:
+			parts = entry.split('{}')
+			values = [float(v) for v in parts[0].split(' ') if v.strip() != ""]
+			high_diff = float(parts[1].replace(' ', ''))
+			low_diff = float(parts[2].replace(' ', ''))
+			if len(values) < 2:
+				continue
+		except Exception:
+			continue
+		w = []
+		for key in ("weights", "high_weights", "low_weights"):
+			try:
+				w.append(float(weights[key][i]))
+			except Exception:
+				w.append(1.0)
+		rows.append((values, high_diff, low_diff, w))
+
+	if not rows:
+		return MemoryStore(pattern_len=1, float_size=float_size)
+
+	widths = {}
+	for values, _h, _l, _w in rows:
+		widths[len(values)] = widths.get(len(values), 0) + 1
+	width = max(widths, key=lambda k: widths[k])
+
+	st = MemoryStore(pattern_len=width - 1, float_size=float_size)
+	for values, high_diff, low_diff, w in rows:
+		if len(values) != width:
+			continue
+		st.append(values[:-1], values[-1], high_diff, low_diff, w[0], w[1], w[2])
+	return st
+
+
+def export_text(st: MemoryStore, tf_choice: str, folder: str = "") -> None:
+	"""Write a store back out in the legacy text format (handy for eyeballing / diffing)."""
+	paths = legacy_paths(tf_choice, folder)
+	entries = []
+	for i in range(len(st)):
+		values = list(st.pattern(i)) + [st.moves[i]]
+		entries.append(" ".join(str(float(v)) for v in values) + "{}" + str(float(st.high_diffs[i])) + "{}" + str(float(st.low_diffs[i])))
+	with open(paths["memories"], "w+", encoding="utf-8") as f:
+		f.write("~".join(entries))
+	for key, col in (("weights", st.weights), ("high_weights", st.high_weights), ("low_weights", st.low_weights)):
+		with open(paths[key], "w+", encoding="utf-8") as f:
+			f.write(" ".join(str(float(x)) for x in col))
+
+
+def widths_flags(widths) -> int:
+	"""Header flag bits for a set of pattern widths; (1,) is the default and stays 0."""
+	widths = sorted({int(w) for w in widths})
+	if not widths or widths == [1]:
+		return 0
+	if widths[0] < 1 or widths[-1] > MAX_PATTERN_WIDTH:
+		raise ValueError(f"pattern widths must be 1..{MAX_PATTERN_WIDTH}, got {widths}")
+	bits = 0
+	for w in widths:
+		bits |= 1 << (w - 1)
+	return bits
+
+
+def pattern_widths(store) -> tuple:
+	"""Ascending pattern widths `store` is scored at (a MemoryStore or a read_header() dict)."""
+	flags = store["flags"] if isinstance(store, dict) else store.flags
+	pattern_len = store["pattern_len"] if isinstance(store, dict) else store.pattern_len
+	bits = int(flags or 0) & WIDTH_FLAGS_MASK
+	widths = tuple(w for w in range(1, MAX_PATTERN_WIDTH + 1) if bits & (1 << (w - 1)) and w <= pattern_len)
+	return widths or (1,)
+
+
+def read_header(path: str) -> dict:
+	"""Read just the 64-byte header (cheap way to get count / generation without loading columns)."""
+	with open(path, "rb") as f:
+		raw = f.read(HEADER_SIZE)
+	magic, version, float_size, pattern_len, flags, count, generation = HEADER_STRUCT.unpack(raw)
+	if magic != MAGIC:
+		raise ValueError("not a PowerTrader memory store")
+	return {
+		"version": version,
+		"float_size": float_size,
+		"pattern_len": pattern_len,
+		"flags": flags,
+		"count": count,
+		"generation": generation,
+	}
+
+
+def store_signature(tf_choice: str, folder: str = ""):
+	"""
+	(path, mtime_ns, size, journal_mtime_ns, journal_size) of whatever load_store() would read,
+	or None if there is no store at all.
+	Readers compare this between polls to know when a reload is needed.
+	"""
+	for path in (store_path(tf_choice, folder), legacy_paths(tf_choice, folder)["memories"]):
+		try:
+			st = os.stat(path)
+		except OSError:
+			continue
+		try:
+			jst = os.stat(journal_path(tf_choice, folder))
+			jsig = (jst.st_mtime_ns, jst.st_size)
+		except OSError:
+			jsig = (None, None)
+		return (path, st.st_mtime_ns, st.st_size) + jsig
+	return None
+
+
+def has_text_memory(tf_choice: str, folder: str = "") -> bool:
+	return os.path.isfile(legacy_paths(tf_choice, folder)["memories"])
+
+
+@pt_metrics.timed("memory_load")
+def load_store(tf_choice: str, folder: str = "", migrate: bool = False, mapped: bool = False) -> MemoryStore:
+	"""
+	Load a timeframe's memories, preferring the binary store (+ its journal).
+	Falls back to the legacy text files (and writes the .ptm once if migrate=True).
+	Returns an empty store when neither exists.
+	"""
+	path = store_path(tf_choice, folder)
+	if os.path.isfile(path):
+		jp = journal_path(tf_choice, folder)
+		if mapped and os.path.isfile(jp) and os.path.getsize(jp) > JOURNAL_HEADER_SIZE:
+			mapped = False  # journal records have to be applied, which needs writable columns
+		st = MemoryStore.load(path, mapped=mapped)
+		if not mapped:
+			replay_journal(st, jp)
+		return st
+	if has_text_memory(tf_choice, folder):
+		st = read_text_memory(tf_choice, folder)
+		if migrate:
+			try:
+				st.save(path)
+			except Exception:
+				pass
+		return st
+	return MemoryStore()
+
+
+def migrate_folder(folder: str = "", tfs=None, overwrite: bool = False) -> list:
+	"""One-shot migrator: converts every timeframe that still only has text files. Returns migrated tfs."""
+	done = []
+	for tf in (tfs or TF_CHOICES):
+		path = store_path(tf, folder)
+		if os.path.isfile(path) and not overwrite:
+			continue
+		if not has_text_memory(tf, folder):
+			continue
+		st = read_text_memory(tf, folder)
+		st.save(path)
+		done.append(tf)
+	return done
+
+
+def _main(argv: list) -> int:
+	if not argv or argv[0] not in ("migrate", "export", "info", "compact", "prune"):
+		print(__doc__)
+		return 2
+	cmd = argv[0]
+	if cmd == "migrate":
+		for folder in (argv[1:] or [os.getcwd()]):
+			done = migrate_folder(folder)
+			print(f"{folder}: migrated {', '.join(done) if done else 'nothing'}")
+		return 0
+	policy = {}
+	rest = []
+	args = list(argv[1:])
+	while args:
+		a = args.pop(0)
+		if a in ("--floor", "--merge", "--cap") and args:
+			v = args.pop(0)
+			if a == "--floor":
+				policy["floor_updates"] = int(v)
+			elif a == "--merge":
+				policy["merge_distance"] = float(v)
+			else:
+				policy["max_memories"] = int(v)
+		else:
+			rest.append(a)
+	folder = rest[0] if rest else os.getcwd()
+	tfs = rest[1:] or TF_CHOICES
+	for tf in tfs:
+		path = store_path(tf, folder)
+		if not os.path.isfile(path):
+			continue
+		st = load_store(tf, folder)
+		if cmd == "compact":
+			compact(st, tf, folder)
+			print(f"{tf}: compacted {len(st)} memories")
+		elif cmd == "prune":
+			new = prune_timeframe(st, tf, folder, **policy)
+			print(f"{tf}: {len(st)} -> {len(new)} memories")
+		elif cmd == "export":
+			export_text(st, tf, folder)
+			print(f"{tf}: exported {len(st)} memories")
+		else:
+			print(f"{tf}: {len(st)} memories, pattern_len={st.pattern_len}, widths={','.join(map(str, pattern_widths(st)))}, float{st.float_size * 8}, generation={st.generation}")
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(_main(sys.argv[1:]))
@@ -0,0 +1,375 @@
+"""
+Low-overhead hot-path timers, counters and gauges for the thinker, trader and trainer.
+
+Each process names itself once (configure("thinker") / "trader" / "trainer_BTC") and then
+writes a rolling snapshot to <hub_data>/metrics_<process>.json at most every
+METRICS_FLUSH_SECONDS (and at exit):
+
+	{"process": "thinker", "pid": 1234, "since": <unix>, "timestamp": <unix>,
+	 "buckets_ms": [0.1, 0.5, ...],
+	 "timers": {"match_scan": {"count": 812, "sum_ms": 95.1, "max_ms": 2.4, "avg_ms": 0.12,
+	                           "p50_ms": 0.5, "p95_ms": 1.0, "p99_ms": 2.5, "buckets": [...]}},
+	 "counters": {"prediction_cache_hits": 5301, ...},
+	 "gauges": {"coins_in_flight": 2, ...}}
+
+Timers are fixed-bucket histograms, so recording is a lock, a few adds and a short bucket
+walk. Shared modules (pt_candles, pt_memory, pt_match, pt_signals) record into the same
+per-process registry, and so does the trader's per-endpoint API latency ("api GET /path/"
+timers); a process that never calls configure() (pt_backtest, pt_bench, imports) keeps its
+numbers in RAM only.
+
+POWERTRADER_METRICS=0 turns recording off: timer() hands back a shared no-op and timed()
+returns the function undecorated, so disabled instrumentation costs nothing.
+
+The hub shows the snapshots in its Metrics tab and can serve them Prometheus-style
+(settings: metrics_port); standalone:
+
+	python pt_metrics.py                   # print the Prometheus text for hub_data once
+	python pt_metrics.py --serve 9464      # http://127.0.0.1:9464/metrics (and /metrics.json)
+"""
+import os
+import re
+import sys
+import glob
+import json
+import time
+import atexit
+import threading
+import functools
+
+ENABLED = (os.environ.get("POWERTRADER_METRICS") or "1").strip().lower() not in ("0", "false", "off", "no")
+METRICS_FLUSH_SECONDS = 5.0
+METRICS_STALE_SECONDS = 120.0  # snapshots older than this belong to a stopped process
+BUCKETS_MS = (0.1, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000)
+METRICS_FILE_PREFIX = "metrics_"
+
+_NAME_RE = re.compile(r"[^a-zA-Z0-9_]")
+
+
+def hub_dir() -> str:
+	return os.environ.get("POWERTRADER_HUB_DIR") or os.path.join(os.path.dirname(os.path.abspath(__file__)), "hub_data")
+
+
+def metrics_path(process: str, folder: str = None) -> str:
+	return os.path.join(folder or hub_dir(), f"{METRICS_FILE_PREFIX}{_NAME_RE.sub('_', process)}.json")
+
+
+def _quantile(buckets, count, q, max_ms):
+	# upper bound of the bucket holding the q-th observation (max_ms past the last bound)
+	if count <= 0:
+		return None
+	need = q * count
+	seen = 0
+	for i, n in enumerate(buckets):
+		seen += n
+		if seen >= need:
+			return float(BUCKETS_MS[i]) if i < len(BUCKETS_MS) else round(max_ms, 3)
+	return round(max_ms, 3)
+
+
+class _Timer:
+	__slots__ = ("_m", "_stage", "_t0")
+
+	def __init__(self, m, stage):
+		self._m = m
+		self._stage = stage
+
+	def __enter__(self):
+		self._t0 = time.perf_counter()
+		return self
+
+	def __exit__(self, *exc):
+		self._m.observe(self._stage, time.perf_counter() - self._t0)
+		return False
+
+
+class _NullTimer:
+	__slots__ = ()
+
+	def __enter__(self):
+		return self
+
+	def __exit__(self, *exc):
+		return False
+
+
+_NULL_TIMER = _NullTimer()
+
+
+class Metrics:
+	"""Thread-safe registry (the thinker steps coins on a thread pool)."""
+
+	def __init__(self, process=None, path=None, enabled=ENABLED):
+		self.process = process
+		self.path = path
+		self.enabled = bool(enabled)
+		self._lock = threading.Lock()
+		self._flush_lock = threading.Lock()  # one writer of <path>.tmp / _last_flush at a time
+		self._timers = {}    # stage -> [count, sum_ms, max_ms, buckets]
+		self._counters = {}
+		self._gauges = {}
+		self._started = time.time()
+		self._last_flush = 0.0
+
+	def timer(self, stage: str):
+		"""`with metrics.timer("kline_fetch"): ...` records the block's wall time."""
+		return _Timer(self, stage) if self.enabled else _NULL_TIMER
+
+	def observe(self, stage: str, seconds: float) -> None:
+		if not self.enabled:
+			return
+		ms = max(0.0, float(seconds) * 1000.0)
+		i = 0
+		while i < len(BUCKETS_MS) and ms > BUCKETS_MS[i]:
+			i += 1
+		with self._lock:
+			t = self._timers.get(stage)
+			if t is None:
+				t = [0, 0.0, 0.0, [0] * (len(BUCKETS_MS) + 1)]
+				self._timers[stage] = t
+			t[0] += 1
+			t[1] += ms
+			if ms > t[2]:
+				t[2] = ms
+			t[3][i] += 1
+		self.maybe_flush()
+
+	def incr(self, name: str, n: int = 1) -> None:
+		if not self.enabled:
+			return
+		with self._lock:
+			self._counters[name] = self._counters.get(name, 0) + n
+		self.maybe_flush()
+
+	def gauge(self, name: str, value) -> None:
+		if not self.enabled:
+			return
+		with self._lock:
+			self._gauges[name] = value
+		self.maybe_flush()
+
+	def snapshot(self) -> dict:
+		timers = {}
+		with self._lock:
+			for stage, (count, sum_ms, max_ms, buckets) in sorted(self._timers.items()):
+				timers[stage] = {
+					"count": count,
+					"sum_ms": round(sum_ms, 3),
+					"max_ms": round(max_ms, 3),
+					"avg_ms": round(sum_ms / count, 3) if count else 0.0,
+					"p50_ms": _quantile(buckets, count, 0.50, max_ms),
+					"p95_ms": _quantile(buckets, count, 0.95, max_ms),
+					"p99_ms": _quantile(buckets, count, 0.99, max_ms),
+					"buckets": list(buckets),
+				}
+			counters = dict(sorted(self._counters.items()))
+			gauges = dict(sorted(self._gauges.items()))
+		return {"process": self.process, "pid": os.getpid(), "since": self._started, "timestamp": time.time(),
+			"buckets_ms": list(BUCKETS_MS), "timers": timers, "counters": counters, "gauges": gauges}
+
+	def maybe_flush(self, force: bool = False) -> None:
+		if self.path is None:
+			return
+		if not force and (time.time() - self._last_flush) < METRICS_FLUSH_SECONDS:
+			return
+		# a hot-path caller never waits: if another thread is flushing, that flush covers it
+		if not self._flush_lock.acquire(blocking=force):
+			return
+		try:
+			now = time.time()
+			if not force and (now - self._last_flush) < METRICS_FLUSH_SECONDS:
+				return
+			self._last_flush = now
+			tmp = f"{self.path}.tmp"
+			with open(tmp, "w", encoding="utf-8") as f:
+				json.dump(self.snapshot(), f)
+			os.replace(tmp, self.path)
+		except Exception:
+			pass
+		finally:
+			self._flush_lock.release()
+
+
+# ---- the per-process registry used by every module ----
+
+_registry = Metrics()
+
+
+def configure(process: str, folder: str = None) -> Metrics:
+	"""Name this process and start writing metrics_<process>.json (no-op when disabled)."""
+	_registry.process = process
+	if _registry.enabled:
+		try:
+			folder = folder or hub_dir()
+			os.makedirs(folder, exist_ok=True)
+			_registry.path = metrics_path(process, folder)
+			atexit.register(_registry.maybe_flush, True)
+		except Exception:
+			_registry.path = None
+	return _registry
+
+
+def timer(stage: str):
+	return _registry.timer(stage)
+
+
+def observe(stage: str, seconds: float) -> None:
+	_registry.observe(stage, seconds)
+
+
+def incr(name: str, n: int = 1) -> None:
+	_registry.incr(name, n)
+
+
+def gauge(name: str, value) -> None:
+	_registry.gauge(name, value)
+
+
+def flush() -> None:
+	_registry.maybe_flush(force=True)
+
+
+def timed(stage: str):
+	"""Decorator form of timer(stage); returns the function unchanged when metrics are off."""
+	def wrap(fn):
+		if not _registry.enabled:
+			return fn
+
+		@functools.wraps(fn)
+		def inner(*args, **kwargs):
+			t0 = time.perf_counter()
+			try:
+				return fn(*args, **kwargs)
+			finally:
+				_registry.observe(stage, time.perf_counter() - t0)
+		return inner
+	return wrap
+
+
+# ---- readers (hub panel, Prometheus endpoint) ----
+
+def load_snapshots(folder: str = None, max_age: float = METRICS_STALE_SECONDS) -> list:
+	"""Every metrics_*.json in `folder`, newest first, each with an "age_s"; stale ones skipped (max_age=None keeps all)."""
+	out = []
+	now = time.time()
+	for path in glob.glob(os.path.join(folder or hub_dir(), f"{METRICS_FILE_PREFIX}*.json")):
+		try:
+			with open(path, "r", encoding="utf-8") as f:
+				snap = json.load(f)
+			age = max(0.0, now - float(snap.get("timestamp", 0.0)))
+			if max_age is not None and age > max_age:
+				continue
+			snap["age_s"] = round(age, 1)
+			out.append(snap)
+		except Exception:
+			continue
+	out.sort(key=lambda s: str(s.get("process") or ""))
+	return out
+
+
+def _label(v) -> str:
+	return str(v).replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", " ")
+
+
+def _metric(name: str) -> str:
+	return "powertrader_" + _NAME_RE.sub("_", name).lower()
+
+
+def render_prometheus(snapshots) -> str:
+	"""Prometheus text exposition format (0.0.4) of load_snapshots() output."""
+	hist, counters, gauges = [], {}, {}
+	ages = []
+	for snap in snapshots:
+		proc = _label(snap.get("process") or "unknown")
+		ages.append(f"powertrader_metrics_age_seconds{{process=\"{proc}\"}} {snap.get('age_s', 0.0)}")
+		bounds = snap.get("buckets_ms") or list(BUCKETS_MS)
+		for stage, t in (snap.get("timers") or {}).items():
+			lbl = f"process=\"{proc}\",stage=\"{_label(stage)}\""
+			seen = 0
+			for b, n in zip(list(bounds) + ["+Inf"], t.get("buckets") or []):
+				seen += n
+				le = "+Inf" if b == "+Inf" else repr(float(b) / 1000.0)
+				hist.append(f"powertrader_stage_seconds_bucket{{{lbl},le=\"{le}\"}} {seen}")
+			hist.append(f"powertrader_stage_seconds_sum{{{lbl}}} {float(t.get('sum_ms', 0.0)) / 1000.0}")
+			hist.append(f"powertrader_stage_seconds_count{{{lbl}}} {int(t.get('count', 0))}")
+		for name, v in (snap.get("counters") or {}).items():
+			counters.setdefault(_metric(name) + "_total", []).append(f"{{process=\"{proc}\"}} {v}")
+		for name, v in (snap.get("gauges") or {}).items():
+			try:
+				v = float(v)
+			except Exception:
+				continue
+			gauges.setdefault(_metric(name), []).append(f"{{process=\"{proc}\"}} {v}")
+
+	lines = ["# HELP powertrader_metrics_age_seconds Seconds since the process last wrote its metrics.",
+		"# TYPE powertrader_metrics_age_seconds gauge"] + ages
+	if hist:
+		lines += ["# HELP powertrader_stage_seconds Hot-path stage wall time.", "# TYPE powertrader_stage_seconds histogram"] + hist
+	for name in sorted(counters):
+		lines.append(f"# TYPE {name} counter")
+		lines += [name + s for s in counters[name]]
+	for name in sorted(gauges):
+		lines.append(f"# TYPE {name} gauge")
+		lines += [name + s for s in gauges[name]]
+	return "\n".join(lines) + "\n"
+
+
+def serve(port: int, folder: str = None, host: str = "127.0.0.1"):
+	"""Serve /metrics (Prometheus text) and /metrics.json from a daemon thread. Returns the server."""
+	from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+	class Handler(BaseHTTPRequestHandler):
+		def do_GET(self):
+			route = self.path.split("?", 1)[0]
+			snaps = load_snapshots(folder)
+			if route in ("/", "/metrics"):
+				body, ctype = render_prometheus(snaps).encode("utf-8"), "text/plain; version=0.0.4; charset=utf-8"
+			elif route == "/metrics.json":
+				body, ctype = json.dumps({"timestamp": time.time(), "processes": snaps}).encode("utf-8"), "application/json"
+			else:
+				self.send_error(404)
+				return
+			self.send_response(200)
+			self.send_header("Content-Type", ctype)
+			self.send_header("Content-Length", str(len(body)))
+			self.end_headers()
+			self.wfile.write(body)
+
+		def log_message(self, *args):
+			pass
+
+	server = ThreadingHTTPServer((host, int(port)), Handler)
+	server.daemon_threads = True
+	threading.Thread(target=server.serve_forever, name="metrics-http", daemon=True).start()
+	return server
+
+
+def _main(argv: list) -> int:
+	folder = None
+	port = None
+	i = 0
+	while i < len(argv):
+		if argv[i] == "--hub-dir" and i + 1 < len(argv):
+			folder = argv[i + 1]
+			i += 1
+		elif argv[i] == "--serve" and i + 1 < len(argv):
+			port = int(argv[i + 1])
+			i += 1
+		else:
+			print("usage: python pt_metrics.py [--hub-dir DIR] [--serve PORT]")
+			return 2
+		i += 1
+	if port is None:
+		sys.stdout.write(render_prometheus(load_snapshots(folder)))
+		return 0
+	serve(port, folder)
+	print(f"[pt_metrics] serving http://127.0.0.1:{port}/metrics")
+	try:
+		while True:
+			time.sleep(3600)
+	except KeyboardInterrupt:
+		return 0
+
+
+if __name__ == "__main__":
+	sys.exit(_main(sys.argv[1:]))
@@ -0,0 +1,258 @@
+"""
+Per-coin position index for the trader: quantity, running cost basis, DCA stage count and
+timestamps, and the last sell, so startup doesn't replay Robinhood's order history or the
+whole of trade_history.jsonl.
+
+hub_data/position_index.json:
+
+	{"history": {"offset": <bytes>, "ident": [dev, ino]},   how much of trade_history.jsonl is applied
+	 "positions": {"BTC": {"qty": .., "cost_usd": .., "opened_ts": .., "last_sell_ts": ..,
+	                       "dca_stages": n, "dca_ts": [..], "verified_ts": .., "unpriced": bool}},
+	 "order_ids": [..]}                                     the last ORDER_IDS_KEEP recorded order ids
+
+has_order() answers from that window and falls back to scanning trade_history.jsonl for an id
+it doesn't hold, so an older order that resurfaces (a pending entry restored long after its
+fill) is still recognised as recorded.
+
+The index tails trade_history.jsonl (pt_history.JsonlTail): the trader's _record_trade()
+appends its row and calls sync(), which applies only the new lines and checkpoints the file
+(tmp + os.replace). A crash between the append and the checkpoint is caught up on the next
+load; a replaced or truncated history is rebuilt from its first line. The first start after an
+upgrade builds the index from the existing history once.
+
+Robinhood stays the source of truth: the trader re-checks the held coins in the background and
+correct() / close() overwrite whatever drifted (manual trades, fills the history never saw).
+"""
+import os
+import json
+import time
+
+import pt_history
+
+INDEX_FILE = "position_index.json"
+ORDER_IDS_KEEP = 1000
+DCA_TS_KEEP = 100
+QTY_DUST = 1e-12
+QTY_REL_TOL = 1e-6      # held quantity vs index quantity
+COST_REL_TOL = 1e-4     # Robinhood average cost vs index average cost
+
+
+def index_path(folder: str) -> str:
+	return os.path.join(folder, INDEX_FILE)
+
+
+def _new_position() -> dict:
+	return {
+		"qty": 0.0,
+		"cost_usd": 0.0,
+		"opened_ts": None,
+		"last_sell_ts": None,
+		"dca_stages": 0,
+		"dca_ts": [],
+		"verified_ts": None,
+		"unpriced": False,
+	}
+
+
+def qty_matches(a: float, b: float) -> bool:
+	a, b = float(a or 0.0), float(b or 0.0)
+	return abs(a - b) <= max(QTY_DUST, QTY_REL_TOL * max(abs(a), abs(b)))
+
+
+class PositionIndex:
+
+	def __init__(self, folder: str, history_path: str):
+		self.path = index_path(folder)
+		self.positions = {}
+		self.order_ids = []
+		self._order_id_set = set()
+		self._revs = {}
+		self._dirty = False
+		self._history_path = history_path
+		self._tail = pt_history.JsonlTail(history_path)
+		self._load()
+		self.sync()
+
+	def _load(self) -> None:
+		try:
+			with open(self.path, "r", encoding="utf-8") as f:
+				data = json.load(f) or {}
+			positions = data.get("positions", {}) or {}
+			hist = data.get("history", {}) or {}
+			ident = hist.get("ident")
+			for base, pos in positions.items():
+				if isinstance(pos, dict):
+					p = _new_position()
+					p.update(pos)
+					self.positions[str(base).upper()] = p
+			self.order_ids = [str(o) for o in (data.get("order_ids", []) or [])][-ORDER_IDS_KEEP:]
+			self._order_id_set = set(self.order_ids)
+			if ident:
+				self._tail._ident = tuple(ident)
+				self._tail.offset = int(hist.get("offset", 0) or 0)
+		except Exception:
+			self.positions, self.order_ids, self._order_id_set = {}, [], set()
+
+	def save(self) -> None:
+		try:
+			data = {
+				"updated_ts": time.time(),
+				"history": {"offset": self._tail.offset, "ident": list(self._tail._ident) if self._tail._ident else None},
+				"positions": self.positions,
+				"order_ids": self.order_ids,
+			}
+			tmp = f"{self.path}.tmp"
+			with open(tmp, "w", encoding="utf-8") as f:
+				json.dump(data, f, indent=2)
+			os.replace(tmp, self.path)
+			self._dirty = False
+		except Exception:
+			pass
+
+	def sync(self) -> set:
+		"""Applies trade_history rows appended since the last call; returns the coins they touched."""
+		touched = set()
+		try:
+			reset, rows = self._tail.read_new()
+			if reset:
+				self.positions, self.order_ids, self._order_id_set = {}, [], set()
+				self._dirty = True
+				touched.update(self._revs)
+			for row in rows:
+				base = self.apply(row)
+				if base:
+					touched.add(base)
+		except Exception:
+			pass
+		if touched or self._dirty:
+			self.save()
+		return touched
+
+	def apply(self, row: dict):
+		"""One trade_history row -> the coin it moved (None if it isn't a usable trade)."""
+		if not isinstance(row, dict):
+			return None
+		base = str(row.get("symbol", "") or "").upper().split("-")[0].strip()
+		side = str(row.get("side", "") or "").lower().strip()
+		try:
+			ts = float(row.get("ts"))
+			qty = max(0.0, float(row.get("qty") or 0.0))
+		except Exception:
+			return None
+		if not base or side not in ("buy", "sell"):
+			return None
+
+		order_id = str(row.get("order_id", "") or "").strip()
+		if order_id and order_id not in self._order_id_set:
+			self.order_ids.append(order_id)
+			self._order_id_set.add(order_id)
+			if len(self.order_ids) > ORDER_IDS_KEEP:
+				for old in self.order_ids[:-ORDER_IDS_KEEP]:
+					self._order_id_set.discard(old)
+				self.order_ids = self.order_ids[-ORDER_IDS_KEEP:]
+
+		pos = self.positions.setdefault(base, _new_position())
+		held = float(pos.get("qty", 0.0) or 0.0)
+		if side == "buy":
+			if held <= QTY_DUST:
+				# fresh trade: the first buy is the entry, every later buy is a DCA stage
+				pos.update(qty=0.0, cost_usd=0.0, opened_ts=ts, dca_stages=0, dca_ts=[], unpriced=False)
+			else:
+				pos["dca_stages"] = int(pos.get("dca_stages", 0) or 0) + 1
+				if row.get("tag") == "DCA":
+					pos["dca_ts"] = (list(pos.get("dca_ts", []) or []) + [ts])[-DCA_TS_KEEP:]
+			try:
+				pos["cost_usd"] = float(pos.get("cost_usd", 0.0) or 0.0) + qty * float(row.get("price"))
+			except Exception:
+				pos["unpriced"] = True  # no fill price: the cost stays wrong until Robinhood corrects it
+			pos["qty"] = held + qty
+		else:
+			frac = min(1.0, qty / held) if held > QTY_DUST else 1.0
+			pos["cost_usd"] = float(pos.get("cost_usd", 0.0) or 0.0) * (1.0 - frac)
+			pos["qty"] = max(0.0, held - qty)
+			pos["last_sell_ts"] = ts
+			pos["dca_ts"] = []  # a sell ends the trade's rolling DCA window
+			if pos["qty"] <= QTY_DUST:
+				pos.update(qty=0.0, cost_usd=0.0, dca_stages=0, unpriced=False)
+
+		self._revs[base] = self._revs.get(base, 0) + 1
+		self._dirty = True
+		return base
+
+	def correct(self, base: str, qty: float, avg_cost: float, dca_stages: int) -> bool:
+		"""Overwrites a coin with what Robinhood says; True if the index had drifted."""
+		base = str(base).upper().strip()
+		pos = self.positions.setdefault(base, _new_position())
+		qty, avg_cost, dca_stages = float(qty or 0.0), float(avg_cost or 0.0), int(dca_stages or 0)
+		old_avg = self.avg_cost(base)
+		changed = (
+			not qty_matches(pos.get("qty", 0.0), qty)
+			or bool(pos.get("unpriced"))
+			or abs(old_avg - avg_cost) > COST_REL_TOL * max(abs(old_avg), abs(avg_cost), 1e-12)
+			or int(pos.get("dca_stages", 0) or 0) != dca_stages
+		)
+		if changed:
+			pos.update(qty=qty, cost_usd=qty * avg_cost, dca_stages=dca_stages, unpriced=False)
+			self._revs[base] = self._revs.get(base, 0) + 1
+		pos["verified_ts"] = time.time()
+		self._dirty = True
+		return changed
+
+	def close(self, base: str) -> bool:
+		"""The coin is no longer held (sold outside the trader); True if the index still had it open."""
+		base = str(base).upper().strip()
+		pos = self.positions.get(base)
+		if not pos or float(pos.get("qty", 0.0) or 0.0) <= QTY_DUST:
+			return False
+		pos.update(qty=0.0, cost_usd=0.0, dca_stages=0, dca_ts=[], unpriced=False)
+		self._revs[base] = self._revs.get(base, 0) + 1
+		self._dirty = True
+		return True
+
+	def rev(self, base: str) -> int:
+		"""Bumped on every change to `base` (lets a background check tell if its answer went stale)."""
+		return self._revs.get(str(base).upper().strip(), 0)
+
+	def position(self, base: str):
+		return self.positions.get(str(base).upper().strip())
+
+	def open_bases(self) -> list:
+		return [b for b, p in self.positions.items() if float(p.get("qty", 0.0) or 0.0) > QTY_DUST]
+
+	def avg_cost(self, base: str) -> float:
+		pos = self.position(base) or {}
+		qty = float(pos.get("qty", 0.0) or 0.0)
+		return float(pos.get("cost_usd", 0.0) or 0.0) / qty if qty > QTY_DUST else 0.0
+
+	def cost_basis(self) -> dict:
+		"""{coin: average cost} for every open position."""
+		return {b: self.avg_cost(b) for b in self.open_bases()}
+
+	def dca_stages(self, base: str) -> int:
+		return int((self.position(base) or {}).get("dca_stages", 0) or 0)
+
+	def has_order(self, order_id: str) -> bool:
+		order_id = str(order_id or "").strip()
+		if not order_id:
+			return False
+		if order_id in self._order_id_set:
+			return True
+		return self._history_has_order(order_id)
+
+	def _history_has_order(self, order_id: str) -> bool:
+		"""Full scan of trade_history.jsonl for an id outside the ORDER_IDS_KEEP window (rare: startup reconcile)."""
+		needle = order_id.encode("utf-8")
+		try:
+			with open(self._history_path, "rb") as f:
+				for ln in f:
+					if needle not in ln:
+						continue
+					try:
+						obj = json.loads(ln)
+					except Exception:
+						continue
+					if isinstance(obj, dict) and str(obj.get("order_id", "") or "").strip() == order_id:
+						return True
+		except Exception:
+			return False
+		return False
@@ -0,0 +1,158 @@
+"""
+Thinker -> trader signal handoff over a localhost UDP socket.
+
+pt_thinker.py publishes one snapshot per coin whenever it writes that coin's signals:
+
+	{"session": <thinker run id>, "coin": "BTC", "version": 12, "ts": <unix>,
+	 "long": 3, "short": 0, "long_pm": 0.25, "short_pm": 0.25,
+	 "low_bounds": [...], "high_bounds": [...]}
+
+`version` only goes up when a field actually changed, so the trader (SignalSubscriber) can
+wake on a real change (wait()) instead of polling, and keep the newest snapshot per coin in
+memory instead of re-opening the text files on every manage_trades() pass. Snapshots are
+re-sent on every thinker step, so a trader started after the thinker picks them up within
+one step.
+
+The per-coin text files (long_dca_signal.txt, low_bound_prices.html, ...) are still written
+as a mirror (the hub reads them, and the trader falls back to them when no fresh snapshot
+arrived); mirror writes go through tmp + os.replace so readers never see a half-written file.
+"""
+import os
+import time
+import json
+import uuid
+import socket
+import threading
+
+import pt_metrics
+
+SIGNAL_HOST = "127.0.0.1"
+SIGNAL_PORT = int(os.environ.get("POWERTRADER_SIGNAL_PORT") or 47651)
+SNAPSHOT_MAX_AGE_SECONDS = 60.0  # older snapshots are ignored (thinker stopped / not publishing)
+MAX_DATAGRAM = 65507
+
+
+def write_atomic(path, text):
+	"""Replace `path` with `text` in one step (falls back to a plain write if the replace fails)."""
+	tmp = f"{path}.tmp"
+	try:
+		with open(tmp, "w") as f:
+			f.write(text)
+		os.replace(tmp, path)
+	except Exception:
+		# e.g. Windows refusing the replace while another process has the file open
+		with open(path, "w+") as f:
+			f.write(text)
+
+
+class SignalPublisher:
+	"""Thread-safe: the thinker steps coins on a thread pool."""
+
+	def __init__(self, mirror=True, host=SIGNAL_HOST, port=SIGNAL_PORT):
+		self.mirror = bool(mirror)
+		self.addr = (host, int(port))
+		self.session = uuid.uuid4().hex
+		self._lock = threading.Lock()
+		self._snapshots = {}
+		self._sock = None
+		try:
+			self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+		except Exception:
+			self._sock = None
+
+	@pt_metrics.timed("signal_write")
+	def publish(self, coin, fields, folder=None, files=None):
+		"""
+		Merge `fields` into `coin`'s snapshot and send it. `files` ({name: text}) are written
+		to `folder` as the compatibility mirror when mirroring is on.
+		"""
+		coin = str(coin).upper().strip()
+		with self._lock:
+			snap = self._snapshots.get(coin)
+			if snap is None:
+				snap = {"session": self.session, "coin": coin, "version": 0}
+				self._snapshots[coin] = snap
+			changed = snap["version"] == 0
+			for k, v in fields.items():
+				if snap.get(k) != v:
+					snap[k] = v
+					changed = True
+			if changed:
+				snap["version"] += 1
+			snap["ts"] = time.time()
+			payload = json.dumps(snap, separators=(",", ":")).encode("utf-8")
+
+		if self._sock is not None and len(payload) <= MAX_DATAGRAM:
+			try:
+				self._sock.sendto(payload, self.addr)
+			except Exception:
+				pass  # nobody listening (trader not running) is fine
+
+		if self.mirror and folder and files:
+			for name, text in files.items():
+				write_atomic(os.path.join(folder, name), text)
+
+
+class SignalSubscriber:
+	"""
+	Receives snapshots on a background thread. If the port can't be bound (another trader
+	already owns it) `ok` is False and get() always returns None, i.e. callers use the files.
+	"""
+
+	def __init__(self, host=SIGNAL_HOST, port=SIGNAL_PORT, event=None):
+		self._lock = threading.Lock()
+		self._changed = event if event is not None else threading.Event()  # may be shared with other wake-up sources
+		self._snapshots = {}
+		self.ok = False
+		try:
+			self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+			self._sock.bind((host, int(port)))
+			self.ok = True
+		except Exception:
+			self._sock = None
+			return
+		t = threading.Thread(target=self._recv_loop, name="signal-feed", daemon=True)
+		t.start()
+
+	def _recv_loop(self):
+		while True:
+			try:
+				data, _ = self._sock.recvfrom(MAX_DATAGRAM)
+				snap = json.loads(data.decode("utf-8"))
+				coin = str(snap.get("coin", "")).upper().strip()
+				version = int(snap.get("version", 0))
+				session = snap.get("session")
+			except Exception:
+				continue
+			if not coin:
+				continue
+			with self._lock:
+				old = self._snapshots.get(coin)
+				is_new = old is None or old["session"] != session or version > old["version"]
+				if old is not None and not is_new and version < old["version"]:
+					continue  # reordered datagram from the same session
+				snap["session"] = session
+				snap["version"] = version
+				snap["received_at"] = time.time()
+				self._snapshots[coin] = snap
+			if is_new:
+				self._changed.set()
+
+	def get(self, coin, max_age=SNAPSHOT_MAX_AGE_SECONDS):
+		"""Newest snapshot for `coin` (a copy), or None if there is none / it is too old."""
+		if not self.ok:
+			return None
+		with self._lock:
+			snap = self._snapshots.get(str(coin).upper().strip())
+			if snap is None or (time.time() - snap["received_at"]) > max_age:
+				return None
+			return dict(snap)
+
+	def wait(self, timeout):
+		"""Block until a snapshot changed (True) or `timeout` seconds passed (False)."""
+		if not self.ok:
+			time.sleep(timeout)
+			return False
+		changed = self._changed.wait(timeout)
+		self._changed.clear()
+		return changed
@@ -0,0 +1,165 @@
+"""
+Optional KuCoin public WebSocket feed (gui_settings.json "market_stream").
+
+KucoinStream subscribes to /market/candles:<PAIR>_<tf> and /market/ticker:<PAIRS> and keeps,
+in memory, the still-open candle per (pair, timeframe) and the last trade price per pair,
+updated on every push. pt_candles uses it (set_live_source) as an overlay for the open
+candle, so readers stop re-downloading the newest candle just to see it move; closed candles
+still come from REST once per candle close, so the shared store only ever holds KuCoin's
+final rows.
+
+Robinhood has no public stream, so its quotes stay authoritative for prices and orders: the
+thinker/trader use the ticker only to decide WHEN a fresh Robinhood quote is worth fetching
+(on_move fires when a pair moved at least move_pct since it last fired).
+
+Needs the websocket-client package; without it (or without network) start() returns False
+and everything keeps polling REST exactly as before.
+"""
+import json
+import time
+import uuid
+import threading
+
+try:
+	import websocket  # websocket-client
+except Exception:
+	websocket = None
+
+try:
+	import requests
+except Exception:
+	requests = None
+
+BULLET_URL = "https://api.kucoin.com/api/v1/bullet-public"
+LIVE_MAX_AGE_SECONDS = 30.0   # older pushes are not trusted (connection silently stalled)
+RECONNECT_MIN_SECONDS = 1.0
+RECONNECT_MAX_SECONDS = 60.0
+SUBSCRIBE_PACE_SECONDS = 0.12  # KuCoin allows 100 upstream messages per 10s
+
+
+class KucoinStream:
+
+	def __init__(self, pairs, timeframes, on_move=None, move_pct=0.05):
+		self.pairs = sorted(set(str(p).upper() for p in pairs))
+		self.timeframes = list(timeframes)
+		self.on_move = on_move
+		self.move_pct = float(move_pct)
+		self._lock = threading.Lock()
+		self._candles = {}      # (pair, tf) -> (row tuple, received_at)
+		self._prices = {}       # pair -> (price, received_at)
+		self._moved_from = {}   # pair -> price at the last on_move
+		self._thread = None
+		self._stop = threading.Event()
+		self.connected = False
+
+	# ---- reading (any thread) ----
+
+	def live_candle(self, pair, tf, max_age=LIVE_MAX_AGE_SECONDS):
+		"""Open candle (ts, open, close, high, low, volume, turnover) or None if not fresh."""
+		with self._lock:
+			hit = self._candles.get((str(pair).upper(), tf))
+		if hit is None or (time.time() - hit[1]) > max_age:
+			return None
+		return hit[0]
+
+	def last_price(self, pair, max_age=LIVE_MAX_AGE_SECONDS):
+		with self._lock:
+			hit = self._prices.get(str(pair).upper())
+		if hit is None or (time.time() - hit[1]) > max_age:
+			return None
+		return hit[0]
+
+	# ---- lifecycle ----
+
+	def start(self) -> bool:
+		if websocket is None or requests is None or not self.pairs:
+			return False
+		if self._thread is None:
+			self._thread = threading.Thread(target=self._run, name="kucoin-stream", daemon=True)
+			self._thread.start()
+		return True
+
+	def stop(self) -> None:
+		self._stop.set()
+
+	def _topics(self):
+		topics = [f"/market/candles:{p}_{tf}" for p in self.pairs for tf in self.timeframes]
+		topics.append("/market/ticker:" + ",".join(self.pairs))
+		return topics
+
+	def _run(self):
+		delay = RECONNECT_MIN_SECONDS
+		while not self._stop.is_set():
+			ws = None
+			try:
+				r = requests.post(BULLET_URL, timeout=10).json()
+				data = r.get("data") or {}
+				server = (data.get("instanceServers") or [{}])[0]
+				url = f"{server['endpoint']}?token={data['token']}&connectId={uuid.uuid4().hex}"
+				ping_every = float(server.get("pingInterval", 18000)) / 1000.0
+				ws = websocket.create_connection(url, timeout=ping_every)
+				for topic in self._topics():
+					ws.send(json.dumps({"id": uuid.uuid4().hex, "type": "subscribe", "topic": topic,
+						"privateChannel": False, "response": False}))
+					time.sleep(SUBSCRIBE_PACE_SECONDS)
+				self.connected = True
+				delay = RECONNECT_MIN_SECONDS
+				next_ping = time.time() + ping_every
+				while not self._stop.is_set():
+					if time.time() >= next_ping:
+						ws.send(json.dumps({"id": str(int(time.time() * 1000)), "type": "ping"}))
+						next_ping = time.time() + ping_every
+					try:
+						raw = ws.recv()
+					except websocket.WebSocketTimeoutException:
+						continue
+					if not raw:
+						raise ConnectionError("stream closed")
+					self._handle(json.loads(raw))
+			except Exception as e:
+				if not self._stop.is_set():
+					print(f"[pt_stream] {type(e).__name__}: {e} (reconnecting in {delay:.0f}s)")
+			finally:
+				self.connected = False
+				try:
+					if ws is not None:
+						ws.close()
+				except Exception:
+					pass
+			self._stop.wait(delay)
+			delay = min(RECONNECT_MAX_SECONDS, delay * 2)
+
+	def _handle(self, msg):
+		if msg.get("type") != "message":
+			return
+		topic = str(msg.get("topic", ""))
+		data = msg.get("data") or {}
+		now = time.time()
+		if topic.startswith("/market/candles:"):
+			pair, _, tf = topic.split(":", 1)[1].rpartition("_")
+			c = data.get("candles") or []
+			if len(c) < 7:
+				return
+			row = (int(float(c[0])),) + tuple(float(x) for x in c[1:7])
+			with self._lock:
+				old = self._candles.get((pair, tf))
+				if old is None or row[0] >= old[0][0]:
+					self._candles[(pair, tf)] = (row, now)
+		elif topic.startswith("/market/ticker:"):
+			pair = topic.split(":", 1)[1]
+			try:
+				price = float(data.get("price"))
+			except Exception:
+				return
+			fire = False
+			with self._lock:
+				self._prices[pair] = (price, now)
+				ref = self._moved_from.get(pair)
+				if ref is None or (ref > 0 and abs(price - ref) / ref * 100.0 >= self.move_pct):
+					self._moved_from[pair] = price
+					fire = True
+			if fire and self.on_move is not None:
+				try:
+					self.on_move(pair)
+				except Exception:
+					pass
@@ -17,8 +17,17 @@ import psutil
 import logging
 import json
 import uuid
+import threading
+from concurrent.futures import ThreadPoolExecutor
 
 from nacl.signing import SigningKey
+import pt_memory
+import pt_match
+import pt_candles
+import pt_signals
+import pt_stream
+import pt_metrics
+import pt_bundles
 
 # -----------------------------
 # Robinhood market-data (current ASK), same source as rhcb.py trader:
@@ -28,6 +37,7 @@ from nacl.signing import SigningKey
 ROBINHOOD_BASE_URL = "https://trading.robinhood.com"
 
 _RH_MD = None  # lazy-init so import doesn't explode if creds missing
+_RH_MD_LOCK = threading.Lock()  # coins step on worker threads; create the client once
 
 
 class RobinhoodMarketData:
@@ -72,6 +82,7 @@ class RobinhoodMarketData:
 
         resp = self.session.request(method=method.upper(), url=url, headers=headers, data=body or None, timeout=self.timeout)
         if resp.status_code >= 400:
+            pt_metrics.incr("api_errors")
             raise RuntimeError(f"Robinhood HTTP {resp.status_code}: {resp.text}")
         return resp.json()
 
@@ -94,26 +105,82 @@ def robinhood_current_ask(symbol: str) -> float:
     Reads creds from r_key.txt and r_secret.txt in the same folder as this script.
     """
     global _RH_MD
-    if _RH_MD is None:
-        base_dir = os.path.dirname(os.path.abspath(__file__))
-        key_path = os.path.join(base_dir, "r_key.txt")
-        secret_path = os.path.join(base_dir, "r_secret.txt")
-
-        if not os.path.isfile(key_path) or not os.path.isfile(secret_path):
-            raise RuntimeError(
-                "Missing r_key.txt and/or r_secret.txt next to pt_thinker.py. "
-                "Run pt_trader.py once to create them (and to set your Robinhood API key)."
-            )
-
-
-        with open(key_path, "r", encoding="utf-8") as f:
-            api_key = f.read()
-        with open(secret_path, "r", encoding="utf-8") as f:
-            priv_b64 = f.read()
-
-        _RH_MD = RobinhoodMarketData(api_key=api_key, base64_private_key=priv_b64)
-
-    return _RH_MD.get_current_ask(symbol)
+    with _RH_MD_LOCK:
+        if _RH_MD is None:
+            _RH_MD = _create_rh_market_data()
+
+    with pt_metrics.timer("price_fetch"):
+        return _RH_MD.get_current_ask(symbol)
+
+
+# --- optional KuCoin stream (gui_settings.json "market_stream", see pt_stream.py) ---
+# Robinhood's ask stays the price we compare against; the stream only tells us when it is
+# worth asking again. Without a live stream every call goes straight to Robinhood.
+STREAM_ASK_MAX_AGE_SECONDS = 10.0
+STREAM_MOVE_PCT = 0.05
+_stream = None
+_stream_pairs = None
+_ask_cache = {}  # sym -> (robinhood ask, kucoin price when fetched, fetched_at)
+
+
+def current_ask(sym: str) -> float:
+    rh_symbol = f"{sym}-USD"
+    kc_price = _stream.last_price(sym + '-USDT') if _stream is not None else None
+    if kc_price is not None:
+        hit = _ask_cache.get(sym)
+        if hit is not None and hit[1] and (time.time() - hit[2]) < STREAM_ASK_MAX_AGE_SECONDS:
+            if abs(kc_price - hit[1]) / hit[1] * 100.0 < STREAM_MOVE_PCT:
+                pt_metrics.incr("price_cache_hits")
+                return hit[0]
+    ask = robinhood_current_ask(rh_symbol)
+    _ask_cache[sym] = (ask, kc_price, time.time())
+    return ask
+
+
+def _sync_stream(coins) -> None:
+    """(Re)start the KuCoin stream for the current coin list when market_stream is on."""
+    global _stream, _stream_pairs
+    if not _gui_settings_cache.get("market_stream", False):
+        if _stream is not None:
+            _stream.stop()
+            _stream = None
+            _stream_pairs = None
+            pt_candles.set_live_source(None)
+        return
+    pairs = sorted(c + '-USDT' for c in coins)
+    if pairs == _stream_pairs:
+        return
+    _stream_pairs = pairs
+    if _stream is not None:
+        _stream.stop()
+    stream = pt_stream.KucoinStream(pairs, tf_choices)
+    if stream.start():
+        _stream = stream
+        pt_candles.set_live_source(stream)
+    else:
+        _stream = None
+        pt_candles.set_live_source(None)
+        print('market_stream is on but websocket-client is not installed; polling REST instead')
+
+
+def _create_rh_market_data() -> RobinhoodMarketData:
+    base_dir = os.path.dirname(os.path.abspath(__file__))
+    key_path = os.path.join(base_dir, "r_key.txt")
+    secret_path = os.path.join(base_dir, "r_secret.txt")
+
+    if not os.path.isfile(key_path) or not os.path.isfile(secret_path):
+        raise RuntimeError(
+            "Missing r_key.txt and/or r_secret.txt next to pt_thinker.py. "
+            "Run pt_trader.py once to create them (and to set your Robinhood API key)."
+        )
+
+
+    with open(key_path, "r", encoding="utf-8") as f:
+        api_key = f.read()
+    with open(secret_path, "r", encoding="utf-8") as f:
+        priv_b64 = f.read()
+
+    return RobinhoodMarketData(api_key=api_key, base64_private_key=priv_b64)
 
 
 def restart_program():
@@ -157,6 +224,11 @@ _GUI_SETTINGS_PATH = os.environ.get("POWERTRADER_GUI_SETTINGS") or os.path.join(
 _gui_settings_cache = {
 	"mtime": None,
 	"coins": ['BTC', 'ETH', 'XRP', 'BNB', 'DOGE'],  # fallback defaults
+	"thinker_max_workers": 4,
+	"signal_file_mirror": True,
+	"market_stream": False,
+	"bundle_source": "",
+	"bundle_poll_seconds": pt_bundles.POLL_SECONDS,
 }
 
 def _load_gui_coins() -> list:
@@ -183,6 +255,18 @@ def _load_gui_coins() -> list:
 		if not coins:
 			coins = list(_gui_settings_cache["coins"])
 
+		try:
+			_gui_settings_cache["thinker_max_workers"] = max(1, int(data.get("thinker_max_workers", _gui_settings_cache["thinker_max_workers"])))
+		except Exception:
+			pass
+		_gui_settings_cache["signal_file_mirror"] = bool(data.get("signal_file_mirror", _gui_settings_cache["signal_file_mirror"]))
+		_gui_settings_cache["market_stream"] = bool(data.get("market_stream", _gui_settings_cache["market_stream"]))
+		_gui_settings_cache["bundle_source"] = str(data.get("bundle_source", "") or "").strip()
+		try:
+			_gui_settings_cache["bundle_poll_seconds"] = float(data.get("bundle_poll_seconds", pt_bundles.POLL_SECONDS))
+		except Exception:
+			pass
+
 		_gui_settings_cache["mtime"] = mtime
 		_gui_settings_cache["coins"] = coins
 		return list(coins)
@@ -191,6 +275,9 @@ def _load_gui_coins() -> list:
 
 # Initial coin list (will be kept live via _sync_coins_from_settings())
 COIN_SYMBOLS = _load_gui_coins()
+
+# per-coin signal snapshots for the trader (pt_signals.py); the text files stay as a mirror
+_signals = pt_signals.SignalPublisher(mirror=_gui_settings_cache["signal_file_mirror"])
 CURRENT_COINS = list(COIN_SYMBOLS)
 
 BASE_DIR = os.path.dirname(os.path.abspath(__file__))
@@ -201,6 +288,39 @@ def coin_folder(sym: str) -> str:
 	return BASE_DIR if sym == 'BTC' else os.path.join(BASE_DIR, sym)
 
 
+# --- memory cache (same idea as the trainer's _memory_cache) ---
+# (sym, tf_choice) -> {"sig": pt_memory.store_signature(), "generation": int, "store": MemoryStore}
+# Reloaded only when the file on disk changes, so stepping a coin doesn't touch the memory files.
+_memory_cache = {}
+
+def load_memory(sym: str, tf_choice: str):
+	folder = coin_folder(sym)
+	key = (sym.upper(), tf_choice)
+	sig = pt_memory.store_signature(tf_choice, folder)
+	cached = _memory_cache.get(key)
+	if cached is not None and cached["sig"] == sig:
+		pt_metrics.incr("memory_cache_hits")
+		return cached["store"]
+	if sig is None:
+		_memory_cache.pop(key, None)
+		return pt_memory.MemoryStore()
+
+	# store file was touched but the journal didn't move: if the generation is unchanged, keep what we have
+	if cached is not None and sig[0].endswith(".ptm") and sig[3:] == cached["sig"][3:]:
+		try:
+			if pt_memory.read_header(sig[0])["generation"] == cached.get("generation"):
+				cached["sig"] = sig
+				pt_metrics.incr("memory_cache_hits")
+				return cached["store"]
+		except Exception:
+			pass
+
+	pt_metrics.incr("memory_cache_misses")
+	store = pt_memory.load_store(tf_choice, folder)
+	_memory_cache[key] = {"sig": sig, "generation": store.generation, "store": store}
+	return store
+
+
 # --- training freshness gate (mirrors pt_hub.py) ---
 _TRAINING_STALE_SECONDS = 14 * 24 * 60 * 60  # 14 days
 
@@ -267,6 +387,23 @@ for _sym in CURRENT_COINS:
 
 distance = 0.5
 tf_choices = ['1hour', '2hour', '4hour', '8hour', '12hour', '1day', '1week']
+_KLINE_ROWS = 3  # only the open candle and the last closed one (history_list[1]) are ever read
+
+def _kline_rows(sym: str, tf_choice: str) -> int:
+	"""Rows step_coin fetches: the open candle plus one closed candle per move of the widest pattern."""
+	try:
+		return max(_KLINE_ROWS, pt_memory.pattern_widths(load_memory(sym, tf_choice))[-1] + 1)
+	except Exception:
+		return _KLINE_ROWS
+
+# Warm start: each coin's state is snapshotted to <coin folder>/thinker_state.json. A restart
+# restores it and only recomputes the timeframes whose last closed candle, threshold or
+# memories changed; with nothing changed the coin is ready after a single sweep.
+STATE_SNAPSHOT_FILE = 'thinker_state.json'
+STATE_SNAPSHOT_VERSION = 1
+STATE_SNAPSHOT_SECONDS = 30.0  # per coin, at most this often unless a candle closed
+STATE_SNAPSHOT_MAX_AGE_SECONDS = 24 * 60 * 60
+STATE_SNAPSHOTS = True  # pt_backtest.py turns them off
 
 def new_coin_state():
 	return {
@@ -289,6 +426,7 @@ def new_coin_state():
 		'updated': [0] * len(tf_choices),
 		'perfects': ['active'] * len(tf_choices),
 		'training_issues': [0] * len(tf_choices),
+		'predictions': [None] * len(tf_choices),  # per tf: (inputs key, perfect, training_issue, high, low)
 
 		# readiness gating (no placeholder-number checks; this is process-based)
 		'bounds_version': 0,
@@ -298,10 +436,49 @@ def new_coin_state():
 
 states = {}
 
+def _prediction_key(folder: str, tf: str, candle_time, openPrice: float, closePrice: float, perfect_threshold: float):
+	"""What a cached prediction depends on (see step_coin)."""
+	return (candle_time, openPrice, closePrice, perfect_threshold, pt_memory.store_signature(tf, folder))
+
+def _tuplify(v):
+	return tuple(_tuplify(x) for x in v) if isinstance(v, list) else v
+
+def _save_state_snapshot(sym: str, st: dict, force: bool = False) -> None:
+	if not STATE_SNAPSHOTS:
+		return
+	now = time.time()
+	if not force and (now - st.get('_snapshot_at', 0.0)) < STATE_SNAPSHOT_SECONDS:
+		return
+	st['_snapshot_at'] = now
+	state = {k: v for k, v in st.items() if not k.startswith('_')}
+	_atomic_write_json(os.path.join(coin_folder(sym), STATE_SNAPSHOT_FILE), {'version': STATE_SNAPSHOT_VERSION, 'saved_at': now, 'state': state})
+
+def _load_state_snapshot(sym: str):
+	"""The coin's saved state (new_coin_state() fields), or None when missing, stale or from another layout."""
+	try:
+		with open(os.path.join(coin_folder(sym), STATE_SNAPSHOT_FILE), 'r', encoding='utf-8') as f:
+			data = json.load(f)
+		if data.get('version') != STATE_SNAPSHOT_VERSION:
+			return None
+		if (time.time() - float(data.get('saved_at', 0.0))) > STATE_SNAPSHOT_MAX_AGE_SECONDS:
+			return None
+		state = data['state']
+		for k, v in new_coin_state().items():
+			if k not in state or (isinstance(v, list) and k != 'tf_times' and len(state[k]) != len(v)):
+				return None
+		if len(state['tf_times']) != len(tf_choices):
+			return None
+		# JSON turned the cached prediction keys into lists; step_coin compares them as tuples
+		state['predictions'] = [_tuplify(p) if p is not None else None for p in state['predictions']]
+		return state
+	except Exception:
+		return None
+
 display_cache = {sym: f"{sym}  (starting.)" for sym in CURRENT_COINS}
 
 # Track which coins have produced REAL predicted levels (not placeholder 1 / 99999999999999999)
 _ready_coins = set()
+_ready_lock = threading.Lock()  # _ready_coins + runner_ready.json are shared by all coin threads
 
 # We consider the runner "READY" only once it is ACTUALLY PRINTING real prediction messages
 # (i.e. output lines start with WITHIN / LONG / SHORT). No numeric placeholder checks at all.
@@ -336,11 +513,12 @@ def _sync_coins_from_settings():
 	removed = [c for c in old_list if c not in new_list]
 
 	# Handle removed coins: stop stepping + clear UI cache entries
-	for sym in removed:
-		try:
+	with _ready_lock:
+		# drop them from CURRENT_COINS first, so an in-flight step can't mark them ready again
+		CURRENT_COINS = [c for c in CURRENT_COINS if c not in removed]
+		for sym in removed:
 			_ready_coins.discard(sym)
-		except Exception:
-			pass
+	for sym in removed:
 		try:
 			display_cache.pop(sym, None)
 		except Exception:
@@ -357,14 +535,10 @@ def _sync_coins_from_settings():
 		except Exception:
 			pass
 		try:
-			# init_coin switches CWD and does network calls, so do it carefully
+			# init_coin does network calls, so do it carefully
 			init_coin(sym)
-			os.chdir(BASE_DIR)
 		except Exception:
-			try:
-				os.chdir(BASE_DIR)
-			except Exception:
-				pass
+			pass
 
 	CURRENT_COINS = list(new_list)
 
@@ -375,17 +549,17 @@ _write_runner_ready(False, stage="starting", ready_coins=[], total_coins=len(CUR
 
 
 def init_coin(sym: str):
-	# switch into the coin's folder so ALL existing relative file I/O stays working
-	os.chdir(coin_folder(sym))
+	# every per-coin file lives in the coin's folder (explicit paths: coins step concurrently, no chdir)
+	folder = coin_folder(sym)
 
 	# per-coin "version" + on/off files (no collisions between coins)
-	with open('alerts_version.txt', 'w+') as f:
+	with open(os.path.join(folder, 'alerts_version.txt'), 'w+') as f:
 		f.write('5/3/2022/9am')
 
-	with open('futures_long_onoff.txt', 'w+') as f:
+	with open(os.path.join(folder, 'futures_long_onoff.txt'), 'w+') as f:
 		f.write('OFF')
 
-	with open('futures_short_onoff.txt', 'w+') as f:
+	with open(os.path.join(folder, 'futures_short_onoff.txt'), 'w+') as f:
 		f.write('OFF')
 
 	st = new_coin_state()
@@ -393,11 +567,11 @@ def init_coin(sym: str):
 	coin = sym + '-USDT'
 	ind = 0
 	tf_times_local = []
+	last_closed = []  # per tf: (time, open, close) of the last closed candle, or None
 	while True:
-		history_list = []
 		while True:
 			try:
-				history = str(market.get_kline(coin, tf_choices[ind])).replace(']]', '], ').replace('[[', '[')
+				rows = pt_candles.get_kline(market, coin, tf_choices[ind], limit=_KLINE_ROWS)
 				break
 			except Exception as e:
 				time.sleep(3.5)
@@ -407,28 +581,43 @@ def init_coin(sym: str):
 					PrintException()
 				continue
 
-		history_list = history.split("], [")
 		ind += 1
 		try:
-			working_minute = str(history_list[1]).replace('"', '').replace("'", "").split(", ")
-			the_time = working_minute[0].replace('[', '')
+			the_time = rows[1][0]
+			last_closed.append((the_time, float(rows[1][1]), float(rows[1][2])))
 		except Exception:
 			the_time = 0.0
+			last_closed.append(None)
 
 		tf_times_local.append(the_time)
 		if len(tf_times_local) >= len(tf_choices):
 			break
 
+	snap = _load_state_snapshot(sym)
+	if snap is not None:
+		st.update(snap)
+		st['tf_choice_index'] = 0
+		trusted = True
+		for i, tf in enumerate(tf_choices):
+			if st['tf_times'][i] != tf_times_local[i]:
+				st['tf_update'][i] = 'yes'  # closed since the snapshot: its prediction is recomputed on its step
+			try:
+				with open(os.path.join(folder, 'neural_perfect_threshold_' + tf + '.txt'), 'r') as f:
+					perfect_threshold = float(f.read())
+				pred = st['predictions'][i]
+				if pred is None or last_closed[i] is None or pred[0] != _prediction_key(folder, tf, *last_closed[i], perfect_threshold):
+					trusted = False
+			except Exception:
+				trusted = False
+		if not trusted:
+			# some bounds came from older candles / memories: rebuild them once before reporting ready
+			st['bounds_version'] = 0
+			st['last_display_bounds_version'] = -1
+		display_cache[sym] = sym + '  (warm start' + ('' if trusted else ', refreshing changed timeframes') + '.)'
+
 	st['tf_times'] = tf_times_local
 	states[sym] = st
 
-# init all coins once (from GUI settings)
-for _sym in CURRENT_COINS:
-	init_coin(_sym)
-
-# restore CWD to base after init
-os.chdir(BASE_DIR)
-
 
 wallet_addr_list = []
 wallet_addr_users = []
@@ -474,9 +663,10 @@ def find_purple_area(lines):
     if purple_bottom is not None and purple_top is not None and purple_top > purple_bottom:
         return (purple_bottom, purple_top)
     return (None, None)
+@pt_metrics.timed("coin_step")
 def step_coin(sym: str):
-	# run inside the coin folder so all existing file reads/writes stay relative + isolated
-	os.chdir(coin_folder(sym))
+	# all of this coin's file reads/writes go to its own folder (explicit paths, safe across threads)
+	folder = coin_folder(sym)
 	coin = sym + '-USDT'
 	st = states[sym]
 
@@ -486,14 +676,12 @@ def step_coin(sym: str):
 	if not _coin_is_trained(sym):
 		try:
 			# Prevent new trades (and DCA) by forcing signals to 0 and keeping PM at baseline.
-			with open('futures_long_profit_margin.txt', 'w+') as f:
-				f.write('0.25')
-			with open('futures_short_profit_margin.txt', 'w+') as f:
-				f.write('0.25')
-			with open('long_dca_signal.txt', 'w+') as f:
-				f.write('0')
-			with open('short_dca_signal.txt', 'w+') as f:
-				f.write('0')
+			_signals.publish(sym, {'long': 0, 'short': 0, 'long_pm': 0.25, 'short_pm': 0.25}, folder, {
+				'futures_long_profit_margin.txt': '0.25',
+				'futures_short_profit_margin.txt': '0.25',
+				'long_dca_signal.txt': '0',
+				'short_dca_signal.txt': '0',
+			})
 		except Exception:
 			pass
 		try:
@@ -501,14 +689,15 @@ def step_coin(sym: str):
 		except Exception:
 			pass
 		try:
-			_ready_coins.discard(sym)
-			all_ready = len(_ready_coins) >= len(CURRENT_COINS)
-			_write_runner_ready(
-				all_ready,
-				stage=("real_predictions" if all_ready else "training_required"),
-				ready_coins=sorted(list(_ready_coins)),
-				total_coins=len(CURRENT_COINS),
-			)
+			with _ready_lock:
+				_ready_coins.discard(sym)
+				all_ready = len(_ready_coins) >= len(CURRENT_COINS)
+				_write_runner_ready(
+					all_ready,
+					stage=("real_predictions" if all_ready else "training_required"),
+					ready_coins=sorted(list(_ready_coins)),
+					total_coins=len(CURRENT_COINS),
+				)
 
 		except Exception:
 			pass
@@ -520,6 +709,8 @@ def step_coin(sym: str):
 		st['bounds_version'] = 0
 	if 'last_display_bounds_version' not in st:
 		st['last_display_bounds_version'] = -1
+	if len(st.get('predictions') or []) != len(tf_choices):
+		st['predictions'] = [None] * len(tf_choices)
 
 	# pull state into local names (lists mutate in-place; ones that get reassigned we set back at end)
 	low_bound_prices = st['low_bound_prices']
@@ -538,6 +729,7 @@ def step_coin(sym: str):
 	messaged = st['messaged']
 	updated = st['updated']
 	perfects = st['perfects']
+	predictions = st['predictions']
 	training_issues = st.get('training_issues', [0] * len(tf_choices))
 	# keep training_issues aligned to tf_choices
 	if len(training_issues) < len(tf_choices):
@@ -546,6 +738,7 @@ def step_coin(sym: str):
 		del training_issues[len(tf_choices):]
 
 	last_difference_between = 0.0
+	swept = False
 
 
 	# ====== ORIGINAL: fetch current candle for this timeframe index ======
@@ -553,7 +746,7 @@ def step_coin(sym: str):
 		history_list = []
 		while True:
 			try:
-				history = str(market.get_kline(coin, tf_choices[tf_choice_index])).replace(']]', '], ').replace('[[', '[')
+				history = str(pt_candles.get_kline(market, coin, tf_choices[tf_choice_index], limit=_kline_rows(sym, tf_choices[tf_choice_index]))).replace(']]', '], ').replace('[[', '[')
 				break
 			except Exception as e:
 				time.sleep(3.5)
@@ -578,148 +771,108 @@ def step_coin(sym: str):
 
 
 	current_candle = 100 * ((closePrice - openPrice) / openPrice)
+	# newest first: the last closed candle, then the ones before it (multi-width memories)
+	current_pattern_moves = [current_candle]
+	for row in history_list[2:]:
+		try:
+			row = str(row).replace('"', '').replace("'", "").replace('[', '').replace(']', '').split(", ")
+			current_pattern_moves.append(100 * ((float(row[2]) - float(row[1])) / float(row[1])))
+		except Exception:
+			break
 
-	# ====== ORIGINAL: load threshold + memories/weights and compute moves ======
-	file = open('neural_perfect_threshold_' + tf_choices[tf_choice_index] + '.txt', 'r')
+	# ====== ORIGINAL: load threshold ======
+	file = open(os.path.join(folder, 'neural_perfect_threshold_' + tf_choices[tf_choice_index] + '.txt'), 'r')
 	perfect_threshold = float(file.read())
 	file.close()
 
-	try:
-		# If we can read/parse training files, this timeframe is NOT a training-file issue.
-		training_issues[tf_choice_index] = 0
-
-		file = open('memories_' + tf_choices[tf_choice_index] + '.txt', 'r')
-		memory_list = file.read().replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').split('~')
-		file.close()
-
-		file = open('memory_weights_' + tf_choices[tf_choice_index] + '.txt', 'r')
-		weight_list = file.read().replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').split(' ')
-		file.close()
-
-		file = open('memory_weights_high_' + tf_choices[tf_choice_index] + '.txt', 'r')
-		high_weight_list = file.read().replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').split(' ')
-		file.close()
-
-		file = open('memory_weights_low_' + tf_choices[tf_choice_index] + '.txt', 'r')
-		low_weight_list = file.read().replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').split(' ')
-		file.close()
-
-		mem_ind = 0
-		diffs_list = []
-		any_perfect = 'no'
-		perfect_dexs = []
-		perfect_diffs = []
-		moves = []
-		move_weights = []
-		unweighted = []
-		high_unweighted = []
-		low_unweighted = []
-		high_moves = []
-		low_moves = []
-
-		while True:
-			memory_pattern = memory_list[mem_ind].split('{}')[0].replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').split(' ')
-			check_dex = 0
-			memory_candle = float(memory_pattern[check_dex])
-
-			if current_candle == 0.0 and memory_candle == 0.0:
-				difference = 0.0
+	# ====== prediction for this timeframe ======
+	# It only depends on the last closed candle, the threshold and the memories, so it is
+	# recomputed when the candle rolls over or the trainer changed the store; otherwise the
+	# cached result is reused and this step is just the cheap price-vs-bounds bookkeeping.
+	pred_key = _prediction_key(folder, tf_choices[tf_choice_index], working_minute[0].replace('[', ''), openPrice, closePrice, perfect_threshold)
+	cached_pred = predictions[tf_choice_index]
+	if cached_pred is not None and cached_pred[0] == pred_key:
+		pt_metrics.incr("prediction_cache_hits")
+		_, perfect_state, training_issue, high_price, low_price = cached_pred
+		perfects[tf_choice_index] = perfect_state
+		training_issues[tf_choice_index] = training_issue
+		high_tf_prices[tf_choice_index] = high_price
+		low_tf_prices[tf_choice_index] = low_price
+	else:
+		pt_metrics.incr("prediction_recomputes")
+		try:
+			# If we can read/parse training files, this timeframe is NOT a training-file issue.
+			training_issues[tf_choice_index] = 0
+
+			store = load_memory(sym, tf_choices[tf_choice_index])
+			memory_count = len(store)
+			if memory_count == 0:
+				raise IndexError('no memories for ' + tf_choices[tf_choice_index])
+			# score the newest candles at every width the memories were trained at, in one pass
+			# (indexed by first value, see pt_match.py); the widths' predictions are averaged
+			widths = [w for w in pt_memory.pattern_widths(store) if w <= len(current_pattern_moves)]
+			if not widths:
+				raise IndexError('not enough candles for ' + tf_choices[tf_choice_index] + ' patterns')
+			match_results = pt_match.match_lengths(current_pattern_moves, store, perfect_threshold, widths)
+			perfect_dexs = pt_match.perfect_union(match_results)
+
+			if not perfect_dexs:
+				final_moves = 0.0
+				high_final_moves = 0.0
+				low_final_moves = 0.0
+				del perfects[tf_choice_index]
+				perfects.insert(tf_choice_index, 'inactive')
 			else:
 				try:
-					difference = abs((abs(current_candle - memory_candle) / ((current_candle + memory_candle) / 2)) * 100)
+					# zero-weight memories stay out of the means
+					final_moves, high_final_moves, low_final_moves = pt_match.ensemble_moves(store, match_results, skip_zero_weights=True)
+					del perfects[tf_choice_index]
+					perfects.insert(tf_choice_index, 'active')
 				except:
-					difference = 0.0
-
-			diff_avg = difference
-
-			if diff_avg <= perfect_threshold:
-				any_perfect = 'yes'
-				high_diff = float(memory_list[mem_ind].split('{}')[1].replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').replace(' ', '')) / 100
-				low_diff = float(memory_list[mem_ind].split('{}')[2].replace("'", "").replace(',', '').replace('"', '').replace(']', '').replace('[', '').replace(' ', '')) / 100
-
-				unweighted.append(float(memory_pattern[len(memory_pattern) - 1]))
-				move_weights.append(float(weight_list[mem_ind]))
-				high_unweighted.append(high_diff)
-				low_unweighted.append(low_diff)
-
-				if float(weight_list[mem_ind]) != 0.0:
-					moves.append(float(memory_pattern[len(memory_pattern) - 1]) * float(weight_list[mem_ind]))
-
-				if float(high_weight_list[mem_ind]) != 0.0:
-					high_moves.append(high_diff * float(high_weight_list[mem_ind]))
-
-				if float(low_weight_list[mem_ind]) != 0.0:
-					low_moves.append(low_diff * float(low_weight_list[mem_ind]))
-
-				perfect_dexs.append(mem_ind)
-				perfect_diffs.append(diff_avg)
-
-			diffs_list.append(diff_avg)
-			mem_ind += 1
-
-			if mem_ind >= len(memory_list):
-				if any_perfect == 'no':
 					final_moves = 0.0
 					high_final_moves = 0.0
 					low_final_moves = 0.0
 					del perfects[tf_choice_index]
 					perfects.insert(tf_choice_index, 'inactive')
-				else:
-					try:
-						final_moves = sum(moves) / len(moves)
-						high_final_moves = sum(high_moves) / len(high_moves)
-						low_final_moves = sum(low_moves) / len(low_moves)
-						del perfects[tf_choice_index]
-						perfects.insert(tf_choice_index, 'active')
-					except:
-						final_moves = 0.0
-						high_final_moves = 0.0
-						low_final_moves = 0.0
-						del perfects[tf_choice_index]
-						perfects.insert(tf_choice_index, 'inactive')
-				break
 
-	except Exception:
-		PrintException()
-		training_issues[tf_choice_index] = 1
-		final_moves = 0.0
-		high_final_moves = 0.0
-		low_final_moves = 0.0
-		del perfects[tf_choice_index]
-		perfects.insert(tf_choice_index, 'inactive')
-
-	# keep threshold persisted (original behavior)
-	file = open('neural_perfect_threshold_' + tf_choices[tf_choice_index] + '.txt', 'w+')
-	file.write(str(perfect_threshold))
-	file.close()
+		except Exception:
+			PrintException()
+			training_issues[tf_choice_index] = 1
+			final_moves = 0.0
+			high_final_moves = 0.0
+			low_final_moves = 0.0
+			del perfects[tf_choice_index]
+			perfects.insert(tf_choice_index, 'inactive')
 
-	# ====== ORIGINAL: compute new high/low predictions ======
-	price_list2 = [openPrice, closePrice]
-	current_pattern = [price_list2[0], price_list2[1]]
+		# ====== ORIGINAL: compute new high/low predictions ======
+		price_list2 = [openPrice, closePrice]
+		current_pattern = [price_list2[0], price_list2[1]]
+
+		try:
+			c_diff = final_moves / 100
+			high_diff = high_final_moves
+			low_diff = low_final_moves
+
+			start_price = current_pattern[len(current_pattern) - 1]
+			high_new_price = start_price + (start_price * high_diff)
+			low_new_price = start_price + (start_price * low_diff)
+		except:
+			start_price = current_pattern[len(current_pattern) - 1]
+			high_new_price = start_price
+			low_new_price = start_price
+
+		if perfects[tf_choice_index] == 'inactive':
+			del high_tf_prices[tf_choice_index]
+			high_tf_prices.insert(tf_choice_index, start_price)
+			del low_tf_prices[tf_choice_index]
+			low_tf_prices.insert(tf_choice_index, start_price)
+		else:
+			del high_tf_prices[tf_choice_index]
+			high_tf_prices.insert(tf_choice_index, high_new_price)
+			del low_tf_prices[tf_choice_index]
+			low_tf_prices.insert(tf_choice_index, low_new_price)
+		predictions[tf_choice_index] = (pred_key, perfects[tf_choice_index], training_issues[tf_choice_index], high_tf_prices[tf_choice_index], low_tf_prices[tf_choice_index])
 
-	try:
-		c_diff = final_moves / 100
-		high_diff = high_final_moves
-		low_diff = low_final_moves
-
-		start_price = current_pattern[len(current_pattern) - 1]
-		high_new_price = start_price + (start_price * high_diff)
-		low_new_price = start_price + (start_price * low_diff)
-	except:
-		start_price = current_pattern[len(current_pattern) - 1]
-		high_new_price = start_price
-		low_new_price = start_price
-
-	if perfects[tf_choice_index] == 'inactive':
-		del high_tf_prices[tf_choice_index]
-		high_tf_prices.insert(tf_choice_index, start_price)
-		del low_tf_prices[tf_choice_index]
-		low_tf_prices.insert(tf_choice_index, start_price)
-	else:
-		del high_tf_prices[tf_choice_index]
-		high_tf_prices.insert(tf_choice_index, high_new_price)
-		del low_tf_prices[tf_choice_index]
-		low_tf_prices.insert(tf_choice_index, low_new_price)
 
 	# ====== advance tf index; if full sweep complete, compute signals ======
 	tf_choice_index += 1
@@ -731,10 +884,9 @@ def step_coin(sym: str):
 		tf_update = ['no'] * len(tf_choices)
 
 		# get current price ONCE per coin — use Robinhood's current ASK (same as rhcb trader buy price)
-		rh_symbol = f"{sym}-USD"
 		while True:
 			try:
-				current = robinhood_current_ask(rh_symbol)
+				current = current_ask(sym)
 				break
 			except Exception as e:
 				print(e)
@@ -781,7 +933,7 @@ def step_coin(sym: str):
 			while True:
 
 				try:
-					history = str(market.get_kline(coin, tf_choices[inder])).replace(']]', '], ').replace('[[', '[')
+					history = str(pt_candles.get_kline(market, coin, tf_choices[inder], limit=_KLINE_ROWS)).replace(']]', '], ').replace('[[', '[')
 					break
 				except Exception as e:
 					time.sleep(3.5)
@@ -959,10 +1111,10 @@ def step_coin(sym: str):
 		# bump bounds_version now that we've computed a new set of prediction bounds
 		st['bounds_version'] = bounds_version_used_for_messages + 1
 
-		with open('low_bound_prices.html', 'w+') as file:
-			file.write(str(new_low_bound_prices).replace("', '", " ").replace("[", "").replace("]", "").replace("'", ""))
-		with open('high_bound_prices.html', 'w+') as file:
-			file.write(str(new_high_bound_prices).replace("', '", " ").replace("[", "").replace("]", "").replace("'", ""))
+		_signals.publish(sym, {'low_bounds': list(new_low_bound_prices), 'high_bounds': list(new_high_bound_prices)}, folder, {
+			'low_bound_prices.html': str(new_low_bound_prices).replace("', '", " ").replace("[", "").replace("]", "").replace("'", ""),
+			'high_bound_prices.html': str(new_high_bound_prices).replace("', '", " ").replace("[", "").replace("]", "").replace("'", ""),
+		})
 
 		# cache display text for this coin (main loop prints everything on one screen)
 		try:
@@ -977,20 +1129,21 @@ def step_coin(sym: str):
 
 			# Only consider this coin "ready" once we've already rebuilt bounds at least once
 			# AND we're now printing messages generated from those rebuilt bounds.
-			if (st['last_display_bounds_version'] >= 1) and _is_printing_real_predictions(messages):
-				_ready_coins.add(sym)
-			else:
-				_ready_coins.discard(sym)
+			with _ready_lock:
+				if (sym in CURRENT_COINS) and (st['last_display_bounds_version'] >= 1) and _is_printing_real_predictions(messages):
+					_ready_coins.add(sym)
+				else:
+					_ready_coins.discard(sym)
 
 
 
-			all_ready = len(_ready_coins) >= len(COIN_SYMBOLS)
-			_write_runner_ready(
-				all_ready,
-				stage=("real_predictions" if all_ready else "warming_up"),
-				ready_coins=sorted(list(_ready_coins)),
-				total_coins=len(COIN_SYMBOLS),
-			)
+				all_ready = len(_ready_coins) >= len(COIN_SYMBOLS)
+				_write_runner_ready(
+					all_ready,
+					stage=("real_predictions" if all_ready else "warming_up"),
+					ready_coins=sorted(list(_ready_coins)),
+					total_coins=len(COIN_SYMBOLS),
+				)
 
 		except:
 			PrintException()
@@ -1012,10 +1165,7 @@ def step_coin(sym: str):
 			except:
 				pm = 0.25
 
-			with open('futures_long_profit_margin.txt', 'w+') as f:
-				f.write(str(pm))
-			with open('long_dca_signal.txt', 'w+') as f:
-				f.write(str(longs))
+			long_pm = pm
 
 			# short pm
 			current_pms = [m for m in margins if m != 0]
@@ -1026,10 +1176,12 @@ def step_coin(sym: str):
 			except:
 				pm = 0.25
 
-			with open('futures_short_profit_margin.txt', 'w+') as f:
-				f.write(str(abs(pm)))
-			with open('short_dca_signal.txt', 'w+') as f:
-				f.write(str(shorts))
+			_signals.publish(sym, {'long': longs, 'short': shorts, 'long_pm': long_pm, 'short_pm': abs(pm)}, folder, {
+				'futures_long_profit_margin.txt': str(long_pm),
+				'long_dca_signal.txt': str(longs),
+				'futures_short_profit_margin.txt': str(abs(pm)),
+				'short_dca_signal.txt': str(shorts),
+			})
 
 		except:
 			PrintException()
@@ -1039,7 +1191,7 @@ def step_coin(sym: str):
 		while this_index_now < len(tf_update):
 			while True:
 				try:
-					history = str(market.get_kline(coin, tf_choices[this_index_now])).replace(']]', '], ').replace('[[', '[')
+					history = str(pt_candles.get_kline(market, coin, tf_choices[this_index_now], limit=_KLINE_ROWS)).replace(']]', '], ').replace('[[', '[')
 					break
 				except Exception as e:
 					time.sleep(3.5)
@@ -1063,6 +1215,7 @@ def step_coin(sym: str):
 				tf_times.insert(this_index_now, the_time)
 
 			this_index_now += 1
+		swept = True
 
 	# ====== save state back ======
 	st['low_bound_prices'] = low_bound_prices
@@ -1088,29 +1241,65 @@ def step_coin(sym: str):
 	st['training_issues'] = training_issues
 
 	states[sym] = st
+	if swept:
+		_save_state_snapshot(sym, st, force=('yes' in tf_update))
 
 
 
 
-try:
-	while True:
-		# Hot-reload coins from GUI settings while running
-		_sync_coins_from_settings()
+def main():
+	# Coins step concurrently on a bounded pool (gui_settings.json "thinker_max_workers").
+	# Each coin is resubmitted as soon as its previous step finishes, so one coin stuck on a
+	# slow KuCoin/Robinhood call (or its 3.5s retry sleep) doesn't hold back the others.
+	pool = ThreadPoolExecutor(max_workers=_gui_settings_cache["thinker_max_workers"], thread_name_prefix="coin")
+	running = {}  # sym -> Future of its current step
+	pt_metrics.configure("thinker")
 
-		for _sym in CURRENT_COINS:
-			step_coin(_sym)
+	# init all coins once (from GUI settings)
+	list(pool.map(init_coin, CURRENT_COINS))
 
-		# clear + re-print one combined screen (so you don't see old output above new)
-		os.system('cls' if os.name == 'nt' else 'clear')
+	# multi-host: trained memories arrive as bundles from bundle_source (pt_bundles.py);
+	# load_memory() picks a swapped-in store up on the coin's next step
+	pt_bundles.Subscriber(
+		lambda: _gui_settings_cache["bundle_source"],
+		lambda: list(CURRENT_COINS),
+		coin_folder,
+		lambda: _gui_settings_cache["bundle_poll_seconds"],
+	).start()
 
-		for _sym in CURRENT_COINS:
-			print(display_cache.get(_sym, _sym + "  (no data yet)"))
-			print("\n" + ("-" * 60) + "\n")
+	try:
+		while True:
+			# Hot-reload coins from GUI settings while running
+			_sync_coins_from_settings()
+			_sync_stream(CURRENT_COINS)
 
-		# small sleep so you don't peg CPU when running many coins
-		time.sleep(0.15)
+			for _sym, fut in list(running.items()):
+				if fut.done():
+					del running[_sym]
+					try:
+						fut.result()
+					except Exception:
+						PrintException()
 
-except Exception:
-	PrintException()
+			for _sym in CURRENT_COINS:
+				if _sym not in running:
+					running[_sym] = pool.submit(step_coin, _sym)
+			pt_metrics.gauge("coins", len(CURRENT_COINS))
+			pt_metrics.gauge("coins_in_flight", sum(1 for f in running.values() if not f.done()))
+
+			# clear + re-print one combined screen (so you don't see old output above new)
+			os.system('cls' if os.name == 'nt' else 'clear')
+
+			for _sym in CURRENT_COINS:
+				print(display_cache.get(_sym, _sym + "  (no data yet)"))
+				print("\n" + ("-" * 60) + "\n")
+
+			# small sleep so you don't peg CPU when running many coins
+			time.sleep(0.15)
+
+	except Exception:
+		PrintException()
 
 
+if __name__ == "__main__":
+	main()
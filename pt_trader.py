@@ -6,11 +6,21 @@ import time
 import math
 from typing import Any, Dict, Optional
 import requests
+from requests.adapters import HTTPAdapter
+from urllib3.util.retry import Retry
+import threading
+import re
+import pt_signals
+import pt_stream
+import pt_metrics
+import pt_history
+import pt_positions
 from nacl.signing import SigningKey
 import os
 import colorama
 from colorama import Fore, Style
 import traceback
+from concurrent.futures import ThreadPoolExecutor
 from cryptography.hazmat.primitives.asymmetric import ed25519
 from cryptography.hazmat.primitives import serialization
 
@@ -25,6 +35,33 @@ TRADE_HISTORY_PATH = os.path.join(HUB_DATA_DIR, "trade_history.jsonl")
 PNL_LEDGER_PATH = os.path.join(HUB_DATA_DIR, "pnl_ledger.json")
 ACCOUNT_VALUE_HISTORY_PATH = os.path.join(HUB_DATA_DIR, "account_value_history.jsonl")
 
+# best_bid_ask: symbols per multi-symbol request, and concurrent single-symbol fallbacks
+PRICE_BATCH_SIZE = 20
+PRICE_FETCH_WORKERS = 8
+
+# make_api_request: shared keep-alive session (pool size comes from gui_settings "trader_api_pool_size")
+API_POOL_SIZE = 10
+API_MAX_RETRIES = 2          # GET only; POSTs (orders) are never replayed
+API_BACKOFF_SECONDS = 0.25   # 0.25s, 0.5s, ... between retries (Retry-After is honoured)
+
+# the loop never idles longer than LOOP_IDLE_SECONDS: trailing-profit and DCA checks read Robinhood
+# quotes, which can move without a KuCoin tick. market_stream only wakes it earlier, as soon as a
+# coin moves STREAM_MOVE_PCT on KuCoin.
+LOOP_IDLE_SECONDS = 0.5
+STREAM_MOVE_PCT = 0.05
+
+# pending orders (pnl_ledger.json "pending_orders") are polled between trade passes, never waited on:
+# first look right after placing, then every ORDER_POLL_MIN_SECONDS growing by ORDER_POLL_BACKOFF up to the max
+ORDER_TERMINAL_STATES = {"filled", "canceled", "cancelled", "rejected", "failed", "error"}
+ORDER_POLL_MIN_SECONDS = 0.5
+ORDER_POLL_MAX_SECONDS = 10.0
+ORDER_POLL_BACKOFF = 1.6
+
+# Position index (pt_positions.py): held coins are re-checked against Robinhood's order
+# history on a background thread this often, and soon after every fill.
+POSITION_VERIFY_SECONDS = 30 * 60
+POSITION_VERIFY_AFTER_FILL_SECONDS = 60.0
+
 
 
 # Initialize colorama
@@ -52,6 +89,9 @@ _gui_settings_cache = {
 	"pm_start_pct_no_dca": 5.0,
 	"pm_start_pct_with_dca": 2.5,
 	"trailing_gap_pct": 0.5,
+
+	"trader_api_pool_size": API_POOL_SIZE,
+	"market_stream": False,
 }
 
 
@@ -162,6 +202,15 @@ def _load_gui_settings() -> dict:
 		if trailing_gap_pct < 0.0:
 			trailing_gap_pct = 0.0
 
+		trader_api_pool_size = data.get("trader_api_pool_size", _gui_settings_cache.get("trader_api_pool_size", API_POOL_SIZE))
+		try:
+			trader_api_pool_size = int(float(trader_api_pool_size))
+		except Exception:
+			trader_api_pool_size = int(_gui_settings_cache.get("trader_api_pool_size", API_POOL_SIZE))
+		trader_api_pool_size = max(1, trader_api_pool_size)
+
+		market_stream = bool(data.get("market_stream", _gui_settings_cache.get("market_stream", False)))
+
 
 		_gui_settings_cache["mtime"] = mtime
 		_gui_settings_cache["coins"] = coins
@@ -175,6 +224,8 @@ def _load_gui_settings() -> dict:
 		_gui_settings_cache["pm_start_pct_no_dca"] = pm_start_pct_no_dca
 		_gui_settings_cache["pm_start_pct_with_dca"] = pm_start_pct_with_dca
 		_gui_settings_cache["trailing_gap_pct"] = trailing_gap_pct
+		_gui_settings_cache["trader_api_pool_size"] = trader_api_pool_size
+		_gui_settings_cache["market_stream"] = market_stream
 
 
 		return {
@@ -190,6 +241,8 @@ def _load_gui_settings() -> dict:
 			"pm_start_pct_no_dca": pm_start_pct_no_dca,
 			"pm_start_pct_with_dca": pm_start_pct_with_dca,
 			"trailing_gap_pct": trailing_gap_pct,
+			"trader_api_pool_size": trader_api_pool_size,
+			"market_stream": market_stream,
 		}
 
 
@@ -245,6 +298,79 @@ PM_START_PCT_WITH_DCA = 2.5
 _last_settings_mtime = None
 
 
+def _build_api_session(pool_size: int) -> requests.Session:
+	"""
+	One keep-alive session for every Robinhood call. Idempotent GETs are retried with
+	exponential backoff on connection errors / 429 / 5xx; POSTs are sent exactly once.
+	"""
+	retry_kwargs = dict(
+		total=API_MAX_RETRIES,
+		connect=API_MAX_RETRIES,
+		read=API_MAX_RETRIES,
+		status=API_MAX_RETRIES,
+		backoff_factor=API_BACKOFF_SECONDS,
+		status_forcelist=(429, 500, 502, 503, 504),
+		raise_on_status=False,
+		respect_retry_after_header=True,
+	)
+	try:
+		retry = Retry(allowed_methods=frozenset(["GET"]), **retry_kwargs)
+	except TypeError:  # urllib3 < 1.26
+		retry = Retry(method_whitelist=frozenset(["GET"]), **retry_kwargs)
+
+	session = requests.Session()
+	adapter = HTTPAdapter(pool_connections=1, pool_maxsize=max(1, int(pool_size)), max_retries=retry)
+	session.mount("https://", adapter)
+	session.mount("http://", adapter)
+	session.headers.update({"Connection": "keep-alive"})
+	return session
+
+
+# thinker signal snapshots (pt_signals.py); created by CryptoAPITrading, None = read the text files
+_signal_feed = None
+
+
+def _signal_snapshot(symbol: str) -> Optional[dict]:
+	if _signal_feed is None:
+		return None
+	snap = _signal_feed.get(symbol)
+	pt_metrics.incr("signal_snapshot_hits" if snap is not None else "signal_snapshot_misses")
+	return snap
+
+
+def _http_retries(response) -> int:
+	"""How many times urllib3 retried the request behind `response` (0 when unknown)."""
+	try:
+		return len(response.raw.retries.history)
+	except Exception:
+		return 0
+
+
+_ID_SEGMENT_RE = re.compile(r"^[0-9a-fA-F-]{16,}$")
+
+
+class ApiLatencyStats:
+	"""
+	Per-endpoint latency for make_api_request, recorded as pt_metrics timers named
+	"api GET /api/v1/crypto/trading/orders/{id}/" (metrics_trader.json, the hub's Metrics tab).
+	Query strings are dropped and id-like path segments collapsed so each endpoint is one row.
+	"""
+
+	@staticmethod
+	def endpoint_key(method: str, path: str) -> str:
+		parts = str(path).split("?", 1)[0].split("/")
+		parts = ["{id}" if _ID_SEGMENT_RE.match(p) else p for p in parts]
+		return f"{str(method).upper()} {'/'.join(parts)}"
+
+	def observe(self, method: str, path: str, elapsed_s: float, ok: bool, response=None) -> None:
+		pt_metrics.observe(f"api {self.endpoint_key(method, path)}", elapsed_s)
+		if not ok:
+			pt_metrics.incr("api_errors")
+		retries = _http_retries(response) if response is not None else 0
+		if retries:
+			pt_metrics.incr("api_retries", retries)
+
+
 
 
 def _refresh_paths_and_symbols():
@@ -324,33 +450,46 @@ def _refresh_paths_and_symbols():
 API_KEY = ""
 BASE64_PRIVATE_KEY = ""
 
-try:
-    with open('r_key.txt', 'r', encoding='utf-8') as f:
-        API_KEY = (f.read() or "").strip()
-    with open('r_secret.txt', 'r', encoding='utf-8') as f:
-        BASE64_PRIVATE_KEY = (f.read() or "").strip()
-except Exception:
-    API_KEY = ""
-    BASE64_PRIVATE_KEY = ""
-
-if not API_KEY or not BASE64_PRIVATE_KEY:
-    print(
-        "\n[PowerTrader] Robinhood API credentials not found.\n"
-        "Open the GUI and go to Settings → Robinhood API → Setup / Update.\n"
-        "That wizard will generate your keypair, tell you where to paste the public key on Robinhood,\n"
-        "and will save r_key.txt + r_secret.txt so this trader can authenticate.\n"
-    )
-    raise SystemExit(1)
+
+def _load_api_credentials() -> None:
+    """
+    Reads r_key.txt + r_secret.txt into API_KEY / BASE64_PRIVATE_KEY (exits if missing).
+    Called when the trader is started, not on import, so pt_backtest.py can import this module.
+    """
+    global API_KEY, BASE64_PRIVATE_KEY
+    try:
+        with open('r_key.txt', 'r', encoding='utf-8') as f:
+            API_KEY = (f.read() or "").strip()
+        with open('r_secret.txt', 'r', encoding='utf-8') as f:
+            BASE64_PRIVATE_KEY = (f.read() or "").strip()
+    except Exception:
+        API_KEY = ""
+        BASE64_PRIVATE_KEY = ""
+
+    if not API_KEY or not BASE64_PRIVATE_KEY:
+        print(
+            "\n[PowerTrader] Robinhood API credentials not found.\n"
+            "Open the GUI and go to Settings → Robinhood API → Setup / Update.\n"
+            "That wizard will generate your keypair, tell you where to paste the public key on Robinhood,\n"
+            "and will save r_key.txt + r_secret.txt so this trader can authenticate.\n"
+        )
+        raise SystemExit(1)
 
 class CryptoAPITrading:
     def __init__(self):
         # keep a copy of the folder map (same idea as trader.py)
         self.path_map = dict(base_paths)
 
-        self.api_key = API_KEY
-        private_key_seed = base64.b64decode(BASE64_PRIVATE_KEY)
-        self.private_key = SigningKey(private_key_seed)
-        self.base_url = "https://trading.robinhood.com"
+        self._init_api()
+
+        # thinker -> trader signal snapshots (falls back to the text files when none arrive)
+        # one wake-up event for run(): thinker signal changes and (market_stream) KuCoin ticker moves
+        self._wake = threading.Event()
+        global _signal_feed
+        if _signal_feed is None:
+            _signal_feed = pt_signals.SignalSubscriber(event=self._wake)
+        self._stream = None
+        self._stream_pairs = None
 
         self.dca_levels_triggered = {}  # Track DCA levels for each crypto
         self.dca_levels = list(DCA_LEVELS)  # Hard DCA triggers (percent PnL)
@@ -372,16 +511,26 @@ class CryptoAPITrading:
 
 
 
-        self.cost_basis = self.calculate_cost_basis()  # Initialize cost basis at startup
-        self.initialize_dca_levels()  # Initialize DCA levels based on historical buy orders
+        # cost basis + DCA stages per coin, kept up to date by _record_trade(); see pt_positions.py
+        self.positions = pt_positions.PositionIndex(HUB_DATA_DIR, TRADE_HISTORY_PATH)
+        self.cost_basis = {}
+        self._init_positions()
+        self._position_verify_thread = None
+        self._position_verify_result = None
+        self._position_verify_due = 0.0  # first background check on the first manage_trades() pass
 
         # GUI hub persistence
         self._pnl_ledger = self._load_pnl_ledger()
+
+        # raw account value log (rotated) + 1min/1hour/1day rollups; see pt_history.py
+        self.account_history = pt_history.AccountValueRecorder(HUB_DATA_DIR)
         self._reconcile_pending_orders()
 
 
         # Cache last known bid/ask per symbol so transient API misses don't zero out account value
         self._last_good_bid_ask = {}
+        # seconds since each symbol's quote was fetched, as of the last get_price() (0.0 = fresh)
+        self.price_age = {}
 
         # Cache last *complete* account snapshot so transient holdings/price misses can't write a bogus low value
         self._last_good_account_snapshot = {
@@ -407,6 +556,18 @@ class CryptoAPITrading:
 
 
 
+    def _init_api(self) -> None:
+        """Robinhood signing key + pooled session (pt_backtest.py swaps this for a simulated exchange)."""
+        self.api_key = API_KEY
+        private_key_seed = base64.b64decode(BASE64_PRIVATE_KEY)
+        self.private_key = SigningKey(private_key_seed)
+        self.base_url = "https://trading.robinhood.com"
+
+        # one pooled keep-alive session for every API call (get_price's concurrent fallbacks included)
+        pool_size = int(_load_gui_settings().get("trader_api_pool_size", API_POOL_SIZE) or API_POOL_SIZE)
+        self.session = _build_api_session(max(pool_size, PRICE_FETCH_WORKERS))
+        self.api_latency = ApiLatencyStats()
+
     def _atomic_write_json(self, path: str, data: dict) -> None:
         try:
             tmp = f"{path}.tmp"
@@ -453,25 +614,9 @@ class CryptoAPITrading:
             pass
 
     def _trade_history_has_order_id(self, order_id: str) -> bool:
-        try:
-            if not order_id:
-                return False
-            if not os.path.isfile(TRADE_HISTORY_PATH):
-                return False
-            with open(TRADE_HISTORY_PATH, "r", encoding="utf-8") as f:
-                for line in f:
-                    line = (line or "").strip()
-                    if not line:
-                        continue
-                    try:
-                        obj = json.loads(line)
-                    except Exception:
-                        continue
-                    if str(obj.get("order_id", "")).strip() == str(order_id).strip():
-                        return True
-        except Exception:
+        if not order_id:
             return False
-        return False
+        return self.positions.has_order(order_id)
 
     def _get_buying_power(self) -> float:
         try:
@@ -541,97 +686,279 @@ class CryptoAPITrading:
         except Exception:
             return 0.0, None
 
-    def _wait_for_order_terminal(self, symbol: str, order_id: str) -> Optional[dict]:
-        """Blocks until order is filled/canceled/rejected, then returns the order dict."""
-        terminal = {"filled", "canceled", "cancelled", "rejected", "failed", "error"}
-        while True:
-            o = self._get_order_by_id(symbol, order_id)
-            if not o:
-                time.sleep(1)
-                continue
-            st = str(o.get("state", "")).lower().strip()
-            if st in terminal:
-                return o
-            time.sleep(1)
+    def _sell_fill_from_order(self, order: dict, expected_price: Optional[float], asset_quantity: float) -> tuple:
+        """Returns (filled_qty, avg_fill_price, fees_usd) for a sell, falling back to what was sent."""
+        actual_price = float(expected_price) if expected_price is not None else None
+        actual_qty = float(asset_quantity or 0.0)
+        fees_usd = None
+
+        def _fee_to_float(v: Any) -> float:
+            try:
+                if v is None:
+                    return 0.0
+                if isinstance(v, (int, float)):
+                    return float(v)
+                if isinstance(v, str):
+                    return float(v)
+                if isinstance(v, dict):
+                    # common shapes: {"amount": "0.12"}, {"value": 0.12}, etc.
+                    for k in ("amount", "value", "usd_amount", "fee", "quantity"):
+                        if k in v:
+                            try:
+                                return float(v[k])
+                            except Exception:
+                                continue
+                return 0.0
+            except Exception:
+                return 0.0
 
-    def _reconcile_pending_orders(self) -> None:
-        """
-        If the hub/trader restarts mid-order, we keep the pre-order buying_power on disk and
-        finish the accounting once the order shows as terminal in Robinhood.
-        """
         try:
-            pending = self._pnl_ledger.get("pending_orders", {})
-            if not isinstance(pending, dict) or not pending:
-                return
+            execs = order.get("executions", []) or []
+            total_qty = 0.0
+            total_notional = 0.0
+            fee_total = 0.0
 
-            # Loop until everything pending is resolved (matches your design: bot waits here).
-            while True:
-                pending = self._pnl_ledger.get("pending_orders", {})
-                if not isinstance(pending, dict) or not pending:
-                    break
+            for ex in execs:
+                try:
+                    q = float(ex.get("quantity", 0.0) or 0.0)
+                    p = float(ex.get("effective_price", 0.0) or 0.0)
+                    total_qty += q
+                    total_notional += (q * p)
 
-                progressed = False
+                    # Fees can show up under different keys; handle the common ones.
+                    for fk in ("fee", "fees", "fee_amount", "fee_usd", "fee_in_usd"):
+                        if fk in ex:
+                            fee_total += _fee_to_float(ex.get(fk))
+                except Exception:
+                    continue
 
-                for order_id, info in list(pending.items()):
-                    try:
-                        if self._trade_history_has_order_id(order_id):
-                            # Already recorded (e.g., crash after writing history) -> just clear pending.
-                            self._pnl_ledger["pending_orders"].pop(order_id, None)
-                            self._save_pnl_ledger()
-                            progressed = True
-                            continue
+            # Some payloads include order-level fee fields too
+            for fk in ("fee", "fees", "fee_amount", "fee_usd", "fee_in_usd"):
+                if fk in order:
+                    fee_total += _fee_to_float(order.get(fk))
 
-                        symbol = str(info.get("symbol", "")).strip()
-                        side = str(info.get("side", "")).strip().lower()
-                        bp_before = float(info.get("buying_power_before", 0.0) or 0.0)
+            if total_qty > 0.0 and total_notional > 0.0:
+                actual_qty = total_qty
+                actual_price = total_notional / total_qty
 
-                        if not symbol or not side or not order_id:
-                            self._pnl_ledger["pending_orders"].pop(order_id, None)
-                            self._save_pnl_ledger()
-                            progressed = True
-                            continue
+            fees_usd = float(fee_total) if fee_total else 0.0
+        except Exception:
+            pass #print(traceback.format_exc())
+
+        return actual_qty, actual_price, fees_usd
+
+    def _track_order(self, order_id: str, info: dict) -> None:
+        """Add a just-placed order to the ledger's pending_orders (persisted so restarts can finish it)."""
+        pending = self._pnl_ledger.setdefault("pending_orders", {})
+        if pending:
+            # Orders in flight together see each other's buying power moves, so their
+            # before/after delta is not theirs alone (settled from the fill instead).
+            info["overlap"] = True
+            for other in pending.values():
+                if isinstance(other, dict):
+                    other["overlap"] = True
+        info.setdefault("created_ts", time.time())
+        info["next_poll_ts"] = 0.0
+        info["poll_delay"] = 0.0
+        pending[order_id] = info
+        self._save_pnl_ledger()
+
+    def _pending_bases(self) -> set:
+        """Coins with an order still working (no new trailing / DCA / entry decisions for them)."""
+        out = set()
+        try:
+            for info in (self._pnl_ledger.get("pending_orders", {}) or {}).values():
+                base = str(info.get("symbol", "")).upper().split("-")[0].strip()
+                if base:
+                    out.add(base)
+        except Exception:
+            pass
+        return out
 
-                        order = self._wait_for_order_terminal(symbol, order_id)
-                        if not order:
-                            continue
+    def _next_order_poll_in(self) -> Optional[float]:
+        """Seconds until the next pending order is due a poll (None when nothing is pending)."""
+        try:
+            pending = self._pnl_ledger.get("pending_orders", {}) or {}
+            if not pending:
+                return None
+            due = min(float(info.get("next_poll_ts", 0.0) or 0.0) for info in pending.values())
+            return max(0.0, due - time.time())
+        except Exception:
+            return None
 
-                        state = str(order.get("state", "")).lower().strip()
-                        if state != "filled":
-                            # Not filled -> no trade to record, clear pending.
-                            self._pnl_ledger["pending_orders"].pop(order_id, None)
-                            self._save_pnl_ledger()
-                            progressed = True
-                            continue
+    def _poll_pending_orders(self) -> bool:
+        """
+        One non-blocking pass over pending_orders: orders that are due get looked up (one
+        get_orders() per symbol); terminal ones are settled, the rest back off.
+        Returns True when at least one order filled (cost basis and DCA levels need a refresh).
+        """
+        pending = self._pnl_ledger.get("pending_orders", {})
+        if not isinstance(pending, dict) or not pending:
+            return False
 
-                        filled_qty, avg_price = self._extract_fill_from_order(order)
-                        bp_after = self._get_buying_power()
-                        bp_delta = float(bp_after) - float(bp_before)
-
-                        self._record_trade(
-                            side=side,
-                            symbol=symbol,
-                            qty=float(filled_qty),
-                            price=float(avg_price) if avg_price is not None else None,
-                            avg_cost_basis=info.get("avg_cost_basis", None),
-                            pnl_pct=info.get("pnl_pct", None),
-                            tag=info.get("tag", None),
-                            order_id=order_id,
-                            fees_usd=None,
-                            buying_power_before=bp_before,
-                            buying_power_after=bp_after,
-                            buying_power_delta=bp_delta,
-                        )
+        now = time.time()
+        by_symbol: Dict[str, list] = {}
+        for order_id, info in list(pending.items()):
+            try:
+                if float(info.get("next_poll_ts", 0.0) or 0.0) <= now:
+                    by_symbol.setdefault(str(info.get("symbol", "")).strip(), []).append(order_id)
+            except Exception:
+                continue
 
-                        # Clear pending now that we recorded it
-                        self._pnl_ledger["pending_orders"].pop(order_id, None)
-                        self._save_pnl_ledger()
-                        progressed = True
+        filled = False
+        for symbol, order_ids in by_symbol.items():
+            orders = {}
+            try:
+                resp = self.get_orders(symbol)
+                for o in (resp.get("results", []) if isinstance(resp, dict) else []):
+                    orders[o.get("id")] = o
+            except Exception:
+                pass
 
+            for order_id in order_ids:
+                info = pending.get(order_id)
+                if not isinstance(info, dict):
+                    continue
+                order = orders.get(order_id)
+                state = str(order.get("state", "")).lower().strip() if isinstance(order, dict) else ""
+                if state in ORDER_TERMINAL_STATES:
+                    try:
+                        pt_metrics.observe("order_round_trip", max(0.0, time.time() - float(info.get("created_ts", now) or now)))
                     except Exception:
-                        continue
+                        pass
+                    try:
+                        filled = self._settle_order(order_id, info, order) or filled
+                    except Exception:
+                        print(traceback.format_exc())
+                    continue
 
-                if not progressed:
-                    time.sleep(1)
+                # still working (or not listed yet): look again later, a bit less often each time
+                delay = float(info.get("poll_delay", 0.0) or 0.0) * ORDER_POLL_BACKOFF
+                delay = min(ORDER_POLL_MAX_SECONDS, max(ORDER_POLL_MIN_SECONDS, delay))
+                info["poll_delay"] = delay
+                info["next_poll_ts"] = now + delay
+                info["polls"] = int(info.get("polls", 0) or 0) + 1
+                pt_metrics.incr("order_polls")
+
+        return filled
+
+    def _settle_order(self, order_id: str, info: dict, order: dict) -> bool:
+        """Finish a terminal order: trade history, PnL ledger and the per-coin trade state. True if filled."""
+        symbol = str(info.get("symbol", "")).strip()
+        side = str(info.get("side", "")).strip().lower()
+        tag = info.get("tag", None)
+        base = symbol.upper().split("-")[0].strip()
+
+        if str(order.get("state", "")).lower().strip() != "filled":
+            # Not filled -> clear pending and do not record a trade
+            self._pnl_ledger.get("pending_orders", {}).pop(order_id, None)
+            self._save_pnl_ledger()
+            print(f"  {side.upper()} order for {symbol} ended {order.get('state')}; nothing recorded.")
+            return False
+
+        avg_cost_basis = info.get("avg_cost_basis", None)
+        pnl_pct = info.get("pnl_pct", None)
+        fees_usd = None
+        if side == "sell":
+            qty, price, fees_usd = self._sell_fill_from_order(order, info.get("expected_price", None), info.get("asset_quantity", 0.0))
+
+            # If we managed to get a better fill price, update the displayed PnL% too
+            if avg_cost_basis is not None and price is not None:
+                try:
+                    acb = float(avg_cost_basis)
+                    if acb > 0:
+                        pnl_pct = ((float(price) - acb) / acb) * 100.0
+                except Exception:
+                    pass
+        else:
+            qty, price = self._extract_fill_from_order(order)
+
+        # --- exact profit tracking snapshot (AFTER the order is complete) ---
+        buying_power_before = info.get("buying_power_before", None)
+        buying_power_after = self._get_buying_power()
+        if info.get("overlap") or (len(self._pnl_ledger.get("pending_orders", {}) or {}) > 1):
+            # another order moved buying power meanwhile: take this order's own cash flow from the fill
+            notional = float(qty or 0.0) * float(price or 0.0)
+            if side == "sell":
+                buying_power_delta = notional - float(fees_usd or 0.0)
+            else:
+                buying_power_delta = -notional
+            buying_power_before = None
+            buying_power_after = None
+        else:
+            buying_power_delta = float(buying_power_after) - float(buying_power_before or 0.0)
+
+        self._record_trade(
+            side=side,
+            symbol=symbol,
+            qty=float(qty),
+            price=float(price) if price is not None else None,
+            avg_cost_basis=float(avg_cost_basis) if avg_cost_basis is not None else None,
+            pnl_pct=float(pnl_pct) if pnl_pct is not None else None,
+            tag=tag,
+            order_id=order_id,
+            fees_usd=float(fees_usd) if fees_usd is not None else None,
+            buying_power_before=buying_power_before,
+            buying_power_after=buying_power_after,
+            buying_power_delta=buying_power_delta,
+        )
+
+        # Clear pending now that it is recorded
+        self._pnl_ledger.get("pending_orders", {}).pop(order_id, None)
+        self._save_pnl_ledger()
+
+        # Per-coin trade state moves on only once the fill is known
+        if info.get("restored"):
+            pass  # placed by an earlier run: _refresh_after_fills() takes its stages from the position index
+        elif side == "sell":
+            self.trailing_pm.pop(base, None)  # clear per-coin trailing state on exit
+            # Trade ended -> reset rolling 24h DCA window for this coin
+            self._reset_dca_window_for_trade(base, sold=True)
+            print(f"  Sold {qty} {base} ({tag or 'SELL'}).")
+        elif tag == "DCA":
+            # record that we completed THIS stage (no matter what triggered it)
+            self.dca_levels_triggered.setdefault(base, []).append(len(self.dca_levels_triggered.get(base, [])))
+            # Only record a DCA buy timestamp on a fill (so skips never advance anything)
+            self._note_dca_buy(base)
+            # DCA changes avg_cost_basis, so the PM line must be rebuilt from the new basis
+            # (this will re-init to 5% if DCA=0, or 2.5% if DCA>=1)
+            self.trailing_pm.pop(base, None)
+            print(f"  DCA buy for {base} filled.")
+        else:
+            # Do NOT pre-trigger any DCA levels. Hardcoded DCA will mark levels only when it hits your loss thresholds.
+            self.dca_levels_triggered[base] = []
+            # Fresh trade -> clear any rolling 24h DCA window for this coin
+            self._reset_dca_window_for_trade(base, sold=False)
+            # Reset trailing PM state for this coin (fresh trade, fresh trailing logic)
+            self.trailing_pm.pop(base, None)
+            print(f"  Entry buy for {base} filled.")
+        return True
+
+    def _reconcile_pending_orders(self) -> None:
+        """
+        If the hub/trader restarts mid-order, we keep the pre-order buying_power on disk and
+        finish the accounting once the order shows as terminal in Robinhood. Startup only drops
+        entries that are already recorded (or unusable); the rest are polled by manage_trades().
+        """
+        try:
+            pending = self._pnl_ledger.get("pending_orders", {})
+            if not isinstance(pending, dict) or not pending:
+                return
+
+            for order_id, info in list(pending.items()):
+                try:
+                    symbol = str(info.get("symbol", "")).strip() if isinstance(info, dict) else ""
+                    side = str(info.get("side", "")).strip().lower() if isinstance(info, dict) else ""
+                    if self._trade_history_has_order_id(order_id) or not symbol or not side or not order_id:
+                        # Already recorded (e.g., crash after writing history) or unusable -> just clear pending.
+                        pending.pop(order_id, None)
+                        continue
+                    info["restored"] = True
+                    info["next_poll_ts"] = 0.0
+                    info["poll_delay"] = 0.0
+                except Exception:
+                    continue
+            self._save_pnl_ledger()
 
         except Exception:
             pass
@@ -772,10 +1099,14 @@ class CryptoAPITrading:
             "position_cost_after_usd": float(position_cost_after) if position_cost_after is not None else None,
         }
         self._append_jsonl(TRADE_HISTORY_PATH, entry)
+        self.positions.sync()
 
 
 
 
+    def _clear_screen(self) -> None:
+        os.system('cls' if os.name == 'nt' else 'clear')
+
     def _write_trader_status(self, status: dict) -> None:
         self._atomic_write_json(TRADER_STATUS_PATH, status)
 
@@ -824,13 +1155,20 @@ class CryptoAPITrading:
     @staticmethod
     def _read_long_dca_signal(symbol: str) -> int:
         """
-        Reads long_dca_signal.txt from the per-coin folder (same folder rules as trader.py).
+        Long signal from the thinker's latest snapshot, else long_dca_signal.txt from the
+        per-coin folder (same folder rules as trader.py).
 
         Used for:
         - Start gate: start trades at level 3+
         - DCA assist: levels 4-7 map to trader DCA stages 0-3 (trade starts at level 3 => stage 0)
         """
         sym = str(symbol).upper().strip()
+        snap = _signal_snapshot(sym)
+        if snap is not None and "long" in snap:
+            try:
+                return int(float(snap["long"]))
+            except Exception:
+                pass
         folder = base_paths.get(sym, main_dir if sym == "BTC" else os.path.join(main_dir, sym))
         path = os.path.join(folder, "long_dca_signal.txt")
         try:
@@ -845,13 +1183,20 @@ class CryptoAPITrading:
     @staticmethod
     def _read_short_dca_signal(symbol: str) -> int:
         """
-        Reads short_dca_signal.txt from the per-coin folder (same folder rules as trader.py).
+        Short signal from the thinker's latest snapshot, else short_dca_signal.txt from the
+        per-coin folder (same folder rules as trader.py).
 
         Used for:
         - Start gate: start trades at level 3+
         - DCA assist: levels 4-7 map to trader DCA stages 0-3 (trade starts at level 3 => stage 0)
         """
         sym = str(symbol).upper().strip()
+        snap = _signal_snapshot(sym)
+        if snap is not None and "short" in snap:
+            try:
+                return int(float(snap["short"]))
+            except Exception:
+                pass
         folder = base_paths.get(sym, main_dir if sym == "BTC" else os.path.join(main_dir, sym))
         path = os.path.join(folder, "short_dca_signal.txt")
         try:
@@ -865,7 +1210,8 @@ class CryptoAPITrading:
     @staticmethod
     def _read_long_price_levels(symbol: str) -> list:
         """
-        Reads low_bound_prices.html from the per-coin folder and returns a list of LONG (blue) price levels.
+        Returns the LONG (blue) price levels from the thinker's latest snapshot, else from
+        low_bound_prices.html in the per-coin folder.
 
         Returned ordering is highest->lowest so:
           N1 = 1st blue line (top)
@@ -873,6 +1219,16 @@ class CryptoAPITrading:
           N7 = 7th blue line (bottom)
         """
         sym = str(symbol).upper().strip()
+        snap = _signal_snapshot(sym)
+        if snap is not None and isinstance(snap.get("low_bounds"), list):
+            vals = []
+            for v in snap["low_bounds"]:
+                try:
+                    vals.append(float(v))
+                except Exception:
+                    continue
+            return CryptoAPITrading._levels_high_to_low(vals)
+
         folder = base_paths.get(sym, main_dir if sym == "BTC" else os.path.join(main_dir, sym))
         path = os.path.join(folder, "low_bound_prices.html")
         try:
@@ -894,115 +1250,216 @@ class CryptoAPITrading:
                 except Exception:
                     continue
 
-            # De-dupe, then sort high->low for stable N1..N7 mapping
-            out = []
-            seen = set()
-            for v in vals:
-                k = round(float(v), 12)
-                if k in seen:
-                    continue
-                seen.add(k)
-                out.append(float(v))
-            out.sort(reverse=True)
-            return out
+            return CryptoAPITrading._levels_high_to_low(vals)
         except Exception:
             return []
 
+    @staticmethod
+    def _levels_high_to_low(vals: list) -> list:
+        # De-dupe, then sort high->low for stable N1..N7 mapping
+        out = []
+        seen = set()
+        for v in vals:
+            k = round(float(v), 12)
+            if k in seen:
+                continue
+            seen.add(k)
+            out.append(float(v))
+        out.sort(reverse=True)
+        return out
 
 
-    def initialize_dca_levels(self):
 
+    def _dca_stages_from_orders(self, orders: list) -> int:
         """
-        Initializes the DCA levels_triggered dictionary based on the number of buy orders
-        that have occurred after the first buy order following the most recent sell order
-        for each cryptocurrency.
+        DCA stages of the current trade from one coin's Robinhood orders: the filled buys after
+        the first buy that followed the most recent sell.
         """
-        holdings = self.get_holdings()
-        if not holdings or "results" not in holdings:
-            print("No holdings found. Skipping DCA levels initialization.")
-            return
+        filled_orders = [
+            order for order in orders
+            if order.get("state") == "filled" and order.get("side") in ["buy", "sell"]
+        ]
+        # Sort orders by creation time in ascending order (oldest first)
+        filled_orders.sort(key=lambda x: x["created_at"])
+
+        # Find the timestamp of the most recent sell order
+        most_recent_sell_time = None
+        for order in reversed(filled_orders):
+            if order["side"] == "sell":
+                most_recent_sell_time = order["created_at"]
+                break
+
+        relevant_buy_orders = [
+            order for order in filled_orders
+            if order["side"] == "buy" and (most_recent_sell_time is None or order["created_at"] > most_recent_sell_time)
+        ]
+        if not relevant_buy_orders:
+            return 0
 
-        for holding in holdings.get("results", []):
-            symbol = holding["asset_code"]
+        # Count the number of buy orders after the first buy
+        first_buy_time = relevant_buy_orders[0]["created_at"]
+        return len([order for order in relevant_buy_orders if order["created_at"] > first_buy_time])
 
-            full_symbol = f"{symbol}-USD"
-            orders = self.get_orders(full_symbol)
-            
-            if not orders or "results" not in orders:
-                print(f"No orders found for {full_symbol}. Skipping.")
-                continue
+    def _cost_basis_from_orders(self, orders: list, quantity: float) -> float:
+        """Average price of the newest filled buys that add up to the held `quantity`."""
+        # Get all filled buy orders, sorted from most recent to oldest
+        buy_orders = [
+            order for order in orders
+            if order.get("side") == "buy" and order.get("state") == "filled"
+        ]
+        buy_orders.sort(key=lambda x: x["created_at"], reverse=True)
 
-            # Filter for filled buy and sell orders
-            filled_orders = [
-                order for order in orders["results"]
-                if order["state"] == "filled" and order["side"] in ["buy", "sell"]
-            ]
-            
-            if not filled_orders:
-                print(f"No filled buy or sell orders for {full_symbol}. Skipping.")
-                continue
+        remaining_quantity = quantity
+        total_cost = 0.0
 
-            # Sort orders by creation time in ascending order (oldest first)
-            filled_orders.sort(key=lambda x: x["created_at"])
+        for order in buy_orders:
+            for execution in order.get("executions", []):
+                qty = float(execution["quantity"])
+                price = float(execution["effective_price"])
 
-            # Find the timestamp of the most recent sell order
-            most_recent_sell_time = None
-            for order in reversed(filled_orders):
-                if order["side"] == "sell":
-                    most_recent_sell_time = order["created_at"]
+                if remaining_quantity <= 0:
                     break
 
-            # Determine the cutoff time for buy orders
-            if most_recent_sell_time:
-                # Find all buy orders after the most recent sell
-                relevant_buy_orders = [
-                    order for order in filled_orders
-                    if order["side"] == "buy" and order["created_at"] > most_recent_sell_time
-                ]
-                if not relevant_buy_orders:
-                    print(f"No buy orders after the most recent sell for {full_symbol}.")
-                    self.dca_levels_triggered[symbol] = []
+                # Use only the portion of the quantity needed to match the current holdings
+                if qty > remaining_quantity:
+                    total_cost += remaining_quantity * price
+                    remaining_quantity = 0
+                else:
+                    total_cost += qty * price
+                    remaining_quantity -= qty
+
+            if remaining_quantity <= 0:
+                break
+
+        return total_cost / quantity if quantity > 0 else 0.0
+
+    def _positions_from_robinhood(self, holdings: Any, bases: Optional[set] = None) -> Dict[str, tuple]:
+        """
+        {coin: (quantity, avg cost, DCA stages)} replayed from Robinhood's order history; one
+        get_orders() per held coin (or per coin in `bases`). Coins whose orders can't be fetched
+        are left out.
+        """
+        out = {}
+        for holding in (holdings or {}).get("results", []) or []:
+            try:
+                code = str(holding["asset_code"]).upper()
+                qty = float(holding["total_quantity"])
+                if bases is not None and code not in bases:
                     continue
-                print(f"Most recent sell for {full_symbol} at {most_recent_sell_time}.")
-            else:
-                # If no sell orders, consider all buy orders
-                relevant_buy_orders = [
-                    order for order in filled_orders
-                    if order["side"] == "buy"
-                ]
-                if not relevant_buy_orders:
-                    print(f"No buy orders for {full_symbol}. Skipping.")
-                    self.dca_levels_triggered[symbol] = []
+                orders = self.get_orders(f"{code}-USD")
+                if not orders or "results" not in orders:
+                    print(f"No orders found for {code}-USD. Skipping.")
                     continue
-                print(f"No sell orders found for {full_symbol}. Considering all buy orders.")
-
-            # Ensure buy orders are sorted by creation time ascending
-            relevant_buy_orders.sort(key=lambda x: x["created_at"])
+                results = orders["results"]
+                out[code] = (qty, self._cost_basis_from_orders(results, qty), self._dca_stages_from_orders(results))
+            except Exception:
+                continue
+        return out
 
-            # Identify the first buy order in the relevant list
-            first_buy_order = relevant_buy_orders[0]
-            first_buy_time = first_buy_order["created_at"]
+    def _init_positions(self) -> None:
+        """
+        Startup: cost basis and DCA stages come from the position index. Only coins whose held
+        quantity disagrees with it (first run, trades made outside the trader) are replayed
+        from Robinhood here; everything else is re-checked by the background verify.
+        """
+        holdings = self.get_holdings()
+        if holdings and "results" in holdings:
+            held = {}
+            for holding in holdings.get("results", []):
+                try:
+                    held[str(holding["asset_code"]).upper()] = float(holding["total_quantity"])
+                except Exception:
+                    continue
+            for base in self.positions.open_bases():
+                if base not in held:
+                    self.positions.close(base)
+            stale = set()
+            for code, qty in held.items():
+                pos = self.positions.position(code)
+                if pos is None or pos.get("unpriced") or not pt_positions.qty_matches(pos.get("qty", 0.0), qty):
+                    stale.add(code)
+            if stale:
+                print(f"Position index is missing {', '.join(sorted(stale))}; replaying their Robinhood orders...")
+                for code, (qty, avg_cost, stages) in self._positions_from_robinhood(holdings, stale).items():
+                    self.positions.correct(code, qty, avg_cost, stages)
+            self.positions.save()
+        else:
+            print("No holdings found. Using the position index as-is.")
+
+        self._positions_to_state()
+
+    def _positions_to_state(self, bases: Optional[set] = None) -> None:
+        """cost_basis / dca_levels_triggered from the index (all open coins, or just `bases`)."""
+        open_bases = set(self.positions.open_bases())
+        if bases is None:
+            self.cost_basis = self.positions.cost_basis()
+            bases = open_bases
+        for base in bases:
+            if base in open_bases:
+                self.cost_basis[base] = self.positions.avg_cost(base)
+                # Track DCA by stage index (0, 1, 2, ...) rather than % values.
+                # This makes neural-vs-hardcoded clean, and allows repeating the -50% stage indefinitely.
+                self.dca_levels_triggered[base] = list(range(self.positions.dca_stages(base)))
+            else:
+                self.cost_basis.pop(base, None)
 
-            # Count the number of buy orders after the first buy
-            buy_orders_after_first = [
-                order for order in relevant_buy_orders
-                if order["created_at"] > first_buy_time
-            ]
+    def _start_position_verify(self) -> None:
+        """Re-check every held coin against Robinhood on a daemon thread (results applied by manage_trades())."""
+        if self._position_verify_thread is not None and self._position_verify_thread.is_alive():
+            return
+        self._position_verify_due = time.time() + POSITION_VERIFY_SECONDS
+        revs = {base: self.positions.rev(base) for base in self.positions.positions}
+        thread = threading.Thread(target=self._verify_positions, args=(revs,), name="position-verify", daemon=True)
+        self._position_verify_thread = thread
+        thread.start()
 
-            triggered_levels_count = len(buy_orders_after_first)
+    def _verify_positions(self, revs: dict) -> None:
+        try:
+            holdings = self.get_holdings()
+            if not holdings or "results" not in holdings:
+                return
+            result = self._positions_from_robinhood(holdings)
+            held = {str(h.get("asset_code", "")).upper() for h in holdings.get("results", [])}
+            self._position_verify_result = (revs, held, result)
+        except Exception:
+            pass
 
-            # Track DCA by stage index (0, 1, 2, ...) rather than % values.
-            # This makes neural-vs-hardcoded clean, and allows repeating the -50% stage indefinitely.
-            self.dca_levels_triggered[symbol] = list(range(triggered_levels_count))
-            print(f"Initialized DCA stages for {symbol}: {triggered_levels_count}")
+    def _apply_position_verify(self, pending_bases: set) -> None:
+        """
+        Adopts a finished background verify. Coins with an order in flight, or that the index
+        moved on since the check started, keep the index's value (the next verify sees them).
+        """
+        done = self._position_verify_result
+        if done is None:
+            return
+        self._position_verify_result = None
+        revs, held, result = done
+        fixed = set()
+        for base in set(self.positions.open_bases()) | set(result):
+            if base in pending_bases or self.positions.rev(base) != revs.get(base, 0):
+                continue
+            if base in result:
+                qty, avg_cost, stages = result[base]
+                changed = self.positions.correct(base, qty, avg_cost, stages)
+            elif base not in held:
+                changed = self.positions.close(base)
+            else:
+                continue  # held, but its orders couldn't be fetched this time
+            if changed:
+                fixed.add(base)
+        self.positions.save()
+        if fixed:
+            print(f"Position index corrected from Robinhood: {', '.join(sorted(fixed))}")
+            pt_metrics.incr("position_index_corrections", len(fixed))
+            self._positions_to_state(fixed)
 
 
     def _seed_dca_window_from_history(self) -> None:
         """
-        Seeds in-memory DCA buy timestamps from TRADE_HISTORY_PATH so the 24h limit
-        works across restarts.
+        Seeds in-memory DCA buy timestamps from the position index so the 24h limit works
+        across restarts.
 
-        Uses the local GUI trade history (tag == "DCA") and resets per trade at the most recent sell.
+        The index keeps each coin's tag == "DCA" buys since its most recent sell (see pt_positions.py).
         """
         now_ts = time.time()
         cutoff = now_ts - float(getattr(self, "dca_window_seconds", 86400))
@@ -1010,51 +1467,17 @@ class CryptoAPITrading:
         self._dca_buy_ts = {}
         self._dca_last_sell_ts = {}
 
-        if not os.path.isfile(TRADE_HISTORY_PATH):
-            return
-
-        try:
-            with open(TRADE_HISTORY_PATH, "r", encoding="utf-8") as f:
-                for line in f:
-                    line = (line or "").strip()
-                    if not line:
-                        continue
-
-                    try:
-                        obj = json.loads(line)
-                    except Exception:
-                        continue
-
-                    ts = obj.get("ts", None)
-                    side = str(obj.get("side", "")).lower()
-                    tag = obj.get("tag", None)
-                    sym_full = str(obj.get("symbol", "")).upper().strip()
-                    base = sym_full.split("-")[0].strip() if sym_full else ""
-                    if not base:
-                        continue
-
-                    try:
-                        ts_f = float(ts)
-                    except Exception:
-                        continue
-
-                    if side == "sell":
-                        prev = float(self._dca_last_sell_ts.get(base, 0.0) or 0.0)
-                        if ts_f > prev:
-                            self._dca_last_sell_ts[base] = ts_f
-
-                    elif side == "buy" and tag == "DCA":
-                        self._dca_buy_ts.setdefault(base, []).append(ts_f)
-
-        except Exception:
-            return
-
-        # Keep only DCA buys after the last sell (current trade) and within rolling 24h
-        for base, ts_list in list(self._dca_buy_ts.items()):
-            last_sell = float(self._dca_last_sell_ts.get(base, 0.0) or 0.0)
-            kept = [t for t in ts_list if (t > last_sell) and (t >= cutoff)]
-            kept.sort()
-            self._dca_buy_ts[base] = kept
+        for base, pos in self.positions.positions.items():
+            try:
+                if pos.get("last_sell_ts") is not None:
+                    self._dca_last_sell_ts[base] = float(pos["last_sell_ts"])
+                last_sell = float(self._dca_last_sell_ts.get(base, 0.0) or 0.0)
+                # Keep only DCA buys after the last sell (current trade) and within rolling 24h
+                kept = [float(t) for t in (pos.get("dca_ts", []) or []) if (float(t) > last_sell) and (float(t) >= cutoff)]
+                kept.sort()
+                self._dca_buy_ts[base] = kept
+            except Exception:
+                continue
 
 
     def _dca_window_count(self, base_symbol: str, now_ts: Optional[float] = None) -> int:
@@ -1100,12 +1523,16 @@ class CryptoAPITrading:
         headers = self.get_authorization_header(method, path, body, timestamp)
         url = self.base_url + path
 
+        ok = False
+        response = None
+        t0 = time.perf_counter()
         try:
             if method == "GET":
-                response = requests.get(url, headers=headers, timeout=10)
+                response = self.session.get(url, headers=headers, timeout=10)
             elif method == "POST":
-                response = requests.post(url, headers=headers, json=json.loads(body), timeout=10)
+                response = self.session.post(url, headers=headers, json=json.loads(body), timeout=10)
 
+            ok = response.ok
             response.raise_for_status()
             return response.json()
         except requests.HTTPError as http_err:
@@ -1117,6 +1544,9 @@ class CryptoAPITrading:
                 return None
         except Exception:
             return None
+        finally:
+            elapsed = time.perf_counter() - t0
+            self.api_latency.observe(method, path, elapsed, ok, response)
 
     def get_authorization_header(
             self, method: str, path: str, body: str, timestamp: int
@@ -1155,77 +1585,84 @@ class CryptoAPITrading:
         path = f"/api/v1/crypto/trading/orders/?symbol={symbol}"
         return self.make_api_request("GET", path)
 
-    def calculate_cost_basis(self):
-        holdings = self.get_holdings()
-        if not holdings or "results" not in holdings:
-            return {}
-
-        active_assets = {holding["asset_code"] for holding in holdings.get("results", [])}
-        current_quantities = {
-            holding["asset_code"]: float(holding["total_quantity"])
-            for holding in holdings.get("results", [])
-        }
-
-        cost_basis = {}
-
-        for asset_code in active_assets:
-            orders = self.get_orders(f"{asset_code}-USD")
-            if not orders or "results" not in orders:
-                continue
-
-            # Get all filled buy orders, sorted from most recent to oldest
-            buy_orders = [
-                order for order in orders["results"]
-                if order["side"] == "buy" and order["state"] == "filled"
-            ]
-            buy_orders.sort(key=lambda x: x["created_at"], reverse=True)
-
-            remaining_quantity = current_quantities[asset_code]
-            total_cost = 0.0
-
-            for order in buy_orders:
-                for execution in order.get("executions", []):
-                    quantity = float(execution["quantity"])
-                    price = float(execution["effective_price"])
-
-                    if remaining_quantity <= 0:
-                        break
-
-                    # Use only the portion of the quantity needed to match the current holdings
-                    if quantity > remaining_quantity:
-                        total_cost += remaining_quantity * price
-                        remaining_quantity = 0
-                    else:
-                        total_cost += quantity * price
-                        remaining_quantity -= quantity
-
-                if remaining_quantity <= 0:
-                    break
-
-            if current_quantities[asset_code] > 0:
-                cost_basis[asset_code] = total_cost / current_quantities[asset_code]
-            else:
-                cost_basis[asset_code] = 0.0
+    def _market_data_get(self, path: str) -> Any:
+        """Signed GET over the shared session (None on any failure, HTTP errors included)."""
+        ok = False
+        response = None
+        t0 = time.perf_counter()
+        try:
+            headers = self.get_authorization_header("GET", path, "", self._get_current_timestamp())
+            response = self.session.get(self.base_url + path, headers=headers, timeout=10)
+            ok = response.ok
+            response.raise_for_status()
+            return response.json()
+        except Exception:
+            return None
+        finally:
+            elapsed = time.perf_counter() - t0
+            self.api_latency.observe("GET", path, elapsed, ok, response)
 
-        return cost_basis
+    def _fetch_best_bid_ask(self, symbols: list) -> Dict[str, dict]:
+        """
+        {symbol: best_bid_ask result}. One request per PRICE_BATCH_SIZE symbols (the endpoint
+        takes repeated symbol= params); whatever a batch didn't return is retried one symbol
+        per request, concurrently.
+        """
+        quotes = {}
+        for i in range(0, len(symbols), PRICE_BATCH_SIZE):
+            chunk = symbols[i:i + PRICE_BATCH_SIZE]
+            query = "&".join(f"symbol={sym}" for sym in chunk)
+            response = self._market_data_get(f"/api/v1/crypto/marketdata/best_bid_ask/?{query}")
+            for result in ((response or {}).get("results") or []):
+                sym = str(result.get("symbol", "") or "").upper()
+                if not sym and len(chunk) == 1:
+                    sym = chunk[0]
+                if sym in chunk:
+                    quotes[sym] = result
+
+        missing = [sym for sym in symbols if sym not in quotes]
+        if missing:
+            def _single(sym):
+                response = self._market_data_get(f"/api/v1/crypto/marketdata/best_bid_ask/?symbol={sym}")
+                if response and response.get("results"):
+                    return sym, response["results"][0]
+                return sym, None
+
+            with ThreadPoolExecutor(max_workers=min(PRICE_FETCH_WORKERS, len(missing))) as pool:
+                for sym, result in pool.map(_single, missing):
+                    if result is not None:
+                        quotes[sym] = result
+        return quotes
+
+    def price_staleness(self, symbol: str) -> Optional[float]:
+        """Seconds since `symbol` last got a fresh quote (None if it never did)."""
+        cached = self._last_good_bid_ask.get(symbol)
+        if not cached:
+            return None
+        return max(0.0, time.time() - float(cached.get("ts", 0.0) or 0.0))
 
+    @pt_metrics.timed("price_fetch")
     def get_price(self, symbols: list) -> Dict[str, float]:
         buy_prices = {}
         sell_prices = {}
         valid_symbols = []
 
+        wanted = []
         for symbol in symbols:
-            if symbol == "USDC-USD":
-                continue
+            if symbol != "USDC-USD" and symbol not in wanted:
+                wanted.append(symbol)
 
-            path = f"/api/v1/crypto/marketdata/best_bid_ask/?symbol={symbol}"
-            response = self.make_api_request("GET", path)
+        quotes = self._fetch_best_bid_ask(wanted) if wanted else {}
 
-            if response and "results" in response:
-                result = response["results"][0]
+        for symbol in wanted:
+            result = quotes.get(symbol)
+            try:
                 ask = float(result["ask_inclusive_of_buy_spread"])
                 bid = float(result["bid_inclusive_of_sell_spread"])
+            except Exception:
+                result = None
 
+            if result is not None:
                 buy_prices[symbol] = ask
                 sell_prices[symbol] = bid
                 valid_symbols.append(symbol)
@@ -1233,6 +1670,7 @@ class CryptoAPITrading:
                 # Update cache for transient failures later
                 try:
                     self._last_good_bid_ask[symbol] = {"ask": ask, "bid": bid, "ts": time.time()}
+                    self.price_age[symbol] = 0.0
                 except Exception:
                     pass
             else:
@@ -1247,9 +1685,11 @@ class CryptoAPITrading:
                     ask = float(cached.get("ask", 0.0) or 0.0)
                     bid = float(cached.get("bid", 0.0) or 0.0)
                     if ask > 0.0 and bid > 0.0:
+                        pt_metrics.incr("price_cache_fallbacks")
                         buy_prices[symbol] = ask
                         sell_prices[symbol] = bid
                         valid_symbols.append(symbol)
+                self.price_age[symbol] = self.price_staleness(symbol)
 
         return buy_prices, sell_prices, valid_symbols
 
@@ -1275,6 +1715,8 @@ class CryptoAPITrading:
 
         while retries < max_retries:
             retries += 1
+            if retries > 1:
+                pt_metrics.incr("order_retries")
             response = None
             try:
                 # Default precision to 8 decimals initially
@@ -1299,11 +1741,12 @@ class CryptoAPITrading:
                 if response and "errors" not in response:
                     order_id = response.get("id", None)
 
-                    # Persist the pre-order buying power so restarts can reconcile precisely
+                    # Track it in pending_orders (with the pre-order buying power, so restarts can
+                    # reconcile precisely). _poll_pending_orders() records the ACTUAL fill from order
+                    # history once it is terminal; nothing here waits for it.
                     try:
                         if order_id:
-                            self._pnl_ledger.setdefault("pending_orders", {})
-                            self._pnl_ledger["pending_orders"][order_id] = {
+                            self._track_order(order_id, {
                                 "symbol": symbol,
                                 "side": "buy",
                                 "buying_power_before": float(buying_power_before),
@@ -1311,52 +1754,11 @@ class CryptoAPITrading:
                                 "pnl_pct": float(pnl_pct) if pnl_pct is not None else None,
                                 "tag": tag,
                                 "created_ts": time.time(),
-                            }
-                            self._save_pnl_ledger()
+                            })
                     except Exception:
                         pass
 
-                    # Wait until the order is actually complete in the system, then use order history executions
-                    if order_id:
-                        order = self._wait_for_order_terminal(symbol, order_id)
-                        state = str(order.get("state", "")).lower().strip() if isinstance(order, dict) else ""
-                        if state != "filled":
-                            # Not filled -> clear pending and do not record a trade
-                            try:
-                                self._pnl_ledger.get("pending_orders", {}).pop(order_id, None)
-                                self._save_pnl_ledger()
-                            except Exception:
-                                pass
-                            return None
-
-                        filled_qty, avg_fill_price = self._extract_fill_from_order(order)
-
-                        buying_power_after = self._get_buying_power()
-                        buying_power_delta = float(buying_power_after) - float(buying_power_before)
-
-                        # Record for GUI history (ACTUAL fill from order history)
-                        self._record_trade(
-                            side="buy",
-                            symbol=symbol,
-                            qty=float(filled_qty),
-                            price=float(avg_fill_price) if avg_fill_price is not None else None,
-                            avg_cost_basis=float(avg_cost_basis) if avg_cost_basis is not None else None,
-                            pnl_pct=float(pnl_pct) if pnl_pct is not None else None,
-                            tag=tag,
-                            order_id=order_id,
-                            buying_power_before=buying_power_before,
-                            buying_power_after=buying_power_after,
-                            buying_power_delta=buying_power_delta,
-                        )
-
-                        # Clear pending now that it is recorded
-                        try:
-                            self._pnl_ledger.get("pending_orders", {}).pop(order_id, None)
-                            self._save_pnl_ledger()
-                        except Exception:
-                            pass
-
-                    return response  # Successfully placed (and fully filled) order
+                    return response  # Successfully placed (fill is tracked in pending_orders)
 
             except Exception:
                 pass #print(traceback.format_exc())
@@ -1411,129 +1813,21 @@ class CryptoAPITrading:
         if response and isinstance(response, dict) and "errors" not in response:
             order_id = response.get("id", None)
 
-            # Persist the pre-order buying power so restarts can reconcile precisely
+            # Track it in pending_orders (pre-order buying power + what was sent, so restarts can
+            # reconcile precisely); _poll_pending_orders() settles it from the order's executions.
             try:
                 if order_id:
-                    self._pnl_ledger.setdefault("pending_orders", {})
-                    self._pnl_ledger["pending_orders"][order_id] = {
+                    self._track_order(order_id, {
                         "symbol": symbol,
                         "side": "sell",
                         "buying_power_before": float(buying_power_before),
                         "avg_cost_basis": float(avg_cost_basis) if avg_cost_basis is not None else None,
                         "pnl_pct": float(pnl_pct) if pnl_pct is not None else None,
                         "tag": tag,
+                        "expected_price": float(expected_price) if expected_price is not None else None,
+                        "asset_quantity": float(asset_quantity),
                         "created_ts": time.time(),
-                    }
-                    self._save_pnl_ledger()
-            except Exception:
-                pass
-
-            # Best-effort: pull actual avg fill price + fees from order executions
-            actual_price = float(expected_price) if expected_price is not None else None
-            actual_qty = float(asset_quantity)
-            fees_usd = None
-
-            def _fee_to_float(v: Any) -> float:
-                try:
-                    if v is None:
-                        return 0.0
-                    if isinstance(v, (int, float)):
-                        return float(v)
-                    if isinstance(v, str):
-                        return float(v)
-                    if isinstance(v, dict):
-                        # common shapes: {"amount": "0.12"}, {"value": 0.12}, etc.
-                        for k in ("amount", "value", "usd_amount", "fee", "quantity"):
-                            if k in v:
-                                try:
-                                    return float(v[k])
-                                except Exception:
-                                    continue
-                    return 0.0
-                except Exception:
-                    return 0.0
-
-            try:
-                if order_id:
-                    match = self._wait_for_order_terminal(symbol, order_id)
-                    if not match:
-                        return response
-
-                    if str(match.get("state", "")).lower() != "filled":
-                        # Not filled -> clear pending and do not record a trade
-                        try:
-                            self._pnl_ledger.get("pending_orders", {}).pop(order_id, None)
-                            self._save_pnl_ledger()
-                        except Exception:
-                            pass
-                        return response
-
-                    execs = match.get("executions", []) or []
-                    total_qty = 0.0
-                    total_notional = 0.0
-                    fee_total = 0.0
-
-                    for ex in execs:
-                        try:
-                            q = float(ex.get("quantity", 0.0) or 0.0)
-                            p = float(ex.get("effective_price", 0.0) or 0.0)
-                            total_qty += q
-                            total_notional += (q * p)
-
-                            # Fees can show up under different keys; handle the common ones.
-                            for fk in ("fee", "fees", "fee_amount", "fee_usd", "fee_in_usd"):
-                                if fk in ex:
-                                    fee_total += _fee_to_float(ex.get(fk))
-                        except Exception:
-                            continue
-
-                    # Some payloads include order-level fee fields too
-                    for fk in ("fee", "fees", "fee_amount", "fee_usd", "fee_in_usd"):
-                        if fk in match:
-                            fee_total += _fee_to_float(match.get(fk))
-
-                    if total_qty > 0.0 and total_notional > 0.0:
-                        actual_qty = total_qty
-                        actual_price = total_notional / total_qty
-
-                    fees_usd = float(fee_total) if fee_total else 0.0
-
-            except Exception:
-                pass #print(traceback.format_exc())
-
-            # If we managed to get a better fill price, update the displayed PnL% too
-            if avg_cost_basis is not None and actual_price is not None:
-                try:
-                    acb = float(avg_cost_basis)
-                    if acb > 0:
-                        pnl_pct = ((float(actual_price) - acb) / acb) * 100.0
-                except Exception:
-                    pass
-
-            # --- exact profit tracking snapshot (AFTER the order is complete) ---
-            buying_power_after = self._get_buying_power()
-            buying_power_delta = float(buying_power_after) - float(buying_power_before)
-
-            self._record_trade(
-                side="sell",
-                symbol=symbol,
-                qty=float(actual_qty),
-                price=float(actual_price) if actual_price is not None else None,
-                avg_cost_basis=float(avg_cost_basis) if avg_cost_basis is not None else None,
-                pnl_pct=float(pnl_pct) if pnl_pct is not None else None,
-                tag=tag,
-                order_id=order_id,
-                fees_usd=float(fees_usd) if fees_usd is not None else None,
-                buying_power_before=buying_power_before,
-                buying_power_after=buying_power_after,
-                buying_power_delta=buying_power_delta,
-            )
-
-            # Clear pending now that it is recorded
-            try:
-                if order_id:
-                    self._pnl_ledger.get("pending_orders", {}).pop(order_id, None)
-                    self._save_pnl_ledger()
+                    })
             except Exception:
                 pass
 
@@ -1544,9 +1838,8 @@ class CryptoAPITrading:
 
 
 
+    @pt_metrics.timed("trade_pass")
     def manage_trades(self):
-        trades_made = False  # Flag to track if any trade was made in this iteration
-
         # Hot-reload coins list + paths + trade params from GUI settings while running
         try:
             _refresh_paths_and_symbols()
@@ -1577,7 +1870,13 @@ class CryptoAPITrading:
         except Exception:
             pass
 
-
+        # Settle orders placed on earlier passes (only the ones due a poll; never waits).
+        if self._poll_pending_orders():
+            self._refresh_after_fills()
+        pending_bases = self._pending_bases()
+        self._apply_position_verify(pending_bases)
+        if time.time() >= self._position_verify_due:
+            self._start_position_verify()
 
 
         # Fetch account details
@@ -1670,7 +1969,7 @@ class CryptoAPITrading:
                 "percent_in_trade": float(in_use),
             }
 
-        os.system('cls' if os.name == 'nt' else 'clear')
+        self._clear_screen()
         print("\n--- Account Summary ---")
         print(f"Total Account Value: ${total_account_value:.2f}")
         print(f"Holdings Value: ${holdings_sell_value:.2f}")
@@ -1823,6 +2122,7 @@ class CryptoAPITrading:
                 "trail_line": float(trail_line_disp) if trail_line_disp else 0.0,
                 "trail_peak": float(trail_peak_disp) if trail_peak_disp else 0.0,
                 "dist_to_trail_pct": float(dist_to_trail_pct) if dist_to_trail_pct else 0.0,
+                "price_age_s": self.price_age.get(full_symbol),
             }
 
 
@@ -1846,6 +2146,10 @@ class CryptoAPITrading:
             else:
                 print("  PM/Trail: N/A (avg_cost_basis is 0)")
 
+            # An order for this coin is still working: no new sell / DCA decision until it settles
+            if symbol in pending_bases:
+                print(f"  Order pending for {symbol}; waiting for it to settle.")
+                continue
 
 
             # --- Trailing profit margin (0.5% trail gap) ---
@@ -1926,15 +2230,9 @@ class CryptoAPITrading:
                         )
 
                         if response and isinstance(response, dict) and "errors" not in response:
-                            trades_made = True
-                            self.trailing_pm.pop(symbol, None)  # clear per-coin trailing state on exit
-
-                            # Trade ended -> reset rolling 24h DCA window for this coin
-                            self._reset_dca_window_for_trade(symbol, sold=True)
-
-                            print(f"  Successfully sold {quantity} {symbol}.")
-                            time.sleep(5)
-                            holdings = self.get_holdings()
+                            # trailing state / DCA window reset once the fill settles (_settle_order)
+                            pending_bases.add(symbol)
+                            print(f"  Sell order placed for {quantity} {symbol}.")
                             continue
 
 
@@ -2005,17 +2303,8 @@ class CryptoAPITrading:
 
                     print(f"  Buy Response: {response}")
                     if response and "errors" not in response:
-                        # record that we completed THIS stage (no matter what triggered it)
-                        self.dca_levels_triggered.setdefault(symbol, []).append(current_stage)
-
-                        # Only record a DCA buy timestamp on success (so skips never advance anything)
-                        self._note_dca_buy(symbol)
-
-                        # DCA changes avg_cost_basis, so the PM line must be rebuilt from the new basis
-                        # (this will re-init to 5% if DCA=0, or 2.5% if DCA>=1)
-                        self.trailing_pm.pop(symbol, None)
-
-                        trades_made = True
+                        # the stage, DCA timestamp and PM line reset are recorded once it fills (_settle_order)
+                        pending_bases.add(symbol)
                         print(f"  Successfully placed DCA buy order for {symbol}.")
                     else:
                         print(f"  Failed to place DCA buy order for {symbol}.")
@@ -2065,6 +2354,7 @@ class CryptoAPITrading:
                     "trail_line": 0.0,
                     "trail_peak": 0.0,
                     "dist_to_trail_pct": 0.0,
+                    "price_age_s": self.price_age.get(full_symbol),
                 }
         except Exception:
             pass
@@ -2087,8 +2377,8 @@ class CryptoAPITrading:
             base_symbol = crypto_symbols[start_index].upper().strip()
             full_symbol = f"{base_symbol}-USD"
 
-            # Skip if already held
-            if full_symbol in holding_full_symbols:
+            # Skip if already held (or an order for it is still working)
+            if full_symbol in holding_full_symbols or base_symbol in pending_bases:
                 start_index += 1
                 continue
 
@@ -2116,39 +2406,21 @@ class CryptoAPITrading:
             )
 
             if response and "errors" not in response:
-                trades_made = True
-                # Do NOT pre-trigger any DCA levels. Hardcoded DCA will mark levels only when it hits your loss thresholds.
-                self.dca_levels_triggered[base_symbol] = []
-
-                # Fresh trade -> clear any rolling 24h DCA window for this coin
-                self._reset_dca_window_for_trade(base_symbol, sold=False)
-
-                # Reset trailing PM state for this coin (fresh trade, fresh trailing logic)
-                self.trailing_pm.pop(base_symbol, None)
-
+                # DCA levels / 24h window / trailing state start fresh once it fills (_settle_order)
+                pending_bases.add(base_symbol)
 
                 print(
                     f"Starting new trade for {full_symbol} (AI start signal long={buy_count}, short={sell_count}). "
                     f"Allocating ${allocation_in_usd:.2f}."
                 )
-                time.sleep(5)
-                holdings = self.get_holdings()
-                holding_full_symbols = [f"{h['asset_code']}-USD" for h in holdings.get("results", [])]
 
 
             start_index += 1
 
-        # If any trades were made, recalculate the cost basis
-        if trades_made:
-            time.sleep(5)
-            print("Trades were made in this iteration. Recalculating cost basis...")
-            new_cost_basis = self.calculate_cost_basis()
-            if new_cost_basis:
-                self.cost_basis = new_cost_basis
-                print("Cost basis recalculated successfully.")
-            else:
-                print("Failed to recalculcate cost basis.")
-            self.initialize_dca_levels()
+        # First look at this pass's orders (market orders are often done already);
+        # if any order filled, recalculate the cost basis
+        if self._poll_pending_orders():
+            self._refresh_after_fills()
 
         # --- GUI HUB STATUS WRITE ---
         try:
@@ -2167,25 +2439,58 @@ class CryptoAPITrading:
                 },
                 "positions": positions,
             }
-            self._append_jsonl(
-                ACCOUNT_VALUE_HISTORY_PATH,
-                {"ts": status["timestamp"], "total_account_value": total_account_value},
-            )
+            self.account_history.record(status["timestamp"], total_account_value)
             self._write_trader_status(status)
+            pt_metrics.gauge("open_positions", sum(1 for p in positions.values() if float(p.get("quantity", 0.0) or 0.0) > 0.0))
+            pt_metrics.gauge("pending_orders", len(self._pnl_ledger.get("pending_orders", {}) or {}))
         except Exception:
             pass
 
 
 
 
+    def _refresh_after_fills(self) -> None:
+        # the fills are already in the position index (_record_trade); Robinhood confirms them shortly
+        self._positions_to_state()
+        self._position_verify_due = min(self._position_verify_due, time.time() + POSITION_VERIFY_AFTER_FILL_SECONDS)
+
+    def _sync_stream(self) -> None:
+        """(Re)start the ticker-only KuCoin stream for the current coins when market_stream is on."""
+        if not _load_gui_settings().get("market_stream", False):
+            if self._stream is not None:
+                self._stream.stop()
+                self._stream = None
+                self._stream_pairs = None
+            return
+        pairs = sorted(f"{c}-USDT" for c in crypto_symbols)
+        if pairs == self._stream_pairs:
+            return
+        self._stream_pairs = pairs
+        if self._stream is not None:
+            self._stream.stop()
+        stream = pt_stream.KucoinStream(pairs, [], on_move=lambda _pair: self._wake.set(), move_pct=STREAM_MOVE_PCT)
+        self._stream = stream if stream.start() else None
+        if self._stream is None:
+            print(f"market_stream is on but websocket-client is not installed; polling every {LOOP_IDLE_SECONDS}s")
+
     def run(self):
         while True:
             try:
                 self.manage_trades()
-                time.sleep(0.5)
+                self._sync_stream()
+                # wakes early on a changed thinker signal (or a ticker move when streaming)
+                idle = LOOP_IDLE_SECONDS
+                # come back in time for the next pending-order poll
+                due = self._next_order_poll_in()
+                if due is not None:
+                    idle = min(idle, due)
+                self._wake.wait(idle)
+                self._wake.clear()
             except Exception as e:
                 print(traceback.format_exc())
 
 if __name__ == "__main__":
+    _load_api_credentials()
+    pt_metrics.configure("trader")
     trading_bot = CryptoAPITrading()
     trading_bot.run()
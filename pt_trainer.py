@@ -1,13 +1,13 @@
 from kucoin.client import Market
 market = Market(url='https://api.kucoin.com')
 import time
+import math
 """
 <------------
 newest oldest
 ------------>
 oldest newest
 """
-avg50 = []
 import sys
 import datetime
 import traceback
@@ -17,90 +17,8 @@ import calendar
 import hashlib
 import hmac
 from datetime import datetime
-sells_count = 0
-prediction_prices_avg_list = []
-pt_server = 'server'
 import psutil
 import logging
-list_len = 0
-restarting = 'no'
-in_trade = 'no'
-updowncount = 0
-updowncount1 = 0
-updowncount1_2 = 0
-updowncount1_3 = 0
-updowncount1_4 = 0
-high_var2 = 0.0
-low_var2 = 0.0
-last_flipped = 'no'
-starting_amounth02 = 100.0
-starting_amounth05 = 100.0
-starting_amounth10 = 100.0
-starting_amounth20 = 100.0
-starting_amounth50 = 100.0
-starting_amount = 100.0
-starting_amount1 = 100.0
-starting_amount1_2 = 100.0
-starting_amount1_3 = 100.0
-starting_amount1_4 = 100.0
-starting_amount2 = 100.0
-starting_amount2_2 = 100.0
-starting_amount2_3 = 100.0
-starting_amount2_4 = 100.0
-starting_amount3 = 100.0
-starting_amount3_2 = 100.0
-starting_amount3_3 = 100.0
-starting_amount3_4 = 100.0
-starting_amount4 = 100.0
-starting_amount4_2 = 100.0
-starting_amount4_3 = 100.0
-starting_amount4_4 = 100.0
-profit_list = []
-profit_list1 = []
-profit_list1_2 = []
-profit_list1_3 = []
-profit_list1_4 = []
-profit_list2 = []
-profit_list2_2 = []
-profit_list2_3 = []
-profit_list2_4 = []
-profit_list3 = []
-profit_list3_2 = []
-profit_list3_3 = []
-profit_list4 = []
-profit_list4_2 = []
-good_hits = []
-good_preds = []
-good_preds2 = []
-good_preds3 = []
-good_preds4 = []
-good_preds5 = []
-good_preds6 = []
-big_good_preds = []
-big_good_preds2 = []
-big_good_preds3 = []
-big_good_preds4 = []
-big_good_preds5 = []
-big_good_preds6 = []
-big_good_hits = []
-upordown = []
-upordown1 = []
-upordown1_2 = []
-upordown1_3 = []
-upordown1_4 = []
-upordown2 = []
-upordown2_2 = []
-upordown2_3 = []
-upordown2_4 = []
-upordown3 = []
-upordown3_2 = []
-upordown3_3 = []
-upordown3_4 = []
-upordown4 = []
-upordown4_2 = []
-upordown4_3 = []
-upordown4_4 = []
-upordown5 = []
 import json
 import uuid
 import os
@@ -111,71 +29,68 @@ def vprint(*args, **kwargs):
 	if VERBOSE:
 		print(*args, **kwargs)
 
+# Shared modules (pt_memory.py, ...) live in the project folder. Alt-coin trainers run from a
+# copy inside <main_neural_dir>/<COIN>/, so also look in the hub-provided project dir and the parent.
+for _p in (os.environ.get("POWERTRADER_PROJECT_DIR"), os.path.dirname(os.path.abspath(__file__)), os.path.dirname(os.path.dirname(os.path.abspath(__file__)))):
+	if _p and os.path.isfile(os.path.join(_p, "pt_memory.py")) and _p not in sys.path:
+		sys.path.insert(0, _p)
+		break
+import pt_memory
+import pt_match
+import pt_candles
+import pt_metrics
+import pt_bundles
+
 # Cache memory/weights in RAM (avoid re-reading and re-writing every loop)
-_memory_cache = {}  # tf_choice -> dict(memory_list, weight_list, high_weight_list, low_weight_list, dirty)
+_memory_cache = {}  # tf_choice -> dict(store, dirty)
 _last_threshold_written = {}  # tf_choice -> float
 
-def _read_text(path):
-	with open(path, "r", encoding="utf-8", errors="ignore") as f:
-		return f.read()
-
 def load_memory(tf_choice):
-	"""Load memories/weights for a timeframe once and keep them in RAM."""
+	"""Load a timeframe's memory store once and keep it in RAM (old text files are migrated on first load)."""
 	if tf_choice in _memory_cache:
 		return _memory_cache[tf_choice]
+	try:
+		store = pt_memory.load_store(tf_choice, migrate=True)
+	except Exception:
+		PrintException()
+		store = pt_memory.MemoryStore()
+	store.journal = pt_memory.MemoryJournal(pt_memory.journal_path(tf_choice), store.pattern_len, store.generation)
 	data = {
-		"memory_list": [],
-		"weight_list": [],
-		"high_weight_list": [],
-		"low_weight_list": [],
+		"store": store,
 		"dirty": False,
 	}
-	try:
-		data["memory_list"] = _read_text(f"memories_{tf_choice}.txt").replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split('~')
-	except:
-		data["memory_list"] = []
-	try:
-		data["weight_list"] = _read_text(f"memory_weights_{tf_choice}.txt").replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-	except:
-		data["weight_list"] = []
-	try:
-		data["high_weight_list"] = _read_text(f"memory_weights_high_{tf_choice}.txt").replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-	except:
-		data["high_weight_list"] = []
-	try:
-		data["low_weight_list"] = _read_text(f"memory_weights_low_{tf_choice}.txt").replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-	except:
-		data["low_weight_list"] = []
 	_memory_cache[tf_choice] = data
+	# a journal left behind by a previous run was replayed by load_store(); fold it in now
+	try:
+		if os.path.isfile(pt_memory.journal_path(tf_choice)):
+			pt_memory.compact(store, tf_choice)
+	except Exception:
+		PrintException()
 	return data
 
+# compact the journal into the main store once it holds this many records (or half the store)
+JOURNAL_COMPACT_RECORDS = 5000
+
+@pt_metrics.timed("memory_flush")
 def flush_memory(tf_choice, force=False):
-	"""Write memories/weights back to disk only when they changed (batch IO)."""
+	"""
+	Persist changes since the last flush. Normally that's an append to the journal
+	(cost ~ number of changes); force=True, or a journal that got big, rewrites the store.
+	"""
 	data = _memory_cache.get(tf_choice)
 	if not data:
 		return
 	if (not data.get("dirty")) and (not force):
 		return
+	store = data["store"]
 	try:
-		with open(f"memories_{tf_choice}.txt", "w+", encoding="utf-8") as f:
-			f.write("~".join([x for x in data["memory_list"] if str(x).strip() != ""]))
-	except:
-		pass
-	try:
-		with open(f"memory_weights_{tf_choice}.txt", "w+", encoding="utf-8") as f:
-			f.write(" ".join([str(x) for x in data["weight_list"] if str(x).strip() != ""]))
-	except:
-		pass
-	try:
-		with open(f"memory_weights_high_{tf_choice}.txt", "w+", encoding="utf-8") as f:
-			f.write(" ".join([str(x) for x in data["high_weight_list"] if str(x).strip() != ""]))
-	except:
-		pass
-	try:
-		with open(f"memory_weights_low_{tf_choice}.txt", "w+", encoding="utf-8") as f:
-			f.write(" ".join([str(x) for x in data["low_weight_list"] if str(x).strip() != ""]))
+		journal = store.journal
+		if force or journal is None or journal.records >= max(JOURNAL_COMPACT_RECORDS, len(store) // 2) or not os.path.isfile(pt_memory.store_path(tf_choice)):
+			pt_memory.compact(store, tf_choice)
+		else:
+			journal.write()
 	except:
-		pass
+		PrintException()
 	data["dirty"] = False
 
 def write_threshold_sometimes(tf_choice, perfect_threshold, loop_i, every=200):
@@ -191,6 +106,85 @@ def write_threshold_sometimes(tf_choice, perfect_threshold, loop_i, every=200):
 	except:
 		pass
 
+def prune_memory(tf_choice, policy):
+	"""
+	Between epochs (a finished timeframe): drop / merge / cap memories per the --prune-*
+	policy (see pt_memory.prune). Call after flush_memory(force=True).
+	"""
+	if not policy:
+		return
+	data = _memory_cache.get(tf_choice)
+	if not data:
+		return
+	store = data["store"]
+	try:
+		new = pt_memory.prune_timeframe(store, tf_choice, **policy)
+	except Exception:
+		PrintException()
+		return
+	if new is not store:
+		print(f"pruned {tf_choice} memories: {len(store)} -> {len(new)}")
+		data["store"] = new
+		data["dirty"] = False
+
+def checkpoint_path(tf_choice):
+	return f"trainer_checkpoint_{tf_choice}.json"
+
+def load_checkpoint(tf_choice):
+	"""Last fully processed candle (+ trainer state) for a timeframe, or None if there's no usable one."""
+	try:
+		with open(checkpoint_path(tf_choice), "r", encoding="utf-8") as f:
+			ckpt = json.load(f)
+		if ckpt.get("timeframe") != tf_choice or int(ckpt.get("last_candle_ts", 0)) <= 0:
+			return None
+		return ckpt
+	except Exception:
+		return None
+
+def save_checkpoint(tf_choice, last_candle_ts, perfect_threshold):
+	"""Call right after flush_memory() so the checkpoint and the memories describe the same candle."""
+	data = _memory_cache.get(tf_choice)
+	ckpt = {
+		"timeframe": tf_choice,
+		"last_candle_ts": int(last_candle_ts),
+		"perfect_threshold": float(perfect_threshold),
+		"memories": len(data["store"]) if data else 0,
+		"saved_at": int(time.time()),
+	}
+	try:
+		tmp = checkpoint_path(tf_choice) + ".tmp"
+		with open(tmp, "w", encoding="utf-8") as f:
+			json.dump(ckpt, f)
+		os.replace(tmp, checkpoint_path(tf_choice))
+	except Exception:
+		PrintException()
+
+def reset_timeframe(tf_choice):
+	"""Forget a timeframe's memories, threshold and checkpoint so it trains from scratch."""
+	_memory_cache.pop(tf_choice, None)
+	_last_threshold_written.pop(tf_choice, None)
+	paths = [pt_memory.store_path(tf_choice), pt_memory.journal_path(tf_choice), pt_memory.remap_path(tf_choice), f"neural_perfect_threshold_{tf_choice}.txt", checkpoint_path(tf_choice)]
+	paths += list(pt_memory.legacy_paths(tf_choice).values())
+	for fp in paths:
+		try:
+			os.remove(fp)
+		except OSError:
+			pass
+
+def incremental_candles(coin_choice, tf_choice, last_candle_ts, context=10):
+	"""
+	Closed candles from a few before the checkpoint up to now, oldest first, as
+	(times, opens, closes, highs, lows). Read from the shared candle store, which only
+	downloads what it doesn't have yet.
+	"""
+	sec = pt_candles.TF_SECONDS[tf_choice]
+	start_at = int(last_candle_ts) - context * sec
+	st = pt_candles.top_up(market, coin_choice, tf_choice, start_at=start_at)
+	now = int(time.time())
+	rows = [r for r in st.window(start_at, now, limit=0) if r[0] + sec <= now]  # skip the still-open candle
+	rows.reverse()
+	return ([float(r[0]) for r in rows], [r[1] for r in rows], [r[2] for r in rows], [r[3] for r in rows], [r[4] for r in rows])
+
 def should_stop_training(loop_i, every=50):
 	"""Check killer.txt less often (still responsive, way less IO)."""
 	if loop_i % every != 0:
@@ -220,8 +214,31 @@ def PrintException():
 	line = linecache.getline(filename, lineno, f.f_globals)
 	print('EXCEPTION IN (LINE {} "{}"): {}'.format(lineno, line.strip(), exc_obj))
 how_far_to_look_back = 100000
+# candles per pattern (the pattern holds n-1 moves); several lengths are matched together and
+# ensembled (pt_match.match_lengths). Overridden with --pattern-lengths.
 number_of_candles = [2]
-number_of_candles_index = 0
+
+def pattern_widths():
+	"""Pattern widths (values per pattern) the number_of_candles setting asks for."""
+	widths = sorted({int(n) - 1 for n in number_of_candles if 2 <= int(n) <= pt_memory.MAX_PATTERN_WIDTH + 1})
+	return tuple(widths) or (1,)
+
+def memory_widths(data):
+	"""
+	Widths to train a loaded timeframe at. A new store takes the configured ones; a store trained
+	at other widths keeps its own (its memories can't be re-cut), until it's retrained from scratch.
+	"""
+	store = data["store"]
+	widths = pattern_widths()
+	if len(store) == 0:
+		return widths
+	have = pt_memory.pattern_widths(store)
+	if have == widths:
+		return widths
+	if not data.get("widths_noted"):
+		data["widths_noted"] = True
+		print(f"memories were trained at pattern widths {have}, not {widths}: keeping theirs (retrain from scratch to change)")
+	return have
 def restart_program():
 	"""Restarts the current program, with file objects and descriptors cleanup"""
 
@@ -233,1357 +250,1205 @@ def restart_program():
 		logging.error(e)
 	python = sys.executable
 	os.execl(python, python, * sys.argv)
-try:
-	if restarted_yet > 2:
-		restarted_yet = 0
-	else:	
-		pass
-except:
-	restarted_yet = 0
 tf_choices = ['1hour', '2hour', '4hour', '8hour', '12hour', '1day', '1week']
 tf_minutes = [60, 120, 240, 480, 720, 1440, 10080]
-# --- GUI HUB INPUT (NO PROMPTS) ---
-# Usage: python pt_trainer.py BTC [reprocess_yes|reprocess_no]
-_arg_coin = "BTC"
 
-try:
-	if len(sys.argv) > 1 and str(sys.argv[1]).strip():
-		_arg_coin = str(sys.argv[1]).strip().upper()
-except Exception:
-	_arg_coin = "BTC"
+restart_processing = "yes"
+
+class TrainContext:
+	"""
+	One training run: which coin, which timeframes it walks, and where it reports.
 
-coin_choice = _arg_coin + '-USDT'
+	A normal run walks all of tf_choices in order. In parallel mode the parent spawns one
+	worker process per timeframe (`--tf <tf>`); each worker gets a context with just that
+	timeframe and reports into trainer_status_<tf>.json, and the parent aggregates those
+	into trainer_status.json for the hub.
 
-restart_processing = "yes"
+	Incremental runs resume every timeframe that has a checkpoint (trainer_checkpoint_<tf>.json)
+	and only walk the candles that closed since; timeframes without one train from scratch.
+	"""
 
-# GUI reads this status file to know if this coin is TRAINING or FINISHED
-_trainer_started_at = int(time.time())
-try:
-	with open("trainer_status.json", "w", encoding="utf-8") as f:
-		json.dump(
-			{
-				"coin": _arg_coin,
-				"state": "TRAINING",
-				"started_at": _trainer_started_at,
-				"timestamp": _trainer_started_at,
-			},
-			f,
-		)
-except Exception:
-	pass
+	def __init__(self, coin, tf_list=None, worker=False, incremental=False, prune=None, publish=None, end_at=None):
+		self.coin = coin
+		self.coin_choice = coin + '-USDT'
+		self.tf_list = list(tf_list or tf_choices)
+		self.worker = worker
+		self.incremental = incremental
+		self.prune = dict(prune or {})  # pt_memory.prune() policy applied when a timeframe finishes
+		self.publish = publish  # bundle repo the finished run is published to (pt_bundles.py), or None
+		self.end_at = int(end_at) if end_at else None  # train on candles that closed by then only (backtests)
+		self.restarted_yet = 0  # 0: 1hour warmup pass, 1: first pass on the tf, 2: full pass
+		self.how_far_to_look_back = how_far_to_look_back
+		self.started_at = int(time.time())
+		if worker:
+			self.status_path = f"trainer_status_{self.tf_list[0]}.json"
+		else:
+			self.status_path = "trainer_status.json"
+
+def _write_status(ctx, state, **extra):
+	"""GUI reads trainer_status.json to know if this coin is TRAINING or FINISHED."""
+	now = int(time.time())
+	data = {
+		"coin": ctx.coin,
+		"state": state,
+		"started_at": ctx.started_at,
+		"timestamp": now,
+	}
+	if ctx.worker:
+		data["timeframe"] = ctx.tf_list[0]
+	data.update(extra)
+	try:
+		tmp = ctx.status_path + ".tmp"
+		with open(tmp, "w", encoding="utf-8") as f:
+			json.dump(data, f)
+		os.replace(tmp, ctx.status_path)
+	except Exception:
+		pass
 
+def _write_progress(ctx, tf_choice, tf_done, restarted_yet, processed, total_candles):
+	"""
+	Report how far this run is. Only the last pass (50% -> 100% of the history) does the bulk
+	of the work, so the warmup passes count as 0% of a timeframe.
+	"""
+	frac = 0.0
+	if restarted_yet >= 2 and total_candles > 0:
+		frac = min(1.0, max(0.0, (processed / total_candles - 0.5) / 0.5))
+	progress = (tf_done + frac) / max(1, len(ctx.tf_list))
+	pt_metrics.gauge("candles_processed", processed)
+	pt_metrics.gauge("candles_total", total_candles)
+	_write_status(ctx, "TRAINING", timeframe=tf_choice, done=tf_done, total=len(ctx.tf_list), progress=round(progress, 4))
 
-the_big_index = 0
-while True:
-	list_len = 0
-	restarting = 'no'
-	in_trade = 'no'
-	updowncount = 0
-	updowncount1 = 0
-	updowncount1_2 = 0
-	updowncount1_3 = 0
-	updowncount1_4 = 0
-	high_var2 = 0.0
-	low_var2 = 0.0
-	last_flipped = 'no'
-	starting_amounth02 = 100.0
-	starting_amounth05 = 100.0
-	starting_amounth10 = 100.0
-	starting_amounth20 = 100.0
-	starting_amounth50 = 100.0
-	starting_amount = 100.0
-	starting_amount1 = 100.0
-	starting_amount1_2 = 100.0
-	starting_amount1_3 = 100.0
-	starting_amount1_4 = 100.0
-	starting_amount2 = 100.0
-	starting_amount2_2 = 100.0
-	starting_amount2_3 = 100.0
-	starting_amount2_4 = 100.0
-	starting_amount3 = 100.0
-	starting_amount3_2 = 100.0
-	starting_amount3_3 = 100.0
-	starting_amount3_4 = 100.0
-	starting_amount4 = 100.0
-	starting_amount4_2 = 100.0
-	starting_amount4_3 = 100.0
-	starting_amount4_4 = 100.0
-	profit_list = []
-	profit_list1 = []
-	profit_list1_2 = []
-	profit_list1_3 = []
-	profit_list1_4 = []
-	profit_list2 = []
-	profit_list2_2 = []
-	profit_list2_3 = []
-	profit_list2_4 = []
-	profit_list3 = []
-	profit_list3_2 = []
-	profit_list3_3 = []
-	profit_list4 = []
-	profit_list4_2 = []
-	good_hits = []
-	good_preds = []
-	good_preds2 = []
-	good_preds3 = []
-	good_preds4 = []
-	good_preds5 = []
-	good_preds6 = []
-	big_good_preds = []
-	big_good_preds2 = []
-	big_good_preds3 = []
-	big_good_preds4 = []
-	big_good_preds5 = []
-	big_good_preds6 = []
-	big_good_hits = []
-	upordown = []
-	upordown1 = []
-	upordown1_2 = []
-	upordown1_3 = []
-	upordown1_4 = []
-	upordown2 = []
-	upordown2_2 = []
-	upordown2_3 = []
-	upordown2_4 = []
-	upordown3 = []
-	upordown3_2 = []
-	upordown3_3 = []
-	upordown3_4 = []
-	upordown4 = []
-	upordown4_2 = []
-	upordown4_3 = []
-	upordown4_4 = []
-	upordown5 = []
-	tf_choice = tf_choices[the_big_index]
-	_mem = load_memory(tf_choice)
-	memory_list = _mem["memory_list"]
-	weight_list = _mem["weight_list"]
-	high_weight_list = _mem["high_weight_list"]
-	low_weight_list = _mem["low_weight_list"]
-	no_list = 'no' if len(memory_list) > 0 else 'yes'
+def _finish_training(ctx, start_time_yes, stopped=False, **extra):
+	"""
+	Mark the run finished. Workers only report their own timeframe; the stamps the hub's
+	freshness gate reads are written once, by the run that owns the whole coin.
+	"""
+	_trainer_finished_at = int(time.time())
+	if ctx.worker:
+		_write_status(ctx, "STOPPED" if stopped else "FINISHED", finished_at=_trainer_finished_at)
+		return
+	try:
+		file = open('trainer_last_start_time.txt','w+')
+		file.write(str(start_time_yes))
+		file.close()
+	except:
+		pass
 
-	tf_list = ['1hour',tf_choice,tf_choice]
-	choice_index = tf_choices.index(tf_choice)
-	minutes_list = [60,tf_minutes[choice_index],tf_minutes[choice_index]]
-	if restarted_yet < 2:
-		timeframe = tf_list[restarted_yet]#droplet setting (create list for all timeframes)
-		timeframe_minutes = minutes_list[restarted_yet]#droplet setting (create list for all timeframe_minutes)
-	else:
-		timeframe = tf_list[2]#droplet setting (create list for all timeframes)
-		timeframe_minutes = minutes_list[2]#droplet setting (create list for all timeframe_minutes)
-	start_time = int(time.time())
-	restarting = 'no'
-	success_rate = 85
-	volume_success_rate = 60
-	candles_to_predict = 1#droplet setting (Max is half of number_of_candles)(Min is 2)
-	max_difference = .5
-	preferred_difference = .4 #droplet setting (max profit_margin) (Min 0.01)
-	min_good_matches = 1#droplet setting (Max 100) (Min 4)
-	max_good_matches = 1#droplet setting (Max 100) (Min is min_good_matches)
-	prediction_expander = 1.33
-	prediction_expander2 = 1.5
-	prediction_adjuster = 0.0
-	diff_avg_setting = 0.01
-	min_success_rate = 90
-	histories = 'off'
-	coin_choice_index = 0
-	list_of_ys_count = 0
-	last_difference_between = 0.0
-	history_list = []
-	history_list2 = []
-	len_avg = []
-	list_len = 0
-	start_time = int(time.time())
-	start_time_yes = start_time
-	if 'n' in restart_processing.lower():
-		try:
-			file = open('trainer_last_start_time.txt','r')
-			last_start_time = int(file.read())
-			file.close()
-		except:
-			last_start_time = 0.0
-	else:
-		last_start_time = 0.0
-	end_time = int(start_time-((1500*timeframe_minutes)*60))
-	perc_comp = format((len(history_list2)/how_far_to_look_back)*100,'.2f')
-	last_perc_comp = perc_comp+'kjfjakjdakd'
-	while True:
-		time.sleep(.5)
+	# Mark training finished for the GUI
+	try:
+		file = open('trainer_last_training_time.txt','w+')
+		file.write(str(_trainer_finished_at))
+		file.close()
+	except:
+		pass
+	if ctx.publish and not stopped:
 		try:
-			history = str(market.get_kline(coin_choice,timeframe,startAt=end_time,endAt=start_time)).replace(']]','], ').replace('[[','[').split('], [')
-		except Exception as e:
+			published = pt_bundles.publish_coin(ctx.publish, os.getcwd(), ctx.coin, ctx.tf_list, trained_at=_trainer_finished_at)
+			print(f"{ctx.coin}: published {', '.join(sorted(published)) if published else 'nothing new'} to {ctx.publish}")
+		except Exception:
 			PrintException()
-			time.sleep(3.5)
-			continue
-		index = 0
-		while True:
-			history_list.append(history[index])
-			index += 1
-			if index >= len(history):
-				break
-			else:
-				continue
-		perc_comp = format((len(history_list)/how_far_to_look_back)*100,'.2f')
-		print('gathering history')
-		current_change = len(history_list)-list_len	
+	_write_status(ctx, "FINISHED", finished_at=_trainer_finished_at, **extra)
+
+def train_parallel(ctx, max_workers=0):
+	"""
+	Train every timeframe of ctx.tf_list in its own worker process (at most max_workers at
+	once; 0 = one per CPU), aggregating the workers' status files as they go.
+	Returns the process exit code.
+	"""
+	import subprocess
+	if max_workers <= 0:
+		max_workers = os.cpu_count() or 1
+	max_workers = max(1, min(max_workers, len(ctx.tf_list)))
+	start_time_yes = int(time.time())
+	env = os.environ.copy()
+	script = os.path.abspath(__file__)
+
+	for tf in ctx.tf_list:
 		try:
-			print('\n\n\n\n')
-			print(current_change)
-			if current_change < 1000:
-				break
-			else:
-				pass
-		except:
-			PrintException()
+			os.remove(f"trainer_status_{tf}.json")
+		except OSError:
 			pass
-		len_avg.append(current_change)
-		list_len = len(history_list)
-		last_perc_comp = perc_comp
-		start_time = end_time
-		end_time = int(start_time-((1500*timeframe_minutes)*60))
-		print(last_start_time)
-		print(start_time)
-		print(end_time)
-		print('\n')
-		if start_time <= last_start_time:
-			break
-		else:
-			continue
-	if timeframe == '1day' or timeframe == '1week':
-		if restarted_yet == 0:
-			index = int(len(history_list)/2)
-		else:
-			index = 1
-	else:
-		index = int(len(history_list)/2)
-	price_list = []
-	high_price_list = []
-	low_price_list = []
-	open_price_list = []
-	volume_list = []
-	minutes_passed = 0
-	try:
-		while True:
-			working_minute = str(history_list[index]).replace('"','').replace("'","").split(", ")
+
+	pending = list(ctx.tf_list)
+	running = {}  # tf -> Popen
+	states = {tf: "QUEUED" for tf in ctx.tf_list}
+	progress = {tf: 0.0 for tf in ctx.tf_list}
+	stopped = False
+	while pending or running:
+		while pending and len(running) < max_workers and not stopped:
+			tf = pending.pop(0)
+			cmd = [sys.executable, "-u", script, ctx.coin, "--tf", tf]
+			if ctx.incremental:
+				cmd.append("--incremental")
+			cmd += _prune_args(ctx.prune)
+			if ctx.end_at:
+				cmd += ["--end-at", str(ctx.end_at)]
+			if pattern_widths() != (1,):
+				cmd += ["--pattern-lengths", ",".join(str(w + 1) for w in pattern_widths())]
+			running[tf] = subprocess.Popen(cmd, env=env)
+			states[tf] = "TRAINING"
+
+		time.sleep(1.0)
+
+		for tf, proc in list(running.items()):
 			try:
-				if index == 1:
-					current_tf_time = float(working_minute[0].replace('[',''))
-					last_tf_time = current_tf_time
-				else:
+				with open(f"trainer_status_{tf}.json", "r", encoding="utf-8") as f:
+					st = json.load(f)
+				states[tf] = str(st.get("state", states[tf])).upper()
+				progress[tf] = float(st.get("progress", progress[tf]) or 0.0)
+			except Exception:
+				pass
+			rc = proc.poll()
+			if rc is None:
+				continue
+			del running[tf]
+			if rc != 0 or states[tf] not in ("FINISHED", "STOPPED"):
+				states[tf] = "FAILED"
+				print(f"{ctx.coin} {tf} worker exited with code {rc}")
+
+		if should_stop_training(0, every=1):
+			# workers see killer.txt themselves; just don't start any more of them
+			stopped = True
+			for tf in pending:
+				states[tf] = "STOPPED"
+			pending = []
+
+		done = sum(1 for tf in ctx.tf_list if states[tf] in ("FINISHED", "STOPPED", "FAILED"))
+		if pending or running:
+			overall = sum(1.0 if states[tf] in ("FINISHED", "STOPPED", "FAILED") else progress[tf] for tf in ctx.tf_list) / len(ctx.tf_list)
+			_write_status(ctx, "TRAINING", timeframes=dict(states), done=done, total=len(ctx.tf_list), progress=round(overall, 4))
+
+	if stopped or all(states[tf] == "FINISHED" for tf in ctx.tf_list):
+		_finish_training(ctx, start_time_yes, timeframes=dict(states), done=len(ctx.tf_list), total=len(ctx.tf_list))
+		return 0
+	_write_status(ctx, "FAILED", timeframes=dict(states), done=len(ctx.tf_list), total=len(ctx.tf_list))
+	return 1
+
+
+def train(ctx):
+	"""
+	Train every timeframe in ctx.tf_list, in order. All the per-run state the old
+	module-level loop kept in globals now lives in this function (and ctx), so a
+	timeframe can be trained in its own worker without sharing anything.
+	"""
+	coin_choice = ctx.coin_choice
+	restarted_yet = ctx.restarted_yet
+	how_far_to_look_back = ctx.how_far_to_look_back
+	number_of_candles_index = 0
+	run_tfs = ctx.tf_list
+	the_big_index = 0
+	while True:
+		list_len = 0
+		restarting = 'no'
+		in_trade = 'no'
+		updowncount = 0
+		updowncount1 = 0
+		updowncount1_2 = 0
+		updowncount1_3 = 0
+		updowncount1_4 = 0
+		high_var2 = 0.0
+		low_var2 = 0.0
+		last_flipped = 'no'
+		starting_amounth02 = 100.0
+		starting_amounth05 = 100.0
+		starting_amounth10 = 100.0
+		starting_amounth20 = 100.0
+		starting_amounth50 = 100.0
+		starting_amount = 100.0
+		starting_amount1 = 100.0
+		starting_amount1_2 = 100.0
+		starting_amount1_3 = 100.0
+		starting_amount1_4 = 100.0
+		starting_amount2 = 100.0
+		starting_amount2_2 = 100.0
+		starting_amount2_3 = 100.0
+		starting_amount2_4 = 100.0
+		starting_amount3 = 100.0
+		starting_amount3_2 = 100.0
+		starting_amount3_3 = 100.0
+		starting_amount3_4 = 100.0
+		starting_amount4 = 100.0
+		starting_amount4_2 = 100.0
+		starting_amount4_3 = 100.0
+		starting_amount4_4 = 100.0
+		profit_list = []
+		profit_list1 = []
+		profit_list1_2 = []
+		profit_list1_3 = []
+		profit_list1_4 = []
+		profit_list2 = []
+		profit_list2_2 = []
+		profit_list2_3 = []
+		profit_list2_4 = []
+		profit_list3 = []
+		profit_list3_2 = []
+		profit_list3_3 = []
+		profit_list4 = []
+		profit_list4_2 = []
+		good_hits = []
+		good_preds = []
+		good_preds2 = []
+		good_preds3 = []
+		good_preds4 = []
+		good_preds5 = []
+		good_preds6 = []
+		big_good_preds = []
+		big_good_preds2 = []
+		big_good_preds3 = []
+		big_good_preds4 = []
+		big_good_preds5 = []
+		big_good_preds6 = []
+		big_good_hits = []
+		upordown = []
+		upordown1 = []
+		upordown1_2 = []
+		upordown1_3 = []
+		upordown1_4 = []
+		upordown2 = []
+		upordown2_2 = []
+		upordown2_3 = []
+		upordown2_4 = []
+		upordown3 = []
+		upordown3_2 = []
+		upordown3_3 = []
+		upordown3_4 = []
+		upordown4 = []
+		upordown4_2 = []
+		upordown4_3 = []
+		upordown4_4 = []
+		upordown5 = []
+		tf_choice = run_tfs[the_big_index]
+		ckpt = None
+		if ctx.incremental and restarted_yet == 0:
+			ckpt = load_checkpoint(tf_choice)
+			if ckpt is not None and len(load_memory(tf_choice)["store"]) > 0:
+				restarted_yet = 2  # memories are already warmed up: go straight to the full pass
+			else:
+				# nothing to resume from: train this timeframe from scratch. The training stamp goes
+				# too, so the hub and thinker gate the coin as untrained instead of running it on
+				# an empty store.
+				ckpt = None
+				reset_timeframe(tf_choice)
+				try:
+					os.remove('trainer_last_training_time.txt')
+				except OSError:
 					pass
-				candle_time = float(working_minute[0].replace('[',''))
-				openPrice = float(working_minute[1])                
-				closePrice = float(working_minute[2])
-				highPrice = float(working_minute[3])
-				lowPrice = float(working_minute[4])
-				open_price_list.append(openPrice)
-				price_list.append(closePrice)
-				high_price_list.append(highPrice)
-				low_price_list.append(lowPrice)
-				index += 1
-				if index >= len(history_list):
+		_mem = load_memory(tf_choice)
+		no_list = 'no' if len(_mem["store"]) > 0 else 'yes'
+
+		tf_list = ['1hour',tf_choice,tf_choice]
+		choice_index = tf_choices.index(tf_choice)
+		minutes_list = [60,tf_minutes[choice_index],tf_minutes[choice_index]]
+		if restarted_yet < 2:
+			timeframe = tf_list[restarted_yet]#droplet setting (create list for all timeframes)
+			timeframe_minutes = minutes_list[restarted_yet]#droplet setting (create list for all timeframe_minutes)
+		else:
+			timeframe = tf_list[2]#droplet setting (create list for all timeframes)
+			timeframe_minutes = minutes_list[2]#droplet setting (create list for all timeframe_minutes)
+		start_time = int(time.time())
+		restarting = 'no'
+		success_rate = 85
+		volume_success_rate = 60
+		candles_to_predict = 1#droplet setting (Max is half of number_of_candles)(Min is 2)
+		max_difference = .5
+		preferred_difference = .4 #droplet setting (max profit_margin) (Min 0.01)
+		min_good_matches = 1#droplet setting (Max 100) (Min 4)
+		max_good_matches = 1#droplet setting (Max 100) (Min is min_good_matches)
+		prediction_expander = 1.33
+		prediction_expander2 = 1.5
+		prediction_adjuster = 0.0
+		diff_avg_setting = 0.01
+		min_success_rate = 90
+		histories = 'off'
+		coin_choice_index = 0
+		list_of_ys_count = 0
+		last_difference_between = 0.0
+		history_list = []
+		history_list2 = []
+		len_avg = []
+		list_len = 0
+		start_time = int(time.time())
+		start_time_yes = start_time
+		if ckpt is None:
+			if 'n' in restart_processing.lower():
+				try:
+					file = open('trainer_last_start_time.txt','r')
+					last_start_time = int(file.read())
+					file.close()
+				except:
+					last_start_time = 0.0
+			else:
+				last_start_time = 0.0
+			# the pages the old backwards walk fetched: all of KuCoin's history, or down to the page that crossed last_start_time
+			page_seconds = (1500*timeframe_minutes)*60
+			oldest = None
+			if last_start_time > 0:
+				oldest = int(start_time-(page_seconds*max(1, math.ceil((start_time-last_start_time)/page_seconds))))
+			def _gathering(n):
+				print('gathering history: '+str(n)+' candles ('+format((n/how_far_to_look_back)*100,'.2f')+'%)')
+			while True:
+				try:
+					# fills the shared candle store: disjoint windows in parallel, rate-limited across processes (pt_candles.py)
+					st = pt_candles.download_history(market,coin_choice,timeframe,stop_at=oldest,progress=_gathering)
 					break
+				except Exception as e:
+					PrintException()
+					time.sleep(3.5)
+			# newest first, (ts, open, close, high, low, volume, turnover) per candle
+			if ctx.end_at is None:
+				history_list = st.window(oldest,start_time,limit=0)
+			else:
+				# nothing from after end_at: not even the candle that was still open then
+				history_list = st.window(oldest,ctx.end_at-st.tf_seconds,limit=0)
+			if timeframe == '1day' or timeframe == '1week':
+				if restarted_yet == 0:
+					index = int(len(history_list)/2)
 				else:
-					continue
+					index = 1
+			else:
+				index = int(len(history_list)/2)
+			price_list = []
+			high_price_list = []
+			low_price_list = []
+			open_price_list = []
+			time_list = []
+			volume_list = []
+			minutes_passed = 0
+			try:
+				while True:
+					working_minute = history_list[index]
+					try:
+						if index == 1:
+							current_tf_time = float(working_minute[0])
+							last_tf_time = current_tf_time
+						else:
+							pass
+						candle_time = float(working_minute[0])
+						openPrice = float(working_minute[1])
+						closePrice = float(working_minute[2])
+						highPrice = float(working_minute[3])
+						lowPrice = float(working_minute[4])
+						open_price_list.append(openPrice)
+						price_list.append(closePrice)
+						high_price_list.append(highPrice)
+						low_price_list.append(lowPrice)
+						time_list.append(candle_time)
+						index += 1
+						if index >= len(history_list):
+							break
+						else:
+							continue
+					except:
+						PrintException()
+						index += 1
+						if index >= len(history_list):
+							break
+						else:
+							continue
+				open_price_list.reverse()
+				price_list.reverse()
+				high_price_list.reverse()
+				low_price_list.reverse()
+				time_list.reverse()
+				ticker_data = str(market.get_ticker(coin_choice)).replace('"','').replace("'","").replace("[","").replace("{","").replace("]","").replace("}","").replace(",","").lower().split(' ')
+				price = float(ticker_data[ticker_data.index('price:')+1])
 			except:
 				PrintException()
-				index += 1
-				if index >= len(history_list):
+		else:
+			# incremental: only the candles that closed since the checkpoint (plus a little context)
+			while True:
+				try:
+					time_list, open_price_list, price_list, high_price_list, low_price_list = incremental_candles(coin_choice, tf_choice, ckpt["last_candle_ts"])
 					break
-				else:
-					continue
-		open_price_list.reverse()
-		price_list.reverse()
-		high_price_list.reverse()
-		low_price_list.reverse()
-		ticker_data = str(market.get_ticker(coin_choice)).replace('"','').replace("'","").replace("[","").replace("{","").replace("]","").replace("}","").replace(",","").lower().split(' ')
-		price = float(ticker_data[ticker_data.index('price:')+1])
-	except:
-		PrintException()
-	history_list = []
-	history_list2 = []
-	perfect_threshold = 1.0
-	loop_i = 0  # counts inner training iterations (used to throttle disk IO)
-	if restarted_yet < 2:
-		price_list_length = 10
-	else:
-		price_list_length = int(len(price_list)*0.5)
-	while True:
+				except Exception:
+					PrintException()
+					time.sleep(3.5)
+			resume_at = max(2, sum(1 for t in time_list if t <= float(ckpt["last_candle_ts"])))
+			if resume_at >= len(price_list):
+				print(tf_choice + ': no new closed candles since the last run')
+				the_big_index += 1
+				restarted_yet = 0
+				if the_big_index >= len(run_tfs):
+					_finish_training(ctx, start_time_yes)
+					sys.exit(0)
+				continue
+		history_list = []
+		history_list2 = []
+		perfect_threshold = 1.0
+		loop_i = 0  # counts inner training iterations (used to throttle disk IO)
+		if restarted_yet < 2:
+			price_list_length = 10
+		else:
+			price_list_length = int(len(price_list)*0.5)
+		if ckpt is not None:
+			perfect_threshold = float(ckpt.get("perfect_threshold", perfect_threshold))
+			price_list_length = resume_at
+		checkpoint_threshold = perfect_threshold  # threshold as of the last candle whose outcome was learned
 		while True:
-			loop_i += 1
-			matched_patterns_count = 0
-			list_of_ys = []
-			list_of_ys_count = 0
-			next_coin = 'no'
-			all_current_patterns = []
-			memory_or_history = []
-			memory_weights = []
+			while True:
+				loop_i += 1
+				matched_patterns_count = 0
+				list_of_ys = []
+				list_of_ys_count = 0
+				next_coin = 'no'
+				all_current_patterns = []
+				memory_or_history = []
+				memory_weights = []
 
-			high_memory_weights = []
-			low_memory_weights = []
-			final_moves = 0.0
-			high_final_moves = 0.0
-			low_final_moves = 0.0
-			memory_indexes = []
-			matches_yep = []
-			flipped = 'no'
-			last_minute = int(time.time()/60)
-			overunder = 'nothing'
-			overunder2 = 'nothing'
-			list_of_ys = []
-			all_predictions = []
-			all_preds = []
-			high_all_predictions = []
-			high_all_preds = []
-			low_all_predictions = []
-			low_all_preds = []
-			try:
-				open_price_list2 = []
-				open_price_list_index = 0
+				high_memory_weights = []
+				low_memory_weights = []
+				final_moves = 0.0
+				high_final_moves = 0.0
+				low_final_moves = 0.0
+				memory_indexes = []
+				matches_yep = []
+				flipped = 'no'
+				last_minute = int(time.time()/60)
+				overunder = 'nothing'
+				overunder2 = 'nothing'
+				list_of_ys = []
+				all_predictions = []
+				all_preds = []
+				high_all_predictions = []
+				high_all_preds = []
+				low_all_predictions = []
+				low_all_preds = []
+				try:
+					open_price_list2 = []
+					open_price_list_index = 0
+					while True:
+						open_price_list2.append(open_price_list[open_price_list_index])
+						open_price_list_index += 1
+						if open_price_list_index >= price_list_length:
+							break
+						else:
+							continue
+				except:
+					break
+				low_all_preds = []
+				try:
+					price_list2 = []
+					price_list_index = 0
+					while True:
+						price_list2.append(price_list[price_list_index])
+						price_list_index += 1
+						if price_list_index >= price_list_length:
+							break
+						else:
+							continue
+				except:
+					break
+				high_price_list2 = []
+				high_price_list_index = 0
 				while True:
-					open_price_list2.append(open_price_list[open_price_list_index])
-					open_price_list_index += 1
-					if open_price_list_index >= price_list_length:
+					high_price_list2.append(high_price_list[high_price_list_index])
+					high_price_list_index += 1
+					if high_price_list_index >= price_list_length:
 						break
 					else:
 						continue
-			except:
-				break
-			low_all_preds = []
-			try:
-				price_list2 = []
-				price_list_index = 0
+				low_price_list2 = []
+				low_price_list_index = 0
 				while True:
-					price_list2.append(price_list[price_list_index])
-					price_list_index += 1
-					if price_list_index >= price_list_length:
+					low_price_list2.append(low_price_list[low_price_list_index])
+					low_price_list_index += 1
+					if low_price_list_index >= price_list_length:
 						break
 					else:
 						continue
-			except:
-				break
-			high_price_list2 = []
-			high_price_list_index = 0
-			while True:
-				high_price_list2.append(high_price_list[high_price_list_index])
-				high_price_list_index += 1
-				if high_price_list_index >= price_list_length:
-					break
-				else:
-					continue
-			low_price_list2 = []
-			low_price_list_index = 0
-			while True:
-				low_price_list2.append(low_price_list[low_price_list_index])
-				low_price_list_index += 1
-				if low_price_list_index >= price_list_length:
-					break
-				else:
-					continue
-			index = 0
-			index2 = index+1
-			price_change_list = []
-			while True:
-				price_change = 100*((price_list2[index]-open_price_list2[index])/open_price_list2[index])
-				price_change_list.append(price_change)
-				index += 1
-				if index >= len(price_list2):
-					break
-				else:
-					continue
-			index = 0
-			index2 = index+1
-			high_price_change_list = []
-			while True:
-				high_price_change = 100*((high_price_list2[index]-open_price_list2[index])/open_price_list2[index])
-				high_price_change_list.append(high_price_change)
-				index += 1
-				if index >= len(price_list2):
-					break
-				else:
-					continue
-			index = 0
-			index2 = index+1
-			low_price_change_list = []
-			while True:
-				low_price_change = 100*((low_price_list2[index]-open_price_list2[index])/open_price_list2[index])
-				low_price_change_list.append(low_price_change)
-				index += 1
-				if index >= len(price_list2):
-					break
-				else:
-					continue
-			# Check stop signal occasionally (much less disk IO)
-			if should_stop_training(loop_i):
-				exited = 'yes'
-				print('finished processing')
-				file = open('trainer_last_start_time.txt','w+')
-				file.write(str(start_time_yes))
-				file.close()
-
-				# Mark training finished for the GUI
-				try:
-					_trainer_finished_at = int(time.time())
-					file = open('trainer_last_training_time.txt','w+')
-					file.write(str(_trainer_finished_at))
-					file.close()
-				except:
-					pass
-				try:
-					with open("trainer_status.json", "w", encoding="utf-8") as f:
-						json.dump(
-							{
-								"coin": _arg_coin,
-								"state": "FINISHED",
-								"started_at": _trainer_started_at,
-								"finished_at": _trainer_finished_at,
-								"timestamp": _trainer_finished_at,
-							},
-							f,
-						)
-				except Exception:
-					pass
-
-				# Flush any cached memory/weights before we spin
-				flush_memory(tf_choice, force=True)
+				index = 0
+				index2 = index+1
+				price_change_list = []
+				while True:
+					price_change = 100*((price_list2[index]-open_price_list2[index])/open_price_list2[index])
+					price_change_list.append(price_change)
+					index += 1
+					if index >= len(price_list2):
+						break
+					else:
+						continue
+				index = 0
+				index2 = index+1
+				high_price_change_list = []
+				while True:
+					high_price_change = 100*((high_price_list2[index]-open_price_list2[index])/open_price_list2[index])
+					high_price_change_list.append(high_price_change)
+					index += 1
+					if index >= len(price_list2):
+						break
+					else:
+						continue
+				index = 0
+				index2 = index+1
+				low_price_change_list = []
+				while True:
+					low_price_change = 100*((low_price_list2[index]-open_price_list2[index])/open_price_list2[index])
+					low_price_change_list.append(low_price_change)
+					index += 1
+					if index >= len(price_list2):
+						break
+					else:
+						continue
+				# progress for the hub's training queue (same cadence as the batched flushes)
+				if loop_i % 200 == 0:
+					_write_progress(ctx, tf_choice, the_big_index, restarted_yet, len(price_list2), len(price_list))
+				# Check stop signal occasionally (much less disk IO)
+				if should_stop_training(loop_i):
+					exited = 'yes'
+					print('finished processing')
 
-				sys.exit(0)
+					# Flush any cached memory/weights before we stop
+					flush_memory(tf_choice, force=True)
+					if restarted_yet >= 2:
+						save_checkpoint(tf_choice, time_list[len(price_list2)-1], perfect_threshold)
+					_finish_training(ctx, start_time_yes, stopped=True)
 
-				the_big_index += 1
-				restarted_yet = 0
-				avg50 = []
-				import sys
-				import datetime
-				import traceback
-				import linecache
-				import base64
-				import calendar
-				import hashlib
-				import hmac
-				from datetime import datetime
-				sells_count = 0
-				prediction_prices_avg_list = []
-				pt_server = 'server'
-				import psutil
-				import logging
-				list_len = 0
-				restarting = 'no'
-				in_trade = 'no'
-				updowncount = 0
-				updowncount1 = 0
-				updowncount1_2 = 0
-				updowncount1_3 = 0
-				updowncount1_4 = 0
-				high_var2 = 0.0
-				low_var2 = 0.0
-				last_flipped = 'no'
-				starting_amounth02 = 100.0
-				starting_amounth05 = 100.0
-				starting_amounth10 = 100.0
-				starting_amounth20 = 100.0
-				starting_amounth50 = 100.0
-				starting_amount = 100.0
-				starting_amount1 = 100.0
-				starting_amount1_2 = 100.0
-				starting_amount1_3 = 100.0
-				starting_amount1_4 = 100.0
-				starting_amount2 = 100.0
-				starting_amount2_2 = 100.0
-				starting_amount2_3 = 100.0
-				starting_amount2_4 = 100.0
-				starting_amount3 = 100.0
-				starting_amount3_2 = 100.0
-				starting_amount3_3 = 100.0
-				starting_amount3_4 = 100.0
-				starting_amount4 = 100.0
-				starting_amount4_2 = 100.0
-				starting_amount4_3 = 100.0
-				starting_amount4_4 = 100.0
-				profit_list = []
-				profit_list1 = []
-				profit_list1_2 = []
-				profit_list1_3 = []
-				profit_list1_4 = []
-				profit_list2 = []
-				profit_list2_2 = []
-				profit_list2_3 = []
-				profit_list2_4 = []
-				profit_list3 = []
-				profit_list3_2 = []
-				profit_list3_3 = []
-				profit_list4 = []
-				profit_list4_2 = []
-				good_hits = []
-				good_preds = []
-				good_preds2 = []
-				good_preds3 = []
-				good_preds4 = []
-				good_preds5 = []
-				good_preds6 = []
-				big_good_preds = []
-				big_good_preds2 = []
-				big_good_preds3 = []
-				big_good_preds4 = []
-				big_good_preds5 = []
-				big_good_preds6 = []
-				big_good_hits = []
-				upordown = []
-				upordown1 = []
-				upordown1_2 = []
-				upordown1_3 = []
-				upordown1_4 = []
-				upordown2 = []
-				upordown2_2 = []
-				upordown2_3 = []
-				upordown2_4 = []
-				upordown3 = []
-				upordown3_2 = []
-				upordown3_3 = []
-				upordown3_4 = []
-				upordown4 = []
-				upordown4_2 = []
-				upordown4_3 = []
-				upordown4_4 = []
-				upordown5 = []
-				import json
-				import uuid
-				how_far_to_look_back = 100000
-				list_len = 0
-				if the_big_index >= len(tf_choices):
-					if len(number_of_candles) == 1:
-						print("Finished processing all timeframes (number_of_candles has only one entry). Exiting.")
+					sys.exit(0)
+				else:
+					exited = 'no'
+				perfect = []
+				while True:
+					try:
+						print('\n\n\n\n')
+						print(choice_index)
+						print(restarted_yet)
+						print(tf_list[restarted_yet])
 						try:
-							file = open('trainer_last_start_time.txt','w+')
-							file.write(str(start_time_yes))
-							file.close()
+							# newest candle first, as many moves as the widest pattern (pt_memory.pattern_widths)
+							_mem = load_memory(tf_choice)
+							widths = memory_widths(_mem)
+							width = _mem["store"].pattern_len if len(_mem["store"]) else widths[-1]
+							current_pattern = [price_change_list[len(price_change_list)-1-j] for j in range(width)]
 						except:
-							pass
-
-						# Mark training finished for the GUI
+							PrintException()
 						try:
-							_trainer_finished_at = int(time.time())
-							file = open('trainer_last_training_time.txt','w+')
-							file.write(str(_trainer_finished_at))
-							file.close()
+							high_current_pattern_length = number_of_candles[number_of_candles_index]
+							index = (len(high_price_change_list))-(number_of_candles[number_of_candles_index]-1)
+							high_current_pattern = []
+							while True:
+								high_current_pattern.append(high_price_change_list[index])
+								index += 1
+								if len(high_current_pattern) >= (number_of_candles[number_of_candles_index]-1):
+									break
+								else:
+									continue
 						except:
-							pass
-						try:
-							with open("trainer_status.json", "w", encoding="utf-8") as f:
-								json.dump(
-									{
-										"coin": _arg_coin,
-										"state": "FINISHED",
-										"started_at": _trainer_started_at,
-										"finished_at": _trainer_finished_at,
-										"timestamp": _trainer_finished_at,
-									},
-									f,
-								)
-						except Exception:
-							pass
-
-						sys.exit(0)
-					else:
-						the_big_index = 0
-				else:
-					pass
-
-				break
-			else:
-				exited = 'no'
-			perfect = []
-			while True:
-				try:
-					print('\n\n\n\n')
-					print(choice_index)
-					print(restarted_yet)
-					print(tf_list[restarted_yet])
-					try:
-						current_pattern_length = number_of_candles[number_of_candles_index]
-						index = (len(price_change_list))-(number_of_candles[number_of_candles_index]-1)
-						current_pattern = []
-						history_pattern_start_index = (len(price_change_list))-((number_of_candles[number_of_candles_index]+candles_to_predict)*2)
-						history_pattern_index = history_pattern_start_index
-						while True:
-							current_pattern.append(price_change_list[index])
-							index += 1
-							if len(current_pattern) >= (number_of_candles[number_of_candles_index]-1):
-								break
-							else:
-								continue
-					except:
-						PrintException()
-					try:
-						high_current_pattern_length = number_of_candles[number_of_candles_index]
-						index = (len(high_price_change_list))-(number_of_candles[number_of_candles_index]-1)
-						high_current_pattern = []
-						while True:
-							high_current_pattern.append(high_price_change_list[index])
-							index += 1
-							if len(high_current_pattern) >= (number_of_candles[number_of_candles_index]-1):
-								break
-							else:
-								continue
-					except:
-						PrintException()
-					try:
-						low_current_pattern_length = number_of_candles[number_of_candles_index]
-						index = (len(low_price_change_list))-(number_of_candles[number_of_candles_index]-1)
-						low_current_pattern = []
-						while True:
-							low_current_pattern.append(low_price_change_list[index])
-							index += 1
-							if len(low_current_pattern) >= (number_of_candles[number_of_candles_index]-1):
-								break
-							else:
-								continue
-					except:
-						PrintException()
-					history_diff = 1000000.0
-					memory_diff = 1000000.0
-					history_diffs = []
-					memory_diffs = []
-					if 1 == 1:
+							PrintException()
 						try:
-							file = open('memories_'+tf_choice+'.txt','r')
-							memory_list = file.read().replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split('~')
-							file.close()
-							file = open('memory_weights_'+tf_choice+'.txt','r')
-							weight_list = file.read().replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-							file.close()							
-							file = open('memory_weights_high_'+tf_choice+'.txt','r')
-							high_weight_list = file.read().replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-							file.close()
-							file = open('memory_weights_low_'+tf_choice+'.txt','r')
-							low_weight_list = file.read().replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-							file.close()
-							mem_ind = 0
-							diffs_list = []
-							any_perfect = 'no'
-							perfect_dexs = []
-							perfect_diffs = []
-							moves = []
-							move_weights = []
-							high_move_weights = []
-							low_move_weights = []
-							unweighted = []
-							high_unweighted = []
-							low_unweighted = []
-							high_moves = []
-							low_moves = []
+							low_current_pattern_length = number_of_candles[number_of_candles_index]
+							index = (len(low_price_change_list))-(number_of_candles[number_of_candles_index]-1)
+							low_current_pattern = []
 							while True:
-								memory_pattern = memory_list[mem_ind].split('{}')[0].replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').split(' ')
-								avgs = []
-								checks = []
-								check_dex = 0
-								while True:
-									current_candle = float(current_pattern[check_dex])
-									memory_candle = float(memory_pattern[check_dex])
-									if current_candle + memory_candle == 0.0:
-										difference = 0.0
-									else:
-										try:
-											difference = abs((abs(current_candle-memory_candle)/((current_candle+memory_candle)/2))*100)
-										except:
-											difference = 0.0
-									checks.append(difference)
-									check_dex += 1
-									if check_dex >= len(current_pattern):
-										break
-									else:
-										continue
-								diff_avg = sum(checks)/len(checks)
-								if diff_avg <= perfect_threshold:
+								low_current_pattern.append(low_price_change_list[index])
+								index += 1
+								if len(low_current_pattern) >= (number_of_candles[number_of_candles_index]-1):
+									break
+								else:
+									continue
+						except:
+							PrintException()
+						history_diff = 1000000.0
+						memory_diff = 1000000.0
+						history_diffs = []
+						memory_diffs = []
+						if 1 == 1:
+							try:
+								# memories/weights come from the in-RAM store (no per-loop disk re-read)
+								_store = load_memory(tf_choice)["store"]
+								memory_count = len(_store)
+								if memory_count == 0:
+									raise IndexError("no memories yet for " + tf_choice)
+								pattern_len = _store.pattern_len
+								mem_patterns = _store.patterns
+								mem_moves = _store.moves
+								weight_list = _store.weights
+								high_weight_list = _store.high_weights
+								low_weight_list = _store.low_weights
+								mem_ind = 0
+								diffs_list = []
+								any_perfect = 'no'
+								perfect_dexs = []
+								perfect_diffs = []
+								moves = []
+								move_weights = []
+								high_move_weights = []
+								low_move_weights = []
+								unweighted = []
+								high_unweighted = []
+								low_unweighted = []
+								high_moves = []
+								low_moves = []
+								# score the current pattern at every width in one pass (indexed by first value, see pt_match.py)
+								match_results = pt_match.match_lengths(current_pattern, _store, perfect_threshold, widths)
+								diffs_list, _, best_index = match_results[widths[-1]]
+								perfect_dexs = pt_match.perfect_union(match_results)
+								for mem_ind in perfect_dexs:
 									any_perfect = 'yes'
-									high_diff = float(memory_list[mem_ind].split('{}')[1].replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').replace(' ',''))/100
-									low_diff = float(memory_list[mem_ind].split('{}')[2].replace("'","").replace(',','').replace('"','').replace(']','').replace('[','').replace(' ',''))/100
-									unweighted.append(float(memory_pattern[len(memory_pattern)-1]))
-									move_weights.append(float(weight_list[mem_ind]))
-									high_move_weights.append(float(high_weight_list[mem_ind]))
-									low_move_weights.append(float(low_weight_list[mem_ind]))
+									high_diff = _store.high_diffs[mem_ind]/100
+									low_diff = _store.low_diffs[mem_ind]/100
+									unweighted.append(mem_moves[mem_ind])
+									move_weights.append(weight_list[mem_ind])
+									high_move_weights.append(high_weight_list[mem_ind])
+									low_move_weights.append(low_weight_list[mem_ind])
 									high_unweighted.append(high_diff)
 									low_unweighted.append(low_diff)
-									moves.append(float(memory_pattern[len(memory_pattern)-1])*float(weight_list[mem_ind]))
-									high_moves.append(high_diff*float(high_weight_list[mem_ind]))
-									low_moves.append(low_diff*float(low_weight_list[mem_ind]))
-									perfect_dexs.append(mem_ind)
-									perfect_diffs.append(diff_avg)
+									moves.append(mem_moves[mem_ind]*weight_list[mem_ind])
+									high_moves.append(high_diff*high_weight_list[mem_ind])
+									low_moves.append(low_diff*low_weight_list[mem_ind])
+									perfect_diffs.append(diffs_list[mem_ind])
+								if any_perfect == 'no':
+									memory_diff = diffs_list[best_index]
+									which_memory_index = best_index
+									perfect.append('no')
+									final_moves = 0.0
+									high_final_moves = 0.0
+									low_final_moves = 0.0
+									new_memory = 'yes'
 								else:
-									pass
-								diffs_list.append(diff_avg)
-								mem_ind += 1
-								if mem_ind >= len(memory_list):
-									if any_perfect == 'no':
-										memory_diff = min(diffs_list)
-										which_memory_index = diffs_list.index(memory_diff)
-										perfect.append('no')
+									try:
+										# one prediction per width, averaged (a single width is just its mean)
+										final_moves, high_final_moves, low_final_moves = pt_match.ensemble_moves(_store, match_results)
+									except:
 										final_moves = 0.0
 										high_final_moves = 0.0
 										low_final_moves = 0.0
-										new_memory = 'yes'
-									else:
-										try:
-											final_moves = sum(moves)/len(moves)
-											high_final_moves = sum(high_moves)/len(high_moves)
-											low_final_moves = sum(low_moves)/len(low_moves)
-										except:
-											final_moves = 0.0
-											high_final_moves = 0.0
-											low_final_moves = 0.0
-										which_memory_index = perfect_dexs[perfect_diffs.index(min(perfect_diffs))]
-										perfect.append('yes')
-									break
-								else:
-									continue
-						except:
-							PrintException()
-							memory_list = []
-							weight_list = []
-							high_weight_list = []
-							low_weight_list = []
-							which_memory_index = 'no'
-							perfect.append('no')
-							diffs_list = []
-							any_perfect = 'no'
-							perfect_dexs = []
-							perfect_diffs = []
-							moves = []
-							move_weights = []
-							high_move_weights = []
-							low_move_weights = []
-							unweighted = []
-							high_moves = []
-							low_moves = []
-							final_moves = 0.0
-							high_final_moves = 0.0
-							low_final_moves = 0.0
-					else:
-						pass
-					all_current_patterns.append(current_pattern)
-					if len(unweighted) > 20:
-						if perfect_threshold < 0.1:
-							perfect_threshold -= 0.001
-						else:
-							perfect_threshold -= 0.01
-						if perfect_threshold < 0.0:
-							perfect_threshold = 0.0
-						else:
-							pass
-					else:
-						if perfect_threshold < 0.1:
-							perfect_threshold += 0.001
-						else:
-							perfect_threshold += 0.01
-						if perfect_threshold > 100.0:
-							perfect_threshold = 100.0
+									which_memory_index = best_index
+									perfect.append('yes')
+							except:
+								PrintException()
+								weight_list = []
+								high_weight_list = []
+								low_weight_list = []
+								which_memory_index = 'no'
+								perfect.append('no')
+								diffs_list = []
+								any_perfect = 'no'
+								perfect_dexs = []
+								perfect_diffs = []
+								moves = []
+								move_weights = []
+								high_move_weights = []
+								low_move_weights = []
+								unweighted = []
+								high_moves = []
+								low_moves = []
+								final_moves = 0.0
+								high_final_moves = 0.0
+								low_final_moves = 0.0
 						else:
 							pass
-					write_threshold_sometimes(tf_choice, perfect_threshold, loop_i, every=200)
-
-					try:
-						index = 0
-						current_pattern_length = number_of_candles[number_of_candles_index]
-						index = (len(price_list2))-current_pattern_length
-						current_pattern = []
-						while True:
-							current_pattern.append(price_list2[index])
-							if len(current_pattern)>=number_of_candles[number_of_candles_index]:
-								break
+						all_current_patterns.append(current_pattern)
+						if len(unweighted) > 20:
+							if perfect_threshold < 0.1:
+								perfect_threshold -= 0.001
 							else:
-								index += 1
-								if index >= len(price_list2):
-									break
-								else:
-									continue	
-					except:
-						PrintException()
-					if 1==1:
-						while True:
-							try:
-								c_diff = final_moves/100
-								high_diff = high_final_moves
-								low_diff = low_final_moves
-								prediction_prices = [current_pattern[len(current_pattern)-1]]
-								high_prediction_prices = [current_pattern[len(current_pattern)-1]]
-								low_prediction_prices = [current_pattern[len(current_pattern)-1]]
-								start_price = current_pattern[len(current_pattern)-1]
-								new_price = start_price+(start_price*c_diff)
-								high_new_price = start_price+(start_price*high_diff)
-								low_new_price = start_price+(start_price*low_diff)
-								prediction_prices = [start_price,new_price]
-								high_prediction_prices = [start_price,high_new_price]
-								low_prediction_prices = [start_price,low_new_price]
-							except:
-								start_price = current_pattern[len(current_pattern)-1]
-								new_price = start_price
-								prediction_prices = [start_price,start_price]
-								high_prediction_prices = [start_price,start_price]
-								low_prediction_prices = [start_price,start_price]
-							break
-						index = len(current_pattern)-1
-						index2 = 0
-						all_preds.append(prediction_prices)
-						high_all_preds.append(high_prediction_prices)
-						low_all_preds.append(low_prediction_prices)
-						overunder = 'within'
-						all_predictions.append(prediction_prices)
-						high_all_predictions.append(high_prediction_prices)
-						low_all_predictions.append(low_prediction_prices)
-						index = 0
-						print(tf_choice)
-						page_info = ''
-						current_pattern_length = 3
-						index = (len(price_list2)-1)-current_pattern_length
-						current_pattern = []
-						while True:
-							current_pattern.append(price_list2[index])
-							index += 1
-							if index >= len(price_list2):
-								break
+								perfect_threshold -= 0.01
+							if perfect_threshold < 0.0:
+								perfect_threshold = 0.0
 							else:
-								continue
-						high_current_pattern_length = 3
-						high_index = (len(high_price_list2)-1)-high_current_pattern_length
-						high_current_pattern = []
-						while True:
-							high_current_pattern.append(high_price_list2[high_index])
-							high_index += 1
-							if high_index >= len(high_price_list2):
-								break
+								pass
+						else:
+							if perfect_threshold < 0.1:
+								perfect_threshold += 0.001
 							else:
-								continue
-						low_current_pattern_length = 3
-						low_index = (len(low_price_list2)-1)-low_current_pattern_length
-						low_current_pattern = []
-						while True:
-							low_current_pattern.append(low_price_list2[low_index])
-							low_index += 1
-							if low_index >= len(low_price_list2):
-								break
+								perfect_threshold += 0.01
+							if perfect_threshold > 100.0:
+								perfect_threshold = 100.0
 							else:
-								continue
+								pass
+						write_threshold_sometimes(tf_choice, perfect_threshold, loop_i, every=200)
+
 						try:
-							which_pattern_length = 0
-							new_y = [start_price,new_price]
-							high_new_y = [start_price,high_new_price]
-							low_new_y = [start_price,low_new_price]
+							index = 0
+							current_pattern_length = number_of_candles[number_of_candles_index]
+							index = (len(price_list2))-current_pattern_length
+							current_pattern = []
+							while True:
+								current_pattern.append(price_list2[index])
+								if len(current_pattern)>=number_of_candles[number_of_candles_index]:
+									break
+								else:
+									index += 1
+									if index >= len(price_list2):
+										break
+									else:
+										continue	
 						except:
 							PrintException()
-							new_y = [current_pattern[len(current_pattern)-1],current_pattern[len(current_pattern)-1]]
-							high_new_y = [current_pattern[len(current_pattern)-1],high_current_pattern[len(high_current_pattern)-1]]
-							low_new_y = [current_pattern[len(current_pattern)-1],low_current_pattern[len(low_current_pattern)-1]]
-					else:
-						current_pattern_length = 3
-						index = (len(price_list2))-current_pattern_length
-						current_pattern = []
-						while True:
-							current_pattern.append(price_list2[index])
-							index += 1
-							if index >= len(price_list2):
-								break
-							else:
-								continue
-						high_current_pattern_length = 3
-						high_index = (len(high_price_list2)-1)-high_current_pattern_length
-						high_current_pattern = []
-						while True:
-							high_current_pattern.append(high_price_list2[high_index])
-							high_index += 1
-							if high_index >= len(high_price_list2):
-								break
-							else:
-								continue
-						low_current_pattern_length = 3
-						low_index = (len(low_price_list2)-1)-low_current_pattern_length
-						low_current_pattern = []
-						while True:
-							low_current_pattern.append(low_price_list2[low_index])
-							low_index += 1
-							if low_index >= len(low_price_list2):
+						if 1==1:
+							while True:
+								try:
+									c_diff = final_moves/100
+									high_diff = high_final_moves
+									low_diff = low_final_moves
+									prediction_prices = [current_pattern[len(current_pattern)-1]]
+									high_prediction_prices = [current_pattern[len(current_pattern)-1]]
+									low_prediction_prices = [current_pattern[len(current_pattern)-1]]
+									start_price = current_pattern[len(current_pattern)-1]
+									new_price = start_price+(start_price*c_diff)
+									high_new_price = start_price+(start_price*high_diff)
+									low_new_price = start_price+(start_price*low_diff)
+									prediction_prices = [start_price,new_price]
+									high_prediction_prices = [start_price,high_new_price]
+									low_prediction_prices = [start_price,low_new_price]
+								except:
+									start_price = current_pattern[len(current_pattern)-1]
+									new_price = start_price
+									prediction_prices = [start_price,start_price]
+									high_prediction_prices = [start_price,start_price]
+									low_prediction_prices = [start_price,start_price]
 								break
-							else:
-								continue
-						new_y = [current_pattern[len(current_pattern)-1],current_pattern[len(current_pattern)-1]]
-						number_of_candles_index += 1
-						if number_of_candles_index >= len(number_of_candles):
-							print("Processed all number_of_candles. Exiting.")
-							sys.exit(0)
-					perfect_yes = 'no'
-					if 1==1:
-						high_current_price = high_current_pattern[len(high_current_pattern)-1]
-						low_current_price = low_current_pattern[len(low_current_pattern)-1]
-						try:
-							try:
-								difference_of_actuals = last_actual-new_y[0]
-								difference_of_last = last_actual-last_prediction
-								percent_difference_of_actuals = ((new_y[0]-last_actual)/abs(last_actual))*100
-								high_difference_of_actuals = last_actual-high_current_price
-								high_percent_difference_of_actuals = ((high_current_price-last_actual)/abs(last_actual))*100
-								low_difference_of_actuals = last_actual-low_current_price
-								low_percent_difference_of_actuals = ((low_current_price-last_actual)/abs(last_actual))*100
-								percent_difference_of_last = ((last_prediction-last_actual)/abs(last_actual))*100
-								high_percent_difference_of_last = ((high_last_prediction-last_actual)/abs(last_actual))*100
-								low_percent_difference_of_last = ((low_last_prediction-last_actual)/abs(last_actual))*100
-								if in_trade == 'no':
-									percent_for_no_sell = ((new_y[1]-last_actual)/abs(last_actual))*100
-									og_actual = last_actual
-									in_trade = 'yes'
+							index = len(current_pattern)-1
+							index2 = 0
+							all_preds.append(prediction_prices)
+							high_all_preds.append(high_prediction_prices)
+							low_all_preds.append(low_prediction_prices)
+							overunder = 'within'
+							all_predictions.append(prediction_prices)
+							high_all_predictions.append(high_prediction_prices)
+							low_all_predictions.append(low_prediction_prices)
+							index = 0
+							print(tf_choice)
+							page_info = ''
+							current_pattern_length = 3
+							index = (len(price_list2)-1)-current_pattern_length
+							current_pattern = []
+							while True:
+								current_pattern.append(price_list2[index])
+								index += 1
+								if index >= len(price_list2):
+									break
+								else:
+									continue
+							high_current_pattern_length = 3
+							high_index = (len(high_price_list2)-1)-high_current_pattern_length
+							high_current_pattern = []
+							while True:
+								high_current_pattern.append(high_price_list2[high_index])
+								high_index += 1
+								if high_index >= len(high_price_list2):
+									break
 								else:
-									percent_for_no_sell = ((new_y[1]-og_actual)/abs(og_actual))*100
+									continue
+							low_current_pattern_length = 3
+							low_index = (len(low_price_list2)-1)-low_current_pattern_length
+							low_current_pattern = []
+							while True:
+								low_current_pattern.append(low_price_list2[low_index])
+								low_index += 1
+								if low_index >= len(low_price_list2):
+									break
+								else:
+									continue
+							try:
+								which_pattern_length = 0
+								new_y = [start_price,new_price]
+								high_new_y = [start_price,high_new_price]
+								low_new_y = [start_price,low_new_price]
 							except:
-								difference_of_actuals = 0.0
-								difference_of_last = 0.0
-								percent_difference_of_actuals = 0.0
-								percent_difference_of_last = 0.0
-								high_difference_of_actuals = 0.0
-								high_percent_difference_of_actuals = 0.0
-								low_difference_of_actuals = 0.0
-								low_percent_difference_of_actuals = 0.0
-								high_percent_difference_of_last = 0.0
-								low_percent_difference_of_last = 0.0
-						except:
-							PrintException()
-						try:
-							perdex = 0
+								PrintException()
+								new_y = [current_pattern[len(current_pattern)-1],current_pattern[len(current_pattern)-1]]
+								high_new_y = [current_pattern[len(current_pattern)-1],high_current_pattern[len(high_current_pattern)-1]]
+								low_new_y = [current_pattern[len(current_pattern)-1],low_current_pattern[len(low_current_pattern)-1]]
+						else:
+							current_pattern_length = 3
+							index = (len(price_list2))-current_pattern_length
+							current_pattern = []
 							while True:
-								if perfect[perdex] == 'yes':
-									perfect_yes = 'yes'
+								current_pattern.append(price_list2[index])
+								index += 1
+								if index >= len(price_list2):
 									break
 								else:
-									perdex += 1
-									if perdex >= len(perfect):                                                                        
-										perfect_yes = 'no'
-										break
-									else:
-										continue
-							high_var = high_percent_difference_of_last
-							low_var = low_percent_difference_of_last
-							if last_flipped == 'no':
-								if high_percent_difference_of_actuals >= high_var2+(high_var2*0.005) and percent_difference_of_actuals < high_var2:
-									upordown3.append(1)
-									upordown.append(1)
-									upordown4.append(1)
-									if len(upordown4) > 100:
-										del upordown4[0]
+									continue
+							high_current_pattern_length = 3
+							high_index = (len(high_price_list2)-1)-high_current_pattern_length
+							high_current_pattern = []
+							while True:
+								high_current_pattern.append(high_price_list2[high_index])
+								high_index += 1
+								if high_index >= len(high_price_list2):
+									break
+								else:
+									continue
+							low_current_pattern_length = 3
+							low_index = (len(low_price_list2)-1)-low_current_pattern_length
+							low_current_pattern = []
+							while True:
+								low_current_pattern.append(low_price_list2[low_index])
+								low_index += 1
+								if low_index >= len(low_price_list2):
+									break
+								else:
+									continue
+							new_y = [current_pattern[len(current_pattern)-1],current_pattern[len(current_pattern)-1]]
+							number_of_candles_index += 1
+							if number_of_candles_index >= len(number_of_candles):
+								print("Processed all number_of_candles. Exiting.")
+								sys.exit(0)
+						perfect_yes = 'no'
+						if 1==1:
+							high_current_price = high_current_pattern[len(high_current_pattern)-1]
+							low_current_price = low_current_pattern[len(low_current_pattern)-1]
+							try:
+								try:
+									difference_of_actuals = last_actual-new_y[0]
+									difference_of_last = last_actual-last_prediction
+									percent_difference_of_actuals = ((new_y[0]-last_actual)/abs(last_actual))*100
+									high_difference_of_actuals = last_actual-high_current_price
+									high_percent_difference_of_actuals = ((high_current_price-last_actual)/abs(last_actual))*100
+									low_difference_of_actuals = last_actual-low_current_price
+									low_percent_difference_of_actuals = ((low_current_price-last_actual)/abs(last_actual))*100
+									percent_difference_of_last = ((last_prediction-last_actual)/abs(last_actual))*100
+									high_percent_difference_of_last = ((high_last_prediction-last_actual)/abs(last_actual))*100
+									low_percent_difference_of_last = ((low_last_prediction-last_actual)/abs(last_actual))*100
+									if in_trade == 'no':
+										percent_for_no_sell = ((new_y[1]-last_actual)/abs(last_actual))*100
+										og_actual = last_actual
+										in_trade = 'yes'
 									else:
-										pass 
-								elif low_percent_difference_of_actuals <= low_var2-(low_var2*0.005) and percent_difference_of_actuals > low_var2:
-									upordown.append(1)
-									upordown3.append(1)
-									upordown4.append(1)
-									if len(upordown4) > 100:
-										del upordown4[0]
+										percent_for_no_sell = ((new_y[1]-og_actual)/abs(og_actual))*100
+								except:
+									difference_of_actuals = 0.0
+									difference_of_last = 0.0
+									percent_difference_of_actuals = 0.0
+									percent_difference_of_last = 0.0
+									high_difference_of_actuals = 0.0
+									high_percent_difference_of_actuals = 0.0
+									low_difference_of_actuals = 0.0
+									low_percent_difference_of_actuals = 0.0
+									high_percent_difference_of_last = 0.0
+									low_percent_difference_of_last = 0.0
+							except:
+								PrintException()
+							try:
+								perdex = 0
+								while True:
+									if perfect[perdex] == 'yes':
+										perfect_yes = 'yes'
+										break
 									else:
-										pass  									
-								elif high_percent_difference_of_actuals >= high_var2+(high_var2*0.005) and percent_difference_of_actuals > high_var2:
-									upordown3.append(0)
-									upordown2.append(0)
-									upordown.append(0)
-									upordown4.append(0)
-									if len(upordown4) > 100:
-										del upordown4[0]
+										perdex += 1
+										if perdex >= len(perfect):                                                                        
+											perfect_yes = 'no'
+											break
+										else:
+											continue
+								high_var = high_percent_difference_of_last
+								low_var = low_percent_difference_of_last
+								if last_flipped == 'no':
+									if high_percent_difference_of_actuals >= high_var2+(high_var2*0.005) and percent_difference_of_actuals < high_var2:
+										upordown3.append(1)
+										upordown.append(1)
+										upordown4.append(1)
+										if len(upordown4) > 100:
+											del upordown4[0]
+										else:
+											pass 
+									elif low_percent_difference_of_actuals <= low_var2-(low_var2*0.005) and percent_difference_of_actuals > low_var2:
+										upordown.append(1)
+										upordown3.append(1)
+										upordown4.append(1)
+										if len(upordown4) > 100:
+											del upordown4[0]
+										else:
+											pass  									
+									elif high_percent_difference_of_actuals >= high_var2+(high_var2*0.005) and percent_difference_of_actuals > high_var2:
+										upordown3.append(0)
+										upordown2.append(0)
+										upordown.append(0)
+										upordown4.append(0)
+										if len(upordown4) > 100:
+											del upordown4[0]
+										else:
+											pass
+									elif low_percent_difference_of_actuals <= low_var2-(low_var2*0.005) and percent_difference_of_actuals < low_var2:
+										upordown3.append(0)
+										upordown2.append(0)
+										upordown.append(0)
+										upordown4.append(0)
+										if len(upordown4) > 100:
+											del upordown4[0]
+										else:
+											pass  
 									else:
 										pass
-								elif low_percent_difference_of_actuals <= low_var2-(low_var2*0.005) and percent_difference_of_actuals < low_var2:
-									upordown3.append(0)
-									upordown2.append(0)
-									upordown.append(0)
-									upordown4.append(0)
-									if len(upordown4) > 100:
-										del upordown4[0]
-									else:
-										pass  
 								else:
 									pass
-							else:
-								pass
-							try:
-								print('(Bounce Accuracy for last 100 Over Limit Candles): ' + format((sum(upordown4)/len(upordown4))*100,'.2f'))
-							except:
-								pass
-							try:
-								print('current candle: '+str(len(price_list2)))
-							except:
-								pass
-							try:
-								print('Total Candles: '+str(int(len(price_list))))
+								try:
+									print('(Bounce Accuracy for last 100 Over Limit Candles): ' + format((sum(upordown4)/len(upordown4))*100,'.2f'))
+								except:
+									pass
+								try:
+									print('current candle: '+str(len(price_list2)))
+								except:
+									pass
+								try:
+									print('Total Candles: '+str(int(len(price_list))))
+								except:
+									pass
 							except:
+								PrintException()
+						else:
+							pass
+						cc_on = 'no'
+						try:
+							long_trade = 'no'
+							short_trade = 'no'
+							last_moves = moves
+							last_high_moves = high_moves
+							last_low_moves = low_moves
+							last_move_weights = move_weights
+							last_high_move_weights = high_move_weights
+							last_low_move_weights = low_move_weights
+							last_perfect_dexs = perfect_dexs
+							last_perfect_diffs = perfect_diffs
+							percent_difference_of_now = ((new_y[1]-new_y[0])/abs(new_y[0]))*100
+							high_percent_difference_of_now = ((high_new_y[1]-high_new_y[0])/abs(high_new_y[0]))*100
+							low_percent_difference_of_now = ((low_new_y[1]-low_new_y[0])/abs(low_new_y[0]))*100
+							high_var2 = high_percent_difference_of_now
+							low_var2 = low_percent_difference_of_now
+							var2 = percent_difference_of_now
+							if flipped == 'yes':
+								new1 = high_percent_difference_of_now
+								high_percent_difference_of_now = low_percent_difference_of_now
+								low_percent_difference_of_now = new1
+							else:
 								pass
 						except:
 							PrintException()
-					else:
-						pass
-					cc_on = 'no'
-					try:
-						long_trade = 'no'
-						short_trade = 'no'
-						last_moves = moves
-						last_high_moves = high_moves
-						last_low_moves = low_moves
-						last_move_weights = move_weights
-						last_high_move_weights = high_move_weights
-						last_low_move_weights = low_move_weights
-						last_perfect_dexs = perfect_dexs
-						last_perfect_diffs = perfect_diffs
-						percent_difference_of_now = ((new_y[1]-new_y[0])/abs(new_y[0]))*100
-						high_percent_difference_of_now = ((high_new_y[1]-high_new_y[0])/abs(high_new_y[0]))*100
-						low_percent_difference_of_now = ((low_new_y[1]-low_new_y[0])/abs(low_new_y[0]))*100
-						high_var2 = high_percent_difference_of_now
-						low_var2 = low_percent_difference_of_now
-						var2 = percent_difference_of_now
-						if flipped == 'yes':
-							new1 = high_percent_difference_of_now
-							high_percent_difference_of_now = low_percent_difference_of_now
-							low_percent_difference_of_now = new1
-						else:
+						last_actual = new_y[0]
+						last_prediction = new_y[1]
+						high_last_prediction = high_new_y[1]
+						low_last_prediction = low_new_y[1]
+						prediction_adjuster = 0.0
+						prediction_expander2 = 1.5
+						ended_on = number_of_candles_index
+						next_coin = 'yes'
+						profit_hit = 'no'
+						long_profit = 0
+						short_profit = 0
+						"""
+						expander_move = input('Expander good? yes or new number: ')
+						if expander_move == 'yes':
 							pass
-					except:
-						PrintException()
-					last_actual = new_y[0]
-					last_prediction = new_y[1]
-					high_last_prediction = high_new_y[1]
-					low_last_prediction = low_new_y[1]
-					prediction_adjuster = 0.0
-					prediction_expander2 = 1.5
-					ended_on = number_of_candles_index
-					next_coin = 'yes'
-					profit_hit = 'no'
-					long_profit = 0
-					short_profit = 0
-					"""
-					expander_move = input('Expander good? yes or new number: ')
-					if expander_move == 'yes':
-						pass
-					else:
-						prediction_expander = expander_move
-						continue
-					"""
-					last_flipped = flipped
-					which_candle_of_the_prediction_index = 0
-					if 1 == 1:
-						current_pattern_ending = [current_pattern[len(current_pattern)-1]]
-						while True:
-							try:
+						else:
+							prediction_expander = expander_move
+							continue
+						"""
+						last_flipped = flipped
+						which_candle_of_the_prediction_index = 0
+						if 1 == 1:
+							current_pattern_ending = [current_pattern[len(current_pattern)-1]]
+							while True:
 								try:
-									price_list_length += 1		
-									which_candle_of_the_prediction_index += 1
 									try:
-										if len(price_list2)>=int(len(price_list)*0.25) and restarted_yet < 2:
-											restarted_yet += 1
-											restarting = 'yes'
-											break
-										else:
+										price_list_length += 1		
+										which_candle_of_the_prediction_index += 1
+										try:
+											if len(price_list2)>=int(len(price_list)*0.25) and restarted_yet < 2:
+												restarted_yet += 1
+												restarting = 'yes'
+												break
+											else:
+												restarting = 'no'
+										except:
 											restarting = 'no'
-									except:
-										restarting = 'no'
-									if len(price_list2) == len(price_list):
-										the_big_index += 1
-										restarted_yet = 0
-										print('restarting')
-										restarting = 'yes'
-										avg50 = []
-										import sys
-										import datetime
-										import traceback
-										import linecache
-										import base64
-										import calendar
-										import hashlib
-										import hmac
-										from datetime import datetime
-										sells_count = 0
-										prediction_prices_avg_list = []
-										pt_server = 'server'
-										import psutil
-										import logging
-										list_len = 0
-										in_trade = 'no'
-										updowncount = 0
-										updowncount1 = 0
-										updowncount1_2 = 0
-										updowncount1_3 = 0
-										updowncount1_4 = 0
-										high_var2 = 0.0
-										low_var2 = 0.0
-										last_flipped = 'no'
-										starting_amounth02 = 100.0
-										starting_amounth05 = 100.0
-										starting_amounth10 = 100.0
-										starting_amounth20 = 100.0
-										starting_amounth50 = 100.0
-										starting_amount = 100.0
-										starting_amount1 = 100.0
-										starting_amount1_2 = 100.0
-										starting_amount1_3 = 100.0
-										starting_amount1_4 = 100.0
-										starting_amount2 = 100.0
-										starting_amount2_2 = 100.0
-										starting_amount2_3 = 100.0
-										starting_amount2_4 = 100.0
-										starting_amount3 = 100.0
-										starting_amount3_2 = 100.0
-										starting_amount3_3 = 100.0
-										starting_amount3_4 = 100.0
-										starting_amount4 = 100.0
-										starting_amount4_2 = 100.0
-										starting_amount4_3 = 100.0
-										starting_amount4_4 = 100.0
-										profit_list = []
-										profit_list1 = []
-										profit_list1_2 = []
-										profit_list1_3 = []
-										profit_list1_4 = []
-										profit_list2 = []
-										profit_list2_2 = []
-										profit_list2_3 = []
-										profit_list2_4 = []
-										profit_list3 = []
-										profit_list3_2 = []
-										profit_list3_3 = []
-										profit_list4 = []
-										profit_list4_2 = []
-										good_hits = []
-										good_preds = []
-										good_preds2 = []
-										good_preds3 = []
-										good_preds4 = []
-										good_preds5 = []
-										good_preds6 = []
-										big_good_preds = []
-										big_good_preds2 = []
-										big_good_preds3 = []
-										big_good_preds4 = []
-										big_good_preds5 = []
-										big_good_preds6 = []
-										big_good_hits = []
-										upordown = []
-										upordown1 = []
-										upordown1_2 = []
-										upordown1_3 = []
-										upordown1_4 = []
-										upordown2 = []
-										upordown2_2 = []
-										upordown2_3 = []
-										upordown2_4 = []
-										upordown3 = []
-										upordown3_2 = []
-										upordown3_3 = []
-										upordown3_4 = []
-										upordown4 = []
-										upordown4_2 = []
-										upordown4_3 = []
-										upordown4_4 = []
-										upordown5 = []
-										import json
-										import uuid
-										how_far_to_look_back = 100000
-										list_len = 0
-										print(the_big_index)
-										print(len(tf_choices))
-										if the_big_index >= len(tf_choices):
-											if len(number_of_candles) == 1:
-												print("Finished processing all timeframes (number_of_candles has only one entry). Exiting.")
-												try:
-													file = open('trainer_last_start_time.txt','w+')
-													file.write(str(start_time_yes))
-													file.close()
-												except:
-													pass
-
-												# Mark training finished for the GUI
-												try:
-													_trainer_finished_at = int(time.time())
-													file = open('trainer_last_training_time.txt','w+')
-													file.write(str(_trainer_finished_at))
-													file.close()
-												except:
-													pass
-												try:
-													with open("trainer_status.json", "w", encoding="utf-8") as f:
-														json.dump(
-															{
-																"coin": _arg_coin,
-																"state": "FINISHED",
-																"started_at": _trainer_started_at,
-																"finished_at": _trainer_finished_at,
-																"timestamp": _trainer_finished_at,
-															},
-															f,
-														)
-												except Exception:
-													pass
-
+										if len(price_list2) == len(price_list):
+											# timeframe done: persist whatever is still only in RAM
+											flush_memory(tf_choice, force=True)
+											if restarted_yet >= 2:
+												prune_memory(tf_choice, ctx.prune)
+												save_checkpoint(tf_choice, time_list[-1], checkpoint_threshold)
+											the_big_index += 1
+											restarted_yet = 0
+											print('restarting')
+											restarting = 'yes'
+											print(the_big_index)
+											print(len(run_tfs))
+											if the_big_index >= len(run_tfs):
+												# every pattern length trains in the same pass, so one sweep of the timeframes is all of it
+												print("Finished processing all timeframes. Exiting.")
+												_finish_training(ctx, start_time_yes)
 												sys.exit(0)
 											else:
-												the_big_index = 0
+												pass
+											break
 										else:
-											pass
-										break
-									else:
-										exited = 'no'
-										try:
-											price_list2 = []
-											price_list_index = 0
-											while True:
-												price_list2.append(price_list[price_list_index])
-												price_list_index += 1
-												if len(price_list2) >= price_list_length:
-													break
-												else:
-													continue
-											high_price_list2 = []
-											high_price_list_index = 0
-											while True:
-												high_price_list2.append(high_price_list[high_price_list_index])
-												high_price_list_index += 1
-												if high_price_list_index >= price_list_length:
-													break
-												else:
-													continue
-											low_price_list2 = []
-											low_price_list_index = 0
-											while True:
-												low_price_list2.append(low_price_list[low_price_list_index])
-												low_price_list_index += 1
-												if low_price_list_index >= price_list_length:
-													break
-												else:
-													continue
-											price2 = price_list2[len(price_list2)-1]
-											high_price2 = high_price_list2[len(high_price_list2)-1]
-											low_price2 = low_price_list2[len(low_price_list2)-1]
-											highlowind = 0
-											this_differ = ((price2-new_y[1])/abs(new_y[1]))*100
-											high_this_differ = ((high_price2-new_y[1])/abs(new_y[1]))*100
-											low_this_differ = ((low_price2-new_y[1])/abs(new_y[1]))*100
-											this_diff = ((price2-new_y[0])/abs(new_y[0]))*100
-											high_this_diff = ((high_price2-new_y[0])/abs(new_y[0]))*100
-											low_this_diff = ((low_price2-new_y[0])/abs(new_y[0]))*100
-											difference_list = []
-											list_of_predictions = all_predictions
-											close_enough_counter = []
-											which_pattern_length_index = 0								
-											while True:
-												current_prediction_price = all_predictions[highlowind][which_candle_of_the_prediction_index]
-												high_current_prediction_price = high_all_predictions[highlowind][which_candle_of_the_prediction_index]
-												low_current_prediction_price = low_all_predictions[highlowind][which_candle_of_the_prediction_index]
-												perc_diff_now = ((current_prediction_price-new_y[0])/abs(new_y[0]))*100
-												perc_diff_now_actual = ((price2-new_y[0])/abs(new_y[0]))*100
-												high_perc_diff_now_actual = ((high_price2-new_y[0])/abs(new_y[0]))*100
-												low_perc_diff_now_actual = ((low_price2-new_y[0])/abs(new_y[0]))*100
-												try:
-													difference = abs((abs(current_prediction_price-float(price2))/((current_prediction_price+float(price2))/2))*100)
-												except:
-													difference = 100.0
-												try:
-													direction = 'down'
+											exited = 'no'
+											try:
+												price_list2 = []
+												price_list_index = 0
+												while True:
+													price_list2.append(price_list[price_list_index])
+													price_list_index += 1
+													if len(price_list2) >= price_list_length:
+														break
+													else:
+														continue
+												high_price_list2 = []
+												high_price_list_index = 0
+												while True:
+													high_price_list2.append(high_price_list[high_price_list_index])
+													high_price_list_index += 1
+													if high_price_list_index >= price_list_length:
+														break
+													else:
+														continue
+												low_price_list2 = []
+												low_price_list_index = 0
+												while True:
+													low_price_list2.append(low_price_list[low_price_list_index])
+													low_price_list_index += 1
+													if low_price_list_index >= price_list_length:
+														break
+													else:
+														continue
+												price2 = price_list2[len(price_list2)-1]
+												high_price2 = high_price_list2[len(high_price_list2)-1]
+												low_price2 = low_price_list2[len(low_price_list2)-1]
+												highlowind = 0
+												weight_updates = []
+												this_differ = ((price2-new_y[1])/abs(new_y[1]))*100
+												high_this_differ = ((high_price2-new_y[1])/abs(new_y[1]))*100
+												low_this_differ = ((low_price2-new_y[1])/abs(new_y[1]))*100
+												this_diff = ((price2-new_y[0])/abs(new_y[0]))*100
+												high_this_diff = ((high_price2-new_y[0])/abs(new_y[0]))*100
+												low_this_diff = ((low_price2-new_y[0])/abs(new_y[0]))*100
+												difference_list = []
+												list_of_predictions = all_predictions
+												close_enough_counter = []
+												which_pattern_length_index = 0								
+												while True:
+													current_prediction_price = all_predictions[highlowind][which_candle_of_the_prediction_index]
+													high_current_prediction_price = high_all_predictions[highlowind][which_candle_of_the_prediction_index]
+													low_current_prediction_price = low_all_predictions[highlowind][which_candle_of_the_prediction_index]
+													perc_diff_now = ((current_prediction_price-new_y[0])/abs(new_y[0]))*100
+													perc_diff_now_actual = ((price2-new_y[0])/abs(new_y[0]))*100
+													high_perc_diff_now_actual = ((high_price2-new_y[0])/abs(new_y[0]))*100
+													low_perc_diff_now_actual = ((low_price2-new_y[0])/abs(new_y[0]))*100
 													try:
-														indy = 0
-														while True:
-															new_memory = 'no'
-															var3 = (moves[indy]*100)
-															high_var3 = (high_moves[indy]*100)
-															low_var3 = (low_moves[indy]*100)
-															if high_perc_diff_now_actual > high_var3+(high_var3*0.1):
-																high_new_weight = high_move_weights[indy] + 0.25
-																if high_new_weight > 2.0:
-																	high_new_weight = 2.0
-																else:
-																	pass
-															elif high_perc_diff_now_actual < high_var3-(high_var3*0.1):
-																high_new_weight = high_move_weights[indy] - 0.25
-																if high_new_weight < 0.0:
-																	high_new_weight = 0.0
-																else:
-																	pass
-															else:
-																high_new_weight = high_move_weights[indy]
-															if low_perc_diff_now_actual < low_var3-(low_var3*0.1):
-																low_new_weight = low_move_weights[indy] + 0.25
-																if low_new_weight > 2.0:
-																	low_new_weight = 2.0
+														difference = abs((abs(current_prediction_price-float(price2))/((current_prediction_price+float(price2))/2))*100)
+													except:
+														difference = 100.0
+													try:
+														direction = 'down'
+														try:
+															indy = 0
+															while True:
+																new_memory = 'no'
+																var3 = (moves[indy]*100)
+																high_var3 = (high_moves[indy]*100)
+																low_var3 = (low_moves[indy]*100)
+																if high_perc_diff_now_actual > high_var3+(high_var3*0.1):
+																	high_new_weight = high_move_weights[indy] + 0.25
+																	if high_new_weight > 2.0:
+																		high_new_weight = 2.0
+																	else:
+																		pass
+																elif high_perc_diff_now_actual < high_var3-(high_var3*0.1):
+																	high_new_weight = high_move_weights[indy] - 0.25
+																	if high_new_weight < 0.0:
+																		high_new_weight = 0.0
+																	else:
+																		pass
 																else:
-																	pass
-															elif low_perc_diff_now_actual > low_var3+(low_var3*0.1):
-																low_new_weight = low_move_weights[indy] - 0.25
-																if low_new_weight < 0.0:
-																	low_new_weight = 0.0
+																	high_new_weight = high_move_weights[indy]
+																if low_perc_diff_now_actual < low_var3-(low_var3*0.1):
+																	low_new_weight = low_move_weights[indy] + 0.25
+																	if low_new_weight > 2.0:
+																		low_new_weight = 2.0
+																	else:
+																		pass
+																elif low_perc_diff_now_actual > low_var3+(low_var3*0.1):
+																	low_new_weight = low_move_weights[indy] - 0.25
+																	if low_new_weight < 0.0:
+																		low_new_weight = 0.0
+																	else:
+																		pass
 																else:
-																	pass
-															else:
-																low_new_weight = low_move_weights[indy]
-															if perc_diff_now_actual > var3+(var3*0.1):
-																new_weight = move_weights[indy] + 0.25
-																if new_weight > 2.0:
-																	new_weight = 2.0
+																	low_new_weight = low_move_weights[indy]
+																if perc_diff_now_actual > var3+(var3*0.1):
+																	new_weight = move_weights[indy] + 0.25
+																	if new_weight > 2.0:
+																		new_weight = 2.0
+																	else:
+																		pass
+																elif perc_diff_now_actual < var3-(var3*0.1):
+																	new_weight = move_weights[indy] - 0.25
+																	if new_weight < (0.0-2.0):
+																		new_weight = (0.0-2.0)
+																	else:
+																		pass
 																else:
-																	pass
-															elif perc_diff_now_actual < var3-(var3*0.1):
-																new_weight = move_weights[indy] - 0.25
-																if new_weight < (0.0-2.0):
-																	new_weight = (0.0-2.0)
+																	new_weight = move_weights[indy]
+																# queued, applied to the store once per candle (see below)
+																weight_updates.append((perfect_dexs[indy], new_weight, high_new_weight, low_new_weight))
+
+																indy += 1
+																if indy >= len(unweighted):
+																	break
 																else:
 																	pass
-															else:
-																new_weight = move_weights[indy]
-															del weight_list[perfect_dexs[indy]]
-															weight_list.insert(perfect_dexs[indy],new_weight)
-															del high_weight_list[perfect_dexs[indy]]
-															high_weight_list.insert(perfect_dexs[indy],high_new_weight)
-															del low_weight_list[perfect_dexs[indy]]
-															low_weight_list.insert(perfect_dexs[indy],low_new_weight)
+														except:
+															PrintException()
+															all_current_patterns[highlowind].append(this_diff)
+
+															# new memory: pattern values + the move that followed, stored in RAM
+															mem_values = [float(v) for v in all_current_patterns[highlowind]]
 
-															# mark dirty (we will flush in batches)
 															_mem = load_memory(tf_choice)
+															if len(_mem["store"]) == 0:
+																_mem["store"].pattern_len = len(mem_values)-1
+																_mem["store"].flags = pt_memory.widths_flags(widths)
+															_mem["store"].append(mem_values[:-1], mem_values[-1], high_this_diff, low_this_diff, 1.0, 1.0, 1.0)
 															_mem["dirty"] = True
 
 															# occasional batch flush
 															if loop_i % 200 == 0:
 																flush_memory(tf_choice)
 
-															indy += 1
-															if indy >= len(unweighted):
-																break
-															else:
-																pass
 													except:
 														PrintException()
-														all_current_patterns[highlowind].append(this_diff)
-
-														# build the same memory entry format, but store in RAM
-														mem_entry = str(all_current_patterns[highlowind]).replace("'","").replace(',','').replace('"','').replace(']','').replace('[','')+'{}'+str(high_this_diff)+'{}'+str(low_this_diff)
-
-														_mem = load_memory(tf_choice)
-														_mem["memory_list"].append(mem_entry)
-														_mem["weight_list"].append('1.0')
-														_mem["high_weight_list"].append('1.0')
-														_mem["low_weight_list"].append('1.0')
-														_mem["dirty"] = True
+														pass										
+													highlowind += 1
+													if highlowind >= len(all_predictions):
+														break
+													else:
+														continue
+												# apply this candle's weight updates in one batch (direct indexed writes into the store columns)
+												if weight_updates:
+													_mem = load_memory(tf_choice)
+													_mem["store"].set_weights(weight_updates)
+													_mem["dirty"] = True
 
-														# occasional batch flush
-														if loop_i % 200 == 0:
-															flush_memory(tf_choice)
+													# occasional batch flush
+													if loop_i % 200 == 0:
+														flush_memory(tf_choice)
+												checkpoint_threshold = perfect_threshold
+												if restarted_yet >= 2 and loop_i % 200 == 0:
+													flush_memory(tf_choice)
+													save_checkpoint(tf_choice, time_list[len(price_list2)-1], perfect_threshold)
+											except SystemExit:
+												raise
+											except KeyboardInterrupt:
+												raise
+											except Exception:
+												PrintException()
+												break
 
-												except:
-													PrintException()
-													pass										
-												highlowind += 1
-												if highlowind >= len(all_predictions):
-													break
-												else:
-													continue
-										except SystemExit:
-											raise
-										except KeyboardInterrupt:
-											raise
-										except Exception:
-											PrintException()
+										if which_candle_of_the_prediction_index >= candles_to_predict:
 											break
-
-									if which_candle_of_the_prediction_index >= candles_to_predict:
+										else:
+											continue
+									except SystemExit:
+										raise
+									except KeyboardInterrupt:
+										raise
+									except Exception:
+										PrintException()
 										break
-									else:
-										continue
+
 								except SystemExit:
 									raise
 								except KeyboardInterrupt:
@@ -1592,34 +1457,125 @@ while True:
 									PrintException()
 									break
 
-							except SystemExit:
-								raise
-							except KeyboardInterrupt:
-								raise
-							except Exception:
-								PrintException()
-								break
+						else:
+							pass
+						coin_choice_index += 1
+						history_list = []
+						price_change_list = []
+						current_pattern = []
+						break
+					except SystemExit:
+						raise
+					except KeyboardInterrupt:
+						raise
+					except Exception:
+						PrintException()
+						break
 
-					else:
-						pass
-					coin_choice_index += 1
-					history_list = []
-					price_change_list = []
-					current_pattern = []
-					break
-				except SystemExit:
-					raise
-				except KeyboardInterrupt:
-					raise
-				except Exception:
-					PrintException()
+				if restarting == 'yes':
 					break
-
+				else:
+					continue
 			if restarting == 'yes':
 				break
 			else:
 				continue
-		if restarting == 'yes':
-			break
-		else:
-			continue
+
+
+_PRUNE_FLAGS = {
+	"--prune-floor": ("floor_updates", int),
+	"--prune-merge": ("merge_distance", float),
+	"--prune-cap": ("max_memories", int),
+}
+
+def _prune_args(policy):
+	out = []
+	for flag, (key, _conv) in _PRUNE_FLAGS.items():
+		if policy.get(key):
+			out += [flag, str(policy[key])]
+	return out
+
+def _parse_args(argv):
+	"""
+	Usage: python pt_trainer.py BTC [--parallel] [--workers N] [--tf 4hour] [--incremental]
+	                                [--prune-floor N] [--prune-merge D] [--prune-cap M] [--publish REPO]
+	                                [--pattern-lengths 2,3,5] [--end-at T]
+	  --parallel     train each timeframe in its own worker process
+	  --workers N    cap on concurrent workers in parallel mode (default: CPU count)
+	  --tf TF        train just this timeframe (what parallel workers run)
+	  --incremental  resume from the per-timeframe checkpoints; only new candles are processed
+	  --prune-*      when a timeframe finishes, drop memories stuck at the weight floor for N
+	                 updates / merge patterns within D % / keep at most M (pt_memory.prune)
+	  --publish REPO after a finished run, publish each timeframe as a bundle into REPO
+	                 (POWERTRADER_BUNDLE_REPO if not given; see pt_bundles.py)
+	  --end-at T     train only on candles that had closed by unix time T (a replay's start; implies
+	                 a full, non-incremental run)
+	  --pattern-lengths  candles per pattern, 2-9 (default 2); several are matched in one pass and
+	                 their predictions averaged. Applies to new memories: a trained store keeps its own.
+	"""
+	opts = {"coin": "BTC", "parallel": False, "workers": 0, "tf": None, "incremental": False, "prune": {}, "publish": os.environ.get("POWERTRADER_BUNDLE_REPO") or None}
+	args = list(argv)
+	i = 0
+	positional = []
+	while i < len(args):
+		a = str(args[i]).strip()
+		if a == "--parallel":
+			opts["parallel"] = True
+		elif a == "--incremental":
+			opts["incremental"] = True
+		elif a == "--workers" and i + 1 < len(args):
+			i += 1
+			try:
+				opts["workers"] = int(args[i])
+			except Exception:
+				pass
+		elif a == "--tf" and i + 1 < len(args):
+			i += 1
+			opts["tf"] = str(args[i]).strip()
+		elif a == "--end-at" and i + 1 < len(args):
+			i += 1
+			try:
+				opts["end_at"] = int(float(args[i]))
+			except Exception:
+				pass
+		elif a == "--pattern-lengths" and i + 1 < len(args):
+			i += 1
+			try:
+				opts["pattern_lengths"] = [int(v) for v in str(args[i]).split(",") if v.strip()]
+			except Exception:
+				pass
+		elif a == "--publish" and i + 1 < len(args):
+			i += 1
+			opts["publish"] = str(args[i]).strip() or None
+		elif a in _PRUNE_FLAGS and i + 1 < len(args):
+			i += 1
+			key, conv = _PRUNE_FLAGS[a]
+			try:
+				if conv(args[i]) > 0:
+					opts["prune"][key] = conv(args[i])
+			except Exception:
+				pass
+		elif a:
+			positional.append(a)
+		i += 1
+	if positional:
+		opts["coin"] = positional[0].upper()
+	return opts
+
+
+if __name__ == "__main__":
+	# --- GUI HUB INPUT (NO PROMPTS) ---
+	_opts = _parse_args(sys.argv[1:])
+	if _opts.get("pattern_lengths"):
+		number_of_candles = _opts["pattern_lengths"]
+	if _opts.get("end_at"):
+		_opts["incremental"] = False
+	if _opts["tf"] in tf_choices:
+		_ctx = TrainContext(_opts["coin"], [_opts["tf"]], worker=True, incremental=_opts["incremental"], prune=_opts["prune"], end_at=_opts.get("end_at"))
+	else:
+		_ctx = TrainContext(_opts["coin"], incremental=_opts["incremental"], prune=_opts["prune"], publish=_opts["publish"], end_at=_opts.get("end_at"))
+	pt_metrics.configure(f"trainer_{_ctx.coin}_{_ctx.tf_list[0]}" if _ctx.worker else f"trainer_{_ctx.coin}")
+	_write_status(_ctx, "TRAINING")
+	if _opts["parallel"] and not _ctx.worker:
+		sys.exit(train_parallel(_ctx, _opts["workers"]))
+	train(_ctx)